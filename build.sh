@@ -21,6 +21,7 @@ case "$1" in
         cmake -DBUILD_PICO=OFF ..
         make
         ./flight_controller_tests_host
+        ./flight_controller_host -n 10000
         ;;
     "pico")
         echo "Building Pico targets..."
@@ -1,16 +1,82 @@
 #pragma once
 
 #include "types.h"
+#include "../include/config.h"
+#include "../utils/fixed_point.h"
+
+// Sensor fusion used by attitude_estimator_update(). The complementary
+// filter slerps toward an Euler-derived accelerometer attitude every step.
+// Mahony (PI feedback on the gravity direction error) and Madgwick
+// (normalized gradient descent step) use only multiplies, adds and inverse
+// square roots, and learn the gyro bias online into gyro_bias.
+typedef enum {
+    ATTITUDE_FILTER_COMPLEMENTARY,
+    ATTITUDE_FILTER_MAHONY,
+    ATTITUDE_FILTER_MADGWICK
+} attitude_filter_t;
 
 typedef struct {
     quaternion_t quaternion;
-    vector3_t gyro_bias;
-    float filter_alpha;
+    vector3_t gyro_bias;        // deg/s
+    float filter_alpha;         // Complementary: weight kept on the gyro
+    attitude_filter_t filter;
+    float kp;                   // Mahony proportional gain, rad/s per unit error
+    float ki;                   // Mahony integral (bias) gain
+    float beta;                 // Madgwick step, rad/s
+    float zeta;                 // Madgwick bias gain
 } attitude_estimator_t;
 
+// Starts level with the filter chosen by ATTITUDE_FILTER in config.h.
+// attitude_estimator_setup() does it in place, for estimators that live in
+// static storage.
+#if !FC_STATIC_ALLOC
 attitude_estimator_t* attitude_estimator_init(void);
+#endif
+void attitude_estimator_setup(attitude_estimator_t* estimator);
+void attitude_estimator_set_filter(attitude_estimator_t* estimator, attitude_filter_t filter);
 void attitude_estimator_update(attitude_estimator_t* estimator, 
                              const vector3_t* accel, 
                              const vector3_t* gyro, 
                              float dt);
 attitude_t attitude_estimator_get_attitude(const attitude_estimator_t* estimator);
+attitude_t attitude_from_quaternion(const quaternion_t* q);
+
+// Inverse of attitude_from_quaternion(): roll, pitch, yaw in degrees
+void quaternion_from_attitude(quaternion_t* q, const attitude_t* attitude);
+
+// Body-frame rotation that takes q to setpoint, as 2 * the vector part of
+// q_sp^-1 (x) q in degrees, negated: per axis it matches setpoint - current
+// Euler angles for small errors, has no singularity at +/-90 degrees pitch
+// and no wrap at +/-180 degrees yaw, and grows to 2 rad (115 degrees) for
+// a half-turn error. Either sign of either quaternion gives the same error.
+void quaternion_attitude_error(vector3_t* error, const quaternion_t* setpoint,
+                               const quaternion_t* q);
+
+// Steps of attitude_estimator_update(), exposed for the benchmarks.
+// estimate_from_accel() leaves q_acc untouched for a zero-length sample.
+void estimate_from_accel(quaternion_t* q_acc, const vector3_t* accel);
+void quaternion_slerp(quaternion_t* result,
+                      const quaternion_t* q1,
+                      const quaternion_t* q2,
+                      float t);
+
+// Fixed-point ATTITUDE_FILTER_MAHONY for the FC_FIXED_POINT flight path:
+// the same equations with the quaternion in Q2.30 and the gyro bias in Q1.31
+// fractions of the gyro full scale. Accel and gyro are the Q15 samples from
+// mpu6050_scale_sample_q15(), dt is in Q1.31 seconds. Step gains are Q8.24.
+typedef struct {
+    quaternion_q30_t quaternion;
+    q31_t gyro_bias[3];
+    int32_t rate_scale;         // Half the gyro full scale, rad/s
+    int32_t kp_scale;           // kp / 2
+    int32_t ki_scale;           // ki, in gyro full scales per radian of error
+} attitude_estimator_q_t;
+
+// Starts from the attitude, bias and Mahony gains of a float estimator.
+// gyro_full_scale is the rate of a Q15 1.0, deg/s.
+void attitude_estimator_q_init(attitude_estimator_q_t* estimator,
+                               const attitude_estimator_t* reference, float gyro_full_scale);
+void attitude_estimator_q_update(attitude_estimator_q_t* estimator, const vector3_q15_t* accel,
+                                 const vector3_q15_t* gyro, q31_t dt);
+void attitude_estimator_q_get_quaternion(const attitude_estimator_q_t* estimator,
+                                         quaternion_t* q);
@@ -0,0 +1,250 @@
+// src/core/dyn_notch.c
+#include "dyn_notch.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../utils/heap_guard.h"
+
+#define PI_F 3.14159265f
+#define MAX_HZ_OF_RATE 0.45f    // Of the sample rate
+#define TRACK_GAIN 0.5f         // Step of a notch toward its new peak
+#define SPECTRUM_GAIN 0.25f     // Weight of a new transform in the average
+#define SPECTRUM_WARMUP 4       // Transforms averaged before a peak is taken
+#define UNASSIGNED_DISTANCE 1e6f
+
+// Steps of the analysis (dyn_notch_t.step)
+#define STEP_LOAD 0
+#define STEP_PEAKS (DYN_NOTCH_STEPS_PER_AXIS - 1)
+
+void biquad_notch_set(biquad_t* f, float center_hz, float q, float sample_hz) {
+    float w0 = 2.0f * PI_F * center_hz / sample_hz;
+    float alpha = sinf(w0) / (2.0f * q);
+    float cos_w0 = cosf(w0);
+    float a0_inv = 1.0f / (1.0f + alpha);
+
+    f->b0 = a0_inv;
+    f->b1 = -2.0f * cos_w0 * a0_inv;
+    f->b2 = a0_inv;
+    f->a1 = f->b1;
+    f->a2 = (1.0f - alpha) * a0_inv;
+}
+
+void biquad_reset(biquad_t* f) {
+    f->s1 = 0.0f;
+    f->s2 = 0.0f;
+}
+
+void dyn_notch_init(dyn_notch_t* dn, float min_hz, float max_hz, float q) {
+    memset(dn, 0, sizeof(*dn));
+    dn->min_hz = min_hz;
+    dn->max_hz = max_hz;
+    dn->q = q;
+}
+
+// New sample rate: forget the history, the peaks and the filter state
+static void configure(dyn_notch_t* dn, float dt) {
+    float bin_hz;
+    float max_hz;
+    int lo, hi;
+
+    dn->dt = dt;
+    dn->sample_hz = 1.0f / dt;
+    bin_hz = dn->sample_hz / DYN_NOTCH_FFT_SIZE;
+    max_hz = dn->max_hz;
+    if (max_hz > MAX_HZ_OF_RATE * dn->sample_hz) max_hz = MAX_HZ_OF_RATE * dn->sample_hz;
+
+    // Whole bins inside the band, keeping a neighbour on each side for the
+    // interpolation
+    lo = (int)ceilf(dn->min_hz / bin_hz);
+    hi = (int)floorf(max_hz / bin_hz);
+    if (lo < 1) lo = 1;
+    if (hi > DYN_NOTCH_FFT_SIZE / 2 - 1) hi = DYN_NOTCH_FFT_SIZE / 2 - 1;
+    if (hi < lo) hi = lo - 1;           // Empty band: nothing is tracked
+    dn->min_bin = (uint16_t)lo;
+    dn->max_bin = (uint16_t)hi;
+
+    dn->head = 0;
+    dn->filled = 0;
+    dn->axis = 0;
+    dn->step = STEP_LOAD;
+    for (int a = 0; a < 3; a++) {
+        for (int p = 0; p < DYN_NOTCH_PEAKS; p++) {
+            dn->peak_hz[a][p] = 0.0f;
+            biquad_reset(&dn->notch[a][p]);
+        }
+        for (int k = 0; k <= DYN_NOTCH_FFT_SIZE / 2; k++) dn->spectrum[a][k] = 0.0f;
+    }
+}
+
+// Windowed history of the current axis, oldest first, into re[] in
+// bit-reversed order. The mean is removed and the block shifted up to just
+// under half scale, so slow manoeuvres don't swamp the noise in Q15.
+static uint32_t load_axis(dyn_notch_t* dn) {
+    const q15_t* x = dn->history[dn->axis];
+    int32_t sum = 0;
+    int32_t mean;
+    int32_t peak = 0;
+    int shift = 0;
+
+    for (int i = 0; i < DYN_NOTCH_FFT_SIZE; i++) sum += x[i];
+    mean = sum / DYN_NOTCH_FFT_SIZE;
+    for (int i = 0; i < DYN_NOTCH_FFT_SIZE; i++) {
+        int32_t v = x[i] - mean;
+        if (v < 0) v = -v;
+        if (v > peak) peak = v;
+    }
+    // Up, or down for blocks past half scale
+    while (peak > 0 && (peak << (shift + 1)) < (1 << 14)) shift++;
+    while (shift <= 0 && (peak >> -shift) >= (1 << 14)) shift--;
+    dn->shift = (int8_t)shift;
+
+    for (int i = 0; i < DYN_NOTCH_FFT_SIZE; i++) {
+        int32_t v = x[(dn->head + i) % DYN_NOTCH_FFT_SIZE] - mean;
+        v = shift >= 0 ? v * (1 << shift) : v >> -shift;
+        int j = fft_q15_bit_reverse((uint16_t)i, DYN_NOTCH_FFT_LOG2);
+        dn->re[j] = q15_mul((q15_t)v, fft_q15_hann(i, DYN_NOTCH_FFT_LOG2));
+        dn->im[j] = 0;
+    }
+    return DYN_NOTCH_FFT_SIZE;
+}
+
+// Hand each found peak (hz[0 .. count-1]) to a notch of the axis: the
+// closest pairs first, with unused notches the last choice. A notch that
+// gets no peak stays where it was.
+static void assign_peaks(dyn_notch_t* dn, const float* hz, int count) {
+    float* track = dn->peak_hz[dn->axis];
+    bool peak_done[DYN_NOTCH_PEAKS] = { false };
+    bool notch_done[DYN_NOTCH_PEAKS] = { false };
+
+    for (int n = 0; n < count; n++) {
+        int best_peak = -1, best_notch = -1;
+        float best = 0.0f;
+        for (int p = 0; p < count; p++) {
+            if (peak_done[p]) continue;
+            for (int s = 0; s < DYN_NOTCH_PEAKS; s++) {
+                if (notch_done[s]) continue;
+                float d = track[s] > 0.0f ? fabsf(track[s] - hz[p]) : UNASSIGNED_DISTANCE;
+                if (best_peak < 0 || d < best) {
+                    best = d;
+                    best_peak = p;
+                    best_notch = s;
+                }
+            }
+        }
+        peak_done[best_peak] = true;
+        notch_done[best_notch] = true;
+
+        float* f = &track[best_notch];
+        *f = *f > 0.0f ? *f + TRACK_GAIN * (hz[best_peak] - *f) : hz[best_peak];
+        biquad_notch_set(&dn->notch[dn->axis][best_notch], *f, dn->q, dn->sample_hz);
+    }
+}
+
+// Power of the finished transform, undoing the block scaling, into the
+// axis's averaged spectrum; then the strongest local maxima of the band that
+// clear the noise floor, and their interpolated frequencies. One transform
+// of white noise has a few bins far above the mean; the average keeps those
+// from being taken for motor noise.
+static uint32_t find_peaks(dyn_notch_t* dn) {
+    float* power = dn->spectrum[dn->axis];
+    int lo = dn->min_bin, hi = dn->max_bin;
+    int bins = hi - lo + 1;
+    float scale = SPECTRUM_GAIN * ldexpf(1.0f, -2 * dn->shift);
+    float band = 0.0f;
+    int peak_bin[DYN_NOTCH_PEAKS];
+    int found = 0;
+    float hz[DYN_NOTCH_PEAKS];
+    int accepted = 0;
+
+    if (bins <= 0) return 0;
+    for (int k = lo - 1; k <= hi + 1; k++) {
+        int32_t re = dn->re[k], im = dn->im[k];
+        uint32_t p = (uint32_t)(re * re) + (uint32_t)(im * im);
+        power[k] = (1.0f - SPECTRUM_GAIN) * power[k] + scale * (float)p;
+        if (k >= lo && k <= hi) band += power[k];
+    }
+    // Every axis gets a transform in turn
+    if (dn->spectra / 3 + 1 < SPECTRUM_WARMUP) return 4u * (uint32_t)(hi - lo + 3);
+
+    // The DYN_NOTCH_PEAKS largest local maxima, strongest first
+    for (int k = lo; k <= hi; k++) {
+        if (power[k] <= power[k - 1] || power[k] < power[k + 1]) continue;
+        int at = found < DYN_NOTCH_PEAKS ? found++ : DYN_NOTCH_PEAKS;
+        while (at > 0 && power[peak_bin[at - 1]] < power[k]) {
+            if (at < DYN_NOTCH_PEAKS) peak_bin[at] = peak_bin[at - 1];
+            at--;
+        }
+        if (at < DYN_NOTCH_PEAKS) peak_bin[at] = k;
+    }
+
+    // Noise floor: the band without the peaks and their neighbours
+    bool excluded[DYN_NOTCH_FFT_SIZE / 2 + 1] = { false };
+    float rest = band;
+    int rest_bins = bins;
+    for (int p = 0; p < found; p++) {
+        for (int k = peak_bin[p] - 1; k <= peak_bin[p] + 1; k++) {
+            if (k < lo || k > hi || excluded[k]) continue;
+            excluded[k] = true;
+            rest -= power[k];
+            rest_bins--;
+        }
+    }
+    float floor_power = rest_bins > 0 ? rest / (float)rest_bins : 0.0f;
+
+    float bin_hz = dn->sample_hz / DYN_NOTCH_FFT_SIZE;
+    for (int p = 0; p < found; p++) {
+        int k = peak_bin[p];
+        if (power[k] <= DYN_NOTCH_THRESHOLD * floor_power) continue;
+
+        // Parabola through the three magnitudes around the peak
+        float a = sqrtf(power[k - 1]);
+        float b = sqrtf(power[k]);
+        float c = sqrtf(power[k + 1]);
+        float denom = a - 2.0f * b + c;
+        float delta = denom < 0.0f ? 0.5f * (a - c) / denom : 0.0f;
+        if (delta > 0.5f) delta = 0.5f;
+        if (delta < -0.5f) delta = -0.5f;
+        hz[accepted++] = ((float)k + delta) * bin_hz;
+    }
+    assign_peaks(dn, hz, accepted);
+
+    // Two integer and two float multiplies per bin
+    return 4u * (uint32_t)(hi - lo + 3);
+}
+
+void dyn_notch_update(dyn_notch_t* dn, vector3_t* gyro, float dt) {
+    float* rate[3] = { &gyro->x, &gyro->y, &gyro->z };
+
+    if (dt != dn->dt) configure(dn, dt);
+
+    for (int a = 0; a < 3; a++) {
+        dn->history[a][dn->head] = q15_from_float(*rate[a] * (1.0f / DYN_NOTCH_INPUT_RANGE));
+    }
+    dn->head = (uint16_t)((dn->head + 1) % DYN_NOTCH_FFT_SIZE);
+
+    // One step of the analysis, once the ring holds a whole window
+    dn->step_cost = 0;
+    if (dn->filled < DYN_NOTCH_FFT_SIZE) {
+        dn->filled++;
+    } else {
+        if (dn->step == STEP_LOAD) {
+            dn->step_cost = load_axis(dn);
+        } else if (dn->step < STEP_PEAKS) {
+            fft_q15_stage(dn->re, dn->im, DYN_NOTCH_FFT_LOG2, dn->step - 1);
+            dn->step_cost = FFT_Q15_STAGE_MULTIPLIES(DYN_NOTCH_FFT_SIZE);
+        } else {
+            dn->step_cost = find_peaks(dn);
+            dn->spectra++;
+        }
+        if (++dn->step == DYN_NOTCH_STEPS_PER_AXIS) {
+            dn->step = STEP_LOAD;
+            dn->axis = (uint8_t)((dn->axis + 1) % 3);
+        }
+    }
+
+    for (int a = 0; a < 3; a++) {
+        for (int p = 0; p < DYN_NOTCH_PEAKS; p++) {
+            if (dn->peak_hz[a][p] > 0.0f) *rate[a] = biquad_apply(&dn->notch[a][p], *rate[a]);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+// flight-controller/src/core/dyn_notch.h
+#pragma once
+
+#include <stdint.h>
+#include "../include/types.h"
+#include "../utils/fixed_point.h"
+#include "../math/fft_q15.h"
+
+// Dynamic gyro notch (FC_DYN_NOTCH). A spectrum analyser keeps the last
+// DYN_NOTCH_FFT_SIZE gyro samples of each axis, transforms them with a
+// Hann-windowed Q15 FFT and tracks the strongest peaks between min_hz and
+// max_hz. A bank of biquad notches per axis follows the peaks.
+//
+// The analysis is spread over the loop: each dyn_notch_update() runs one
+// step of it, bounded by DYN_NOTCH_STEP_BUDGET multiplies, and one axis is
+// done every DYN_NOTCH_STEPS_PER_AXIS calls. Only the notches themselves
+// run on every sample.
+
+#define DYN_NOTCH_FFT_LOG2 6
+#define DYN_NOTCH_FFT_SIZE (1 << DYN_NOTCH_FFT_LOG2)
+#define DYN_NOTCH_PEAKS 2               // Notches per axis
+
+// Gyro rates are analysed as Q15 fractions of this many deg/s
+#define DYN_NOTCH_INPUT_RANGE 2000.0f
+
+// A peak must stand this many times above the mean power of the rest of
+// the band, in the spectrum averaged over the axis's recent transforms
+#define DYN_NOTCH_THRESHOLD 10.0f
+
+// Window and load, the FFT stages one per call, then the peak search
+#define DYN_NOTCH_STEPS_PER_AXIS (DYN_NOTCH_FFT_LOG2 + 2)
+
+// Most multiplies any dyn_notch_update() spends on the analysis: one FFT
+// stage. The peak search, with the band capped at 0.45 of the sample rate,
+// stays below it. The notches add five float multiplies per active filter,
+// and a retuned notch a sine and a cosine.
+#define DYN_NOTCH_STEP_BUDGET FFT_Q15_STAGE_MULTIPLIES(DYN_NOTCH_FFT_SIZE)
+
+// Second-order notch (RBJ cookbook), transposed direct form II
+typedef struct {
+    float b0, b1, b2;
+    float a1, a2;
+    float s1, s2;
+} biquad_t;
+
+// Sets the coefficients and keeps the state, so the notch can be moved
+// while it runs
+void biquad_notch_set(biquad_t* f, float center_hz, float q, float sample_hz);
+void biquad_reset(biquad_t* f);
+
+static inline float biquad_apply(biquad_t* f, float x) {
+    float y = f->b0 * x + f->s1;
+    f->s1 = f->b1 * x - f->a1 * y + f->s2;
+    f->s2 = f->b2 * x - f->a2 * y;
+    return y;
+}
+
+typedef struct {
+    // Analyser
+    q15_t history[3][DYN_NOTCH_FFT_SIZE];   // Ring of input samples per axis
+    uint16_t head;                          // Next slot to write
+    uint16_t filled;                        // Samples in the ring, up to N
+    q15_t re[DYN_NOTCH_FFT_SIZE];           // Transform of the current axis
+    q15_t im[DYN_NOTCH_FFT_SIZE];
+    int8_t shift;                           // Block scaling of re[], im[]
+    uint8_t axis;
+    uint8_t step;                           // 0 .. DYN_NOTCH_STEPS_PER_AXIS - 1
+    float spectrum[3][DYN_NOTCH_FFT_SIZE / 2 + 1];  // Smoothed power
+    uint32_t step_cost;                     // Multiplies in the last update
+    uint32_t spectra;                       // Transforms completed
+
+    // Tracker and filters; a peak_hz of 0 means the notch is off
+    float peak_hz[3][DYN_NOTCH_PEAKS];
+    biquad_t notch[3][DYN_NOTCH_PEAKS];
+
+    // Configuration
+    float dt;
+    float sample_hz;
+    float min_hz;
+    float max_hz;
+    float q;
+    uint16_t min_bin;
+    uint16_t max_bin;
+} dyn_notch_t;
+
+// Searches [min_hz, max_hz]; max_hz is capped at 0.45 of the sample rate
+// once that is known
+void dyn_notch_init(dyn_notch_t* dn, float min_hz, float max_hz, float q);
+
+// Feeds one sample of every axis (deg/s) and notches it in place. dt is the
+// sample period; a new one restarts the analysis.
+void dyn_notch_update(dyn_notch_t* dn, vector3_t* gyro, float dt);
@@ -1,92 +1,290 @@
 #include "flight_controller.h"
+#include "mixer.h"
 #include "drivers/mpu6050.h"
 #include "drivers/esc.h"
 #include "utils/logger.h"
+#include "utils/loop_profiler.h"
 #include "include/config.h"
-#include <stdlib.h>
+#include "utils/heap_guard.h"
+
+#if FC_STATIC_ALLOC
+static flight_stack_t flight_stack;
+#endif
 
 flight_controller_t* flight_controller_init(void) {
-    flight_controller_t* fc = malloc(sizeof(flight_controller_t));
-    if (fc == NULL) return NULL;
+#if FC_STATIC_ALLOC
+    return flight_controller_setup(&flight_stack);
+#else
+    flight_stack_t* stack = malloc(sizeof(flight_stack_t));
+    if (stack == NULL) return NULL;
+
+    flight_controller_t* fc = flight_controller_setup(stack);
+    if (fc == NULL) free(stack);
+    return fc;
+#endif
+}
+
+flight_controller_t* flight_controller_setup(flight_stack_t* stack) {
+    flight_controller_t* fc = &stack->fc;
 
     // Initialize IMU
     mpu6050_config_t imu_config = {
         .gyro_range = 1,        // ±500°/s
         .accel_range = 1,       // ±4g
         .dlpf_bandwidth = 2,    // 92Hz bandwidth
-        .sample_rate_div = 4    // 200Hz sample rate
+        // 1kHz / (1 + div): one data-ready pulse per sensor update, whatever
+        // the control rate; the control path averages the updates between
+        // its ticks
+        .sample_rate_div = (1000 / IMU_UPDATE_FREQ) - 1
     };
-    fc->imu = mpu6050_init(PIN_I2C_SDA, PIN_I2C_SCL, &imu_config);
-    if (fc->imu == NULL) {
-        free(fc);
-        return NULL;
-    }
+    fc->imu = mpu6050_setup(&stack->imu, PIN_I2C_SDA, PIN_I2C_SCL, &imu_config);
+    if (fc->imu == NULL) return NULL;
+    mpu6050_enable_data_ready_interrupt(fc->imu);
+
+    fc->attitude_estimator = &stack->estimator;
+    attitude_estimator_setup(fc->attitude_estimator);
+
+    // Outputs are ignored until esc_arm()
+    fc->esc = esc_setup(&stack->esc, &DEFAULT_ESC_CONFIG);
+    if (fc->esc == NULL) return NULL;
+    fc->current_mode = FLIGHT_MODE_DISARMED;
 
-    fc->attitude_estimator = attitude_estimator_init();
-    fc->pid_roll = pid_controller_init(PID_ROLL_KP, PID_ROLL_KI, PID_ROLL_KD);
-    fc->pid_pitch = pid_controller_init(PID_PITCH_KP, PID_PITCH_KI, PID_PITCH_KD);
-    fc->pid_yaw = pid_controller_init(PID_YAW_KP, PID_YAW_KI, PID_YAW_KD);
+    pid_axes_init(&fc->rate_pid, DT);
+    pid_axes_set_gains(&fc->rate_pid, PID_AXIS_ROLL, PID_ROLL_KP, PID_ROLL_KI, PID_ROLL_KD);
+    pid_axes_set_gains(&fc->rate_pid, PID_AXIS_PITCH, PID_PITCH_KP, PID_PITCH_KI, PID_PITCH_KD);
+    pid_axes_set_gains(&fc->rate_pid, PID_AXIS_YAW, PID_YAW_KP, PID_YAW_KI, PID_YAW_KD);
+    pid_axes_init(&fc->angle_pid, ANGLE_DT);
+    pid_axes_set_gains(&fc->angle_pid, PID_AXIS_ROLL, ANGLE_ROLL_KP, ANGLE_ROLL_KI, ANGLE_ROLL_KD);
+    pid_axes_set_gains(&fc->angle_pid, PID_AXIS_PITCH, ANGLE_PITCH_KP, ANGLE_PITCH_KI,
+                       ANGLE_PITCH_KD);
+    pid_axes_set_gains(&fc->angle_pid, PID_AXIS_YAW, ANGLE_YAW_KP, ANGLE_YAW_KI, ANGLE_YAW_KD);
+    for (int a = 0; a < PID_AXES; a++) {
+        pid_axes_set_limits(&fc->rate_pid, a, 1.0f, PID_RATE_INTEGRAL_LIMIT);
+        pid_axes_set_limits(&fc->angle_pid, a, MAX_RATE, MAX_ANGLE);
+    }
     
     // Initialize setpoint to zero
     fc->setpoint.roll = 0.0f;
     fc->setpoint.pitch = 0.0f;
     fc->setpoint.yaw = 0.0f;
     fc->setpoint.throttle = 0.0f;
+    fc->rate_setpoint = (vector3_t){ 0.0f, 0.0f, 0.0f };
+    fc->angle_countdown = 0;
+    fc->sample_seq = 0;
+    for (int i = 0; i < 4; i++) fc->motor_output[i] = 0.0f;
+    fc->attitude_control = ATTITUDE_CONTROL;
+    fc->setpoint_attitude = (attitude_t){ 0.0f, 0.0f, 0.0f };
+    fc->setpoint_quaternion = (quaternion_t){ 1.0f, 0.0f, 0.0f, 0.0f };
+#if FC_RPM_NOTCH
+    rpm_notch_init(&fc->rpm_notch, MOTOR_POLES, RPM_NOTCH_MIN_HZ, RPM_NOTCH_Q);
+#endif
+#if FC_DYN_NOTCH
+    dyn_notch_init(&fc->gyro_notch, DYN_NOTCH_MIN_HZ, DYN_NOTCH_MAX_HZ, DYN_NOTCH_Q);
+#endif
+    flight_controller_sync_fixed(fc);
     
     return fc;
 }
 
+void flight_controller_sync_fixed(flight_controller_t* fc) {
+#if FC_FIXED_POINT
+    fc->gyro_full_scale = mpu6050_gyro_full_scale(fc->imu);
+    attitude_estimator_q_init(&fc->estimator_q, fc->attitude_estimator, fc->gyro_full_scale);
+    for (int a = 0; a < PID_AXES; a++) {
+        pid_controller_t rate;
+        pid_axes_get(&fc->rate_pid, a, &rate);
+        pid_controller_q_init(&fc->pid_q[a], &rate, DT, PID_Q_RATE_ERROR_RANGE);
+    }
+#else
+    (void)fc;
+#endif
+}
+
+// Means of int16 counts stay in range
+static int16_t round_counts(float x) {
+    return (int16_t)(x >= 0.0f ? x + 0.5f : x - 0.5f);
+}
 
-struct flight_controller {
-    mpu6050_t* imu;
-    attitude_estimator_t* attitude_estimator;
-    pid_controller_t* pid_roll;
-    pid_controller_t* pid_pitch;
-    pid_controller_t* pid_yaw;
-    esc_controller_t* esc;
-    flight_mode_t current_mode;
-    setpoint_t setpoint;
-};
+void flight_controller_imu_step(flight_controller_t* fc) {
+    // Publish the burst that transferred since the previous call, which adds
+    // it to the oversampling sum, and queue the next one so the bus runs
+    // while the estimator and PIDs execute
+    mpu6050_read_async_poll(fc->imu);
+    mpu6050_read_async_start(fc->imu);
+}
 
+void flight_controller_sensor_step(flight_controller_t* fc, uint64_t timestamp_us, float dt,
+                                   attitude_sample_t* sample) {
+    vector3_t raw_accel, raw_gyro;
+    vector3_t gyro;
+#if FC_FIXED_POINT
+    vector3_q15_t accel_q, gyro_q;
+#else
+    vector3_t accel;
+#endif
 
-void flight_controller_update(flight_controller_t* fc) {
-    vector3_t accel, gyro;
-    mpu6050_read_scaled(fc->imu, &accel, &gyro);
+    // Take the mean of the updates summed since the previous call, this
+    // cycle's included. Fall back to a blocking read until the first burst
+    // has landed.
+    PROFILE_BEGIN(PROFILE_STAGE_IMU_READ);
+    flight_controller_imu_step(fc);
+    if (mpu6050_read_average(fc->imu, &raw_accel, &raw_gyro) < 0) {
+        mpu6050_read_raw(fc->imu, &raw_accel, &raw_gyro);
+    }
+    sample->raw_accel[0] = round_counts(raw_accel.x);
+    sample->raw_accel[1] = round_counts(raw_accel.y);
+    sample->raw_accel[2] = round_counts(raw_accel.z);
+    sample->raw_gyro[0] = round_counts(raw_gyro.x);
+    sample->raw_gyro[1] = round_counts(raw_gyro.y);
+    sample->raw_gyro[2] = round_counts(raw_gyro.z);
+#if FC_FIXED_POINT
+    mpu6050_scale_sample_q15(fc->imu, sample->raw_accel, sample->raw_gyro, &accel_q, &gyro_q);
+#else
+    mpu6050_scale_sample(fc->imu, &raw_accel, &raw_gyro, &accel, &gyro);
+#endif
+    PROFILE_END(PROFILE_STAGE_IMU_READ);
+
+#if FC_RPM_NOTCH || FC_DYN_NOTCH
+    PROFILE_BEGIN(PROFILE_STAGE_GYRO_FILTER);
+#if FC_RPM_NOTCH
+    rpm_notch_update(&fc->rpm_notch, &gyro, dt);
+#endif
+#if FC_DYN_NOTCH
+    dyn_notch_update(&fc->gyro_notch, &gyro, dt);
+#endif
+    PROFILE_END(PROFILE_STAGE_GYRO_FILTER);
+#endif
+
+    PROFILE_BEGIN(PROFILE_STAGE_ESTIMATOR);
+#if FC_FIXED_POINT
+    attitude_estimator_q_update(&fc->estimator_q, &accel_q, &gyro_q, q31_from_float(dt));
+    attitude_estimator_q_get_quaternion(&fc->estimator_q, &fc->attitude_estimator->quaternion);
+    gyro.x = q15_to_float(gyro_q.x) * fc->gyro_full_scale;
+    gyro.y = q15_to_float(gyro_q.y) * fc->gyro_full_scale;
+    gyro.z = q15_to_float(gyro_q.z) * fc->gyro_full_scale;
+#else
+    attitude_estimator_update(fc->attitude_estimator, &accel, &gyro, dt);
+#endif
+    PROFILE_END(PROFILE_STAGE_ESTIMATOR);
+
+    sample->timestamp_us = timestamp_us;
+    sample->seq = fc->sample_seq++;
+    sample->quaternion = fc->attitude_estimator->quaternion;
+    sample->gyro = gyro;
+}
 
-    attitude_estimator_update(fc->attitude_estimator, &accel, &gyro, DT);
-    attitude_t current_attitude = attitude_estimator_get_attitude(fc->attitude_estimator);
+// Per-axis error for the angle PIDs, degrees. Only the Euler mode pays for
+// the inverse trigonometry; telemetry converts the sample's quaternion
+// itself, at its own rate.
+static void attitude_error(flight_controller_t* fc, const quaternion_t* q, vector3_t* error) {
+    if (fc->attitude_control == ATTITUDE_CONTROL_QUATERNION) {
+        attitude_t* sp = &fc->setpoint_attitude;
+        if (sp->roll != fc->setpoint.roll || sp->pitch != fc->setpoint.pitch ||
+            sp->yaw != fc->setpoint.yaw) {
+            *sp = (attitude_t){ fc->setpoint.roll, fc->setpoint.pitch, fc->setpoint.yaw };
+            quaternion_from_attitude(&fc->setpoint_quaternion, sp);
+        }
+        quaternion_attitude_error(error, &fc->setpoint_quaternion, q);
+    } else {
+        attitude_t current = attitude_from_quaternion(q);
+        error->x = fc->setpoint.roll - current.roll;
+        error->y = fc->setpoint.pitch - current.pitch;
+        error->z = fc->setpoint.yaw - current.yaw;
+    }
+}
+
+#if FC_FIXED_POINT
+static q31_t rate_error_q(float error) {
+    return q31_from_float(error * (1.0f / PID_Q_RATE_ERROR_RANGE));
+}
+
+// Float views of the fixed-point PID terms, for the blackbox
+static void publish_pid_terms(pid_axes_t* pid, int axis, const pid_controller_q_t* q) {
+    pid->p_term[axis] = q15_to_float(q->p_term);
+    pid->i_term[axis] = q15_to_float(q->i_term);
+    pid->d_term[axis] = q15_to_float(q->d_term);
+}
+
+static void control_step_q(flight_controller_t* fc, const vector3_t* error) {
+    PROFILE_BEGIN(PROFILE_STAGE_RATE_PIDS);
+    q15_t roll_output = pid_controller_q_update(&fc->pid_q[0], rate_error_q(error->x));
+    q15_t pitch_output = pid_controller_q_update(&fc->pid_q[1], rate_error_q(error->y));
+    q15_t yaw_output = pid_controller_q_update(&fc->pid_q[2], rate_error_q(error->z));
+    PROFILE_END(PROFILE_STAGE_RATE_PIDS);
+
+    PROFILE_BEGIN(PROFILE_STAGE_MIXER);
+    q15_t motor[4];
+    mixer_quad_x_q15(q15_from_float(fc->setpoint.throttle), roll_output, pitch_output, yaw_output,
+                     motor);
+    esc_set_output_q15(fc->esc, motor);
+    PROFILE_END(PROFILE_STAGE_MIXER);
+
+    for (int i = 0; i < 4; i++) fc->motor_output[i] = q15_to_float(motor[i]);
+    for (int a = 0; a < PID_AXES; a++) publish_pid_terms(&fc->rate_pid, a, &fc->pid_q[a]);
+}
+#endif
 
-    float roll_output = pid_controller_update(fc->pid_roll, 
-                                            fc->setpoint.roll - current_attitude.roll,
-                                            DT);
+// Outer loop: attitude error to body rate setpoints
+static void angle_step(flight_controller_t* fc, const attitude_sample_t* sample) {
+    PROFILE_BEGIN(PROFILE_STAGE_EULER);
+    vector3_t error;
+    attitude_error(fc, &sample->quaternion, &error);
+    PROFILE_END(PROFILE_STAGE_EULER);
 
-    float pitch_output = pid_controller_update(fc->pid_pitch,
-                                             fc->setpoint.pitch - current_attitude.pitch,
-                                             DT);
+    PROFILE_BEGIN(PROFILE_STAGE_ANGLE_PIDS);
+    pid_axes_update(&fc->angle_pid, &error, &fc->rate_setpoint);
+    PROFILE_END(PROFILE_STAGE_ANGLE_PIDS);
+}
+
+void flight_controller_control_step(flight_controller_t* fc, const attitude_sample_t* sample) {
+    if (fc->angle_countdown == 0) {
+        angle_step(fc, sample);
+        fc->angle_countdown = ANGLE_LOOP_DECIMATION;
+    }
+    fc->angle_countdown--;
+
+    // Inner loop, straight from the gyro
+    vector3_t error = {
+        fc->rate_setpoint.x - sample->gyro.x,
+        fc->rate_setpoint.y - sample->gyro.y,
+        fc->rate_setpoint.z - sample->gyro.z
+    };
 
-    float yaw_output = pid_controller_update(fc->pid_yaw,
-                                           fc->setpoint.yaw - current_attitude.yaw,
-                                           DT);
+#if FC_FIXED_POINT
+    control_step_q(fc, &error);
+#else
+    PROFILE_BEGIN(PROFILE_STAGE_RATE_PIDS);
+    vector3_t output;
+    pid_axes_update(&fc->rate_pid, &error, &output);
+    PROFILE_END(PROFILE_STAGE_RATE_PIDS);
 
     // Calculate motor outputs
-    float m1 = fc->setpoint.throttle + roll_output + pitch_output + yaw_output;
-    float m2 = fc->setpoint.throttle - roll_output + pitch_output - yaw_output;
-    float m3 = fc->setpoint.throttle - roll_output - pitch_output + yaw_output;
-    float m4 = fc->setpoint.throttle + roll_output - pitch_output - yaw_output;
+    PROFILE_BEGIN(PROFILE_STAGE_MIXER);
+    mixer_quad_x(fc->setpoint.throttle, output.x, output.y, output.z, fc->motor_output);
+    esc_set_output(fc->esc, fc->motor_output[0], fc->motor_output[1],
+                   fc->motor_output[2], fc->motor_output[3]);
+    PROFILE_END(PROFILE_STAGE_MIXER);
 
-    esc_set_output(fc->esc, m1, m2, m3, m4);
+#if FC_RPM_NOTCH
+    // The replies to the frames before this one; the sensor step picks them
+    // up on its next sample
+    uint32_t erpm[4];
+    if (esc_get_erpm(fc->esc, erpm)) rpm_notch_set_erpm(&fc->rpm_notch, erpm);
+#endif
+#endif
+}
+
+void flight_controller_update(flight_controller_t* fc) {
+    attitude_sample_t sample;
+    flight_controller_sensor_step(fc, 0, DT, &sample);
+    flight_controller_control_step(fc, &sample);
 }
 
 void flight_controller_cleanup(flight_controller_t* fc) {
-    if (fc == NULL) return;
-    
-    // Clean up components
-    if (fc->pid_roll) free(fc->pid_roll);
-    if (fc->pid_pitch) free(fc->pid_pitch);
-    if (fc->pid_yaw) free(fc->pid_yaw);
-    if (fc->attitude_estimator) free(fc->attitude_estimator);
-    if (fc->imu) free(fc->imu);
-    if (fc->esc) free(fc->esc);
-    
+#if FC_STATIC_ALLOC
+    (void)fc;
+#else
+    // fc is the first member of its flight_stack_t
     free(fc);
+#endif
 }
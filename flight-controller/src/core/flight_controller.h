@@ -2,8 +2,11 @@
 #pragma once
 
 #include "../include/types.h"
+#include "../include/config.h"
 #include "attitude_estimator.h"
 #include "pid_controller.h"
+#include "dyn_notch.h"
+#include "rpm_notch.h"
 #include "../drivers/mpu6050.h"
 #include "../drivers/esc.h"
 
@@ -14,17 +17,94 @@ typedef struct {
     float throttle;
 } setpoint_t;
 
+// Estimator output handed from the sensor stage to the control stage
+typedef struct {
+    uint64_t timestamp_us;
+    uint32_t seq;
+    quaternion_t quaternion;
+    vector3_t gyro;              // Scaled rates fed to the estimator, deg/s
+    int16_t raw_accel[3];        // Sensor counts, for the blackbox
+    int16_t raw_gyro[3];
+} attitude_sample_t;
+
 typedef struct {
     mpu6050_t* imu;
     attitude_estimator_t* attitude_estimator;
-    pid_controller_t* pid_roll;
-    pid_controller_t* pid_pitch;
-    pid_controller_t* pid_yaw;
+    pid_axes_t rate_pid;            // Rate loop: deg/s error to mixer command
+    pid_axes_t angle_pid;           // Angle loop: degrees to a rate setpoint
     esc_controller_t* esc;
     flight_mode_t current_mode;
     setpoint_t setpoint;
+    vector3_t rate_setpoint;        // Angle loop output, body deg/s
+    uint8_t angle_countdown;        // Control steps until the angle loop runs
+    uint32_t sample_seq;
+    float motor_output[4];      // Last mixer output, for telemetry
+    attitude_control_t attitude_control;    // ATTITUDE_CONTROL from config.h
+    // setpoint's roll, pitch and yaw as a quaternion, converted again only
+    // when they change
+    attitude_t setpoint_attitude;
+    quaternion_t setpoint_quaternion;
+#if FC_RPM_NOTCH
+    rpm_notch_t rpm_notch;
+#endif
+#if FC_DYN_NOTCH
+    dyn_notch_t gyro_notch;
+#endif
+#if FC_FIXED_POINT
+    // The loop runs on these; the float estimator and rate_pid above hold
+    // the gains and a float view of the state for telemetry and the blackbox
+    attitude_estimator_q_t estimator_q;
+    pid_controller_q_t pid_q[3];    // Roll, pitch, yaw rate
+    float gyro_full_scale;          // deg/s of a Q15 1.0
+#endif
 } flight_controller_t;
 
+// Everything the flight loop owns, in one block: the controller first, then
+// the objects its pointers lead to. flight_controller_init() allocates one,
+// or with FC_STATIC_ALLOC uses one reserved at link time, so the whole
+// stack shows up in the firmware's .bss.
+typedef struct {
+    flight_controller_t fc;
+    attitude_estimator_t estimator;
+    mpu6050_storage_t imu;
+    esc_storage_t esc;
+} flight_stack_t;
+
 flight_controller_t* flight_controller_init(void);
+
+// Brings up the stack in place; NULL if the IMU's bus or the ESC outputs
+// can't be set up. The returned controller is &stack->fc and needs no
+// cleanup.
+flight_controller_t* flight_controller_setup(flight_stack_t* stack);
 void flight_controller_update(flight_controller_t* fc);
+
+// The two halves of flight_controller_update(), for running IMU acquisition
+// and estimation separately (e.g. on the other core) from the control path.
+// The sensor step estimates from the mean of every IMU update that landed
+// since it last ran, notched at the motors' harmonics when FC_RPM_NOTCH and
+// then at the strongest peak when FC_DYN_NOTCH; dt must not change from
+// call to call, or the notches start over.
+void flight_controller_sensor_step(flight_controller_t* fc, uint64_t timestamp_us, float dt,
+                                   attitude_sample_t* sample);
+
+// The control step is a cascade. Every call runs the rate loop on the
+// sample's gyro rates, with dt = DT, and drives the mixer and ESCs, taking
+// the motors' eRPM for the RPM notches when FC_RPM_NOTCH. Every
+// ANGLE_LOOP_DECIMATION-th call, the first one included, the angle loop
+// first turns the attitude error into new rate setpoints, with dt =
+// ANGLE_DT.
+void flight_controller_control_step(flight_controller_t* fc, const attitude_sample_t* sample);
+
+// Collect one IMU update for the next sensor step. When the sensor step runs
+// slower than the IMU, call this on the IMU ticks in between (see
+// IMU_OVERSAMPLE in config.h).
+void flight_controller_imu_step(flight_controller_t* fc);
+
+// Releases a controller from flight_controller_init(); nothing to do with
+// FC_STATIC_ALLOC
 void flight_controller_cleanup(flight_controller_t* fc);
+
+// Reload the fixed-point state from the float estimator and rate PIDs,
+// after changing their gains or resetting them. Does nothing without
+// FC_FIXED_POINT.
+void flight_controller_sync_fixed(flight_controller_t* fc);
@@ -0,0 +1,62 @@
+#include "loop_trigger.h"
+
+// Wait 1.5 periods for a data-ready edge before assuming the IMU interrupt
+// has stopped and switching to timer ticks
+#define TIMEOUT_PERIODS_NUM 3
+#define TIMEOUT_PERIODS_DEN 2
+
+void loop_trigger_init(loop_trigger_t* trigger, const loop_trigger_port_t* port, uint32_t period_us) {
+    trigger->port = *port;
+    trigger->period_us = period_us;
+    trigger->timeout_us = period_us * TIMEOUT_PERIODS_NUM / TIMEOUT_PERIODS_DEN;
+
+    trigger->irq_count = 0;
+    trigger->irq_time_us = 0;
+    trigger->irq_seen = 0;
+    trigger->last_tick_us = port->now_us(port->ctx);
+    trigger->fallback_active = false;
+
+    trigger->irq_ticks = 0;
+    trigger->fallback_ticks = 0;
+    trigger->fallback_entries = 0;
+    trigger->missed_irqs = 0;
+}
+
+void loop_trigger_signal(loop_trigger_t* trigger, uint64_t timestamp_us) {
+    trigger->irq_time_us = timestamp_us;
+    trigger->irq_count++;
+}
+
+loop_trigger_source_t loop_trigger_wait(loop_trigger_t* trigger) {
+    const loop_trigger_port_t* port = &trigger->port;
+
+    while (1) {
+        uint32_t count = trigger->irq_count;
+        if (count != trigger->irq_seen) {
+            trigger->missed_irqs += count - trigger->irq_seen - 1;
+            trigger->irq_seen = count;
+            trigger->last_tick_us = trigger->irq_time_us;
+            trigger->fallback_active = false;
+            trigger->irq_ticks++;
+            return LOOP_TRIGGER_DATA_READY;
+        }
+
+        uint64_t deadline = trigger->last_tick_us +
+                            (trigger->fallback_active ? trigger->period_us : trigger->timeout_us);
+        uint64_t now = port->now_us(port->ctx);
+
+        if (now >= deadline) {
+            if (!trigger->fallback_active) {
+                trigger->fallback_active = true;
+                trigger->fallback_entries++;
+            }
+            // Keep fallback ticks on their own grid, but do not try to catch
+            // up if the caller overran by more than a whole period
+            trigger->last_tick_us = (now - deadline >= trigger->period_us) ? now : deadline;
+            trigger->fallback_ticks++;
+            return LOOP_TRIGGER_FALLBACK;
+        }
+
+        port->wait_until(port->ctx, deadline);
+    }
+}
@@ -0,0 +1,51 @@
+// flight-controller/src/core/loop_trigger.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    LOOP_TRIGGER_DATA_READY,  // Woken by the IMU data-ready interrupt
+    LOOP_TRIGGER_FALLBACK     // Interrupt went silent, woken by the timer
+} loop_trigger_source_t;
+
+// Platform hooks so the trigger logic can run against a fake clock
+typedef struct {
+    uint64_t (*now_us)(void* ctx);
+    // Sleep until loop_trigger_signal() is called or the deadline passes.
+    // Spurious early returns are allowed.
+    void (*wait_until)(void* ctx, uint64_t deadline_us);
+    void* ctx;
+} loop_trigger_port_t;
+
+typedef struct {
+    loop_trigger_port_t port;
+    uint32_t period_us;
+    uint32_t timeout_us;          // Silence tolerated before falling back
+
+    // Written by the interrupt handler only
+    volatile uint32_t irq_count;
+    volatile uint64_t irq_time_us;
+
+    uint32_t irq_seen;
+    uint64_t last_tick_us;
+    bool fallback_active;
+
+    // Statistics
+    uint32_t irq_ticks;
+    uint32_t fallback_ticks;
+    uint32_t fallback_entries;
+    uint32_t missed_irqs;         // Interrupts that arrived while a tick was pending
+} loop_trigger_t;
+
+void loop_trigger_init(loop_trigger_t* trigger, const loop_trigger_port_t* port, uint32_t period_us);
+
+// Called from the data-ready interrupt handler
+void loop_trigger_signal(loop_trigger_t* trigger, uint64_t timestamp_us);
+
+// Block until the next control tick is due and report what caused it
+loop_trigger_source_t loop_trigger_wait(loop_trigger_t* trigger);
+
+// HAL port: rising-edge GPIO interrupt on int_pin, sleeping in
+// hal_event_wait_until() (WFE on the RP2040)
+void loop_trigger_hal_init(loop_trigger_t* trigger, uint8_t int_pin, uint32_t period_us);
@@ -0,0 +1,17 @@
+#include "mixer.h"
+#include "../utils/heap_guard.h"
+
+void mixer_quad_x(float throttle, float roll, float pitch, float yaw, float motor[4]) {
+    motor[0] = throttle + roll + pitch + yaw;
+    motor[1] = throttle - roll + pitch - yaw;
+    motor[2] = throttle - roll - pitch + yaw;
+    motor[3] = throttle + roll - pitch - yaw;
+}
+
+void mixer_quad_x_q15(q15_t throttle, q15_t roll, q15_t pitch, q15_t yaw, q15_t motor[4]) {
+    int32_t t = throttle;
+    motor[0] = q15_sat(t + roll + pitch + yaw);
+    motor[1] = q15_sat(t - roll + pitch - yaw);
+    motor[2] = q15_sat(t - roll - pitch + yaw);
+    motor[3] = q15_sat(t + roll - pitch - yaw);
+}
@@ -0,0 +1,13 @@
+// flight-controller/src/core/mixer.h
+#pragma once
+
+#include "../utils/fixed_point.h"
+
+// Quad-X mix of the throttle and the three axis commands into motor outputs,
+// in PIN_MOTOR1..PIN_MOTOR4 order. Outputs are not clamped; esc_set_output()
+// limits them to the ESC range.
+void mixer_quad_x(float throttle, float roll, float pitch, float yaw, float motor[4]);
+
+// The same mix in Q15 with saturating sums. Outputs past +/-1 clamp there,
+// which esc_set_output_q15() would have clamped anyway.
+void mixer_quad_x_q15(q15_t throttle, q15_t roll, q15_t pitch, q15_t yaw, q15_t motor[4]);
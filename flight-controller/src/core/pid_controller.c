@@ -1,13 +1,20 @@
 #include "pid_controller.h"
-#include <stdlib.h>
 #include <math.h>
+#include "../utils/heap_guard.h"
 
 #define DERIVATIVE_FILTER_ALPHA 0.1f  // Lower = more filtering
 
+#if !FC_STATIC_ALLOC
 pid_controller_t* pid_controller_init(float kp, float ki, float kd) {
     pid_controller_t* pid = malloc(sizeof(pid_controller_t));
     if (pid == NULL) return NULL;
-    
+
+    pid_controller_setup(pid, kp, ki, kd);
+    return pid;
+}
+#endif
+
+void pid_controller_setup(pid_controller_t* pid, float kp, float ki, float kd) {
     // Initialize gains
     pid->kp = kp;
     pid->ki = ki;
@@ -24,8 +31,9 @@ pid_controller_t* pid_controller_init(float kp, float ki, float kd) {
     pid->derivative_lpf = 0.0f;
     pid->derivative_filter_alpha = DERIVATIVE_FILTER_ALPHA;
     pid->prev_time = 0.0f;
-    
-    return pid;
+    pid->p_term = 0.0f;
+    pid->i_term = 0.0f;
+    pid->d_term = 0.0f;
 }
 
 void pid_controller_reset(pid_controller_t* pid) {
@@ -33,6 +41,9 @@ void pid_controller_reset(pid_controller_t* pid) {
     pid->prev_error = 0.0f;
     pid->prev_measurement = 0.0f;
     pid->derivative_lpf = 0.0f;
+    pid->p_term = 0.0f;
+    pid->i_term = 0.0f;
+    pid->d_term = 0.0f;
 }
 
 static float constrain(float value, float min, float max) {
@@ -47,10 +58,10 @@ float pid_controller_update(pid_controller_t* pid, float error, float dt) {
     // Calculate P term
     float p_term = pid->kp * error;
     
-    // Calculate I term with anti-windup
-    pid->integral += (error * dt);
-    pid->integral = constrain(pid->integral, -pid->integral_limit, pid->integral_limit);
-    float i_term = pid->ki * pid->integral;
+    // Calculate I term; the step is kept below unless it winds up
+    float integral = constrain(pid->integral + error * dt, -pid->integral_limit,
+                               pid->integral_limit);
+    float i_term = pid->ki * integral;
     
     // Calculate D term with derivative on error
     float error_derivative = (error - pid->prev_error) / dt;
@@ -60,6 +71,10 @@ float pid_controller_update(pid_controller_t* pid, float error, float dt) {
                          ((1.0f - pid->derivative_filter_alpha) * pid->derivative_lpf);
     
     float d_term = pid->kd * pid->derivative_lpf;
+
+    pid->p_term = p_term;
+    pid->i_term = i_term;
+    pid->d_term = d_term;
     
     // Calculate total output
     float output = p_term + i_term + d_term;
@@ -73,7 +88,7 @@ float pid_controller_update(pid_controller_t* pid, float error, float dt) {
         (output <= -pid->output_limit && error < 0.0f)) {
         // Don't update integral
     } else {
-        pid->integral += error * dt;
+        pid->integral = integral;
     }
     
     // Store error for next iteration
@@ -91,10 +106,10 @@ float pid_controller_update_dom(pid_controller_t* pid, float setpoint, float mea
     // P term
     float p_term = pid->kp * error;
     
-    // I term with anti-windup
-    pid->integral += (error * dt);
-    pid->integral = constrain(pid->integral, -pid->integral_limit, pid->integral_limit);
-    float i_term = pid->ki * pid->integral;
+    // I term; the step is kept below unless it winds up
+    float integral = constrain(pid->integral + error * dt, -pid->integral_limit,
+                               pid->integral_limit);
+    float i_term = pid->ki * integral;
     
     // D term with derivative on measurement
     float measurement_derivative = (measurement - pid->prev_measurement) / dt;
@@ -105,6 +120,10 @@ float pid_controller_update_dom(pid_controller_t* pid, float setpoint, float mea
     
     // Note the negative sign because we want derivative of error
     float d_term = -pid->kd * pid->derivative_lpf;
+
+    pid->p_term = p_term;
+    pid->i_term = i_term;
+    pid->d_term = d_term;
     
     // Calculate total output
     float output = p_term + i_term + d_term;
@@ -117,7 +136,7 @@ float pid_controller_update_dom(pid_controller_t* pid, float setpoint, float mea
         (output <= -pid->output_limit && error < 0.0f)) {
         // Don't update integral
     } else {
-        pid->integral += error * dt;
+        pid->integral = integral;
     }
     
     // Store measurement for next iteration
@@ -138,4 +157,208 @@ void pid_controller_set_gains(pid_controller_t* pid, float kp, float ki, float k
 void pid_controller_set_limits(pid_controller_t* pid, float output_limit, float integral_limit) {
     pid->output_limit = output_limit;
     pid->integral_limit = integral_limit;
-}
\ No newline at end of file
+}
+
+static void pid_axes_derive(pid_axes_t* pid, int axis) {
+    float alpha = pid->derivative_filter_alpha[axis];
+    pid->ki_dt[axis] = pid->ki[axis] * pid->dt;
+    pid->kd_alpha_dt[axis] = pid->kd[axis] * alpha / pid->dt;
+    pid->derivative_keep[axis] = 1.0f - alpha;
+    pid->i_limit[axis] = fabsf(pid->ki[axis]) * pid->integral_limit[axis];
+}
+
+bool pid_axes_init(pid_axes_t* pid, float dt) {
+    if (dt <= 0.0f) return false;
+    pid->dt = dt;
+    for (int a = 0; a < PID_AXES; a++) {
+        pid->kp[a] = 0.0f;
+        pid->ki[a] = 0.0f;
+        pid->kd[a] = 0.0f;
+        pid->output_limit[a] = 1.0f;
+        pid->integral_limit[a] = 0.5f;
+        pid->derivative_filter_alpha[a] = DERIVATIVE_FILTER_ALPHA;
+        pid_axes_derive(pid, a);
+    }
+    pid_axes_reset(pid);
+    return true;
+}
+
+bool pid_axes_set_dt(pid_axes_t* pid, float dt) {
+    if (dt <= 0.0f) return false;
+    pid->dt = dt;
+    for (int a = 0; a < PID_AXES; a++) pid_axes_derive(pid, a);
+    return true;
+}
+
+static void pid_axes_reset_axis(pid_axes_t* pid, int axis) {
+    pid->integral[axis] = 0.0f;
+    pid->derivative[axis] = 0.0f;
+    pid->prev_error[axis] = 0.0f;
+    pid->prev_measurement[axis] = 0.0f;
+    pid->p_term[axis] = 0.0f;
+    pid->i_term[axis] = 0.0f;
+    pid->d_term[axis] = 0.0f;
+}
+
+void pid_axes_set_gains(pid_axes_t* pid, int axis, float kp, float ki, float kd) {
+    pid->kp[axis] = kp;
+    pid->ki[axis] = ki;
+    pid->kd[axis] = kd;
+    pid_axes_derive(pid, axis);
+    pid_axes_reset_axis(pid, axis);
+}
+
+void pid_axes_set_limits(pid_axes_t* pid, int axis, float output_limit, float integral_limit) {
+    pid->output_limit[axis] = output_limit;
+    pid->integral_limit[axis] = integral_limit;
+    pid_axes_derive(pid, axis);
+}
+
+void pid_axes_reset(pid_axes_t* pid) {
+    for (int a = 0; a < PID_AXES; a++) pid_axes_reset_axis(pid, a);
+}
+
+// One axis of either update. change is how much the derivative's input
+// moved since the last step: the error, or minus the measurement.
+static inline float pid_axes_step(pid_axes_t* pid, int a, float error, float change) {
+    float p_term = pid->kp[a] * error;
+    float i_term = constrain(pid->integral[a] + pid->ki_dt[a] * error, -pid->i_limit[a],
+                             pid->i_limit[a]);
+    float d_term = pid->kd_alpha_dt[a] * change + pid->derivative_keep[a] * pid->derivative[a];
+    float limit = pid->output_limit[a];
+    float output = constrain(p_term + i_term + d_term, -limit, limit);
+
+    pid->p_term[a] = p_term;
+    pid->i_term[a] = i_term;
+    pid->d_term[a] = d_term;
+    pid->derivative[a] = d_term;
+
+    // Anti-windup, as in pid_controller_update()
+    if (!((output >= limit && error > 0.0f) || (output <= -limit && error < 0.0f))) {
+        pid->integral[a] = i_term;
+    }
+    return output;
+}
+
+void pid_axes_update(pid_axes_t* pid, const vector3_t* error, vector3_t* output) {
+    const float e[PID_AXES] = { error->x, error->y, error->z };
+    float out[PID_AXES];
+
+    for (int a = 0; a < PID_AXES; a++) {
+        out[a] = pid_axes_step(pid, a, e[a], e[a] - pid->prev_error[a]);
+        pid->prev_error[a] = e[a];
+    }
+    output->x = out[PID_AXIS_ROLL];
+    output->y = out[PID_AXIS_PITCH];
+    output->z = out[PID_AXIS_YAW];
+}
+
+void pid_axes_update_dom(pid_axes_t* pid, const vector3_t* setpoint,
+                         const vector3_t* measurement, vector3_t* output) {
+    const float sp[PID_AXES] = { setpoint->x, setpoint->y, setpoint->z };
+    const float m[PID_AXES] = { measurement->x, measurement->y, measurement->z };
+    float out[PID_AXES];
+
+    for (int a = 0; a < PID_AXES; a++) {
+        out[a] = pid_axes_step(pid, a, sp[a] - m[a], pid->prev_measurement[a] - m[a]);
+        pid->prev_measurement[a] = m[a];
+    }
+    output->x = out[PID_AXIS_ROLL];
+    output->y = out[PID_AXIS_PITCH];
+    output->z = out[PID_AXIS_YAW];
+}
+
+void pid_axes_get(const pid_axes_t* pid, int axis, pid_controller_t* out) {
+    float ki = pid->ki[axis], kd = pid->kd[axis];
+
+    out->kp = pid->kp[axis];
+    out->ki = ki;
+    out->kd = kd;
+    out->output_limit = pid->output_limit[axis];
+    out->integral_limit = pid->integral_limit[axis];
+    out->integral = ki != 0.0f ? pid->integral[axis] / ki : 0.0f;
+    out->prev_error = pid->prev_error[axis];
+    out->prev_measurement = pid->prev_measurement[axis];
+    out->derivative_lpf = kd != 0.0f ? pid->derivative[axis] / kd : 0.0f;
+    out->derivative_filter_alpha = pid->derivative_filter_alpha[axis];
+    out->prev_time = 0.0f;
+    out->p_term = pid->p_term[axis];
+    out->i_term = pid->i_term[axis];
+    out->d_term = pid->d_term[axis];
+}
+
+// Q16.16, saturating at +/-32768
+static int32_t q16_from_float(float x) {
+    return q31_from_float(x * (1.0f / 32768.0f));
+}
+
+// Q7.24, saturating at +/-128
+static int32_t q24_from_float(float x) {
+    return q31_from_float(x * (1.0f / 128.0f));
+}
+
+void pid_controller_q_init(pid_controller_q_t* q, const pid_controller_t* pid, float dt,
+                           float range) {
+    q->kp = q16_from_float(pid->kp * range);
+    q->ki = q16_from_float(pid->ki * range);
+    q->kd = q16_from_float(pid->kd * range);
+    q->dt = q31_from_float(dt);
+    q->inv_dt = q16_from_float(1.0f / dt);
+    q->output_limit = q15_from_float(pid->output_limit);
+    q->integral_limit = q31_from_float(pid->integral_limit / range);
+    q->integral = q31_from_float(pid->integral / range);
+    q->prev_error = q31_from_float(pid->prev_error / range);
+    q->derivative_lpf = q24_from_float(pid->derivative_lpf / range);
+    q->derivative_filter_alpha = q15_from_float(pid->derivative_filter_alpha);
+    q->p_term = q15_from_float(pid->p_term);
+    q->i_term = q15_from_float(pid->i_term);
+    q->d_term = q15_from_float(pid->d_term);
+}
+
+static q31_t constrain_q31(q31_t value, q31_t limit) {
+    if (value < -limit) return -limit;
+    if (value > limit) return limit;
+    return value;
+}
+
+// pid_controller_update() in integers. Against the float controller fed
+// the same errors the output stays within 2^-13 (4 counts of Q15) while
+// unsaturated; the terms saturate at +/-1, where the float ones do not.
+// The derivative is kept in Q7.24 so that its rounding, 2^-24 of the
+// error range per second each step, stays well under one output count for
+// any gain below the range. It saturates at 128 times the range per
+// second: a 46 degree step in one 2 ms loop with PID_Q_ERROR_RANGE, or a
+// 256 deg/s step in one 1 ms loop with PID_Q_RATE_ERROR_RANGE.
+q15_t pid_controller_q_update(pid_controller_q_t* pid, q31_t error) {
+    int32_t p_term = q31_sat(((int64_t)pid->kp * error + ((int64_t)1 << 31)) >> 32);
+
+    q31_t integral_step = q31_sat(((int64_t)error * pid->dt + (1 << 30)) >> 31);
+    q31_t integral = constrain_q31(q31_add(pid->integral, integral_step), pid->integral_limit);
+    int32_t i_term = q31_sat(((int64_t)pid->ki * integral + ((int64_t)1 << 31)) >> 32);
+
+    int64_t error_change = (int64_t)error - pid->prev_error;
+    int32_t derivative = q31_sat((error_change * pid->inv_dt + (1 << 22)) >> 23);
+    int64_t lpf = pid->derivative_lpf;
+    pid->derivative_lpf = q31_sat(lpf + ((pid->derivative_filter_alpha * (derivative - lpf) +
+                                          (1 << 14)) >> 15));
+    int32_t d_term = q31_sat(((int64_t)pid->kd * pid->derivative_lpf + (1 << 24)) >> 25);
+
+    pid->p_term = q15_sat(p_term);
+    pid->i_term = q15_sat(i_term);
+    pid->d_term = q15_sat(d_term);
+
+    int64_t sum = (int64_t)p_term + i_term + d_term;
+    q15_t output = (q15_t)(sum > pid->output_limit ? pid->output_limit :
+                           sum < -pid->output_limit ? -pid->output_limit : sum);
+
+    // Same anti-windup as the float controller
+    if ((output >= pid->output_limit && error > 0) ||
+        (output <= -pid->output_limit && error < 0)) {
+        // Don't update integral
+    } else {
+        pid->integral = integral;
+    }
+
+    pid->prev_error = error;
+    return output;
+}
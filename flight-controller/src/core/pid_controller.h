@@ -1,5 +1,10 @@
 #pragma once
 
+#include <stdbool.h>
+#include "../include/types.h"
+#include "../include/config.h"
+#include "../utils/fixed_point.h"
+
 typedef struct {
     // PID gains
     float kp;
@@ -21,11 +26,117 @@ typedef struct {
     
     // Delta time
     float prev_time;
+
+    // Contributions from the last update, before output limiting
+    float p_term;
+    float i_term;
+    float d_term;
 } pid_controller_t;
 
+#if !FC_STATIC_ALLOC
 pid_controller_t* pid_controller_init(float kp, float ki, float kd);
+#endif
+// pid_controller_init() in place
+void pid_controller_setup(pid_controller_t* pid, float kp, float ki, float kd);
 void pid_controller_reset(pid_controller_t* pid);
 float pid_controller_update(pid_controller_t* pid, float error, float dt);
+
+// Same controller with the derivative taken on the measurement instead of
+// the error, so a step in the setpoint gives no derivative kick
+float pid_controller_update_dom(pid_controller_t* pid, float setpoint, float measurement,
+                                float dt);
 void pid_controller_set_gains(pid_controller_t* pid, float kp, float ki, float kd);
 void pid_controller_set_limits(pid_controller_t* pid, float output_limit, float integral_limit);
 
+// Roll, pitch and yaw controllers in one struct of arrays, updated
+// together in one pass. Step for step the same controller as
+// pid_controller_update(), with the per-step constants (ki * dt, the
+// derivative filter's kd * alpha / dt, the integral limit in output units)
+// worked out when the gains, limits or dt change rather than on every
+// update. The integral and the filtered derivative are kept in output
+// units, already multiplied by their gains. Lives inside its owner; there
+// is nothing to free.
+enum {
+    PID_AXIS_ROLL,
+    PID_AXIS_PITCH,
+    PID_AXIS_YAW,
+    PID_AXES
+};
+
+typedef struct {
+    // Per-step coefficients
+    float kp[PID_AXES];
+    float ki_dt[PID_AXES];
+    float kd_alpha_dt[PID_AXES];    // Derivative filter input gain
+    float derivative_keep[PID_AXES];    // 1 - alpha
+    float i_limit[PID_AXES];
+    float output_limit[PID_AXES];
+
+    // State
+    float integral[PID_AXES];       // ki * integral of the error
+    float derivative[PID_AXES];     // kd * filtered derivative
+    float prev_error[PID_AXES];
+    float prev_measurement[PID_AXES];
+
+    // Contributions from the last update, before output limiting
+    float p_term[PID_AXES];
+    float i_term[PID_AXES];
+    float d_term[PID_AXES];
+
+    // As set, for working out the coefficients again
+    float ki[PID_AXES];
+    float kd[PID_AXES];
+    float integral_limit[PID_AXES];
+    float derivative_filter_alpha[PID_AXES];
+    float dt;
+} pid_axes_t;
+
+// Zero gains and the limits of pid_controller_init(). Fails for dt <= 0.
+bool pid_axes_init(pid_axes_t* pid, float dt);
+bool pid_axes_set_dt(pid_axes_t* pid, float dt);
+// Resets the axis, as pid_controller_set_gains() does
+void pid_axes_set_gains(pid_axes_t* pid, int axis, float kp, float ki, float kd);
+void pid_axes_set_limits(pid_axes_t* pid, int axis, float output_limit, float integral_limit);
+void pid_axes_reset(pid_axes_t* pid);
+
+// pid_controller_update() and pid_controller_update_dom() on all three axes
+void pid_axes_update(pid_axes_t* pid, const vector3_t* error, vector3_t* output);
+void pid_axes_update_dom(pid_axes_t* pid, const vector3_t* setpoint,
+                         const vector3_t* measurement, vector3_t* output);
+
+// One axis as a scalar controller with the same gains, limits and state
+void pid_axes_get(const pid_axes_t* pid, int axis, pid_controller_t* out);
+
+
+// Errors handed to the fixed-point controller are Q1.31 fractions of the
+// range it was set up with; larger errors saturate. Ranges for angle errors
+// in degrees and for rate errors in deg/s:
+#define PID_Q_ERROR_RANGE 180.0f
+#define PID_Q_RATE_ERROR_RANGE 2000.0f
+
+// Fixed-point pid_controller_update() for the FC_FIXED_POINT flight path,
+// step for step the same controller. The error is Q1.31 of the error
+// range, the output and the three terms Q15. The loop period and the range
+// are fixed when the controller is set up. See pid_controller.c for the
+// error bounds.
+typedef struct {
+    int32_t kp;                 // Q16.16, gains times the error range
+    int32_t ki;
+    int32_t kd;
+    q31_t dt;                   // Seconds
+    int32_t inv_dt;             // Q16.16, 1/s
+    q15_t output_limit;
+    q31_t integral_limit;       // Error range * s
+    q31_t integral;
+    q31_t prev_error;
+    int32_t derivative_lpf;     // Q7.24 error per second
+    q15_t derivative_filter_alpha;
+    q15_t p_term;
+    q15_t i_term;
+    q15_t d_term;
+} pid_controller_q_t;
+
+// Takes the gains, limits and state of a float controller
+void pid_controller_q_init(pid_controller_q_t* q, const pid_controller_t* pid, float dt,
+                           float error_range);
+q15_t pid_controller_q_update(pid_controller_q_t* q, q31_t error);
@@ -0,0 +1,112 @@
+// src/core/rpm_notch.c
+#include "rpm_notch.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../utils/heap_guard.h"
+
+#define PI_F 3.14159265f
+#define MAX_HZ_OF_RATE 0.45f    // Of the sample rate, as for the dynamic notch
+
+void rpm_notch_init(rpm_notch_t* rn, uint8_t motor_poles, float min_hz, float q) {
+    memset(rn, 0, sizeof(*rn));
+    // An electrical turn is one pole pair
+    rn->erpm_to_hz = 2.0f / ((float)motor_poles * 60.0f);
+    rn->min_hz = min_hz;
+    rn->q = q;
+}
+
+void rpm_notch_set_erpm(rpm_notch_t* rn, const uint32_t erpm[RPM_NOTCH_MOTORS]) {
+    for (int m = 0; m < RPM_NOTCH_MOTORS; m++) rn->motor_hz[m] = (float)erpm[m] * rn->erpm_to_hz;
+}
+
+// RBJ cookbook notch, as biquad_notch_set(), from cos(w0) and sin(w0)
+static void set_coefficients(rpm_notch_filter_t* f, float q) {
+    float alpha = f->sin_w0 / (2.0f * q);
+    float a0_inv = 1.0f / (1.0f + alpha);
+    f->b0 = a0_inv;
+    f->b1 = -2.0f * f->cos_w0 * a0_inv;
+    f->a2 = (1.0f - alpha) * a0_inv;
+}
+
+static void retune_exact(rpm_notch_filter_t* f, float w, float q) {
+    // Coming on: nothing of an older tone in the state
+    if (f->center == 0.0f) {
+        for (int a = 0; a < 3; a++) {
+            f->s1[a] = 0.0f;
+            f->s2[a] = 0.0f;
+        }
+    }
+    f->center = w;
+    f->cos_w0 = cosf(w);
+    f->sin_w0 = sinf(w);
+    f->rotations = 0;
+    set_coefficients(f, q);
+}
+
+// Turns the notch by d: cos(d) and sin(d) as short series, then the pair
+// pulled back onto the unit circle
+static void rotate(rpm_notch_filter_t* f, float d, float q) {
+    float d2 = d * d;
+    float cd = 1.0f - d2 * (0.5f - d2 * (1.0f / 24.0f));
+    float sd = d * (1.0f - d2 * (1.0f / 6.0f - d2 * (1.0f / 120.0f)));
+    float c = f->cos_w0 * cd - f->sin_w0 * sd;
+    float s = f->sin_w0 * cd + f->cos_w0 * sd;
+    float k = 1.5f - 0.5f * (c * c + s * s);
+    f->cos_w0 = c * k;
+    f->sin_w0 = s * k;
+    f->rotations++;
+    set_coefficients(f, q);
+}
+
+void rpm_notch_update(rpm_notch_t* rn, vector3_t* gyro, float dt) {
+    float* rate[3] = { &gyro->x, &gyro->y, &gyro->z };
+    bool exact_done = false;
+
+    if (dt != rn->dt) {
+        rn->dt = dt;
+        for (int n = 0; n < RPM_NOTCH_COUNT; n++) rn->notch[n].center = 0.0f;
+    }
+    const float hz_to_rad = 2.0f * PI_F * dt;
+    const float max_hz = MAX_HZ_OF_RATE / dt;
+
+    // From the one first in line for cosf() and sinf(), so each gets its turn
+    const int first = rn->next;
+    for (int i = 0; i < RPM_NOTCH_COUNT; i++) {
+        int n = (first + i) % RPM_NOTCH_COUNT;
+        rpm_notch_filter_t* f = &rn->notch[n];
+        float hz = rn->motor_hz[n / RPM_NOTCH_HARMONICS] * (float)(n % RPM_NOTCH_HARMONICS + 1);
+        if (hz < rn->min_hz || hz > max_hz) {
+            f->center = 0.0f;
+            continue;
+        }
+
+        float w = hz * hz_to_rad;
+        bool exact = f->center == 0.0f || f->rotations >= RPM_NOTCH_RESYNC_STEPS;
+        if (exact && !exact_done) {
+            retune_exact(f, w, rn->q);
+            rn->exact_retunes++;
+            rn->next = (uint8_t)((n + 1) % RPM_NOTCH_COUNT);
+            exact_done = true;
+        } else if (f->center != 0.0f && w != f->center) {
+            float d = w - f->center;
+            if (d > RPM_NOTCH_MAX_STEP) d = RPM_NOTCH_MAX_STEP;
+            if (d < -RPM_NOTCH_MAX_STEP) d = -RPM_NOTCH_MAX_STEP;
+            rotate(f, d, rn->q);
+            f->center = d == w - f->center ? w : f->center + d;
+            rn->rotations++;
+        }
+    }
+
+    for (int n = 0; n < RPM_NOTCH_COUNT; n++) {
+        rpm_notch_filter_t* f = &rn->notch[n];
+        if (f->center == 0.0f) continue;
+        for (int a = 0; a < 3; a++) {
+            float x = *rate[a];
+            float y = f->b0 * x + f->s1[a];
+            f->s1[a] = f->b1 * (x - y) + f->s2[a];
+            f->s2[a] = f->b0 * x - f->a2 * y;
+            *rate[a] = y;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+// flight-controller/src/core/rpm_notch.h
+#pragma once
+
+#include <stdint.h>
+#include "../include/config.h"
+#include "../include/types.h"
+
+// RPM notch filters (FC_RPM_NOTCH). Each motor shakes the frame at its
+// rotation rate and the harmonics of it. With the rates the ESCs report
+// over bidirectional DShot, a notch sits on each of the first
+// RPM_NOTCH_HARMONICS harmonics of every motor, on all three gyro axes.
+//
+// A notch's coefficients follow from the cosine and sine of its center and
+// are shared by the three axes. When its target moves, the notch is turned
+// toward it by at most RPM_NOTCH_MAX_STEP radians per sample, rotating the
+// last cosine and sine by the step with a handful of multiplies. cosf()
+// and sinf() only run when a notch comes on and after every
+// RPM_NOTCH_RESYNC_STEPS rotations, for one notch per update at most.
+
+#define RPM_NOTCH_MOTORS 4
+#define RPM_NOTCH_COUNT (RPM_NOTCH_MOTORS * RPM_NOTCH_HARMONICS)
+#define RPM_NOTCH_MAX_STEP 0.2f         // Radians per sample
+#define RPM_NOTCH_RESYNC_STEPS 256
+
+typedef struct {
+    float b0, b1, a2;           // A notch has b2 = b0 and a1 = b1
+    float s1[3], s2[3];         // Per axis, transposed direct form II
+    float center;               // Radians per sample; 0 when off
+    float cos_w0, sin_w0;
+    uint16_t rotations;         // Since cosf() and sinf() last ran
+} rpm_notch_filter_t;
+
+typedef struct {
+    rpm_notch_filter_t notch[RPM_NOTCH_COUNT];  // Harmonic h of motor m at m * H + h
+
+    // Rotor speeds. The control step writes them and the sensor step reads
+    // them, maybe on the other core; each is one word, so a reader never
+    // sees half of one.
+    float motor_hz[RPM_NOTCH_MOTORS];
+
+    // Configuration
+    float erpm_to_hz;
+    float min_hz;
+    float q;
+    float dt;
+
+    uint8_t next;               // First in line for cosf() and sinf()
+    uint32_t exact_retunes;     // Retunes with cosf() and sinf() so far
+    uint32_t rotations;         // Incremental retunes so far
+} rpm_notch_t;
+
+// Notches below min_hz, or above 0.45 of the sample rate, are off
+void rpm_notch_init(rpm_notch_t* rn, uint8_t motor_poles, float min_hz, float q);
+
+// Rotor speeds from the ESCs' electrical RPM
+void rpm_notch_set_erpm(rpm_notch_t* rn, const uint32_t erpm[RPM_NOTCH_MOTORS]);
+
+// Moves the notches toward their harmonics and notches one sample of every
+// axis (deg/s) in place. dt is the sample period; a new one turns every
+// notch off, to come back on at the new rate.
+void rpm_notch_update(rpm_notch_t* rn, vector3_t* gyro, float dt);
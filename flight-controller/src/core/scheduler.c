@@ -0,0 +1,91 @@
+#include "scheduler.h"
+#include <string.h>
+
+void scheduler_init(scheduler_t* sched, uint32_t base_freq_hz,
+                    scheduler_clock_fn clock, void* clock_ctx) {
+    memset(sched, 0, sizeof(scheduler_t));
+    sched->clock = clock;
+    sched->clock_ctx = clock_ctx;
+    sched->base_period_us = 1000000 / base_freq_hz;
+    sched->start_us = clock(clock_ctx);
+}
+
+int scheduler_add_task(scheduler_t* sched, const char* name, uint32_t rate_hz,
+                       scheduler_task_fn fn, void* ctx) {
+    if (sched->task_count >= SCHEDULER_MAX_TASKS || rate_hz == 0) return -1;
+
+    uint32_t base_freq_hz = 1000000 / sched->base_period_us;
+    if (rate_hz > base_freq_hz || base_freq_hz % rate_hz != 0) return -1;
+
+    scheduler_task_t* task = &sched->tasks[sched->task_count];
+    memset(task, 0, sizeof(scheduler_task_t));
+    task->name = name;
+    task->fn = fn;
+    task->ctx = ctx;
+    task->divider = base_freq_hz / rate_hz;
+    task->period_us = task->divider * sched->base_period_us;
+
+    // First deadline is the next multiple of the task period on the grid
+    uint64_t now = sched->clock(sched->clock_ctx);
+    uint64_t elapsed = now > sched->start_us ? now - sched->start_us : 0;
+    uint64_t periods = (elapsed + task->period_us - 1) / task->period_us;
+    task->next_deadline_us = sched->start_us + periods * task->period_us;
+
+    return sched->task_count++;
+}
+
+int scheduler_poll(scheduler_t* sched) {
+    int ran = 0;
+
+    for (uint8_t i = 0; i < sched->task_count; i++) {
+        scheduler_task_t* task = &sched->tasks[i];
+
+        // Each task reads the clock itself so time spent in earlier tasks
+        // shows up as jitter in later ones
+        uint64_t now = sched->clock(sched->clock_ctx);
+        if (now < task->next_deadline_us) continue;
+
+        uint32_t jitter = (uint32_t)(now - task->next_deadline_us);
+        task->fn(task->ctx, now);
+
+        task->runs++;
+        task->total_jitter_us += jitter;
+        if (jitter > task->max_jitter_us) task->max_jitter_us = jitter;
+
+        task->next_deadline_us += task->period_us;
+        if (now >= task->next_deadline_us) {
+            // Skip whole periods we can no longer meet instead of bursting
+            uint64_t missed = (now - task->next_deadline_us) / task->period_us + 1;
+            task->overruns += (uint32_t)missed;
+            task->next_deadline_us += missed * task->period_us;
+        }
+        ran++;
+    }
+
+    return ran;
+}
+
+uint64_t scheduler_next_deadline(const scheduler_t* sched) {
+    uint64_t next = UINT64_MAX;
+    for (uint8_t i = 0; i < sched->task_count; i++) {
+        if (sched->tasks[i].next_deadline_us < next) {
+            next = sched->tasks[i].next_deadline_us;
+        }
+    }
+    return next;
+}
+
+uint32_t scheduler_mean_jitter_us(const scheduler_task_t* task) {
+    if (task->runs == 0) return 0;
+    return (uint32_t)(task->total_jitter_us / task->runs);
+}
+
+void scheduler_reset_stats(scheduler_t* sched) {
+    for (uint8_t i = 0; i < sched->task_count; i++) {
+        scheduler_task_t* task = &sched->tasks[i];
+        task->runs = 0;
+        task->overruns = 0;
+        task->max_jitter_us = 0;
+        task->total_jitter_us = 0;
+    }
+}
@@ -0,0 +1,53 @@
+// flight-controller/src/core/scheduler.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS 8
+
+typedef void (*scheduler_task_fn)(void* ctx, uint64_t now_us);
+typedef uint64_t (*scheduler_clock_fn)(void* ctx);
+
+// Tasks run every `divider` base ticks. Deadlines are absolute points on
+// the base tick grid, so a late start never shifts later deadlines.
+typedef struct {
+    const char* name;
+    scheduler_task_fn fn;
+    void* ctx;
+    uint32_t divider;
+    uint32_t period_us;
+    uint64_t next_deadline_us;
+
+    // Statistics (jitter is start time minus deadline)
+    uint32_t runs;
+    uint32_t overruns;          // Deadlines skipped because the task fell a whole period behind
+    uint32_t max_jitter_us;
+    uint64_t total_jitter_us;
+} scheduler_task_t;
+
+typedef struct {
+    scheduler_clock_fn clock;
+    void* clock_ctx;
+    uint32_t base_period_us;
+    uint64_t start_us;
+    scheduler_task_t tasks[SCHEDULER_MAX_TASKS];
+    uint8_t task_count;
+} scheduler_t;
+
+void scheduler_init(scheduler_t* sched, uint32_t base_freq_hz,
+                    scheduler_clock_fn clock, void* clock_ctx);
+
+// Tasks run in registration order when several are due on the same tick.
+// rate_hz must divide the base frequency; returns the task id or -1.
+int scheduler_add_task(scheduler_t* sched, const char* name, uint32_t rate_hz,
+                       scheduler_task_fn fn, void* ctx);
+
+// Run every task whose deadline has passed; returns how many ran
+int scheduler_poll(scheduler_t* sched);
+
+// Earliest pending deadline, for sleeping between polls
+uint64_t scheduler_next_deadline(const scheduler_t* sched);
+
+uint32_t scheduler_mean_jitter_us(const scheduler_task_t* task);
+void scheduler_reset_stats(scheduler_t* sched);
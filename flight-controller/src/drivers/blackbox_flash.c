@@ -0,0 +1,62 @@
+#include "utils/blackbox.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include <string.h>
+
+// Erasing or programming takes the flash out of XIP mode. flash_safe_execute()
+// parks the other core in RAM and masks interrupts for the duration, so every
+// call stalls the sensor core: one page program is roughly 0.5 ms, one sector
+// erase 40-50 ms (W25Q16JV datasheet: 0.4/3 ms and 45/400 ms typical/max).
+// Erases therefore only run from blackbox_prepare() before arming; main.c
+// measures each page program and reports the longest in the blackbox
+// telemetry record.
+#define BLACKBOX_FLASH_TIMEOUT_MS 100
+
+typedef struct {
+    uint32_t base;              // Offset of the log region from the start of flash
+    uint32_t offset;
+    uint32_t len;
+    const uint8_t* data;
+} flash_op_t;
+
+static flash_op_t op;
+
+static void do_erase(void* param) {
+    const flash_op_t* o = param;
+    flash_range_erase(o->base + o->offset, o->len);
+}
+
+static void do_program(void* param) {
+    const flash_op_t* o = param;
+    flash_range_program(o->base + o->offset, o->data, BLACKBOX_PAGE_SIZE);
+}
+
+static int flash_erase(void* ctx, uint32_t offset, uint32_t len) {
+    op.base = (uint32_t)(uintptr_t)ctx;
+    op.offset = offset;
+    op.len = len;
+    return flash_safe_execute(do_erase, &op, BLACKBOX_FLASH_TIMEOUT_MS) == PICO_OK ? 0 : -1;
+}
+
+static int flash_program_page(void* ctx, uint32_t offset, const uint8_t* data) {
+    op.base = (uint32_t)(uintptr_t)ctx;
+    op.offset = offset;
+    op.data = data;
+    return flash_safe_execute(do_program, &op, BLACKBOX_FLASH_TIMEOUT_MS) == PICO_OK ? 0 : -1;
+}
+
+static void flash_read(void* ctx, uint32_t offset, uint8_t* dst, size_t len) {
+    const uint8_t* src = (const uint8_t*)(uintptr_t)(XIP_BASE + (uint32_t)(uintptr_t)ctx + offset);
+    memcpy(dst, src, len);
+}
+
+void blackbox_flash_init(blackbox_t* bb, uint32_t flash_offset, uint32_t size, uint32_t decimation) {
+    const blackbox_storage_t storage = {
+        .erase = flash_erase,
+        .program_page = flash_program_page,
+        .read = flash_read,
+        .size = size,
+        .ctx = (void*)(uintptr_t)flash_offset
+    };
+    blackbox_init(bb, &storage, decimation);
+}
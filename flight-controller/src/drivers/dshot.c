@@ -0,0 +1,266 @@
+// src/drivers/dshot.c
+#include "dshot.h"
+#include "../utils/heap_guard.h"
+
+// PIO instruction encoding (RP2040 datasheet, 3.4)
+#define PIO_OP_JMP  0x0000u
+#define PIO_OP_IN   0x4000u
+#define PIO_OP_MOV  0xA000u
+#define PIO_OP_OUT  0x6000u
+#define PIO_OP_SET  0xE000u
+#define PIO_DELAY(n) ((uint16_t)((n) << 8))
+#define PIO_DEST_PINS (0u << 5)
+#define PIO_DEST_X    (1u << 5)
+#define PIO_DEST_Y    (2u << 5)
+#define PIO_DEST_PINDIRS (4u << 5)
+#define PIO_SRC_PINS  0u
+#define PIO_SRC_X     1u
+#define PIO_MOV_INVERT (1u << 3)
+#define PIO_JMP_Y_DEC (4u << 5)
+
+// One bit of all four motors per pass. The state machine stalls in the
+// first instruction, with the pins low, until the FIFO has a frame.
+//
+//   .wrap_target
+//       out x, 4            ; next bit of each motor
+//       set pins, 0b1111 [2] ; every pin high for 3 clocks
+//       mov pins, x [2]     ; low for 3 clocks unless the bit is 1
+//       set pins, 0         ; low; with the next out, 2 clocks
+//   .wrap
+const uint16_t dshot_pio_program[DSHOT_PIO_PROGRAM_LENGTH] = {
+    PIO_OP_OUT | PIO_DEST_X | 4,
+    PIO_OP_SET | PIO_DELAY(2) | PIO_DEST_PINS | 0xF,
+    PIO_OP_MOV | PIO_DELAY(2) | PIO_DEST_PINS | PIO_SRC_X,
+    PIO_OP_SET | PIO_DEST_PINS | 0,
+};
+
+// Bidirectional: the frame inverted, then the capture. The pins idle high
+// and driven, and the state machine stalls in the first out.
+//
+//   .wrap_target
+//       set y, 15            ; 16 bits
+//   bit:
+//       out x, 4             ; next bit of each motor
+//       set pins, 0 [5]      ; every pin low for 6 clocks
+//       mov pins, ~x [5]     ; low for 6 more where the bit is 1
+//       set pins, 0b1111 [1] ; high; with the jmp and the next out, 4 clocks
+//       jmp y--, bit
+//       out y, 32            ; samples to take, less one
+//       set pindirs, 0       ; release the pins to the ESCs
+//   sample:
+//       in pins, 4 [2]       ; all four pins every 4 clocks
+//       jmp y--, sample
+//       set pindirs, 0b1111  ; drive them again, high
+//   .wrap
+const uint16_t dshot_bidir_pio_program[DSHOT_BIDIR_PIO_PROGRAM_LENGTH] = {
+    PIO_OP_SET | PIO_DEST_Y | 15,
+    PIO_OP_OUT | PIO_DEST_X | 4,
+    PIO_OP_SET | PIO_DELAY(5) | PIO_DEST_PINS | 0,
+    PIO_OP_MOV | PIO_DELAY(5) | PIO_DEST_PINS | PIO_MOV_INVERT | PIO_SRC_X,
+    PIO_OP_SET | PIO_DELAY(1) | PIO_DEST_PINS | 0xF,
+    PIO_OP_JMP | PIO_JMP_Y_DEC | 1,
+    PIO_OP_OUT | PIO_DEST_Y | 0,
+    PIO_OP_SET | PIO_DEST_PINDIRS | 0,
+    PIO_OP_IN | PIO_DELAY(2) | PIO_SRC_PINS | 4,
+    PIO_OP_JMP | PIO_JMP_Y_DEC | 8,
+    PIO_OP_SET | PIO_DEST_PINDIRS | 0xF,
+};
+
+// GCR code of each nibble, and the nibble of each 5-bit code (0xFF: none)
+static const uint8_t gcr_code[16] = {
+    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17,
+    0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F,
+};
+static const uint8_t gcr_nibble[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x09, 0x0A, 0x0B, 0xFF, 0x0D, 0x0E, 0x0F,
+    0xFF, 0xFF, 0x02, 0x03, 0xFF, 0x05, 0x06, 0x07,
+    0xFF, 0x00, 0x08, 0x01, 0xFF, 0x04, 0x0C, 0xFF,
+};
+
+#define ERPM_STOPPED 0xFFFu
+#define REPLY_WINDOW_SAMPLES 96 // From the start bit's capture word: 30 reply bits
+#define US_PER_MINUTE 60000000u
+
+float dshot_pio_clock_div(uint32_t sys_hz, uint32_t bit_rate) {
+    return (float)sys_hz / ((float)bit_rate * DSHOT_PIO_TICKS_PER_BIT);
+}
+
+float dshot_bidir_pio_clock_div(uint32_t sys_hz, uint32_t bit_rate) {
+    return (float)sys_hz / ((float)bit_rate * DSHOT_BIDIR_PIO_TICKS_PER_BIT);
+}
+
+uint16_t dshot_throttle_value(float throttle) {
+    if (throttle <= 0.0f) return DSHOT_THROTTLE_MIN;
+    if (throttle >= 1.0f) return DSHOT_THROTTLE_MAX;
+    return (uint16_t)(DSHOT_THROTTLE_MIN +
+                      throttle * (DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN) + 0.5f);
+}
+
+uint16_t dshot_throttle_q15_value(q15_t throttle) {
+    const uint32_t span = DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN;
+    if (throttle <= 0) return DSHOT_THROTTLE_MIN;
+    if (throttle == Q15_MAX) return DSHOT_THROTTLE_MAX;
+    return (uint16_t)(DSHOT_THROTTLE_MIN + ((span * (uint32_t)throttle + (1u << 14)) >> 15));
+}
+
+uint16_t dshot_frame(uint16_t value, bool telemetry) {
+    uint16_t v = (uint16_t)(((value & 0x7FFu) << 1) | (telemetry ? 1u : 0u));
+    uint16_t crc = (v ^ (v >> 4) ^ (v >> 8)) & 0xFu;
+    return (uint16_t)((v << 4) | crc);
+}
+
+uint16_t dshot_bidir_frame(uint16_t value, bool telemetry) {
+    return (uint16_t)(dshot_frame(value, telemetry) ^ 0xFu);
+}
+
+// Bit i of a byte to bit 4i of a word
+static uint32_t spread_nibbles(uint32_t x) {
+    x = (x | (x << 12)) & 0x000F000Fu;
+    x = (x | (x << 6)) & 0x03030303u;
+    x = (x | (x << 3)) & 0x11111111u;
+    return x;
+}
+
+void dshot_pack(const uint16_t frame[DSHOT_MOTORS], uint32_t words[DSHOT_PACKED_WORDS]) {
+    uint32_t high = 0, low = 0;
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        high |= spread_nibbles(frame[m] >> 8) << m;
+        low |= spread_nibbles(frame[m] & 0xFFu) << m;
+    }
+    words[0] = high;
+    words[1] = low;
+}
+
+// Bit 4i of a word to bit i of a byte, undoing spread_nibbles()
+static uint32_t gather_nibbles(uint32_t x) {
+    x &= 0x11111111u;
+    x = (x | (x >> 3)) & 0x03030303u;
+    x = (x | (x >> 6)) & 0x000F000Fu;
+    x = (x | (x >> 12)) & 0xFFu;
+    return x;
+}
+
+static uint32_t stream_level(const uint32_t* stream, int sample) {
+    return (stream[sample >> 5] >> (31 - (sample & 31))) & 1u;
+}
+
+// Samples from sample on at level, up to end
+static int run_length(const uint32_t* stream, int sample, uint32_t level, int end) {
+    int run = 0;
+    while (sample < end) {
+        uint32_t x = stream[sample >> 5] << (sample & 31);
+        int left = 32 - (sample & 31);
+        if (left > end - sample) left = end - sample;
+        if (level) x = ~x;
+        int n = x ? __builtin_clz(x) : 32;
+        if (n >= left) n = left;
+        run += n;
+        sample += n;
+        if (n < left) break;
+    }
+    return run;
+}
+
+dshot_telemetry_status_t dshot_capture_levels(const uint32_t capture[DSHOT_TELEMETRY_WORDS],
+                                              int motor, uint32_t* levels) {
+    const uint32_t idle = 0x11111111u << motor;
+    uint32_t stream[REPLY_WINDOW_SAMPLES / 32] = { 0 };
+    int bits = 0;
+    uint32_t out = 0;
+
+    // Idle words skipped eight samples at a time; from the one with the
+    // start bit, the motor's samples one bit each, the first at the top
+    int first = 0;
+    while (first < DSHOT_TELEMETRY_WORDS && (capture[first] & idle) == idle) first++;
+    if (first == DSHOT_TELEMETRY_WORDS) return DSHOT_TELEMETRY_NO_REPLY;
+    int words = DSHOT_TELEMETRY_WORDS - first;
+    if (words > REPLY_WINDOW_SAMPLES / 8) words = REPLY_WINDOW_SAMPLES / 8;
+    for (int w = 0; w < words; w++) {
+        stream[w >> 2] |= gather_nibbles(capture[first + w] >> motor) << (24 - 8 * (w & 3));
+    }
+    const int end = 8 * words;
+    int sample = run_length(stream, 0, 1u, end);
+
+    // Each run of one level is a whole number of reply bits, 3.2 samples
+    // each; GCR allows no more than three in a row
+    while (bits < DSHOT_TELEMETRY_BITS) {
+        uint32_t level = stream_level(stream, sample);
+        int run = run_length(stream, sample, level, end);
+        sample += run;
+        int n = (run * 5 * DSHOT_TELEMETRY_SAMPLE_TICKS + 2 * DSHOT_BIDIR_PIO_TICKS_PER_BIT) /
+                (4 * DSHOT_BIDIR_PIO_TICKS_PER_BIT);
+        if (sample == end) {
+            // Back to idle, or cut off by the end of the window or capture
+            if (!level) return DSHOT_TELEMETRY_BAD_CODE;
+            n = DSHOT_TELEMETRY_BITS - bits;
+        }
+        if (n == 0 || n > 3) {
+            if (!level || bits + n < DSHOT_TELEMETRY_BITS) return DSHOT_TELEMETRY_BAD_CODE;
+        }
+        if (n > DSHOT_TELEMETRY_BITS - bits) n = DSHOT_TELEMETRY_BITS - bits;
+        out = (out << n) | (level ? (1u << n) - 1u : 0u);
+        bits += n;
+    }
+    *levels = out;
+    return DSHOT_TELEMETRY_OK;
+}
+
+dshot_telemetry_status_t dshot_gcr_decode(uint32_t levels, uint16_t* value) {
+    uint32_t gcr = (levels ^ (levels >> 1)) & 0xFFFFFu;
+    uint32_t frame = 0;
+    for (int shift = 15; shift >= 0; shift -= 5) {
+        uint8_t nibble = gcr_nibble[(gcr >> shift) & 0x1Fu];
+        if (nibble == 0xFF) return DSHOT_TELEMETRY_BAD_CODE;
+        frame = (frame << 4) | nibble;
+    }
+    uint32_t crc = frame ^ (frame >> 8);
+    crc ^= crc >> 4;
+    if ((crc & 0xFu) != 0xFu) return DSHOT_TELEMETRY_BAD_CRC;
+    *value = (uint16_t)(frame >> 4);
+    return DSHOT_TELEMETRY_OK;
+}
+
+uint32_t dshot_erpm(uint16_t value) {
+    uint32_t period_us = (uint32_t)(value & 0x1FFu) << (value >> 9);
+    if (value == ERPM_STOPPED || period_us == 0) return 0;
+    return (US_PER_MINUTE + period_us / 2) / period_us;
+}
+
+dshot_telemetry_status_t dshot_telemetry_decode(const uint32_t capture[DSHOT_TELEMETRY_WORDS],
+                                                int motor, uint32_t* erpm) {
+    uint32_t levels;
+    uint16_t value;
+    dshot_telemetry_status_t status = dshot_capture_levels(capture, motor, &levels);
+    if (status == DSHOT_TELEMETRY_OK) status = dshot_gcr_decode(levels, &value);
+    if (status == DSHOT_TELEMETRY_OK) *erpm = dshot_erpm(value);
+    return status;
+}
+
+uint16_t dshot_erpm_value(uint32_t erpm) {
+    if (erpm == 0) return ERPM_STOPPED;
+    uint32_t period_us = (US_PER_MINUTE + erpm / 2) / erpm;
+    uint32_t exponent = 0;
+    while (period_us > 0x1FFu) {
+        period_us >>= 1;
+        exponent++;
+    }
+    if (exponent > 7) return ERPM_STOPPED;
+    return (uint16_t)((exponent << 9) | period_us);
+}
+
+uint32_t dshot_gcr_encode(uint16_t value) {
+    uint32_t v = value & 0xFFFu;
+    uint32_t frame = (v << 4) | (~(v ^ (v >> 4) ^ (v >> 8)) & 0xFu);
+    uint32_t gcr = 0;
+    for (int shift = 12; shift >= 0; shift -= 4) gcr = (gcr << 5) | gcr_code[(frame >> shift) & 0xFu];
+
+    // Start low, then a change of level for every 1
+    uint32_t level = 0;
+    uint32_t levels = 0;
+    for (int bit = 19; bit >= 0; bit--) {
+        level ^= (gcr >> bit) & 1u;
+        levels |= level << bit;
+    }
+    return levels;
+}
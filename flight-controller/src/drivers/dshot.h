@@ -0,0 +1,116 @@
+// flight-controller/src/drivers/dshot.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../utils/fixed_point.h"
+
+// DShot digital ESC frames. A frame is 16 bits, MSB first: an 11-bit value,
+// the telemetry request bit and a 4-bit CRC. Values 1..47 are commands,
+// 48..2047 throttle; 0 stops the motor.
+//
+// The four motors are sent in parallel by one PIO state machine on four
+// consecutive pins. dshot_pack() interleaves their frames into
+// DSHOT_PACKED_WORDS words, which DMA feeds to the state machine.
+
+#define DSHOT_MOTORS 4
+#define DSHOT_PACKED_WORDS 2
+
+#define DSHOT_CMD_MOTOR_STOP 0
+#define DSHOT_THROTTLE_MIN 48
+#define DSHOT_THROTTLE_MAX 2047
+
+// Bit rates of DShot150/300/600
+#define DSHOT150_BIT_RATE 150000u
+#define DSHOT300_BIT_RATE 300000u
+#define DSHOT600_BIT_RATE 600000u
+
+// Each bit is DSHOT_PIO_TICKS_PER_BIT state machine clocks: high for 3, the
+// bit for 3, low for 2. A 0 is high for 3/8 of the bit, a 1 for 6/8.
+#define DSHOT_PIO_TICKS_PER_BIT 8
+#define DSHOT_PIO_T0H_TICKS 3
+#define DSHOT_PIO_T1H_TICKS 6
+
+// The program, assembled (see dshot.c). Wraps from its last instruction to
+// its first; the out pins and the set pins are both the four motor pins,
+// the OSR shifts left with autopull at 32 bits.
+#define DSHOT_PIO_PROGRAM_LENGTH 4
+#define DSHOT_PIO_WRAP_TARGET 0
+#define DSHOT_PIO_WRAP 3
+extern const uint16_t dshot_pio_program[DSHOT_PIO_PROGRAM_LENGTH];
+
+// State machine clock divider for bit_rate from a sys_hz system clock
+float dshot_pio_clock_div(uint32_t sys_hz, uint32_t bit_rate);
+
+// Throttle value for 0..1 (clamped): DSHOT_THROTTLE_MIN to _MAX
+uint16_t dshot_throttle_value(float throttle);
+uint16_t dshot_throttle_q15_value(q15_t throttle);
+
+// 16-bit frame of an 11-bit value
+uint16_t dshot_frame(uint16_t value, bool telemetry);
+
+// Interleaves one frame per motor: each 4-bit group, from the top of
+// words[0], is one bit of all four frames, motor 1 in its lowest bit
+void dshot_pack(const uint16_t frame[DSHOT_MOTORS], uint32_t words[DSHOT_PACKED_WORDS]);
+
+// Bidirectional DShot (ESC_DSHOT_BIDIR). The line idles high, each bit is
+// a low pulse and the frame's CRC is inverted. After each frame the ESCs
+// answer on the same pins: about 30 us later, each sends its eRPM as 21
+// bits at 5/4 of the bit rate. The reply's 16-bit frame (a 12-bit period,
+// then a CRC) is GCR-coded into 20 bits, and those are NRZI-coded onto the
+// line after a low start bit: a 1 is a change of level.
+//
+// The bidirectional program sends the frame with 16 clocks per bit, then
+// releases the pins and samples all four every DSHOT_TELEMETRY_SAMPLE_TICKS
+// clocks, DSHOT_TELEMETRY_SAMPLES times: 3.2 samples per reply bit. The
+// samples are pushed to the RX FIFO eight to a word, first in the top
+// nibble, motor 1 in each nibble's lowest bit. The number of samples less
+// one is the third word of every send, after the two packed frame words.
+#define DSHOT_BIDIR_PIO_TICKS_PER_BIT 16
+#define DSHOT_BIDIR_PIO_T0L_TICKS 6
+#define DSHOT_BIDIR_PIO_T1L_TICKS 12
+#define DSHOT_BIDIR_PIO_PROGRAM_LENGTH 11
+#define DSHOT_BIDIR_PIO_WRAP_TARGET 0
+#define DSHOT_BIDIR_PIO_WRAP 10
+extern const uint16_t dshot_bidir_pio_program[DSHOT_BIDIR_PIO_PROGRAM_LENGTH];
+
+#define DSHOT_BIDIR_WORDS (DSHOT_PACKED_WORDS + 1)
+#define DSHOT_TELEMETRY_SAMPLE_TICKS 4
+#define DSHOT_TELEMETRY_SAMPLES 256
+#define DSHOT_TELEMETRY_WORDS (DSHOT_TELEMETRY_SAMPLES * DSHOT_MOTORS / 32)
+#define DSHOT_TELEMETRY_BITS 21
+#define DSHOT_TELEMETRY_TURNAROUND_US 30    // Frame end to reply, nominal
+
+float dshot_bidir_pio_clock_div(uint32_t sys_hz, uint32_t bit_rate);
+
+// dshot_frame() with the inverted CRC of bidirectional DShot
+uint16_t dshot_bidir_frame(uint16_t value, bool telemetry);
+
+typedef enum {
+    DSHOT_TELEMETRY_OK,
+    DSHOT_TELEMETRY_NO_REPLY,   // The pin stayed high
+    DSHOT_TELEMETRY_BAD_CODE,   // A level held too long or not a GCR code
+    DSHOT_TELEMETRY_BAD_CRC,
+} dshot_telemetry_status_t;
+
+// One motor's reply from a capture: the 21 line levels from the start bit,
+// the first in bit 20. Levels after the reply's last edge are the idle high.
+dshot_telemetry_status_t dshot_capture_levels(const uint32_t capture[DSHOT_TELEMETRY_WORDS],
+                                              int motor, uint32_t* levels);
+
+// The 12-bit value of 21 line levels: NRZI, GCR and CRC checked. The value
+// is a period in us, a 9-bit mantissa shifted left by the top 3 bits.
+dshot_telemetry_status_t dshot_gcr_decode(uint32_t levels, uint16_t* value);
+
+// Electrical RPM of a decoded value; 0 for the stopped motor's 0xFFF
+uint32_t dshot_erpm(uint16_t value);
+
+// dshot_capture_levels(), dshot_gcr_decode() and dshot_erpm() in one call.
+// A failed decode leaves *erpm alone.
+dshot_telemetry_status_t dshot_telemetry_decode(const uint32_t capture[DSHOT_TELEMETRY_WORDS],
+                                                int motor, uint32_t* erpm);
+
+// The ESC's side, for the host model and the tests: the value reporting
+// an eRPM, and the line levels of a value's reply
+uint16_t dshot_erpm_value(uint32_t erpm);
+uint32_t dshot_gcr_encode(uint16_t value);
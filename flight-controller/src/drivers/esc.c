@@ -1,43 +1,127 @@
 #include "esc.h"
-#include "hardware/pwm.h"
-#include "hardware/clocks.h"
-#include "hardware/gpio.h"
-#include "pico/stdlib.h"
-#include <stdlib.h>
+#include "dshot.h"
+#include "hal.h"
+#include <stdbool.h>
+#include "../utils/heap_guard.h"
 
 
 #define PWM_RESOLUTION 16
 #define MIN_THROTTLE 0.0f
 #define MAX_THROTTLE 1.0f
+#define ARM_MS 1000
 
 struct esc_controller {
     esc_config_t config;
-    uint8_t slice_num[4];  // PWM slice numbers for each motor
-    uint8_t channel[4];    // PWM channels for each motor
+    esc_duty_range_t duty_range;
+    uint32_t sync_pins;         // Pins restarted after each output, or 0
+    uint32_t erpm[DSHOT_MOTORS];
+    uint32_t telemetry_errors;
     bool is_armed;
 };
 
-static inline uint16_t throttle_to_duty(const esc_controller_t* esc, float throttle) {
+_Static_assert(sizeof(struct esc_controller) <= sizeof(esc_storage_t),
+               "ESC_STORAGE_SIZE is too small for esc_controller_t");
+
+static bool is_dshot(const esc_controller_t* esc) {
+    return esc->config.protocol >= ESC_PROTOCOL_DSHOT150;
+}
+
+static bool is_synced(esc_protocol_t protocol) {
+    return protocol == ESC_PROTOCOL_ONESHOT125 || protocol == ESC_PROTOCOL_ONESHOT42 ||
+           protocol == ESC_PROTOCOL_MULTISHOT;
+}
+
+static uint32_t dshot_bit_rate(esc_protocol_t protocol) {
+    switch (protocol) {
+        case ESC_PROTOCOL_DSHOT150: return DSHOT150_BIT_RATE;
+        case ESC_PROTOCOL_DSHOT300: return DSHOT300_BIT_RATE;
+        default: return DSHOT600_BIT_RATE;
+    }
+}
+
+// The replies to the last frame, if they are in
+static void read_telemetry(esc_controller_t* esc) {
+    const uint32_t* capture = hal_dshot_telemetry();
+    if (capture == NULL) return;
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        if (dshot_telemetry_decode(capture, m, &esc->erpm[m]) != DSHOT_TELEMETRY_OK) {
+            esc->telemetry_errors++;
+        }
+    }
+}
+
+static void dshot_send(esc_controller_t* esc, const uint16_t value[DSHOT_MOTORS]) {
+    uint16_t frame[DSHOT_MOTORS];
+    uint32_t words[DSHOT_PACKED_WORDS];
+    if (esc->config.bidirectional) {
+        read_telemetry(esc);
+        for (int i = 0; i < DSHOT_MOTORS; i++) frame[i] = dshot_bidir_frame(value[i], false);
+    } else {
+        for (int i = 0; i < DSHOT_MOTORS; i++) frame[i] = dshot_frame(value[i], false);
+    }
+    dshot_pack(frame, words);
+    hal_dshot_send(words);
+}
+
+static void dshot_stop(esc_controller_t* esc) {
+    const uint16_t stop[DSHOT_MOTORS] = { DSHOT_CMD_MOTOR_STOP, DSHOT_CMD_MOTOR_STOP,
+                                          DSHOT_CMD_MOTOR_STOP, DSHOT_CMD_MOTOR_STOP };
+    dshot_send(esc, stop);
+}
+
+void esc_duty_range_init(esc_duty_range_t* range, const esc_config_t* config) {
+    float counts_per_ms = (float)SYS_CLOCK_HZ / (float)config->clock_div / 1000.0f;
+    range->min_duty = (uint16_t)(config->min_pulse_ms * counts_per_ms + 0.5f);
+    range->max_duty = (uint16_t)(config->max_pulse_ms * counts_per_ms + 0.5f);
+    range->span = (float)(range->max_duty - range->min_duty);
+}
+
+uint16_t esc_throttle_to_duty(const esc_duty_range_t* range, float throttle) {
     // Constrain throttle to valid range
-    if (throttle < MIN_THROTTLE) throttle = MIN_THROTTLE;
-    if (throttle > MAX_THROTTLE) throttle = MAX_THROTTLE;
-    
-    // Convert throttle to pulse width
-    float pulse_width = esc->config.min_pulse_ms + 
-                       throttle * (esc->config.max_pulse_ms - esc->config.min_pulse_ms);
-    
-    // Convert to duty cycle value
-    float duty_cycle = pulse_width / (1000.0f / esc->config.pwm_freq);
-    return (uint16_t)(duty_cycle * esc->config.wrap_value);
+    if (throttle <= MIN_THROTTLE) return range->min_duty;
+    if (throttle >= MAX_THROTTLE) return range->max_duty;
+    return (uint16_t)(range->min_duty + (uint16_t)(throttle * range->span + 0.5f));
+}
+
+uint16_t esc_throttle_q15_to_duty(const esc_duty_range_t* range, q15_t throttle) {
+    if (throttle <= 0) return range->min_duty;
+    if (throttle == Q15_MAX) return range->max_duty;
+    uint32_t span = (uint32_t)(range->max_duty - range->min_duty);
+    return (uint16_t)(range->min_duty + ((span * (uint32_t)throttle + (1u << 14)) >> 15));
 }
 
+#if !FC_STATIC_ALLOC
 esc_controller_t* esc_init(const esc_config_t* config) {
-    esc_controller_t* esc = malloc(sizeof(esc_controller_t));
-    if (esc == NULL) return NULL;
-    
+    esc_storage_t* storage = malloc(sizeof(esc_storage_t));
+    if (storage == NULL) return NULL;
+
+    esc_controller_t* esc = esc_setup(storage, config);
+    if (esc == NULL) free(storage);
+    return esc;
+}
+#endif
+
+esc_controller_t* esc_setup(esc_storage_t* storage, const esc_config_t* config) {
+    esc_controller_t* esc = (esc_controller_t*)storage;
+
     // Store configuration
     esc->config = *config;
+    esc->sync_pins = 0;
+    for (int m = 0; m < DSHOT_MOTORS; m++) esc->erpm[m] = 0;
+    esc->telemetry_errors = 0;
     esc->is_armed = false;
+
+    // One state machine drives all four pins; the first frame goes out on
+    // arming, until then the pins stay low
+    if (is_dshot(esc)) {
+        if (config->motor2_pin != config->motor1_pin + 1 ||
+            config->motor3_pin != config->motor1_pin + 2 ||
+            config->motor4_pin != config->motor1_pin + 3) {
+            return NULL;
+        }
+        return hal_dshot_init(config->motor1_pin, dshot_bit_rate(config->protocol),
+                              config->bidirectional) ? esc : NULL;
+    }
     
     // Configure PWM for each motor
     uint8_t pins[4] = {
@@ -47,63 +131,73 @@ esc_controller_t* esc_init(const esc_config_t* config) {
         config->motor4_pin
     };
     
-    // Initialize PWM for each motor
+    // Initialize PWM for each motor, starting with the motors off
+    esc_duty_range_init(&esc->duty_range, config);
     for (int i = 0; i < 4; i++) {
-        gpio_set_function(pins[i], GPIO_FUNC_PWM);
-        esc->slice_num[i] = pwm_gpio_to_slice_num(pins[i]);
-        esc->channel[i] = pwm_gpio_to_channel(pins[i]);
-        
-        // Configure PWM
-        pwm_config cfg = pwm_get_default_config();
-        pwm_config_set_clkdiv(&cfg, config->clock_div);
-        pwm_config_set_wrap(&cfg, config->wrap_value);
-        pwm_init(esc->slice_num[i], &cfg, true);
-        
-        // Start with motors off
-        pwm_set_gpio_level(pins[i], 0);
+        hal_pwm_init(pins[i], (float)config->clock_div, config->wrap_value);
+        if (is_synced(config->protocol)) esc->sync_pins |= 1u << pins[i];
     }
     
     return esc;
 }
 
 void esc_calibrate(esc_controller_t* esc) {
+    // DShot throttle is absolute
+    if (is_dshot(esc)) return;
+
     // ESC calibration procedure
     // 1. Set maximum throttle
     for (int i = 0; i < 4; i++) {
-        pwm_set_gpio_level(esc->config.motor1_pin + i, 
-                          throttle_to_duty(esc, MAX_THROTTLE));
+        hal_pwm_set_level(esc->config.motor1_pin + i,
+                          esc->duty_range.max_duty);
     }
     
     // 2. Wait for ESC to recognize max throttle
-    sleep_ms(5000);
+    hal_sleep_ms(5000);
     
     // 3. Set minimum throttle
     for (int i = 0; i < 4; i++) {
-        pwm_set_gpio_level(esc->config.motor1_pin + i, 
-                          throttle_to_duty(esc, MIN_THROTTLE));
+        hal_pwm_set_level(esc->config.motor1_pin + i,
+                          esc->duty_range.min_duty);
     }
     
     // 4. Wait for ESC to recognize min throttle
-    sleep_ms(2000);
+    hal_sleep_ms(2000);
 }
 
 void esc_arm(esc_controller_t* esc) {
+    // DShot ESCs arm on a steady stream of stop frames
+    if (is_dshot(esc)) {
+        for (int ms = 0; ms < ARM_MS; ms++) {
+            dshot_stop(esc);
+            hal_sleep_ms(1);
+        }
+        esc->is_armed = true;
+        return;
+    }
+
     // Send minimum throttle signal to arm ESCs
     for (int i = 0; i < 4; i++) {
-        pwm_set_gpio_level(esc->config.motor1_pin + i, 
-                          throttle_to_duty(esc, MIN_THROTTLE));
+        hal_pwm_set_level(esc->config.motor1_pin + i,
+                          esc->duty_range.min_duty);
     }
     
     // Wait for ESCs to initialize
-    sleep_ms(1000);
+    hal_sleep_ms(ARM_MS);
     
     esc->is_armed = true;
 }
 
 void esc_disarm(esc_controller_t* esc) {
+    if (is_dshot(esc)) {
+        dshot_stop(esc);
+        esc->is_armed = false;
+        return;
+    }
+
     // Set all motors to zero
     for (int i = 0; i < 4; i++) {
-        pwm_set_gpio_level(esc->config.motor1_pin + i, 0);
+        hal_pwm_set_level(esc->config.motor1_pin + i, 0);
     }
     
     esc->is_armed = false;
@@ -111,38 +205,103 @@ void esc_disarm(esc_controller_t* esc) {
 
 void esc_set_output(esc_controller_t* esc, float m1, float m2, float m3, float m4) {
     if (!esc->is_armed) return;
+
+    if (is_dshot(esc)) {
+        const uint16_t value[DSHOT_MOTORS] = { dshot_throttle_value(m1), dshot_throttle_value(m2),
+                                               dshot_throttle_value(m3), dshot_throttle_value(m4) };
+        dshot_send(esc, value);
+        return;
+    }
     
     // Convert throttle values to PWM duty cycles
-    uint16_t duty1 = throttle_to_duty(esc, m1);
-    uint16_t duty2 = throttle_to_duty(esc, m2);
-    uint16_t duty3 = throttle_to_duty(esc, m3);
-    uint16_t duty4 = throttle_to_duty(esc, m4);
+    uint16_t duty1 = esc_throttle_to_duty(&esc->duty_range, m1);
+    uint16_t duty2 = esc_throttle_to_duty(&esc->duty_range, m2);
+    uint16_t duty3 = esc_throttle_to_duty(&esc->duty_range, m3);
+    uint16_t duty4 = esc_throttle_to_duty(&esc->duty_range, m4);
     
     // Set PWM levels
-    pwm_set_gpio_level(esc->config.motor1_pin, duty1);
-    pwm_set_gpio_level(esc->config.motor2_pin, duty2);
-    pwm_set_gpio_level(esc->config.motor3_pin, duty3);
-    pwm_set_gpio_level(esc->config.motor4_pin, duty4);
+    hal_pwm_set_level(esc->config.motor1_pin, duty1);
+    hal_pwm_set_level(esc->config.motor2_pin, duty2);
+    hal_pwm_set_level(esc->config.motor3_pin, duty3);
+    hal_pwm_set_level(esc->config.motor4_pin, duty4);
+
+    // One pulse of the new levels on all four, now
+    if (esc->sync_pins != 0) hal_pwm_restart(esc->sync_pins);
+}
+
+void esc_set_output_q15(esc_controller_t* esc, const q15_t motor[4]) {
+    if (!esc->is_armed) return;
+
+    if (is_dshot(esc)) {
+        uint16_t value[DSHOT_MOTORS];
+        for (int i = 0; i < DSHOT_MOTORS; i++) value[i] = dshot_throttle_q15_value(motor[i]);
+        dshot_send(esc, value);
+        return;
+    }
+
+    hal_pwm_set_level(esc->config.motor1_pin, esc_throttle_q15_to_duty(&esc->duty_range, motor[0]));
+    hal_pwm_set_level(esc->config.motor2_pin, esc_throttle_q15_to_duty(&esc->duty_range, motor[1]));
+    hal_pwm_set_level(esc->config.motor3_pin, esc_throttle_q15_to_duty(&esc->duty_range, motor[2]));
+    hal_pwm_set_level(esc->config.motor4_pin, esc_throttle_q15_to_duty(&esc->duty_range, motor[3]));
+    if (esc->sync_pins != 0) hal_pwm_restart(esc->sync_pins);
 }
 
 void esc_emergency_stop(esc_controller_t* esc) {
     // Immediately stop all motors
-    for (int i = 0; i < 4; i++) {
-        pwm_set_gpio_level(esc->config.motor1_pin + i, 0);
+    if (is_dshot(esc)) {
+        dshot_stop(esc);
+    } else {
+        for (int i = 0; i < 4; i++) {
+            hal_pwm_set_level(esc->config.motor1_pin + i, 0);
+        }
     }
     
     esc->is_armed = false;
 }
 
-// Example usage in main.c:
-const esc_config_t DEFAULT_ESC_CONFIG = {
-    .motor1_pin = PIN_MOTOR1,
-    .motor2_pin = PIN_MOTOR2,
-    .motor3_pin = PIN_MOTOR3,
-    .motor4_pin = PIN_MOTOR4,
-    .min_pulse_ms = 1.0f,    // 1ms minimum pulse
-    .max_pulse_ms = 2.0f,    // 2ms maximum pulse
-    .pwm_freq = 400,         // 400Hz update rate
-    .clock_div = 64,         // Clock divider
-    .wrap_value = 62500      // For 400Hz with system clock at 125MHz
+bool esc_get_erpm(const esc_controller_t* esc, uint32_t erpm[4]) {
+    if (!is_dshot(esc) || !esc->config.bidirectional) return false;
+    for (int m = 0; m < DSHOT_MOTORS; m++) erpm[m] = esc->erpm[m];
+    return true;
+}
+
+uint32_t esc_telemetry_errors(const esc_controller_t* esc) {
+    return esc->telemetry_errors;
+}
+
+// Pulse protocols count at SYS_CLOCK_HZ / clock_div: PWM at 25 MHz for a
+// 400 Hz period, the synced ones at 31.25 MHz for a 2.1 ms period
+#define ESC_PINS .motor1_pin = PIN_MOTOR1, .motor2_pin = PIN_MOTOR2, \
+                 .motor3_pin = PIN_MOTOR3, .motor4_pin = PIN_MOTOR4
+
+const esc_config_t ESC_PROTOCOL_CONFIG[ESC_PROTOCOL_COUNT] = {
+    [ESC_PROTOCOL_PWM] = {
+        .protocol = ESC_PROTOCOL_PWM, ESC_PINS,
+        .min_pulse_ms = 1.0f, .max_pulse_ms = 2.0f,
+        .clock_div = 10, .wrap_value = 62500,
+    },
+    [ESC_PROTOCOL_ONESHOT125] = {
+        .protocol = ESC_PROTOCOL_ONESHOT125, ESC_PINS,
+        .min_pulse_ms = 0.125f, .max_pulse_ms = 0.25f,
+        .clock_div = 8, .wrap_value = 65535,
+    },
+    [ESC_PROTOCOL_ONESHOT42] = {
+        .protocol = ESC_PROTOCOL_ONESHOT42, ESC_PINS,
+        .min_pulse_ms = 0.042f, .max_pulse_ms = 0.084f,
+        .clock_div = 8, .wrap_value = 65535,
+    },
+    [ESC_PROTOCOL_MULTISHOT] = {
+        .protocol = ESC_PROTOCOL_MULTISHOT, ESC_PINS,
+        .min_pulse_ms = 0.005f, .max_pulse_ms = 0.025f,
+        .clock_div = 8, .wrap_value = 65535,
+    },
+    [ESC_PROTOCOL_DSHOT150] = {
+        .protocol = ESC_PROTOCOL_DSHOT150, ESC_PINS, .bidirectional = ESC_DSHOT_BIDIR,
+    },
+    [ESC_PROTOCOL_DSHOT300] = {
+        .protocol = ESC_PROTOCOL_DSHOT300, ESC_PINS, .bidirectional = ESC_DSHOT_BIDIR,
+    },
+    [ESC_PROTOCOL_DSHOT600] = {
+        .protocol = ESC_PROTOCOL_DSHOT600, ESC_PINS, .bidirectional = ESC_DSHOT_BIDIR,
+    },
 };
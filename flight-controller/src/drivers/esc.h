@@ -1,25 +1,97 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
-#include "config.h"
+#include "../include/config.h"
+#include "../utils/fixed_point.h"
+
+// Output protocol. PWM repeats 1-2 ms pulses from free-running 400 Hz
+// slices. OneShot125 (125-250 us), OneShot42 (42-84 us) and Multishot
+// (5-25 us) pulses are triggered together, once per control update, by
+// restarting the slices right after the new levels are set; their period
+// (2.1 ms) is longer than a control tick, so the slices only repeat a
+// pulse on their own when the loop stalls. The DShot protocols send
+// digital frames from a PIO state machine (see dshot.h); they need no
+// calibration and the four motor pins must be consecutive. Bidirectional
+// DShot also reads back each motor's eRPM after every frame.
+typedef enum {
+    ESC_PROTOCOL_PWM,
+    ESC_PROTOCOL_ONESHOT125,
+    ESC_PROTOCOL_ONESHOT42,
+    ESC_PROTOCOL_MULTISHOT,
+    ESC_PROTOCOL_DSHOT150,
+    ESC_PROTOCOL_DSHOT300,
+    ESC_PROTOCOL_DSHOT600,
+    ESC_PROTOCOL_COUNT
+} esc_protocol_t;
 
 typedef struct {
+    esc_protocol_t protocol;
     uint8_t motor1_pin;
     uint8_t motor2_pin;
     uint8_t motor3_pin;
     uint8_t motor4_pin;
+    bool bidirectional;         // DShot only: eRPM telemetry
     float min_pulse_ms;
     float max_pulse_ms;
-    uint32_t pwm_freq;
-    uint32_t clock_div;
-    uint16_t wrap_value;
+    uint32_t clock_div;         // Counter clock is SYS_CLOCK_HZ / clock_div
+    uint16_t wrap_value;        // Period of wrap_value + 1 counts; PWM pulse
+                                // protocols only, like the three fields above
 } esc_config_t;
 
+// Throttle to PWM level, precomputed from a configuration so that the
+// conversions on the loop's path are a multiply and an add: the levels
+// at zero and full throttle and the span between them
+typedef struct {
+    uint16_t min_duty;
+    uint16_t max_duty;
+    float span;
+} esc_duty_range_t;
+
 typedef struct esc_controller esc_controller_t;
 
+// Room for a controller set up in place with esc_setup(); esc.c checks
+// that it fits
+#define ESC_STORAGE_SIZE 64
+typedef union {
+    uint8_t bytes[ESC_STORAGE_SIZE];
+    uint64_t align;
+} esc_storage_t;
+
+// Each protocol on PIN_MOTOR1..4, and the one selected by ESC_PROTOCOL
+extern const esc_config_t ESC_PROTOCOL_CONFIG[ESC_PROTOCOL_COUNT];
+#define DEFAULT_ESC_CONFIG (ESC_PROTOCOL_CONFIG[ESC_PROTOCOL])
+
+// NULL if a DShot configuration's pins are not consecutive or its PIO
+// resources are taken
+#if !FC_STATIC_ALLOC
 esc_controller_t* esc_init(const esc_config_t* config);
+#endif
+esc_controller_t* esc_setup(esc_storage_t* storage, const esc_config_t* config);
+
+// Teaches pulse ESCs the throttle range (7 s, blocking); nothing for
+// DShot. Arming holds zero throttle for a second, as a stream of stop
+// frames with DShot. Both leave the synced protocols' slices free-running.
 void esc_calibrate(esc_controller_t* esc);
 void esc_arm(esc_controller_t* esc);
 void esc_disarm(esc_controller_t* esc);
 void esc_set_output(esc_controller_t* esc, float m1, float m2, float m3, float m4);
 void esc_emergency_stop(esc_controller_t* esc);
+
+// Bidirectional DShot: each motor's eRPM as last reported, decoded from the
+// replies to the previous frame on every output. A reply that fails to
+// decode keeps the last value and counts in the errors. False, with the
+// eRPM untouched, without telemetry.
+bool esc_get_erpm(const esc_controller_t* esc, uint32_t erpm[4]);
+uint32_t esc_telemetry_errors(const esc_controller_t* esc);
+
+// PWM compare level for a throttle in 0..1 (clamped)
+void esc_duty_range_init(esc_duty_range_t* range, const esc_config_t* config);
+uint16_t esc_throttle_to_duty(const esc_duty_range_t* range, float throttle);
+
+// Fixed-point esc_throttle_to_duty() for the FC_FIXED_POINT path. The
+// throttle is clamped to 0..1 (Q15 32767 counts as full throttle) and
+// scaled between the two levels of the range. The result is within one
+// PWM count of the float conversion.
+uint16_t esc_throttle_q15_to_duty(const esc_duty_range_t* range, q15_t throttle);
+void esc_set_output_q15(esc_controller_t* esc, const q15_t motor[4]);
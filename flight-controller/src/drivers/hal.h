@@ -0,0 +1,61 @@
+// flight-controller/src/drivers/hal.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "i2c_bus.h"
+
+// Thin platform layer under the drivers. Exactly one backend is linked into
+// each binary: hal_pico.c on the RP2040, hal_linux.c on a Linux host (see
+// hal_linux.h for the host-only controls).
+
+// Clocks and stdio. Returns 0 on success.
+int hal_init(void);
+
+// Monotonic time since boot
+uint64_t hal_time_us(void);
+void hal_sleep_us(uint64_t us);
+void hal_sleep_ms(uint32_t ms);
+void hal_sleep_until(uint64_t deadline_us);
+
+// Low-power wait until hal_event_signal() is called (typically from an
+// interrupt handler) or the deadline passes. Spurious early returns are
+// allowed, so callers re-check their condition.
+void hal_event_wait_until(uint64_t deadline_us);
+void hal_event_signal(void);
+
+// Index of the calling core; always 0 on the host
+uint32_t hal_core_num(void);
+void hal_console_flush(void);
+
+// GPIO. The handler runs in interrupt context on the core that registered it.
+typedef void (*hal_gpio_irq_handler_t)(uint8_t pin);
+void hal_gpio_input(uint8_t pin, bool pull_down);
+void hal_gpio_irq_rising(uint8_t pin, hal_gpio_irq_handler_t handler);
+
+// PWM on one pin: counter period of wrap + 1 ticks of the divided clock.
+// Pins sharing a slice share clock_div and wrap.
+void hal_pwm_init(uint8_t pin, float clock_div, uint16_t wrap);
+void hal_pwm_set_level(uint8_t pin, uint16_t level);
+
+// Starts a new period now, on the same clock, on the slices of the pins in
+// pin_mask (bit n for GPIO n), so that their pulses of the levels set
+// since the last one go out together
+void hal_pwm_restart(uint32_t pin_mask);
+
+// DShot output on the four pins from pin_base (see dshot.h), at bit_rate
+// bits/s, bidirectional if asked. False if the pins or the PIO and DMA
+// resources are unavailable. hal_dshot_send() queues one frame per pin,
+// packed by dshot_pack(), and returns without waiting; a send while the
+// last one is still being queued, or its replies captured, is dropped.
+bool hal_dshot_init(uint8_t pin_base, uint32_t bit_rate, bool bidirectional);
+void hal_dshot_send(const uint32_t words[2]);
+
+// Bidirectional: the DSHOT_TELEMETRY_WORDS of the capture that followed
+// the last send, once it is complete. NULL until then, after it was
+// returned once, and without bidirectional DShot. Valid until the next
+// send.
+const uint32_t* hal_dshot_telemetry(void);
+
+// I2C controller instance with its pins set up; NULL on failure
+i2c_bus_t* hal_i2c_init(uint8_t instance, uint8_t sda_pin, uint8_t scl_pin, uint32_t baudrate);
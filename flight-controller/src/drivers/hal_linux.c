@@ -0,0 +1,270 @@
+#include "hal_linux.h"
+#include "dshot.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define HAL_GPIO_COUNT 64
+
+static bool virtual_time;
+static uint32_t core_num;
+static uint64_t virtual_now_us;
+
+static pthread_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t event_cond;
+static pthread_once_t event_once = PTHREAD_ONCE_INIT;
+static bool event_pending;
+
+static hal_gpio_irq_handler_t gpio_handlers[HAL_GPIO_COUNT];
+static uint16_t pwm_level[HAL_GPIO_COUNT];
+static uint16_t pwm_wrap[HAL_GPIO_COUNT];
+static uint32_t pwm_restarts[HAL_GPIO_COUNT];
+
+// DShot: every send unpacks the frames from the words the state machine
+// would be fed. Bidirectional, modeled ESCs reply a few clocks apart, and
+// their levels are sampled at the program's capture clocks into what its
+// DMA would leave for hal_dshot_telemetry(). The clock-by-clock pio_sim
+// model is only run by the tests of the programs' timing.
+#define DSHOT_REPLY_SKEW_CLOCKS 5
+
+static bool dshot_ready;
+static bool dshot_bidir;
+static uint32_t dshot_bit_rate;
+static uint8_t dshot_pin_base;
+static uint16_t dshot_frames[DSHOT_MOTORS];
+static uint32_t dshot_sends;
+static bool dshot_replies[DSHOT_MOTORS];
+static uint32_t dshot_reply_levels[DSHOT_MOTORS];
+static uint32_t dshot_capture[DSHOT_TELEMETRY_WORDS];
+static bool dshot_capture_ready;
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// Waits use CLOCK_MONOTONIC so they agree with hal_time_us()
+static void event_init(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&event_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+int hal_init(void) {
+    pthread_once(&event_once, event_init);
+    return 0;
+}
+
+void hal_linux_set_virtual_time(bool enable) {
+    virtual_time = enable;
+    virtual_now_us = 0;
+}
+
+void hal_linux_advance_us(uint64_t us) {
+    virtual_now_us += us;
+}
+
+uint64_t hal_time_us(void) {
+    return virtual_time ? virtual_now_us : monotonic_us();
+}
+
+void hal_sleep_until(uint64_t deadline_us) {
+    if (virtual_time) {
+        if (deadline_us > virtual_now_us) virtual_now_us = deadline_us;
+        return;
+    }
+
+    const struct timespec ts = {
+        .tv_sec = (time_t)(deadline_us / 1000000u),
+        .tv_nsec = (long)(deadline_us % 1000000u) * 1000
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+void hal_sleep_us(uint64_t us) {
+    hal_sleep_until(hal_time_us() + us);
+}
+
+void hal_sleep_ms(uint32_t ms) {
+    hal_sleep_us((uint64_t)ms * 1000u);
+}
+
+void hal_event_wait_until(uint64_t deadline_us) {
+    pthread_once(&event_once, event_init);
+    pthread_mutex_lock(&event_lock);
+
+    if (virtual_time) {
+        // Nothing else can move the clock, so a pending event or the
+        // deadline are the only ways out
+        if (!event_pending && deadline_us > virtual_now_us) virtual_now_us = deadline_us;
+    } else {
+        const struct timespec ts = {
+            .tv_sec = (time_t)(deadline_us / 1000000u),
+            .tv_nsec = (long)(deadline_us % 1000000u) * 1000
+        };
+        while (!event_pending) {
+            if (pthread_cond_timedwait(&event_cond, &event_lock, &ts) == ETIMEDOUT) break;
+        }
+    }
+
+    event_pending = false;
+    pthread_mutex_unlock(&event_lock);
+}
+
+void hal_event_signal(void) {
+    pthread_once(&event_once, event_init);
+    pthread_mutex_lock(&event_lock);
+    event_pending = true;
+    pthread_cond_broadcast(&event_cond);
+    pthread_mutex_unlock(&event_lock);
+}
+
+uint32_t hal_core_num(void) {
+    return core_num;
+}
+
+void hal_linux_set_core_num(uint32_t core) {
+    core_num = core;
+}
+
+void hal_console_flush(void) {
+    fflush(stdout);
+}
+
+void hal_gpio_input(uint8_t pin, bool pull_down) {
+    (void)pin;
+    (void)pull_down;
+}
+
+void hal_gpio_irq_rising(uint8_t pin, hal_gpio_irq_handler_t handler) {
+    if (pin < HAL_GPIO_COUNT) gpio_handlers[pin] = handler;
+}
+
+void hal_linux_gpio_edge(uint8_t pin) {
+    if (pin < HAL_GPIO_COUNT && gpio_handlers[pin] != NULL) {
+        gpio_handlers[pin](pin);
+    }
+}
+
+void hal_pwm_init(uint8_t pin, float clock_div, uint16_t wrap) {
+    (void)clock_div;
+    if (pin >= HAL_GPIO_COUNT) return;
+    pwm_wrap[pin] = wrap;
+    pwm_level[pin] = 0;
+    pwm_restarts[pin] = 0;
+}
+
+void hal_pwm_set_level(uint8_t pin, uint16_t level) {
+    if (pin < HAL_GPIO_COUNT) pwm_level[pin] = level;
+}
+
+void hal_pwm_restart(uint32_t pin_mask) {
+    for (uint8_t pin = 0; pin < 32; pin++) {
+        if (pin_mask & (1u << pin)) pwm_restarts[pin]++;
+    }
+}
+
+uint16_t hal_linux_pwm_level(uint8_t pin) {
+    return pin < HAL_GPIO_COUNT ? pwm_level[pin] : 0;
+}
+
+uint16_t hal_linux_pwm_wrap(uint8_t pin) {
+    return pin < HAL_GPIO_COUNT ? pwm_wrap[pin] : 0;
+}
+
+uint32_t hal_linux_pwm_restarts(uint8_t pin) {
+    return pin < HAL_GPIO_COUNT ? pwm_restarts[pin] : 0;
+}
+
+bool hal_dshot_init(uint8_t pin_base, uint32_t bit_rate, bool bidirectional) {
+    if (pin_base + DSHOT_MOTORS > HAL_GPIO_COUNT) return false;
+    dshot_ready = true;
+    dshot_bidir = bidirectional;
+    dshot_bit_rate = bit_rate;
+    dshot_pin_base = pin_base;
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        dshot_frames[m] = 0;
+        dshot_replies[m] = true;
+        dshot_reply_levels[m] = dshot_gcr_encode(dshot_erpm_value(0));
+    }
+    dshot_sends = 0;
+    dshot_capture_ready = false;
+    return true;
+}
+
+// Samples the program's capture of the modeled ESCs' replies. Its first
+// sample is on the clock after it releases the pins, then one every
+// DSHOT_TELEMETRY_SAMPLE_TICKS, eight to a word with the first in the top
+// nibble. The lines idle high outside the replies.
+static void capture_replies(void) {
+    const uint64_t turnaround = (uint64_t)DSHOT_TELEMETRY_TURNAROUND_US * dshot_bit_rate *
+                                DSHOT_BIDIR_PIO_TICKS_PER_BIT / 1000000u;
+    for (int w = 0; w < DSHOT_TELEMETRY_WORDS; w++) dshot_capture[w] = 0xFFFFFFFFu;
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        if (!dshot_replies[m]) continue;
+        const uint64_t start = turnaround + (uint64_t)m * DSHOT_REPLY_SKEW_CLOCKS;
+        int s = (int)((start + DSHOT_TELEMETRY_SAMPLE_TICKS - 1) / DSHOT_TELEMETRY_SAMPLE_TICKS);
+        for (; s < DSHOT_TELEMETRY_SAMPLES; s++) {
+            // A reply bit is 4/5 of a frame bit
+            uint64_t since_start = (uint64_t)s * DSHOT_TELEMETRY_SAMPLE_TICKS - start;
+            uint64_t bit = since_start * 5 / (4 * DSHOT_BIDIR_PIO_TICKS_PER_BIT);
+            if (bit >= DSHOT_TELEMETRY_BITS) break;
+            if (!((dshot_reply_levels[m] >> (DSHOT_TELEMETRY_BITS - 1 - bit)) & 1u)) {
+                dshot_capture[s / 8] &= ~(1u << (4 * (7 - s % 8) + m));
+            }
+        }
+    }
+}
+
+void hal_dshot_send(const uint32_t words[2]) {
+    if (!dshot_ready) return;
+
+    // Bit i of every frame is in the 4-bit group 7 - i % 8 of word i / 8,
+    // motor 1 in its lowest bit (see dshot_pack())
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        uint16_t frame = 0;
+        for (int i = 0; i < 16; i++) {
+            frame = (uint16_t)((frame << 1) | ((words[i / 8] >> (4 * (7 - i % 8) + m)) & 1u));
+        }
+        dshot_frames[m] = frame;
+    }
+    if (dshot_bidir) capture_replies();
+    dshot_capture_ready = dshot_bidir;
+    dshot_sends++;
+}
+
+const uint32_t* hal_dshot_telemetry(void) {
+    if (!dshot_capture_ready) return NULL;
+    dshot_capture_ready = false;
+    return dshot_capture;
+}
+
+uint16_t hal_linux_dshot_frame(uint8_t pin) {
+    if (!dshot_ready || pin < dshot_pin_base || pin >= dshot_pin_base + DSHOT_MOTORS) return 0;
+    return dshot_frames[pin - dshot_pin_base];
+}
+
+uint32_t hal_linux_dshot_sends(void) {
+    return dshot_sends;
+}
+
+void hal_linux_dshot_set_erpm(uint8_t pin, uint32_t erpm) {
+    hal_linux_dshot_set_reply(pin, true, dshot_gcr_encode(dshot_erpm_value(erpm)));
+}
+
+void hal_linux_dshot_set_reply(uint8_t pin, bool reply, uint32_t levels) {
+    if (pin < dshot_pin_base || pin >= dshot_pin_base + DSHOT_MOTORS) return;
+    dshot_replies[pin - dshot_pin_base] = reply;
+    dshot_reply_levels[pin - dshot_pin_base] = levels;
+}
+
+i2c_bus_t* hal_i2c_init(uint8_t instance, uint8_t sda_pin, uint8_t scl_pin, uint32_t baudrate) {
+    (void)sda_pin;
+    (void)scl_pin;
+    return i2c_bus_linux_init(instance, baudrate);
+}
@@ -0,0 +1,58 @@
+// flight-controller/src/drivers/hal_linux.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hal.h"
+
+// Host-only controls of the Linux HAL backend.
+
+// Virtual time: hal_time_us() stops following the wall clock and every
+// sleep or wait returns at once after moving the clock to its deadline.
+// Used by tests and simulations to run faster than real time. The clock
+// starts at 0 when enabled.
+void hal_linux_set_virtual_time(bool enable);
+void hal_linux_advance_us(uint64_t us);
+
+// What hal_core_num() returns on every thread, 0 by default: lets a test
+// run code as core 1 would
+void hal_linux_set_core_num(uint32_t core);
+
+// Raise a rising edge on pin, running its handler on the calling thread
+void hal_linux_gpio_edge(uint8_t pin);
+
+// Last level and wrap programmed on a PWM pin
+uint16_t hal_linux_pwm_level(uint8_t pin);
+uint16_t hal_linux_pwm_wrap(uint8_t pin);
+
+// hal_pwm_restart() calls that included a pin since its hal_pwm_init()
+uint32_t hal_linux_pwm_restarts(uint8_t pin);
+
+// Frame on a DShot pin as unpacked from the words of the last
+// hal_dshot_send() (0 before any), and the sends since hal_dshot_init()
+uint16_t hal_linux_dshot_frame(uint8_t pin);
+uint32_t hal_linux_dshot_sends(void);
+
+// Bidirectional DShot: what the modeled ESC on pin answers each frame with,
+// an eRPM or raw line levels (see dshot_gcr_encode()), or nothing. Every
+// ESC reports a stopped motor after hal_dshot_init().
+void hal_linux_dshot_set_erpm(uint8_t pin, uint32_t erpm);
+void hal_linux_dshot_set_reply(uint8_t pin, bool reply, uint32_t levels);
+
+// Simulated I2C target. Transfers addressed to it never reach the kernel;
+// the callbacks follow the i2c_bus_ops_t write/read contract.
+typedef struct {
+    uint8_t addr;
+    int (*write)(void* ctx, const uint8_t* src, size_t len, bool nostop);
+    int (*read)(void* ctx, uint8_t* dst, size_t len, bool nostop);
+    void* ctx;
+} hal_i2c_device_t;
+
+#define HAL_LINUX_I2C_INSTANCES 2
+#define HAL_LINUX_I2C_DEVICES   4    // Per instance
+
+// Attach before or after hal_i2c_init(); the device must outlive the bus.
+// Returns false if the instance is out of range or full.
+bool hal_linux_i2c_attach(uint8_t instance, const hal_i2c_device_t* device);
+void hal_linux_i2c_detach_all(void);
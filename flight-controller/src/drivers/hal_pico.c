@@ -0,0 +1,241 @@
+#include "hal.h"
+#include "dshot.h"
+#include "../include/config.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/structs/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/vreg.h"
+#include "pico/platform.h"
+#include "pico/stdlib.h"
+
+#define HAL_GPIO_COUNT 30
+
+// The SDK has one GPIO callback per core; dispatch to per-pin handlers
+static hal_gpio_irq_handler_t gpio_handlers[HAL_GPIO_COUNT];
+
+// DShot state machine on pio0 and the DMA channel feeding it. The channel
+// reads dshot_words, so a send copies the caller's frames there first.
+// Bidirectional, a second channel drains the capture into dshot_capture.
+static int dshot_sm = -1;
+static int dshot_chan = -1;
+static int dshot_rx_chan = -1;
+static uint8_t dshot_pin_base;
+static uint32_t dshot_words[DSHOT_BIDIR_WORDS];
+static uint32_t dshot_capture[DSHOT_TELEMETRY_WORDS];
+static bool dshot_capture_pending;
+
+int hal_init(void) {
+    // Initialize stdlib for Pico
+    stdio_init_all();
+
+    // Set voltage to support higher frequencies
+    vreg_set_voltage(VREG_VOLTAGE_1_30);
+    sleep_ms(10);  // Allow voltage to stabilize
+
+    // Set system clock to SYS_CLOCK_HZ (250 MHz)
+    clock_configure(clk_sys,
+                   CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+                   CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
+                   SYS_CLOCK_HZ,
+                   SYS_CLOCK_HZ);
+
+    // Configure peripheral clocks
+    clock_configure(clk_peri,
+                   0,
+                   CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
+                   SYS_CLOCK_HZ,
+                   SYS_CLOCK_HZ);
+
+    return 0;
+}
+
+uint64_t hal_time_us(void) {
+    return time_us_64();
+}
+
+void hal_sleep_us(uint64_t us) {
+    sleep_us(us);
+}
+
+void hal_sleep_ms(uint32_t ms) {
+    sleep_ms(ms);
+}
+
+void hal_sleep_until(uint64_t deadline_us) {
+    sleep_until(from_us_since_boot(deadline_us));
+}
+
+void hal_event_wait_until(uint64_t deadline_us) {
+    best_effort_wfe_or_timeout(from_us_since_boot(deadline_us));
+}
+
+void hal_event_signal(void) {
+    __sev();
+}
+
+uint32_t hal_core_num(void) {
+    return get_core_num();
+}
+
+void hal_console_flush(void) {
+    stdio_flush();
+}
+
+static void gpio_dispatch(uint gpio, uint32_t events) {
+    (void)events;
+    if (gpio < HAL_GPIO_COUNT && gpio_handlers[gpio] != NULL) {
+        gpio_handlers[gpio]((uint8_t)gpio);
+    }
+}
+
+void hal_gpio_input(uint8_t pin, bool pull_down) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_IN);
+    if (pull_down) gpio_pull_down(pin);
+}
+
+void hal_gpio_irq_rising(uint8_t pin, hal_gpio_irq_handler_t handler) {
+    if (pin >= HAL_GPIO_COUNT) return;
+    gpio_handlers[pin] = handler;
+    gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_RISE, true, gpio_dispatch);
+}
+
+void hal_pwm_init(uint8_t pin, float clock_div, uint16_t wrap) {
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+
+    pwm_config cfg = pwm_get_default_config();
+    pwm_config_set_clkdiv(&cfg, clock_div);
+    pwm_config_set_wrap(&cfg, wrap);
+    pwm_init(pwm_gpio_to_slice_num(pin), &cfg, true);
+
+    pwm_set_gpio_level(pin, 0);
+}
+
+void hal_pwm_set_level(uint8_t pin, uint16_t level) {
+    pwm_set_gpio_level(pin, level);
+}
+
+void hal_pwm_restart(uint32_t pin_mask) {
+    uint32_t slices = 0;
+    for (uint pin = 0; pin < HAL_GPIO_COUNT; pin++) {
+        if (pin_mask & (1u << pin)) slices |= 1u << pwm_gpio_to_slice_num(pin);
+    }
+
+    // Stopped at their TOP, the slices all wrap on the first count once
+    // enabled together: the wrap latches the new levels and starts the pulse
+    hw_clear_bits(&pwm_hw->en, slices);
+    for (uint slice = 0; slice < NUM_PWM_SLICES; slice++) {
+        if (slices & (1u << slice)) pwm_set_counter(slice, (uint16_t)pwm_hw->slice[slice].top);
+    }
+    hw_set_bits(&pwm_hw->en, slices);
+}
+
+bool hal_dshot_init(uint8_t pin_base, uint32_t bit_rate, bool bidirectional) {
+    static const pio_program_t program = {
+        .instructions = dshot_pio_program,
+        .length = DSHOT_PIO_PROGRAM_LENGTH,
+        .origin = -1,
+    };
+    static const pio_program_t bidir_program = {
+        .instructions = dshot_bidir_pio_program,
+        .length = DSHOT_BIDIR_PIO_PROGRAM_LENGTH,
+        .origin = -1,
+    };
+    const pio_program_t* prog = bidirectional ? &bidir_program : &program;
+    PIO pio = pio0;
+
+    if (dshot_sm >= 0) return pin_base == dshot_pin_base;
+    if (pin_base + DSHOT_MOTORS > HAL_GPIO_COUNT) return false;
+    if (!pio_can_add_program(pio, prog)) return false;
+    int sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0) return false;
+    int chan = dma_claim_unused_channel(false);
+    int rx_chan = bidirectional ? dma_claim_unused_channel(false) : -1;
+    if (chan < 0 || (bidirectional && rx_chan < 0)) {
+        if (chan >= 0) dma_channel_unclaim((uint)chan);
+        if (rx_chan >= 0) dma_channel_unclaim((uint)rx_chan);
+        pio_sm_unclaim(pio, (uint)sm);
+        return false;
+    }
+    uint offset = pio_add_program(pio, prog);
+
+    // Driven by the state machine: low, or bidirectional idle high with
+    // pull-ups holding the line while the ESCs answer
+    uint32_t idle = bidirectional ? 0xFu << pin_base : 0;
+    for (uint i = 0; i < DSHOT_MOTORS; i++) {
+        pio_gpio_init(pio, pin_base + i);
+        if (bidirectional) gpio_pull_up(pin_base + i);
+    }
+    pio_sm_set_pins_with_mask(pio, (uint)sm, idle, 0xFu << pin_base);
+    pio_sm_set_consecutive_pindirs(pio, (uint)sm, pin_base, DSHOT_MOTORS, true);
+
+    pio_sm_config cfg = pio_get_default_sm_config();
+    sm_config_set_out_pins(&cfg, pin_base, DSHOT_MOTORS);
+    sm_config_set_set_pins(&cfg, pin_base, DSHOT_MOTORS);
+    sm_config_set_out_shift(&cfg, false, true, 32);
+    if (bidirectional) {
+        sm_config_set_wrap(&cfg, offset + DSHOT_BIDIR_PIO_WRAP_TARGET, offset + DSHOT_BIDIR_PIO_WRAP);
+        sm_config_set_in_pins(&cfg, pin_base);
+        sm_config_set_in_shift(&cfg, false, true, 32);
+        sm_config_set_clkdiv(&cfg, dshot_bidir_pio_clock_div(clock_get_hz(clk_sys), bit_rate));
+    } else {
+        sm_config_set_wrap(&cfg, offset + DSHOT_PIO_WRAP_TARGET, offset + DSHOT_PIO_WRAP);
+        sm_config_set_fifo_join(&cfg, PIO_FIFO_JOIN_TX);
+        sm_config_set_clkdiv(&cfg, dshot_pio_clock_div(clock_get_hz(clk_sys), bit_rate));
+    }
+    pio_sm_init(pio, (uint)sm, offset, &cfg);
+    pio_sm_set_enabled(pio, (uint)sm, true);
+
+    dma_channel_config dma = dma_channel_get_default_config((uint)chan);
+    channel_config_set_transfer_data_size(&dma, DMA_SIZE_32);
+    channel_config_set_read_increment(&dma, true);
+    channel_config_set_write_increment(&dma, false);
+    channel_config_set_dreq(&dma, pio_get_dreq(pio, (uint)sm, true));
+    dma_channel_configure((uint)chan, &dma, &pio->txf[sm], dshot_words, DSHOT_PACKED_WORDS, false);
+
+    if (bidirectional) {
+        dma_channel_config rx = dma_channel_get_default_config((uint)rx_chan);
+        channel_config_set_transfer_data_size(&rx, DMA_SIZE_32);
+        channel_config_set_read_increment(&rx, false);
+        channel_config_set_write_increment(&rx, true);
+        channel_config_set_dreq(&rx, pio_get_dreq(pio, (uint)sm, false));
+        dma_channel_configure((uint)rx_chan, &rx, dshot_capture, &pio->rxf[sm],
+                              DSHOT_TELEMETRY_WORDS, false);
+        dshot_words[DSHOT_PACKED_WORDS] = DSHOT_TELEMETRY_SAMPLES - 1;
+    }
+
+    dshot_sm = sm;
+    dshot_chan = chan;
+    dshot_rx_chan = rx_chan;
+    dshot_pin_base = pin_base;
+    return true;
+}
+
+void hal_dshot_send(const uint32_t words[2]) {
+    if (dshot_chan < 0 || dma_channel_is_busy((uint)dshot_chan)) return;
+    for (int i = 0; i < DSHOT_PACKED_WORDS; i++) dshot_words[i] = words[i];
+    if (dshot_rx_chan < 0) {
+        dma_channel_transfer_from_buffer_now((uint)dshot_chan, dshot_words, DSHOT_PACKED_WORDS);
+        return;
+    }
+
+    // The capture of the last replies must be over before the next frame
+    if (dma_channel_is_busy((uint)dshot_rx_chan)) return;
+    dma_channel_transfer_to_buffer_now((uint)dshot_rx_chan, dshot_capture, DSHOT_TELEMETRY_WORDS);
+    dma_channel_transfer_from_buffer_now((uint)dshot_chan, dshot_words, DSHOT_BIDIR_WORDS);
+    dshot_capture_pending = true;
+}
+
+const uint32_t* hal_dshot_telemetry(void) {
+    if (!dshot_capture_pending || dma_channel_is_busy((uint)dshot_rx_chan)) return NULL;
+    dshot_capture_pending = false;
+    return dshot_capture;
+}
+
+i2c_bus_t* hal_i2c_init(uint8_t instance, uint8_t sda_pin, uint8_t scl_pin, uint32_t baudrate) {
+    return i2c_bus_pico_init(instance, sda_pin, scl_pin, baudrate);
+}
@@ -0,0 +1,61 @@
+// flight-controller/src/drivers/i2c_bus.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// State of the background transfer started with i2c_bus_read_reg_async()
+typedef enum {
+    I2C_BUS_IDLE = 0,
+    I2C_BUS_BUSY,
+    I2C_BUS_DONE,
+    I2C_BUS_ERROR
+} i2c_bus_status_t;
+
+typedef struct i2c_bus i2c_bus_t;
+
+// Backend operations. Blocking calls follow the Pico SDK convention and
+// return the number of bytes transferred or a negative value on error.
+typedef struct {
+    int (*write)(i2c_bus_t* bus, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
+    int (*read)(i2c_bus_t* bus, uint8_t addr, uint8_t* dst, size_t len, bool nostop);
+
+    // Write the register address, repeated start, then read len bytes into
+    // dst without blocking the caller. dst must stay valid until poll()
+    // reports DONE or ERROR. Returns false if a transfer is already running.
+    bool (*read_reg_async)(i2c_bus_t* bus, uint8_t addr, uint8_t reg, uint8_t* dst, size_t len);
+    i2c_bus_status_t (*poll)(i2c_bus_t* bus);
+} i2c_bus_ops_t;
+
+struct i2c_bus {
+    const i2c_bus_ops_t* ops;
+    void* ctx;
+};
+
+static inline int i2c_bus_write(i2c_bus_t* bus, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    return bus->ops->write(bus, addr, src, len, nostop);
+}
+
+static inline int i2c_bus_read(i2c_bus_t* bus, uint8_t addr, uint8_t* dst, size_t len, bool nostop) {
+    return bus->ops->read(bus, addr, dst, len, nostop);
+}
+
+static inline bool i2c_bus_read_reg_async(i2c_bus_t* bus, uint8_t addr, uint8_t reg, uint8_t* dst, size_t len) {
+    return bus->ops->read_reg_async(bus, addr, reg, dst, len);
+}
+
+static inline i2c_bus_status_t i2c_bus_poll(i2c_bus_t* bus) {
+    return bus->ops->poll(bus);
+}
+
+// RP2040 backend: blocking transfers use the SDK, asynchronous register
+// reads are driven by a pair of DMA channels feeding IC_DATA_CMD. Each
+// controller is set up once; asking for it again returns the same bus, or
+// NULL if the pins differ.
+i2c_bus_t* i2c_bus_pico_init(uint8_t instance, uint8_t sda_pin, uint8_t scl_pin, uint32_t baudrate);
+
+// Linux backend: targets attached with hal_linux_i2c_attach() are simulated,
+// anything else goes to /dev/i2c-<instance> if it exists. Asynchronous reads
+// complete inside read_reg_async().
+i2c_bus_t* i2c_bus_linux_init(uint8_t instance, uint32_t baudrate);
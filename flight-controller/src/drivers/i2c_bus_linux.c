@@ -0,0 +1,149 @@
+#include "i2c_bus.h"
+#include "hal_linux.h"
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#define I2C_BUS_MAX_WRITE 32
+
+typedef struct {
+    i2c_bus_t bus;
+    uint8_t instance;
+    int fd;                     // /dev/i2c-N, or -1 if there is none
+
+    // A write with nostop is held back and sent with the following read as
+    // one I2C_RDWR transaction, so the kernel issues a repeated start
+    uint8_t pending[I2C_BUS_MAX_WRITE];
+    size_t pending_len;
+    uint8_t pending_addr;
+
+    i2c_bus_status_t status;
+} i2c_bus_linux_t;
+
+static const hal_i2c_device_t* devices[HAL_LINUX_I2C_INSTANCES][HAL_LINUX_I2C_DEVICES];
+
+bool hal_linux_i2c_attach(uint8_t instance, const hal_i2c_device_t* device) {
+    if (instance >= HAL_LINUX_I2C_INSTANCES) return false;
+    for (int i = 0; i < HAL_LINUX_I2C_DEVICES; i++) {
+        if (devices[instance][i] == NULL) {
+            devices[instance][i] = device;
+            return true;
+        }
+    }
+    return false;
+}
+
+void hal_linux_i2c_detach_all(void) {
+    memset(devices, 0, sizeof(devices));
+}
+
+static const hal_i2c_device_t* find_device(const i2c_bus_linux_t* lb, uint8_t addr) {
+    for (int i = 0; i < HAL_LINUX_I2C_DEVICES; i++) {
+        const hal_i2c_device_t* dev = devices[lb->instance][i];
+        if (dev != NULL && dev->addr == addr) return dev;
+    }
+    return NULL;
+}
+
+static int kernel_transfer(i2c_bus_linux_t* lb, struct i2c_msg* msgs, int count) {
+    if (lb->fd < 0) return -1;
+    struct i2c_rdwr_ioctl_data xfer = { .msgs = msgs, .nmsgs = (uint32_t)count };
+    return ioctl(lb->fd, I2C_RDWR, &xfer) == count ? 0 : -1;
+}
+
+// Send a held-back write on its own, e.g. when no read follows it
+static int flush_pending(i2c_bus_linux_t* lb) {
+    if (lb->pending_len == 0) return 0;
+    struct i2c_msg msg = {
+        .addr = lb->pending_addr, .flags = 0,
+        .len = (uint16_t)lb->pending_len, .buf = lb->pending
+    };
+    lb->pending_len = 0;
+    return kernel_transfer(lb, &msg, 1);
+}
+
+static int linux_write(i2c_bus_t* bus, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    i2c_bus_linux_t* lb = bus->ctx;
+    if (lb->status == I2C_BUS_BUSY) return -1;
+
+    const hal_i2c_device_t* dev = find_device(lb, addr);
+    if (dev != NULL) return dev->write(dev->ctx, src, len, nostop);
+
+    if (flush_pending(lb) < 0) return -1;
+    if (nostop && len <= I2C_BUS_MAX_WRITE) {
+        memcpy(lb->pending, src, len);
+        lb->pending_len = len;
+        lb->pending_addr = addr;
+        return (int)len;
+    }
+
+    struct i2c_msg msg = { .addr = addr, .flags = 0, .len = (uint16_t)len, .buf = (uint8_t*)src };
+    return kernel_transfer(lb, &msg, 1) == 0 ? (int)len : -1;
+}
+
+static int linux_read(i2c_bus_t* bus, uint8_t addr, uint8_t* dst, size_t len, bool nostop) {
+    i2c_bus_linux_t* lb = bus->ctx;
+    if (lb->status == I2C_BUS_BUSY) return -1;
+
+    const hal_i2c_device_t* dev = find_device(lb, addr);
+    if (dev != NULL) return dev->read(dev->ctx, dst, len, nostop);
+
+    struct i2c_msg msgs[2];
+    int count = 0;
+    if (lb->pending_len > 0 && lb->pending_addr == addr) {
+        msgs[count++] = (struct i2c_msg){
+            .addr = addr, .flags = 0, .len = (uint16_t)lb->pending_len, .buf = lb->pending
+        };
+        lb->pending_len = 0;
+    } else if (flush_pending(lb) < 0) {
+        return -1;
+    }
+    msgs[count++] = (struct i2c_msg){ .addr = addr, .flags = I2C_M_RD, .len = (uint16_t)len, .buf = dst };
+    return kernel_transfer(lb, msgs, count) == 0 ? (int)len : -1;
+}
+
+static bool linux_read_reg_async(i2c_bus_t* bus, uint8_t addr, uint8_t reg, uint8_t* dst, size_t len) {
+    i2c_bus_linux_t* lb = bus->ctx;
+    if (lb->status == I2C_BUS_BUSY) return false;
+
+    bool ok = linux_write(bus, addr, &reg, 1, true) == 1 &&
+              linux_read(bus, addr, dst, len, false) == (int)len;
+    lb->status = ok ? I2C_BUS_DONE : I2C_BUS_ERROR;
+    return true;
+}
+
+static i2c_bus_status_t linux_poll(i2c_bus_t* bus) {
+    i2c_bus_linux_t* lb = bus->ctx;
+    return lb->status;
+}
+
+static const i2c_bus_ops_t LINUX_I2C_BUS_OPS = {
+    .write = linux_write,
+    .read = linux_read,
+    .read_reg_async = linux_read_reg_async,
+    .poll = linux_poll
+};
+
+i2c_bus_t* i2c_bus_linux_init(uint8_t instance, uint32_t baudrate) {
+    (void)baudrate;     // Set by the kernel driver
+    if (instance >= HAL_LINUX_I2C_INSTANCES) return NULL;
+
+    i2c_bus_linux_t* lb = malloc(sizeof(i2c_bus_linux_t));
+    if (lb == NULL) return NULL;
+
+    char path[16];
+    snprintf(path, sizeof(path), "/dev/i2c-%u", (unsigned)instance);
+    lb->fd = open(path, O_RDWR);
+    lb->instance = instance;
+    lb->pending_len = 0;
+    lb->status = I2C_BUS_IDLE;
+
+    lb->bus.ops = &LINUX_I2C_BUS_OPS;
+    lb->bus.ctx = lb;
+    return &lb->bus;
+}
@@ -0,0 +1,148 @@
+#include "i2c_bus.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "pico/time.h"
+#include "../utils/heap_guard.h"
+
+#define I2C_BUS_TIMEOUT_US     1000000
+#define I2C_BUS_MAX_ASYNC_LEN  32
+
+// IC_DATA_CMD command bits
+#define DATA_CMD_READ     (1u << 8)
+#define DATA_CMD_STOP     (1u << 9)
+#define DATA_CMD_RESTART  (1u << 10)
+
+typedef struct {
+    i2c_bus_t bus;
+    i2c_inst_t* i2c;
+    int tx_chan;
+    int rx_chan;
+    i2c_bus_status_t status;
+    uint64_t started_us;
+    // Command words clocked into IC_DATA_CMD by the TX channel: the register
+    // address followed by one read command per byte.
+    uint32_t cmd[I2C_BUS_MAX_ASYNC_LEN + 1];
+    bool claimed;
+    uint8_t sda_pin;
+    uint8_t scl_pin;
+} i2c_bus_pico_t;
+
+// One bus per I2C controller, allocated at link time
+static i2c_bus_pico_t buses[2];
+
+static void set_target(i2c_inst_t* i2c, uint8_t addr) {
+    i2c->hw->enable = 0;
+    i2c->hw->tar = addr;
+    i2c->hw->enable = 1;
+}
+
+static int pico_write(i2c_bus_t* bus, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    i2c_bus_pico_t* pb = bus->ctx;
+    if (pb->status == I2C_BUS_BUSY) return PICO_ERROR_GENERIC;
+    return i2c_write_timeout_us(pb->i2c, addr, src, len, nostop, I2C_BUS_TIMEOUT_US);
+}
+
+static int pico_read(i2c_bus_t* bus, uint8_t addr, uint8_t* dst, size_t len, bool nostop) {
+    i2c_bus_pico_t* pb = bus->ctx;
+    if (pb->status == I2C_BUS_BUSY) return PICO_ERROR_GENERIC;
+    return i2c_read_timeout_us(pb->i2c, addr, dst, len, nostop, I2C_BUS_TIMEOUT_US);
+}
+
+static bool pico_read_reg_async(i2c_bus_t* bus, uint8_t addr, uint8_t reg, uint8_t* dst, size_t len) {
+    i2c_bus_pico_t* pb = bus->ctx;
+    if (pb->status == I2C_BUS_BUSY) return false;
+    if (len == 0 || len > I2C_BUS_MAX_ASYNC_LEN) return false;
+
+    pb->cmd[0] = reg;
+    for (size_t i = 0; i < len; i++) {
+        pb->cmd[i + 1] = DATA_CMD_READ;
+    }
+    pb->cmd[1] |= DATA_CMD_RESTART;
+    pb->cmd[len] |= DATA_CMD_STOP;
+
+    set_target(pb->i2c, addr);
+    pb->i2c->restart_on_next = false;
+
+    // RX must be armed before TX starts issuing read commands
+    dma_channel_set_write_addr(pb->rx_chan, dst, false);
+    dma_channel_set_trans_count(pb->rx_chan, len, true);
+    dma_channel_set_read_addr(pb->tx_chan, pb->cmd, false);
+    dma_channel_set_trans_count(pb->tx_chan, len + 1, true);
+
+    pb->started_us = time_us_64();
+    pb->status = I2C_BUS_BUSY;
+    return true;
+}
+
+static void abort_transfer(i2c_bus_pico_t* pb) {
+    dma_channel_abort(pb->tx_chan);
+    dma_channel_abort(pb->rx_chan);
+    (void)pb->i2c->hw->clr_tx_abrt;
+    pb->status = I2C_BUS_ERROR;
+}
+
+static i2c_bus_status_t pico_poll(i2c_bus_t* bus) {
+    i2c_bus_pico_t* pb = bus->ctx;
+    if (pb->status != I2C_BUS_BUSY) return pb->status;
+
+    if (pb->i2c->hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        abort_transfer(pb);
+    } else if (!dma_channel_is_busy(pb->rx_chan)) {
+        pb->status = I2C_BUS_DONE;
+    } else if (time_us_64() - pb->started_us > I2C_BUS_TIMEOUT_US) {
+        abort_transfer(pb);
+    }
+
+    return pb->status;
+}
+
+static const i2c_bus_ops_t PICO_I2C_BUS_OPS = {
+    .write = pico_write,
+    .read = pico_read,
+    .read_reg_async = pico_read_reg_async,
+    .poll = pico_poll
+};
+
+i2c_bus_t* i2c_bus_pico_init(uint8_t instance, uint8_t sda_pin, uint8_t scl_pin, uint32_t baudrate) {
+    if (instance > 1) return NULL;
+    i2c_bus_pico_t* pb = &buses[instance];
+    if (pb->claimed) {
+        // Pins and DMA channels already set up, maybe for other pins
+        return pb->sda_pin == sda_pin && pb->scl_pin == scl_pin ? &pb->bus : NULL;
+    }
+    pb->claimed = true;
+    pb->sda_pin = sda_pin;
+    pb->scl_pin = scl_pin;
+
+    pb->i2c = instance == 0 ? i2c0 : i2c1;
+    pb->status = I2C_BUS_IDLE;
+
+    i2c_init(pb->i2c, baudrate);
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+
+    // i2c_init() already enables the DREQ handshake in IC_DMA_CR
+    pb->tx_chan = dma_claim_unused_channel(true);
+    pb->rx_chan = dma_claim_unused_channel(true);
+
+    dma_channel_config tx = dma_channel_get_default_config(pb->tx_chan);
+    channel_config_set_transfer_data_size(&tx, DMA_SIZE_32);
+    channel_config_set_read_increment(&tx, true);
+    channel_config_set_write_increment(&tx, false);
+    channel_config_set_dreq(&tx, i2c_get_dreq(pb->i2c, true));
+    dma_channel_configure(pb->tx_chan, &tx, &pb->i2c->hw->data_cmd, pb->cmd, 0, false);
+
+    dma_channel_config rx = dma_channel_get_default_config(pb->rx_chan);
+    channel_config_set_transfer_data_size(&rx, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx, false);
+    channel_config_set_write_increment(&rx, true);
+    channel_config_set_dreq(&rx, i2c_get_dreq(pb->i2c, false));
+    dma_channel_configure(pb->rx_chan, &rx, NULL, &pb->i2c->hw->data_cmd, 0, false);
+
+    pb->bus.ops = &PICO_I2C_BUS_OPS;
+    pb->bus.ctx = pb;
+    return &pb->bus;
+}
@@ -0,0 +1,34 @@
+#include "core/loop_trigger.h"
+#include "hal.h"
+
+// GPIO callbacks are shared across pins, so only one trigger can be bound
+static loop_trigger_t* data_ready_trigger;
+
+static void data_ready_isr(uint8_t pin) {
+    (void)pin;
+    loop_trigger_signal(data_ready_trigger, hal_time_us());
+    hal_event_signal();
+}
+
+static uint64_t hal_now_us(void* ctx) {
+    (void)ctx;
+    return hal_time_us();
+}
+
+static void hal_wait_until(void* ctx, uint64_t deadline_us) {
+    (void)ctx;
+    hal_event_wait_until(deadline_us);
+}
+
+void loop_trigger_hal_init(loop_trigger_t* trigger, uint8_t int_pin, uint32_t period_us) {
+    const loop_trigger_port_t port = {
+        .now_us = hal_now_us,
+        .wait_until = hal_wait_until,
+        .ctx = NULL
+    };
+    loop_trigger_init(trigger, &port, period_us);
+
+    data_ready_trigger = trigger;
+    hal_gpio_input(int_pin, true);
+    hal_gpio_irq_rising(int_pin, data_ready_isr);
+}
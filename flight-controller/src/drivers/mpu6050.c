@@ -1,10 +1,12 @@
 #include "mpu6050.h"
-#include "hardware/i2c.h"
-#include "hardware/gpio.h"
+#include "hal.h"
 #include <string.h>
-#include <stdlib.h>
+#include "../utils/heap_guard.h"
 
 #define I2C_FREQ 400000  // 400 kHz
+#define MPU6050_BURST_LEN 14  // accel (6) + temp (2) + gyro (6)
+#define MPU6050_ASYNC_BURST_LEN (1 + MPU6050_BURST_LEN)  // INT_STATUS first
+#define MPU6050_FIFO_DRAIN_MAX 16  // Frames fetched per FIFO burst
 
 // Scaling factors for raw values
 static const float GYRO_SCALE_250  = 131.0f;    // LSB/(°/s) for ±250°/s
@@ -18,47 +20,118 @@ static const float ACCEL_SCALE_8G  = 4096.0f;   // LSB/g for ±8g
 static const float ACCEL_SCALE_16G = 2048.0f;   // LSB/g for ±16g
 
 struct mpu6050_dev {
-    i2c_inst_t* i2c;
+    i2c_bus_t* bus;
     uint8_t addr;
     float gyro_scale;
     float accel_scale;
     vector3_t gyro_offset;
     vector3_t accel_offset;
+    int16_t gyro_offset_counts[3];  // The offsets rounded, for the fixed-point path
+    int16_t accel_offset_counts[3];
+
+    // Double-buffered burst slots for asynchronous reads. The bus fills
+    // slots[fill_slot] while consumers decode slots[fill_slot ^ 1].
+    uint8_t slots[2][MPU6050_ASYNC_BURST_LEN];
+    uint8_t fill_slot;
+    bool transfer_pending;
+    bool sample_ready;
+    uint32_t async_errors;
+
+    // Oversampling sum of the fresh bursts since the last read_average()
+    int32_t accel_sum[3];
+    int32_t gyro_sum[3];
+    uint32_t sum_count;
+    vector3_t mean_accel;
+    vector3_t mean_gyro;
+    bool have_mean;
+    uint32_t sample_period_us;
+    uint64_t last_fresh_us;
+    mpu6050_sample_stats_t sample_stats;
+
+    uint8_t int_enable;
+    bool fifo_overflowed;       // FIFO_OFLOW seen by a burst's INT_STATUS read
+    mpu6050_fifo_stats_t fifo_stats;
 };
 
+_Static_assert(sizeof(struct mpu6050_dev) <= sizeof(mpu6050_storage_t),
+               "MPU6050_STORAGE_SIZE is too small for mpu6050_t");
+
 static inline int16_t combine_bytes(uint8_t msb, uint8_t lsb) {
     return (int16_t)((msb << 8) | lsb);
 }
 
 static bool mpu6050_write_reg(mpu6050_t* dev, uint8_t reg, uint8_t data) {
     uint8_t buf[2] = {reg, data};
-    return i2c_write_timeout_us(dev->i2c, dev->addr, buf, 2, false, 1000000) == 2;
+    return i2c_bus_write(dev->bus, dev->addr, buf, 2, false) == 2;
 }
 
 static uint8_t mpu6050_read_reg(mpu6050_t* dev, uint8_t reg) {
-    uint8_t data;
-    i2c_write_timeout_us(dev->i2c, dev->addr, &reg, 1, true, 1000000);
-    i2c_read_timeout_us(dev->i2c, dev->addr, &data, 1, false, 1000000);
+    uint8_t data = 0;
+    i2c_bus_write(dev->bus, dev->addr, &reg, 1, true);
+    i2c_bus_read(dev->bus, dev->addr, &data, 1, false);
     return data;
 }
 
+// Blocking transfers must not interleave with a burst already on the bus
+static void wait_for_async(mpu6050_t* dev) {
+    while (dev->transfer_pending) {
+        mpu6050_read_async_poll(dev);
+    }
+}
+
+#if !FC_STATIC_ALLOC
 mpu6050_t* mpu6050_init(uint8_t sda_pin, uint8_t scl_pin, const mpu6050_config_t* config) {
-    mpu6050_t* dev = malloc(sizeof(mpu6050_t));
-    if (dev == NULL) return NULL;
+    mpu6050_storage_t* storage = malloc(sizeof(mpu6050_storage_t));
+    if (storage == NULL) return NULL;
+
+    mpu6050_t* dev = mpu6050_setup(storage, sda_pin, scl_pin, config);
+    if (dev == NULL) free(storage);
+    return dev;
+}
+
+mpu6050_t* mpu6050_init_with_bus(i2c_bus_t* bus, const mpu6050_config_t* config) {
+    mpu6050_storage_t* storage = malloc(sizeof(mpu6050_storage_t));
+    if (storage == NULL) return NULL;
+
+    mpu6050_t* dev = mpu6050_setup_with_bus(storage, bus, config);
+    if (dev == NULL) free(storage);
+    return dev;
+}
+#endif
 
-    // Initialize I2C
-    dev->i2c = i2c0;  // Use I2C0 by default
+mpu6050_t* mpu6050_setup(mpu6050_storage_t* storage, uint8_t sda_pin, uint8_t scl_pin,
+                         const mpu6050_config_t* config) {
+    // Use I2C0 by default
+    return mpu6050_setup_with_bus(storage, hal_i2c_init(0, sda_pin, scl_pin, I2C_FREQ), config);
+}
+
+mpu6050_t* mpu6050_setup_with_bus(mpu6050_storage_t* storage, i2c_bus_t* bus,
+                                  const mpu6050_config_t* config) {
+    if (bus == NULL) return NULL;
+    mpu6050_t* dev = (mpu6050_t*)storage;
+
+    dev->bus = bus;
     dev->addr = MPU6050_ADDR;
-    
-    i2c_init(dev->i2c, I2C_FREQ);
-    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
-    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
-    gpio_pull_up(sda_pin);
-    gpio_pull_up(scl_pin);
+    dev->fill_slot = 0;
+    dev->transfer_pending = false;
+    dev->sample_ready = false;
+    dev->async_errors = 0;
+    dev->int_enable = 0;
+    memset(&dev->fifo_stats, 0, sizeof(mpu6050_fifo_stats_t));
+    memset(dev->accel_sum, 0, sizeof(dev->accel_sum));
+    memset(dev->gyro_sum, 0, sizeof(dev->gyro_sum));
+    dev->sum_count = 0;
+    dev->have_mean = false;
+    dev->last_fresh_us = 0;
+    memset(&dev->sample_stats, 0, sizeof(mpu6050_sample_stats_t));
+
+    // The gyro output rate is 8 kHz with the DLPF off (0 or 7), 1 kHz with it on
+    uint32_t output_hz = (config->dlpf_bandwidth == 0 || config->dlpf_bandwidth >= 7) ? 8000 : 1000;
+    dev->sample_period_us = (1u + config->sample_rate_div) * 1000000u / output_hz;
     
     // Reset the device
     mpu6050_write_reg(dev, MPU6050_REG_PWR_MGMT_1, 0x80);
-    sleep_ms(100);  // Wait for reset
+    hal_sleep_ms(100);  // Wait for reset
     
     // Wake up
     mpu6050_write_reg(dev, MPU6050_REG_PWR_MGMT_1, 0x00);
@@ -93,6 +166,8 @@ mpu6050_t* mpu6050_init(uint8_t sda_pin, uint8_t scl_pin, const mpu6050_config_t
     // Initialize offsets to zero
     memset(&dev->gyro_offset, 0, sizeof(vector3_t));
     memset(&dev->accel_offset, 0, sizeof(vector3_t));
+    memset(dev->gyro_offset_counts, 0, sizeof(dev->gyro_offset_counts));
+    memset(dev->accel_offset_counts, 0, sizeof(dev->accel_offset_counts));
     
     return dev;
 }
@@ -101,6 +176,19 @@ bool mpu6050_test_connection(mpu6050_t* dev) {
     return mpu6050_read_reg(dev, MPU6050_REG_WHO_AM_I) == 0x68;
 }
 
+bool mpu6050_enable_data_ready_interrupt(mpu6050_t* dev) {
+    wait_for_async(dev);
+
+    // Unlatched pulse so a missed status read can never wedge the line high
+    bool ok = mpu6050_write_reg(dev, MPU6050_REG_INT_PIN_CFG, MPU6050_INT_PIN_RD_CLEAR);
+    dev->int_enable |= MPU6050_INT_DATA_RDY;
+    return ok && mpu6050_write_reg(dev, MPU6050_REG_INT_ENABLE, dev->int_enable);
+}
+
+static int16_t round_counts(float x) {
+    return q15_sat((int32_t)(x >= 0.0f ? x + 0.5f : x - 0.5f));
+}
+
 void mpu6050_calibrate(mpu6050_t* dev, int num_samples) {
     vector3_t gyro_sum = {0};
     vector3_t accel_sum = {0};
@@ -118,7 +206,7 @@ void mpu6050_calibrate(mpu6050_t* dev, int num_samples) {
         accel_sum.y += accel.y;
         accel_sum.z += accel.z;
         
-        sleep_ms(2);  // Wait for next sample
+        hal_sleep_ms(2);  // Wait for next sample
     }
     
     // Calculate average offsets
@@ -130,17 +218,16 @@ void mpu6050_calibrate(mpu6050_t* dev, int num_samples) {
     dev->accel_offset.x = accel_sum.x / num_samples;
     dev->accel_offset.y = accel_sum.y / num_samples;
     dev->accel_offset.z = (accel_sum.z / num_samples) - dev->accel_scale; // Remove 1g
+
+    dev->gyro_offset_counts[0] = round_counts(dev->gyro_offset.x);
+    dev->gyro_offset_counts[1] = round_counts(dev->gyro_offset.y);
+    dev->gyro_offset_counts[2] = round_counts(dev->gyro_offset.z);
+    dev->accel_offset_counts[0] = round_counts(dev->accel_offset.x);
+    dev->accel_offset_counts[1] = round_counts(dev->accel_offset.y);
+    dev->accel_offset_counts[2] = round_counts(dev->accel_offset.z);
 }
 
-void mpu6050_read_raw(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro) {
-    uint8_t buffer[14];
-    uint8_t reg = MPU6050_REG_ACCEL_XOUT_H;
-    
-    // Read all data at once (6 bytes accel, 2 bytes temp, 6 bytes gyro)
-    i2c_write_timeout_us(dev->i2c, dev->addr, &reg, 1, true, 1000000);
-    i2c_read_timeout_us(dev->i2c, dev->addr, buffer, 14, false, 1000000);
-    
-    // Combine bytes and store in vectors
+static void decode_burst(const uint8_t* buffer, vector3_t* accel, vector3_t* gyro) {
     accel->x = combine_bytes(buffer[0], buffer[1]);
     accel->y = combine_bytes(buffer[2], buffer[3]);
     accel->z = combine_bytes(buffer[4], buffer[5]);
@@ -150,16 +237,277 @@ void mpu6050_read_raw(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro) {
     gyro->z = combine_bytes(buffer[12], buffer[13]);
 }
 
+void mpu6050_scale_sample(const mpu6050_t* dev,
+                          const vector3_t* raw_accel, const vector3_t* raw_gyro,
+                          vector3_t* accel, vector3_t* gyro) {
+    accel->x = (raw_accel->x - dev->accel_offset.x) / dev->accel_scale;
+    accel->y = (raw_accel->y - dev->accel_offset.y) / dev->accel_scale;
+    accel->z = (raw_accel->z - dev->accel_offset.z) / dev->accel_scale;
+    
+    gyro->x = (raw_gyro->x - dev->gyro_offset.x) / dev->gyro_scale;
+    gyro->y = (raw_gyro->y - dev->gyro_offset.y) / dev->gyro_scale;
+    gyro->z = (raw_gyro->z - dev->gyro_offset.z) / dev->gyro_scale;
+}
+
+void mpu6050_scale_sample_q15(const mpu6050_t* dev,
+                              const int16_t raw_accel[3], const int16_t raw_gyro[3],
+                              vector3_q15_t* accel, vector3_q15_t* gyro) {
+    accel->x = q15_sub(raw_accel[0], dev->accel_offset_counts[0]);
+    accel->y = q15_sub(raw_accel[1], dev->accel_offset_counts[1]);
+    accel->z = q15_sub(raw_accel[2], dev->accel_offset_counts[2]);
+
+    gyro->x = q15_sub(raw_gyro[0], dev->gyro_offset_counts[0]);
+    gyro->y = q15_sub(raw_gyro[1], dev->gyro_offset_counts[1]);
+    gyro->z = q15_sub(raw_gyro[2], dev->gyro_offset_counts[2]);
+}
+
+float mpu6050_accel_full_scale(const mpu6050_t* dev) {
+    return 32768.0f / dev->accel_scale;
+}
+
+float mpu6050_gyro_full_scale(const mpu6050_t* dev) {
+    return 32768.0f / dev->gyro_scale;
+}
+
+void mpu6050_read_raw(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro) {
+    uint8_t buffer[MPU6050_BURST_LEN];
+    uint8_t reg = MPU6050_REG_ACCEL_XOUT_H;
+    
+    wait_for_async(dev);
+
+    // Read all data at once (6 bytes accel, 2 bytes temp, 6 bytes gyro)
+    i2c_bus_write(dev->bus, dev->addr, &reg, 1, true);
+    i2c_bus_read(dev->bus, dev->addr, buffer, MPU6050_BURST_LEN, false);
+    
+    decode_burst(buffer, accel, gyro);
+}
+
 void mpu6050_read_scaled(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro) {
     vector3_t raw_accel, raw_gyro;
     mpu6050_read_raw(dev, &raw_accel, &raw_gyro);
-    
-    // Apply scaling and remove offsets
-    accel->x = (raw_accel.x - dev->accel_offset.x) / dev->accel_scale;
-    accel->y = (raw_accel.y - dev->accel_offset.y) / dev->accel_scale;
-    accel->z = (raw_accel.z - dev->accel_offset.z) / dev->accel_scale;
-    
-    gyro->x = (raw_gyro.x - dev->gyro_offset.x) / dev->gyro_scale;
-    gyro->y = (raw_gyro.y - dev->gyro_offset.y) / dev->gyro_scale;
-    gyro->z = (raw_gyro.z - dev->gyro_offset.z) / dev->gyro_scale;
+    mpu6050_scale_sample(dev, &raw_accel, &raw_gyro, accel, gyro);
+}
+
+bool mpu6050_read_async_start(mpu6050_t* dev) {
+    if (dev->transfer_pending) return false;
+
+    dev->transfer_pending = i2c_bus_read_reg_async(dev->bus, dev->addr,
+                                                   MPU6050_REG_INT_STATUS,
+                                                   dev->slots[dev->fill_slot],
+                                                   MPU6050_ASYNC_BURST_LEN);
+    return dev->transfer_pending;
+}
+
+// Runs once per landed burst, whoever polls it
+static void account_burst(mpu6050_t* dev, const uint8_t* burst) {
+    // Reading INT_STATUS cleared it; keep the overflow for the next drain
+    if (burst[0] & MPU6050_INT_FIFO_OFLOW) dev->fifo_overflowed = true;
+    if (!(burst[0] & MPU6050_INT_DATA_RDY)) {
+        dev->sample_stats.duplicates++;
+        return;
+    }
+
+    uint64_t now = hal_time_us();
+    if (dev->sample_stats.fresh > 0) {
+        uint64_t periods = (now - dev->last_fresh_us + dev->sample_period_us / 2) /
+                           dev->sample_period_us;
+        if (periods > 1) dev->sample_stats.skipped += (uint32_t)(periods - 1);
+    }
+    dev->last_fresh_us = now;
+    dev->sample_stats.fresh++;
+
+    const uint8_t* data = &burst[1];
+    for (int i = 0; i < 3; i++) {
+        dev->accel_sum[i] += combine_bytes(data[2 * i], data[2 * i + 1]);
+        dev->gyro_sum[i] += combine_bytes(data[8 + 2 * i], data[8 + 2 * i + 1]);
+    }
+    dev->sum_count++;
+}
+
+mpu6050_async_status_t mpu6050_read_async_poll(mpu6050_t* dev) {
+    if (!dev->transfer_pending) {
+        return dev->sample_ready ? MPU6050_ASYNC_IDLE : MPU6050_ASYNC_EMPTY;
+    }
+
+    switch (i2c_bus_poll(dev->bus)) {
+        case I2C_BUS_DONE:
+            // Publish the filled slot and hand the other one to the next burst
+            account_burst(dev, dev->slots[dev->fill_slot]);
+            dev->fill_slot ^= 1;
+            dev->sample_ready = true;
+            dev->transfer_pending = false;
+            return MPU6050_ASYNC_READY;
+        case I2C_BUS_BUSY:
+            return MPU6050_ASYNC_BUSY;
+        default:
+            dev->async_errors++;
+            dev->transfer_pending = false;
+            return MPU6050_ASYNC_ERROR;
+    }
+}
+
+bool mpu6050_read_async_complete(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro) {
+    if (!dev->sample_ready) return false;
+    decode_burst(&dev->slots[dev->fill_slot ^ 1][1], accel, gyro);
+    return true;
+}
+
+bool mpu6050_read_async_complete_scaled(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro) {
+    vector3_t raw_accel, raw_gyro;
+    if (!mpu6050_read_async_complete(dev, &raw_accel, &raw_gyro)) return false;
+    mpu6050_scale_sample(dev, &raw_accel, &raw_gyro, accel, gyro);
+    return true;
+}
+
+uint32_t mpu6050_async_error_count(const mpu6050_t* dev) {
+    return dev->async_errors;
+}
+
+int mpu6050_read_average(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro) {
+    int count = (int)dev->sum_count;
+
+    if (count > 0) {
+        float inv = 1.0f / (float)count;
+        dev->mean_accel = (vector3_t){ dev->accel_sum[0] * inv, dev->accel_sum[1] * inv,
+                                       dev->accel_sum[2] * inv };
+        dev->mean_gyro = (vector3_t){ dev->gyro_sum[0] * inv, dev->gyro_sum[1] * inv,
+                                      dev->gyro_sum[2] * inv };
+        dev->have_mean = true;
+        memset(dev->accel_sum, 0, sizeof(dev->accel_sum));
+        memset(dev->gyro_sum, 0, sizeof(dev->gyro_sum));
+        dev->sum_count = 0;
+    } else if (!dev->have_mean) {
+        // Bursts landed but none was flagged fresh: hold the latest one
+        if (!mpu6050_read_async_complete(dev, &dev->mean_accel, &dev->mean_gyro)) return -1;
+        dev->have_mean = true;
+    }
+
+    *accel = dev->mean_accel;
+    *gyro = dev->mean_gyro;
+    return count;
+}
+
+const mpu6050_sample_stats_t* mpu6050_get_sample_stats(const mpu6050_t* dev) {
+    return &dev->sample_stats;
+}
+
+static void decode_fifo_frame(const uint8_t* buffer, mpu6050_fifo_frame_t* frame) {
+    frame->accel.x = combine_bytes(buffer[0], buffer[1]);
+    frame->accel.y = combine_bytes(buffer[2], buffer[3]);
+    frame->accel.z = combine_bytes(buffer[4], buffer[5]);
+
+    frame->gyro.x = combine_bytes(buffer[6], buffer[7]);
+    frame->gyro.y = combine_bytes(buffer[8], buffer[9]);
+    frame->gyro.z = combine_bytes(buffer[10], buffer[11]);
+}
+
+int mpu6050_fifo_parse(const uint8_t* data, int len,
+                       mpu6050_fifo_frame_t* frames, int max_frames,
+                       mpu6050_fifo_stats_t* stats) {
+    int count = len / MPU6050_FIFO_FRAME_LEN;
+    if (count > max_frames) count = max_frames;
+
+    for (int i = 0; i < count; i++) {
+        decode_fifo_frame(&data[i * MPU6050_FIFO_FRAME_LEN], &frames[i]);
+        frames[i].seq = stats->next_seq++;
+    }
+
+    stats->frames += count;
+    return count;
+}
+
+bool mpu6050_fifo_enable(mpu6050_t* dev) {
+    wait_for_async(dev);
+
+    bool ok = mpu6050_write_reg(dev, MPU6050_REG_USER_CTRL, 0);
+    ok = ok && mpu6050_write_reg(dev, MPU6050_REG_FIFO_EN,
+                                 MPU6050_FIFO_EN_XG | MPU6050_FIFO_EN_YG |
+                                 MPU6050_FIFO_EN_ZG | MPU6050_FIFO_EN_ACCEL);
+
+    // Enabled so INT_STATUS latches FIFO_OFLOW for drain(). The overflow is
+    // raised by a sample write, so on the INT pin it falls in the same
+    // pulse as that sample's DATA_RDY rather than adding a loop tick.
+    dev->int_enable |= MPU6050_INT_FIFO_OFLOW;
+    ok = ok && mpu6050_write_reg(dev, MPU6050_REG_INT_ENABLE, dev->int_enable);
+    ok = ok && mpu6050_write_reg(dev, MPU6050_REG_USER_CTRL,
+                                 MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RESET);
+
+    memset(&dev->fifo_stats, 0, sizeof(mpu6050_fifo_stats_t));
+    dev->fifo_overflowed = false;
+    return ok;
+}
+
+void mpu6050_fifo_reset(mpu6050_t* dev) {
+    wait_for_async(dev);
+    mpu6050_write_reg(dev, MPU6050_REG_USER_CTRL,
+                      MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RESET);
+}
+
+// Discards what the FIFO holds after it wrapped: the frames it held, as
+// many as pending bytes make, are lost and skipped in the sequence. The
+// status read clears a FIFO_OFLOW latched before the reset.
+static void fifo_overflow(mpu6050_t* dev, int pending) {
+    uint32_t lost = (uint32_t)pending / MPU6050_FIFO_FRAME_LEN;
+    mpu6050_fifo_reset(dev);
+    mpu6050_read_reg(dev, MPU6050_REG_INT_STATUS);
+    dev->fifo_overflowed = false;
+    dev->fifo_stats.overflows++;
+    dev->fifo_stats.lost_frames += lost;
+    dev->fifo_stats.next_seq += lost;
+}
+
+int mpu6050_fifo_drain(mpu6050_t* dev, mpu6050_fifo_frame_t* frames, int max_frames) {
+    uint8_t buffer[MPU6050_FIFO_DRAIN_MAX * MPU6050_FIFO_FRAME_LEN];
+    uint8_t count_buf[2];
+    uint8_t reg = MPU6050_REG_FIFO_COUNTH;
+
+    wait_for_async(dev);
+
+    if (i2c_bus_write(dev->bus, dev->addr, &reg, 1, true) != 1 ||
+        i2c_bus_read(dev->bus, dev->addr, count_buf, 2, false) != 2) {
+        return -1;
+    }
+    int pending = (count_buf[0] << 8) | count_buf[1];
+
+    // The FIFO only has room for MPU6050_FIFO_MAX_FRAMES whole frames; any
+    // byte beyond that means the sensor wrapped and frame alignment is lost.
+    if (dev->fifo_overflowed || pending > MPU6050_FIFO_MAX_FRAMES * MPU6050_FIFO_FRAME_LEN) {
+        fifo_overflow(dev, pending);
+        return 0;
+    }
+
+    int wanted = pending / MPU6050_FIFO_FRAME_LEN;
+    if (wanted > max_frames) wanted = max_frames;
+    if (wanted > MPU6050_FIFO_DRAIN_MAX) wanted = MPU6050_FIFO_DRAIN_MAX;
+
+    int len = wanted * MPU6050_FIFO_FRAME_LEN;
+    if (len > 0) {
+        reg = MPU6050_REG_FIFO_R_W;
+        dev->fifo_stats.drains++;
+        if (i2c_bus_write(dev->bus, dev->addr, &reg, 1, true) != 1 ||
+            i2c_bus_read(dev->bus, dev->addr, buffer, len, false) != len) {
+            return -1;
+        }
+    }
+
+    // FIFO_OFLOW, read after the data and cleared by the read, covers every
+    // write since the last drain: after a wrap, frames already read may be
+    // misaligned, so they are dropped with the rest
+    uint8_t status;
+    reg = MPU6050_REG_INT_STATUS;
+    if (i2c_bus_write(dev->bus, dev->addr, &reg, 1, true) != 1 ||
+        i2c_bus_read(dev->bus, dev->addr, &status, 1, false) != 1) {
+        return -1;
+    }
+    if (status & MPU6050_INT_FIFO_OFLOW) {
+        fifo_overflow(dev, pending);
+        return 0;
+    }
+    if (len == 0) return 0;
+
+    return mpu6050_fifo_parse(buffer, len, frames, wanted, &dev->fifo_stats);
+}
+
+const mpu6050_fifo_stats_t* mpu6050_fifo_get_stats(const mpu6050_t* dev) {
+    return &dev->fifo_stats;
 }
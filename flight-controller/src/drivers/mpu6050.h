@@ -1,9 +1,11 @@
 // flight-controller/src/drivers/mpu6050.h
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "../include/types.h"
-#include "system.h"
+#include "i2c_bus.h"
+#include "../utils/fixed_point.h"
 
 // MPU6050 registers
 #define MPU6050_ADDR              0x68
@@ -12,12 +14,39 @@
 #define MPU6050_REG_GYRO_CONFIG  0x1B
 #define MPU6050_REG_ACCEL_CONFIG 0x1C
 #define MPU6050_REG_FIFO_EN      0x23
+#define MPU6050_REG_INT_PIN_CFG  0x37
 #define MPU6050_REG_INT_ENABLE   0x38
+#define MPU6050_REG_INT_STATUS   0x3A
 #define MPU6050_REG_ACCEL_XOUT_H 0x3B
 #define MPU6050_REG_GYRO_XOUT_H  0x43
+#define MPU6050_REG_USER_CTRL    0x6A
 #define MPU6050_REG_PWR_MGMT_1   0x6B
+#define MPU6050_REG_FIFO_COUNTH  0x72
+#define MPU6050_REG_FIFO_R_W     0x74
 #define MPU6050_REG_WHO_AM_I     0x75
 
+// FIFO_EN bits
+#define MPU6050_FIFO_EN_XG       0x40
+#define MPU6050_FIFO_EN_YG       0x20
+#define MPU6050_FIFO_EN_ZG       0x10
+#define MPU6050_FIFO_EN_ACCEL    0x08
+
+// USER_CTRL bits
+#define MPU6050_USER_CTRL_FIFO_EN    0x40
+#define MPU6050_USER_CTRL_FIFO_RESET 0x04
+
+// INT_PIN_CFG bits
+#define MPU6050_INT_PIN_RD_CLEAR 0x10
+
+// INT_ENABLE / INT_STATUS bits
+#define MPU6050_INT_FIFO_OFLOW   0x10
+#define MPU6050_INT_DATA_RDY     0x01
+
+// FIFO geometry: each frame is accel XYZ followed by gyro XYZ, big-endian
+#define MPU6050_FIFO_SIZE        1024
+#define MPU6050_FIFO_FRAME_LEN   12
+#define MPU6050_FIFO_MAX_FRAMES  (MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_LEN)
+
 typedef struct {
     uint8_t gyro_range;     // 0=±250°/s, 1=±500°/s, 2=±1000°/s, 3=±2000°/s
     uint8_t accel_range;    // 0=±2g, 1=±4g, 2=±8g, 3=±16g
@@ -25,13 +54,117 @@ typedef struct {
     uint8_t sample_rate_div;// Sample Rate = 1kHz / (1 + sample_rate_div)
 } mpu6050_config_t;
 
+// Progress of a background burst read
+typedef enum {
+    MPU6050_ASYNC_EMPTY,  // No transfer running and no sample captured yet
+    MPU6050_ASYNC_IDLE,   // No transfer running, last sample still available
+    MPU6050_ASYNC_BUSY,   // Burst in flight
+    MPU6050_ASYNC_READY,  // Burst just completed and was published
+    MPU6050_ASYNC_ERROR   // Burst aborted, previous sample kept
+} mpu6050_async_status_t;
+
+// One accel+gyro frame drained from the FIFO, in raw counts
+typedef struct {
+    vector3_t accel;
+    vector3_t gyro;
+    uint32_t seq;           // Sample index since the FIFO was enabled
+} mpu6050_fifo_frame_t;
+
+// Freshness of the asynchronous bursts. Every burst also reads INT_STATUS,
+// whose DATA_RDY bit says whether the sensor latched a new sample since
+// the previous read.
+typedef struct {
+    uint32_t fresh;         // Bursts carrying a new sample
+    uint32_t duplicates;    // Bursts that repeated the previous sample
+    uint32_t skipped;       // Sensor updates overwritten before any burst read them
+} mpu6050_sample_stats_t;
+
+typedef struct {
+    uint32_t next_seq;
+    uint32_t frames;        // Frames delivered to the caller
+    uint32_t overflows;     // Times the FIFO filled up and had to be reset
+    uint32_t lost_frames;   // Frames discarded by overflow resets
+    uint32_t drains;        // Burst transactions issued
+} mpu6050_fifo_stats_t;
+
 // Forward declaration
 typedef struct mpu6050_dev mpu6050_t;
 
-// Function declarations
+// Room for a device set up in place with mpu6050_setup(); mpu6050.c
+// checks that it fits
+#define MPU6050_STORAGE_SIZE 224
+typedef union {
+    uint8_t bytes[MPU6050_STORAGE_SIZE];
+    uint64_t align;
+} mpu6050_storage_t;
+
+// Function declarations. Each returns NULL, with nothing left allocated, if
+// the bus can't be set up (or is NULL).
+#if !FC_STATIC_ALLOC
 mpu6050_t* mpu6050_init(uint8_t sda_pin, uint8_t scl_pin, const mpu6050_config_t* config);
+mpu6050_t* mpu6050_init_with_bus(i2c_bus_t* bus, const mpu6050_config_t* config);
+#endif
+mpu6050_t* mpu6050_setup(mpu6050_storage_t* storage, uint8_t sda_pin, uint8_t scl_pin,
+                         const mpu6050_config_t* config);
+mpu6050_t* mpu6050_setup_with_bus(mpu6050_storage_t* storage, i2c_bus_t* bus,
+                                  const mpu6050_config_t* config);
 bool mpu6050_test_connection(mpu6050_t* dev);
+// Pulse the INT pin (active high, ~50 us) whenever a new sample is ready
+bool mpu6050_enable_data_ready_interrupt(mpu6050_t* dev);
 void mpu6050_calibrate(mpu6050_t* dev, int num_samples);
 void mpu6050_read_raw(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro);
 void mpu6050_read_scaled(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro);
+// Apply calibration offsets and range scaling to a raw sample (g, deg/s)
+void mpu6050_scale_sample(const mpu6050_t* dev,
+                          const vector3_t* raw_accel, const vector3_t* raw_gyro,
+                          vector3_t* accel, vector3_t* gyro);
+// Fixed-point mpu6050_scale_sample(). Subtracts the calibration offsets,
+// rounded to whole counts, with saturation. The results are Q15 fractions
+// of the configured range: 1.0 is mpu6050_accel_full_scale() g or
+// mpu6050_gyro_full_scale() deg/s. Against the float path the error is at
+// most half a count before saturation.
+void mpu6050_scale_sample_q15(const mpu6050_t* dev,
+                              const int16_t raw_accel[3], const int16_t raw_gyro[3],
+                              vector3_q15_t* accel, vector3_q15_t* gyro);
+float mpu6050_accel_full_scale(const mpu6050_t* dev);
+float mpu6050_gyro_full_scale(const mpu6050_t* dev);
+
+// Asynchronous burst reads. start() queues a transfer into the back slot,
+// poll() publishes it once the bus reports completion and complete() decodes
+// the most recently published slot, so the caller can process one sample
+// while the next one is on the bus.
+bool mpu6050_read_async_start(mpu6050_t* dev);
+mpu6050_async_status_t mpu6050_read_async_poll(mpu6050_t* dev);
+bool mpu6050_read_async_complete(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro);
+bool mpu6050_read_async_complete_scaled(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro);
+uint32_t mpu6050_async_error_count(const mpu6050_t* dev);
+
+// Oversampling. Every fresh burst that lands is added to a running sum;
+// read_average() returns the mean of the samples summed since its last
+// call, in raw counts, and restarts the sum. It returns how many samples
+// it averaged: 0 if none arrived, with the previous mean repeated, or -1
+// if no burst has ever landed, with accel and gyro untouched. Polling at
+// the sensor rate or faster keeps every update; a gap of more than one
+// sample period between fresh bursts counts as skipped samples.
+int mpu6050_read_average(mpu6050_t* dev, vector3_t* accel, vector3_t* gyro);
+const mpu6050_sample_stats_t* mpu6050_get_sample_stats(const mpu6050_t* dev);
+
+// Hardware FIFO batch mode. drain() reads the FIFO count and then every
+// complete frame (up to max_frames) in a single burst, returning the number
+// of frames written or -1 on a bus error. It then reads INT_STATUS: when
+// FIFO_OFLOW is set, or the count is more than the FIFO holds, the FIFO
+// wrapped since the last drain. It is reset, the frames it held (those
+// just read included) are dropped and accounted for in the sequence
+// numbers. Reading INT_STATUS also clears DATA_RDY, so drain() is not
+// meant to be mixed with the asynchronous bursts; an overflow a burst
+// sees is still kept for the next drain.
+bool mpu6050_fifo_enable(mpu6050_t* dev);
+void mpu6050_fifo_reset(mpu6050_t* dev);
+int mpu6050_fifo_drain(mpu6050_t* dev, mpu6050_fifo_frame_t* frames, int max_frames);
+const mpu6050_fifo_stats_t* mpu6050_fifo_get_stats(const mpu6050_t* dev);
 
+// Decode whole frames from a raw FIFO dump, stamping consecutive sequence
+// numbers from stats. Trailing partial frames are ignored.
+int mpu6050_fifo_parse(const uint8_t* data, int len,
+                       mpu6050_fifo_frame_t* frames, int max_frames,
+                       mpu6050_fifo_stats_t* stats);
@@ -0,0 +1,94 @@
+#include "mpu6050_sim.h"
+#include "mpu6050.h"
+#include <math.h>
+#include <string.h>
+
+#define MPU6050_REG_TEMP_OUT_H 0x41
+#define MPU6050_SIM_TEMP_RAW   (-3920)   // 25 degC: (25 - 36.53) * 340
+
+static const float GYRO_LSB[4] = { 131.0f, 65.5f, 32.8f, 16.4f };
+static const float ACCEL_LSB[4] = { 16384.0f, 8192.0f, 4096.0f, 2048.0f };
+
+static void put_counts(uint8_t* dst, float value) {
+    float rounded = roundf(value);
+    if (rounded > 32767.0f) rounded = 32767.0f;
+    if (rounded < -32768.0f) rounded = -32768.0f;
+    int16_t counts = (int16_t)rounded;
+    dst[0] = (uint8_t)((uint16_t)counts >> 8);
+    dst[1] = (uint8_t)counts;
+}
+
+// Encode the sample with the ranges currently programmed
+static void refresh_data_regs(mpu6050_sim_t* sim) {
+    float accel_lsb = ACCEL_LSB[(sim->regs[MPU6050_REG_ACCEL_CONFIG] >> 3) & 3];
+    float gyro_lsb = GYRO_LSB[(sim->regs[MPU6050_REG_GYRO_CONFIG] >> 3) & 3];
+    uint8_t* a = &sim->regs[MPU6050_REG_ACCEL_XOUT_H];
+    uint8_t* g = &sim->regs[MPU6050_REG_GYRO_XOUT_H];
+
+    put_counts(&a[0], sim->accel.x * accel_lsb);
+    put_counts(&a[2], sim->accel.y * accel_lsb);
+    put_counts(&a[4], sim->accel.z * accel_lsb);
+    put_counts(&sim->regs[MPU6050_REG_TEMP_OUT_H], (float)MPU6050_SIM_TEMP_RAW);
+    put_counts(&g[0], sim->gyro.x * gyro_lsb);
+    put_counts(&g[2], sim->gyro.y * gyro_lsb);
+    put_counts(&g[4], sim->gyro.z * gyro_lsb);
+}
+
+static void reset_regs(mpu6050_sim_t* sim) {
+    memset(sim->regs, 0, sizeof(sim->regs));
+    sim->regs[MPU6050_REG_WHO_AM_I] = MPU6050_ADDR;
+    sim->regs[MPU6050_REG_PWR_MGMT_1] = 0x40;   // Asleep after reset
+}
+
+static int sim_write(void* ctx, const uint8_t* src, size_t len, bool nostop) {
+    (void)nostop;
+    mpu6050_sim_t* sim = ctx;
+    if (len == 0) return 0;
+
+    sim->reg_ptr = src[0] & 0x7F;
+    for (size_t i = 1; i < len; i++) {
+        uint8_t reg = sim->reg_ptr;
+        if (reg == MPU6050_REG_PWR_MGMT_1 && (src[i] & 0x80)) {
+            reset_regs(sim);
+        } else {
+            sim->regs[reg] = src[i];
+        }
+        sim->reg_ptr = (uint8_t)((reg + 1) & 0x7F);
+    }
+    return (int)len;
+}
+
+static int sim_read(void* ctx, uint8_t* dst, size_t len, bool nostop) {
+    (void)nostop;
+    mpu6050_sim_t* sim = ctx;
+
+    refresh_data_regs(sim);
+    bool clear_status = (sim->regs[MPU6050_REG_INT_PIN_CFG] & MPU6050_INT_PIN_RD_CLEAR) != 0;
+    for (size_t i = 0; i < len; i++) {
+        // FIFO_COUNTH/L stay zero
+        if (sim->reg_ptr == MPU6050_REG_INT_STATUS) clear_status = true;
+        dst[i] = sim->regs[sim->reg_ptr];
+        sim->reg_ptr = (uint8_t)((sim->reg_ptr + 1) & 0x7F);
+    }
+    if (clear_status) sim->regs[MPU6050_REG_INT_STATUS] = 0;
+    sim->reads++;
+    return (int)len;
+}
+
+bool mpu6050_sim_init(mpu6050_sim_t* sim, uint8_t instance) {
+    memset(sim, 0, sizeof(*sim));
+    reset_regs(sim);
+    sim->accel.z = 1.0f;
+
+    sim->device.addr = MPU6050_ADDR;
+    sim->device.write = sim_write;
+    sim->device.read = sim_read;
+    sim->device.ctx = sim;
+    return hal_linux_i2c_attach(instance, &sim->device);
+}
+
+void mpu6050_sim_set_sample(mpu6050_sim_t* sim, const vector3_t* accel, const vector3_t* gyro) {
+    sim->accel = *accel;
+    sim->gyro = *gyro;
+    sim->regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_DATA_RDY;
+}
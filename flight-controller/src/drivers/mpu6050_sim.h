@@ -0,0 +1,27 @@
+// flight-controller/src/drivers/mpu6050_sim.h
+#pragma once
+
+#include <stdint.h>
+#include "hal_linux.h"
+#include "../include/types.h"
+
+// Register-level MPU6050 model for the Linux HAL. The real mpu6050 driver
+// talks to it over the simulated I2C bus; the data registers hold whatever
+// was last set with mpu6050_sim_set_sample(), converted with the ranges the
+// driver programmed. Each new sample sets DATA_RDY in INT_STATUS, which
+// reading INT_STATUS clears (any read with INT_RD_CLEAR set). The FIFO is
+// not modeled and always reads empty.
+typedef struct {
+    hal_i2c_device_t device;
+    uint8_t regs[128];
+    uint8_t reg_ptr;            // Set by the first byte of every write
+    vector3_t accel;            // g
+    vector3_t gyro;             // deg/s
+    uint32_t reads;             // Read transactions served
+} mpu6050_sim_t;
+
+// Initialize a level, motionless sensor and attach it to I2C instance
+bool mpu6050_sim_init(mpu6050_sim_t* sim, uint8_t instance);
+
+// accel in g, gyro in deg/s
+void mpu6050_sim_set_sample(mpu6050_sim_t* sim, const vector3_t* accel, const vector3_t* gyro);
@@ -0,0 +1,247 @@
+// src/drivers/pio_sim.c
+#include "pio_sim.h"
+
+// Major opcodes, bits 15..13
+#define OP_JMP   0
+#define OP_IN    2
+#define OP_OUT   3
+#define OP_PULL  4      // PUSH when bit 7 is clear
+#define OP_MOV   5
+#define OP_SET   7
+
+// Destinations and sources, bits 7..5 and 2..0
+#define REG_PINS 0
+#define REG_X    1
+#define REG_Y    2
+#define REG_NULL 3
+#define REG_PINDIRS 4
+#define REG_OSR  7
+
+static uint32_t pin_mask(const pio_sim_t* sm) {
+    return sm->pin_count >= 32 ? 0xFFFFFFFFu : (1u << sm->pin_count) - 1u;
+}
+
+void pio_sim_init(pio_sim_t* sm, const uint16_t* program, uint8_t length,
+                  uint8_t wrap_target, uint8_t wrap, uint8_t pin_count) {
+    sm->program = program;
+    sm->length = length;
+    sm->wrap_target = wrap_target;
+    sm->wrap = wrap;
+    sm->pin_count = pin_count;
+    pio_sim_set_out_shift(sm, false, true, 32);
+    pio_sim_set_in_shift(sm, false, false, 32);
+    sm->pc = wrap_target;
+    sm->delay = 0;
+    sm->x = 0;
+    sm->y = 0;
+    sm->osr = 0;
+    sm->osr_shifted = 32;
+    sm->pins = 0;
+    sm->pindirs = pin_mask(sm);
+    sm->inputs = 0;
+    sm->isr = 0;
+    sm->isr_shifted = 0;
+    sm->fifo_head = 0;
+    sm->fifo_count = 0;
+    sm->rx_head = 0;
+    sm->rx_count = 0;
+    sm->clocks = 0;
+}
+
+void pio_sim_set_out_shift(pio_sim_t* sm, bool shift_right, bool autopull, uint8_t threshold) {
+    sm->shift_right = shift_right;
+    sm->autopull = autopull;
+    sm->pull_threshold = threshold == 0 || threshold > 32 ? 32 : threshold;
+}
+
+void pio_sim_set_in_shift(pio_sim_t* sm, bool shift_right, bool autopush, uint8_t threshold) {
+    sm->in_shift_right = shift_right;
+    sm->autopush = autopush;
+    sm->push_threshold = threshold == 0 || threshold > 32 ? 32 : threshold;
+}
+
+bool pio_sim_put(pio_sim_t* sm, uint32_t word) {
+    if (sm->fifo_count == PIO_SIM_FIFO_DEPTH) return false;
+    sm->fifo[(sm->fifo_head + sm->fifo_count) % PIO_SIM_FIFO_DEPTH] = word;
+    sm->fifo_count++;
+    return true;
+}
+
+bool pio_sim_get(pio_sim_t* sm, uint32_t* word) {
+    if (sm->rx_count == 0) return false;
+    *word = sm->rx_fifo[sm->rx_head];
+    sm->rx_head = (uint8_t)((sm->rx_head + 1) % PIO_SIM_RX_FIFO_DEPTH);
+    sm->rx_count--;
+    return true;
+}
+
+uint32_t pio_sim_pin_levels(const pio_sim_t* sm) {
+    return ((sm->pins & sm->pindirs) | (sm->inputs & ~sm->pindirs)) & pin_mask(sm);
+}
+
+static bool pull(pio_sim_t* sm) {
+    if (sm->fifo_count == 0) return false;
+    sm->osr = sm->fifo[sm->fifo_head];
+    sm->fifo_head = (uint8_t)((sm->fifo_head + 1) % PIO_SIM_FIFO_DEPTH);
+    sm->fifo_count--;
+    sm->osr_shifted = 0;
+    return true;
+}
+
+static uint32_t shift_out(pio_sim_t* sm, int bits) {
+    uint32_t data;
+    if (bits == 32) {
+        data = sm->osr;
+        sm->osr = 0;
+    } else if (sm->shift_right) {
+        data = sm->osr & ((1u << bits) - 1u);
+        sm->osr >>= bits;
+    } else {
+        data = sm->osr >> (32 - bits);
+        sm->osr <<= bits;
+    }
+    sm->osr_shifted = (uint8_t)(sm->osr_shifted + bits > 32 ? 32 : sm->osr_shifted + bits);
+    return data;
+}
+
+static void shift_in(pio_sim_t* sm, uint32_t data, int bits) {
+    if (bits == 32) {
+        sm->isr = data;
+    } else if (sm->in_shift_right) {
+        sm->isr = (sm->isr >> bits) | ((data & ((1u << bits) - 1u)) << (32 - bits));
+    } else {
+        sm->isr = (sm->isr << bits) | (data & ((1u << bits) - 1u));
+    }
+    sm->isr_shifted = (uint8_t)(sm->isr_shifted + bits > 32 ? 32 : sm->isr_shifted + bits);
+}
+
+static bool write_reg(pio_sim_t* sm, int dest, uint32_t value) {
+    switch (dest) {
+        case REG_PINS: sm->pins = value & pin_mask(sm); return true;
+        case REG_X: sm->x = value; return true;
+        case REG_Y: sm->y = value; return true;
+        case REG_NULL: return true;
+        default: return false;
+    }
+}
+
+static bool jump_taken(pio_sim_t* sm, int condition, bool* supported) {
+    *supported = true;
+    switch (condition) {
+        case 0: return true;
+        case 1: return sm->x == 0;
+        case 2: return sm->x-- != 0;
+        case 3: return sm->y == 0;
+        case 4: return sm->y-- != 0;
+        case 5: return sm->x != sm->y;
+        case 7: return sm->osr_shifted < sm->pull_threshold;
+        default: *supported = false; return false;
+    }
+}
+
+pio_sim_result_t pio_sim_step(pio_sim_t* sm) {
+    sm->clocks++;
+    if (sm->delay > 0) {
+        sm->delay--;
+        return PIO_SIM_RAN;
+    }
+    if (sm->pc >= sm->length) return PIO_SIM_UNSUPPORTED;
+
+    uint16_t instr = sm->program[sm->pc];
+    int op = instr >> 13;
+    int dest = (instr >> 5) & 7;
+    int next = sm->pc == sm->wrap ? sm->wrap_target : sm->pc + 1;
+
+    switch (op) {
+        case OP_JMP: {
+            bool supported;
+            if (jump_taken(sm, dest, &supported)) next = instr & 0x1F;
+            if (!supported) return PIO_SIM_UNSUPPORTED;
+            break;
+        }
+        case OP_IN: {
+            int bits = instr & 0x1F;
+            uint32_t value;
+            if (bits == 0) bits = 32;
+            switch (dest) {
+                case REG_PINS: value = pio_sim_pin_levels(sm); break;
+                case REG_X: value = sm->x; break;
+                case REG_Y: value = sm->y; break;
+                case REG_NULL: value = 0; break;
+                default: return PIO_SIM_UNSUPPORTED;
+            }
+            bool push = sm->autopush && sm->isr_shifted + bits >= sm->push_threshold;
+            if (push && sm->rx_count == PIO_SIM_RX_FIFO_DEPTH) return PIO_SIM_STALLED;
+            shift_in(sm, value, bits);
+            if (push) {
+                sm->rx_fifo[(sm->rx_head + sm->rx_count) % PIO_SIM_RX_FIFO_DEPTH] = sm->isr;
+                sm->rx_count++;
+                sm->isr = 0;
+                sm->isr_shifted = 0;
+            }
+            break;
+        }
+        case OP_OUT: {
+            int bits = instr & 0x1F;
+            if (bits == 0) bits = 32;
+            if (sm->autopull && sm->osr_shifted >= sm->pull_threshold && !pull(sm)) {
+                return PIO_SIM_STALLED;
+            }
+            if (!write_reg(sm, dest, shift_out(sm, bits))) return PIO_SIM_UNSUPPORTED;
+            break;
+        }
+        case OP_PULL: {
+            bool if_empty = instr & 0x40;
+            bool block = instr & 0x20;
+            if (!(instr & 0x80)) return PIO_SIM_UNSUPPORTED;
+            if (if_empty && sm->osr_shifted < sm->pull_threshold) break;
+            if (!pull(sm)) {
+                if (block) return PIO_SIM_STALLED;
+                sm->osr = sm->x;
+            }
+            break;
+        }
+        case OP_MOV: {
+            uint32_t value;
+            switch (instr & 7) {
+                case REG_PINS: value = pio_sim_pin_levels(sm); break;
+                case REG_X: value = sm->x; break;
+                case REG_Y: value = sm->y; break;
+                case REG_NULL: value = 0; break;
+                case REG_OSR: value = sm->osr; break;
+                default: return PIO_SIM_UNSUPPORTED;
+            }
+            switch ((instr >> 3) & 3) {
+                case 0: break;
+                case 1: value = ~value; break;
+                case 2: {
+                    uint32_t r = 0;
+                    for (int i = 0; i < 32; i++) r |= ((value >> i) & 1u) << (31 - i);
+                    value = r;
+                    break;
+                }
+                default: return PIO_SIM_UNSUPPORTED;
+            }
+            if (dest == REG_OSR) {
+                sm->osr = value;
+                sm->osr_shifted = 0;
+            } else if (!write_reg(sm, dest, value)) {
+                return PIO_SIM_UNSUPPORTED;
+            }
+            break;
+        }
+        case OP_SET:
+            if (dest == REG_PINDIRS) {
+                sm->pindirs = (instr & 0x1Fu) & pin_mask(sm);
+            } else if (!write_reg(sm, dest, instr & 0x1F)) {
+                return PIO_SIM_UNSUPPORTED;
+            }
+            break;
+        default:
+            return PIO_SIM_UNSUPPORTED;
+    }
+
+    sm->pc = (uint8_t)next;
+    sm->delay = (instr >> 8) & 0x1F;
+    return PIO_SIM_RAN;
+}
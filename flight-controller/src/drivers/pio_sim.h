@@ -0,0 +1,79 @@
+// flight-controller/src/drivers/pio_sim.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Clock-by-clock model of one RP2040 PIO state machine, for checking the
+// firmware's PIO programs on the host. It runs the assembled instruction
+// words: JMP (all conditions but PIN), OUT, SET, MOV and PULL to and from
+// the pins, X, Y and the OSR, IN from the pins, X, Y and NULL, and SET
+// PINDIRS, with delays, wrap, autopull and autopush. Side-set, WAIT, PUSH
+// and IRQ are not modeled. The program is loaded at offset 0 and the in,
+// out and set pins share one base.
+#define PIO_SIM_FIFO_DEPTH 8    // TX FIFO, as if the RX FIFO were joined to it
+#define PIO_SIM_RX_FIFO_DEPTH 4
+
+typedef enum {
+    PIO_SIM_RAN,            // An instruction or a delay clock completed
+    PIO_SIM_STALLED,        // Waiting on an empty TX FIFO
+    PIO_SIM_UNSUPPORTED,    // The instruction at pc is not modeled
+} pio_sim_result_t;
+
+typedef struct {
+    const uint16_t* program;
+    uint8_t length;
+    uint8_t wrap_target;
+    uint8_t wrap;
+    uint8_t pin_count;
+
+    // OSR configuration (sm_config_set_out_shift())
+    bool shift_right;
+    bool autopull;
+    uint8_t pull_threshold;     // 1..32
+
+    uint8_t pc;
+    uint8_t delay;              // Clocks left of the last instruction's delay
+    uint32_t x;
+    uint32_t y;
+    uint32_t osr;
+    uint8_t osr_shifted;        // Bits shifted out since the last pull
+    uint32_t pins;              // Levels driven on the pin_count pins from the base
+    uint32_t pindirs;           // 1 where the state machine drives the pin
+    uint32_t inputs;            // Levels from outside, seen where it doesn't
+
+    // ISR configuration (sm_config_set_in_shift())
+    bool in_shift_right;
+    bool autopush;
+    uint8_t push_threshold;     // 1..32
+    uint32_t isr;
+    uint8_t isr_shifted;        // Bits shifted in since the last push
+
+    uint32_t fifo[PIO_SIM_FIFO_DEPTH];
+    uint8_t fifo_head;
+    uint8_t fifo_count;
+    uint32_t rx_fifo[PIO_SIM_RX_FIFO_DEPTH];
+    uint8_t rx_head;
+    uint8_t rx_count;
+    uint64_t clocks;            // Steps so far, stalled ones included
+} pio_sim_t;
+
+// Starts at wrap_target with the pins driven low, the OSR empty and
+// shifting left with autopull at 32 bits, the ISR empty and shifting left
+// without autopush
+void pio_sim_init(pio_sim_t* sm, const uint16_t* program, uint8_t length,
+                  uint8_t wrap_target, uint8_t wrap, uint8_t pin_count);
+void pio_sim_set_out_shift(pio_sim_t* sm, bool shift_right, bool autopull, uint8_t threshold);
+void pio_sim_set_in_shift(pio_sim_t* sm, bool shift_right, bool autopush, uint8_t threshold);
+
+// Queues a word in the TX FIFO; false when it is full
+bool pio_sim_put(pio_sim_t* sm, uint32_t word);
+
+// Takes a word from the RX FIFO; false when it is empty
+bool pio_sim_get(pio_sim_t* sm, uint32_t* word);
+
+// Levels on the pins: driven ones from pins, the others from inputs
+uint32_t pio_sim_pin_levels(const pio_sim_t* sm);
+
+// Advances one state machine clock
+pio_sim_result_t pio_sim_step(pio_sim_t* sm);
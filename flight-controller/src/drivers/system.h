@@ -1,11 +0,0 @@
-#pragma once
-
-#include "pico/stdlib.h"
-#include "hardware/gpio.h"
-#include "hardware/i2c.h"
-#include "hardware/pwm.h"
-#include "hardware/timer.h"
-
-// System initialization
-int system_init(void);
-
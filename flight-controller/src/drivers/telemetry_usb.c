@@ -0,0 +1,27 @@
+#include "utils/telemetry.h"
+#include "tusb.h"
+
+// Both this and stdio_usb write to the CDC interface from core 0 thread
+// context; TinyUSB itself is serviced from the SDK's USB interrupt
+static size_t usb_write(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+
+    // Nobody listening: discard instead of letting the ring back up
+    if (!tud_cdc_connected()) return len;
+
+    uint32_t space = tud_cdc_write_available();
+    if (len > space) len = space;
+    if (len == 0) return 0;
+
+    uint32_t n = tud_cdc_write(data, (uint32_t)len);
+    tud_cdc_write_flush();
+    return n;
+}
+
+void telemetry_usb_init(telemetry_t* tel) {
+    const telemetry_port_t port = {
+        .write = usb_write,
+        .ctx = NULL
+    };
+    telemetry_init(tel, &port);
+}
@@ -1,10 +1,131 @@
 #pragma once
 
-// System configuration
-#define CONTROL_LOOP_FREQ 500
+// System configuration. The control loop is the inner rate loop, the
+// mixer and the ESC output; the outer angle loop runs on every
+// ANGLE_LOOP_DECIMATION-th control update.
+#define CONTROL_LOOP_FREQ 1000
+#define ANGLE_LOOP_FREQ   250
 #define IMU_UPDATE_FREQ  1000
 #define TELEMETRY_FREQ   100
+#define STATS_FREQ       1     // Scheduler jitter/overrun report
 #define DT (1.0f / CONTROL_LOOP_FREQ)
+#define CONTROL_LOOP_PERIOD_US (1000000 / CONTROL_LOOP_FREQ)
+#define ANGLE_DT (1.0f / ANGLE_LOOP_FREQ)
+#define IMU_DT (1.0f / IMU_UPDATE_FREQ)
+#define IMU_UPDATE_PERIOD_US (1000000 / IMU_UPDATE_FREQ)
+
+#define ANGLE_LOOP_DECIMATION (CONTROL_LOOP_FREQ / ANGLE_LOOP_FREQ)
+#if CONTROL_LOOP_FREQ % ANGLE_LOOP_FREQ != 0
+#error "CONTROL_LOOP_FREQ must be a multiple of ANGLE_LOOP_FREQ"
+#endif
+
+// IMU updates averaged into each control update when one core runs both
+#define IMU_OVERSAMPLE (IMU_UPDATE_FREQ / CONTROL_LOOP_FREQ)
+#if IMU_UPDATE_FREQ % CONTROL_LOOP_FREQ != 0
+#error "IMU_UPDATE_FREQ must be a multiple of CONTROL_LOOP_FREQ"
+#endif
+
+// Run IMU acquisition and attitude estimation on core 1 at IMU_UPDATE_FREQ
+// and the PIDs, mixer and ESC output on core 0 at CONTROL_LOOP_FREQ
+#ifndef FC_DUAL_CORE
+#define FC_DUAL_CORE 1
+#endif
+#define ATTITUDE_RING_SIZE 8    // Must be a power of two
+#define TELEMETRY_DRAIN_MAX 8   // Frames written per telemetry tick, at most
+#define LOG_CORE1_QUEUE_SIZE 16 // Core 1 log records awaiting core 0; a power of two
+
+// Blackbox flight recorder, kept in the upper half of the 2 MB flash
+#define BLACKBOX_FLASH_OFFSET    (1u << 20)
+#define BLACKBOX_FLASH_SIZE      (1u << 20)
+#define BLACKBOX_DECIMATION      4      // Log every n-th control update
+#define BLACKBOX_PAGE_PROGRAM_US 700    // Idle time a page program needs, stall included
+#define BLACKBOX_MIN_FREE        (64u << 10)    // Less left at boot starts the log over
+
+// Attitude fusion: ATTITUDE_FILTER_COMPLEMENTARY, _MAHONY or _MADGWICK
+// (see attitude_estimator.h)
+#ifndef ATTITUDE_FILTER
+#define ATTITUDE_FILTER ATTITUDE_FILTER_COMPLEMENTARY
+#endif
+
+// Angle PID error: ATTITUDE_CONTROL_EULER subtracts Euler angles,
+// ATTITUDE_CONTROL_QUATERNION uses quaternion_attitude_error() and needs no
+// inverse trigonometry (see types.h)
+#ifndef ATTITUDE_CONTROL
+#define ATTITUDE_CONTROL ATTITUDE_CONTROL_QUATERNION
+#endif
+
+// Use the approximate inverse square root, atan2, asin, sin and cos of
+// math/fast_math.h in the float estimator instead of libm. Errors are
+// bounded there; quaternion_slerp() keeps libm.
+#ifndef FC_FAST_MATH
+#define FC_FAST_MATH 0
+#endif
+
+// Run sensor scaling, attitude estimation, the rate PIDs, the mixer and the
+// ESC conversion in Q15/Q31 fixed point (utils/fixed_point.h). The
+// estimator is then the Mahony filter whatever ATTITUDE_FILTER says; the
+// attitude error and the angle loop, at ANGLE_LOOP_FREQ, stay in float.
+#ifndef FC_FIXED_POINT
+#define FC_FIXED_POINT 0
+#endif
+
+// Notch motor noise out of the gyro rates before estimation, at the peaks
+// an on-board FFT finds between DYN_NOTCH_MIN_HZ and DYN_NOTCH_MAX_HZ (see
+// core/dyn_notch.h). The band is capped at 0.45 of the sensor step's rate.
+// Float path only: FC_FIXED_POINT turns it off.
+#ifndef FC_DYN_NOTCH
+#define FC_DYN_NOTCH 1
+#endif
+#if FC_FIXED_POINT
+#undef FC_DYN_NOTCH
+#define FC_DYN_NOTCH 0
+#endif
+#define DYN_NOTCH_MIN_HZ 60.0f
+#define DYN_NOTCH_MAX_HZ 400.0f
+#define DYN_NOTCH_Q      3.0f     // Center over -3 dB width
+
+// Keep the whole flight stack (controller, estimator, IMU and ESC drivers)
+// in one statically allocated flight_stack_t instead of a heap block. The
+// modules on the loop's path then can't call malloc or free at all (see
+// utils/heap_guard.h), and their allocating *_init() constructors are
+// compiled out in favour of the *_setup() forms. Tests and host tools keep
+// the heap.
+#ifndef FC_STATIC_ALLOC
+#define FC_STATIC_ALLOC 0
+#endif
+
+// Motor output: ESC_PROTOCOL_PWM (1-2 ms pulses at 400 Hz),
+// ESC_PROTOCOL_ONESHOT125, _ONESHOT42, _MULTISHOT (one pulse per control
+// update) or ESC_PROTOCOL_DSHOT150, _DSHOT300, _DSHOT600 (see esc.h).
+// DShot needs PIN_MOTOR1..4 on consecutive pins.
+#ifndef ESC_PROTOCOL
+#define ESC_PROTOCOL ESC_PROTOCOL_PWM
+#endif
+
+// Bidirectional DShot: after every frame each ESC reports its motor's
+// electrical RPM (see drivers/dshot.h). Needs a DShot ESC_PROTOCOL and
+// ESC firmware that answers. MOTOR_POLES turns eRPM into rotor speed.
+#ifndef ESC_DSHOT_BIDIR
+#define ESC_DSHOT_BIDIR 0
+#endif
+#define MOTOR_POLES 14
+
+// Notch the gyro rates at the first RPM_NOTCH_HARMONICS harmonics of every
+// motor's rotation, as the ESCs report it, before the dynamic notch (see
+// core/rpm_notch.h). On with ESC_DSHOT_BIDIR; float path only.
+#ifndef FC_RPM_NOTCH
+#define FC_RPM_NOTCH ESC_DSHOT_BIDIR
+#endif
+#if FC_FIXED_POINT
+#undef FC_RPM_NOTCH
+#define FC_RPM_NOTCH 0
+#endif
+#define RPM_NOTCH_HARMONICS 2
+#define RPM_NOTCH_MIN_HZ 80.0f
+#define RPM_NOTCH_Q      5.0f
+
+// System clock set by hal_init(); the PWM and PIO dividers derive from it
+#define SYS_CLOCK_HZ 250000000u
 
 // Hardware pins
 #define PIN_MOTOR1      2
@@ -13,17 +134,31 @@
 #define PIN_MOTOR4      5
 #define PIN_I2C_SDA    12
 #define PIN_I2C_SCL    13
+#define PIN_IMU_INT    14    // MPU6050 INT (data ready)
 
-// PID constants
-#define PID_ROLL_KP    0.5f
-#define PID_ROLL_KI    0.2f
-#define PID_ROLL_KD    0.1f
-#define PID_PITCH_KP   0.5f
-#define PID_PITCH_KI   0.2f
-#define PID_PITCH_KD   0.1f
-#define PID_YAW_KP     0.85f
-#define PID_YAW_KI     0.15f
+// Rate loop PID constants: body rate error in deg/s to a mixer command
+#define PID_ROLL_KP    0.0005f
+#define PID_ROLL_KI    0.002f
+#define PID_ROLL_KD    0.00001f
+#define PID_PITCH_KP   0.0005f
+#define PID_PITCH_KI   0.002f
+#define PID_PITCH_KD   0.00001f
+#define PID_YAW_KP     0.002f
+#define PID_YAW_KI     0.005f
 #define PID_YAW_KD     0.0f
+#define PID_RATE_INTEGRAL_LIMIT 50.0f   // deg/s * s
+
+// Angle loop constants: attitude error in degrees to a body rate setpoint
+// in deg/s, limited to MAX_RATE
+#define ANGLE_ROLL_KP   5.0f
+#define ANGLE_ROLL_KI   0.0f
+#define ANGLE_ROLL_KD   0.0f
+#define ANGLE_PITCH_KP  5.0f
+#define ANGLE_PITCH_KI  0.0f
+#define ANGLE_PITCH_KD  0.0f
+#define ANGLE_YAW_KP    3.0f
+#define ANGLE_YAW_KI    0.0f
+#define ANGLE_YAW_KD    0.0f
 
 // Flight limits
 #define MAX_ANGLE      45.0f    // degrees
@@ -26,6 +26,12 @@ typedef enum {
     FLIGHT_MODE_POSITION_HOLD
 } flight_mode_t;
 
+// How the angle PIDs get their error (ATTITUDE_CONTROL in config.h)
+typedef enum {
+    ATTITUDE_CONTROL_EULER,         // Setpoint minus attitude_from_quaternion()
+    ATTITUDE_CONTROL_QUATERNION     // quaternion_attitude_error()
+} attitude_control_t;
+
 // Motor control types
 typedef struct {
     float throttle;
@@ -1,32 +1,271 @@
 #include "core/flight_controller.h"
-#include "drivers/system.h"
+#include "core/loop_trigger.h"
+#include "core/scheduler.h"
+#include "drivers/hal.h"
 #include "include/config.h"
+#include "utils/blackbox.h"
 #include "utils/logger.h"
+#include "utils/loop_profiler.h"
+#include "utils/spsc_ring.h"
+#include "utils/telemetry.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
 #include <stdio.h>
 
+static flight_controller_t* fc;
+static scheduler_t scheduler;
+static telemetry_t telemetry;
+static blackbox_t blackbox;
+static attitude_sample_t control_sample;    // Latest sample the controller used
+static uint32_t blackbox_max_stall_us;      // Since the last stats report
+static uint32_t blackbox_deferred;
+
+static uint64_t scheduler_clock(void* ctx) {
+    (void)ctx;
+    return hal_time_us();
+}
+
+// Called after every control update; blackbox_log() keeps every
+// BLACKBOX_DECIMATION-th frame and never touches flash itself
+static void blackbox_record(void) {
+    blackbox_frame_t frame = {
+        .time_us = (uint32_t)control_sample.timestamp_us,
+        .iteration = control_sample.seq,
+        .quaternion = {
+            control_sample.quaternion.q0, control_sample.quaternion.q1,
+            control_sample.quaternion.q2, control_sample.quaternion.q3
+        }
+    };
+    for (int i = 0; i < 3; i++) {
+        frame.accel[i] = control_sample.raw_accel[i];
+        frame.gyro[i] = control_sample.raw_gyro[i];
+        frame.pid[i][0] = fc->rate_pid.p_term[i];
+        frame.pid[i][1] = fc->rate_pid.i_term[i];
+        frame.pid[i][2] = fc->rate_pid.d_term[i];
+    }
+    for (int i = 0; i < 4; i++) frame.motor[i] = fc->motor_output[i];
+    blackbox_log(&blackbox, &frame);
+}
+
+// Also after every control update, which follows the IMU tick at tick_us.
+// A page program parks the sensor core and masks interrupts, so one page
+// is written only if the stall still ends before the next tick is due.
+// The IMU clock drifts against ours, so the phase moves through the good
+// part of the period often enough for the 30-40 pages a second the log needs.
+static void blackbox_write_idle(uint64_t tick_us) {
+    if (spsc_ring_count(&blackbox.queue) == 0) return;
+
+    uint64_t start = hal_time_us();
+    if (start - tick_us + BLACKBOX_PAGE_PROGRAM_US > IMU_UPDATE_PERIOD_US) {
+        blackbox_deferred++;
+        return;
+    }
+    if (blackbox_flush(&blackbox, 1) > 0) {
+        uint32_t stall = (uint32_t)(hal_time_us() - start);
+        if (stall > blackbox_max_stall_us) blackbox_max_stall_us = stall;
+    }
+}
+
+#if FC_DUAL_CORE
+// Core 1 produces one attitude sample per IMU update, core 0 consumes them
+static spsc_ring_t attitude_ring;
+static attitude_sample_t attitude_ring_storage[ATTITUDE_RING_SIZE];
+static bool have_sample;
+
+static void sensor_core_main(void) {
+    // Lets core 0 park this core while the blackbox programs flash
+    flash_safe_execute_core_init();
+#ifdef FC_PROFILE
+    loop_profiler_init_core();
+#endif
+    // The GPIO interrupt is enabled from this core, so it is serviced here
+    loop_trigger_t trigger;
+    loop_trigger_hal_init(&trigger, PIN_IMU_INT, IMU_UPDATE_PERIOD_US);
+
+    while (1) {
+        loop_trigger_wait(&trigger);
+
+        attitude_sample_t sample;
+        flight_controller_sensor_step(fc, trigger.last_tick_us, IMU_DT, &sample);
+        spsc_ring_push(&attitude_ring, &sample);
+    }
+}
+
+static void control_task(void* ctx, uint64_t now_us) {
+    (void)ctx;
+    (void)now_us;
+
+    // Only the newest estimate matters to the controller
+    if (spsc_ring_pop_latest(&attitude_ring, &control_sample, NULL)) {
+        have_sample = true;
+    }
+    if (have_sample) {
+        flight_controller_control_step(fc, &control_sample);
+        blackbox_record();
+        blackbox_write_idle(control_sample.timestamp_us);
+    }
+}
+#else
+// The control update is driven by the IMU data-ready trigger, so the
+// scheduler only carries the time-based background tasks
+static loop_trigger_t trigger;
+#endif
+
+// Records are queued here, in the stats task and from core 1's log calls,
+// then framed and written to USB without blocking; anything the link
+// cannot take is dropped
+static void telemetry_task(void* ctx, uint64_t now_us) {
+    (void)ctx;
+
+    attitude_t attitude = attitude_from_quaternion(&control_sample.quaternion);
+    const telemetry_attitude_t att = {
+        .roll = attitude.roll, .pitch = attitude.pitch, .yaw = attitude.yaw,
+        .rate_x = control_sample.gyro.x, .rate_y = control_sample.gyro.y,
+        .rate_z = control_sample.gyro.z
+    };
+    telemetry_send(&telemetry, TELEMETRY_ATTITUDE, now_us, &att, sizeof(att));
+
+    telemetry_motors_t motors = { .throttle = fc->setpoint.throttle };
+    for (int i = 0; i < 4; i++) motors.output[i] = fc->motor_output[i];
+    telemetry_send(&telemetry, TELEMETRY_MOTORS, now_us, &motors, sizeof(motors));
+
+    logger_pump();
+    telemetry_drain(&telemetry, TELEMETRY_DRAIN_MAX);
+}
+
+static void stats_task(void* ctx, uint64_t now_us) {
+    (void)ctx;
+
+    for (uint8_t i = 0; i < scheduler.task_count; i++) {
+        const scheduler_task_t* task = &scheduler.tasks[i];
+        const telemetry_task_t rec = {
+            .task = i,
+            .runs = task->runs,
+            .overruns = task->overruns,
+            .max_jitter_us = task->max_jitter_us,
+            .mean_jitter_us = scheduler_mean_jitter_us(task)
+        };
+        telemetry_send(&telemetry, TELEMETRY_TASK, now_us, &rec, sizeof(rec));
+    }
+
+    telemetry_status_t status = {
+        .dropped = telemetry_dropped(&telemetry),
+        .sent = telemetry.records_sent
+    };
+#if !FC_DUAL_CORE
+    status.trigger_irq = trigger.irq_ticks;
+    status.trigger_fallback = trigger.fallback_ticks;
+    status.trigger_missed = trigger.missed_irqs;
+#endif
+    const mpu6050_sample_stats_t* imu_stats = mpu6050_get_sample_stats(fc->imu);
+    status.imu_duplicates = (uint16_t)imu_stats->duplicates;
+    status.imu_skipped = (uint16_t)imu_stats->skipped;
+    telemetry_send(&telemetry, TELEMETRY_STATUS, now_us, &status, sizeof(status));
+
+    const telemetry_blackbox_t bb = {
+        .pages_written = blackbox.pages_written,
+        .frames_dropped = blackbox.frames_dropped,
+        .erased_bytes = blackbox_erased_bytes(&blackbox),
+        .max_stall_us = blackbox_max_stall_us,
+        .deferred = blackbox_deferred
+    };
+    telemetry_send(&telemetry, TELEMETRY_BLACKBOX, now_us, &bb, sizeof(bb));
+    blackbox_max_stall_us = 0;
+
+#ifdef FC_PROFILE
+    for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+        profile_stage_stats_t stats;
+        if (!loop_profiler_read(stage, &stats) || stats.count == 0) continue;
+        const telemetry_profile_t rec = {
+            .stage = (uint8_t)stage,
+            .count = stats.count,
+            .min = stats.min,
+            .max = stats.max,
+            .mean = (uint32_t)(stats.total / stats.count),
+            .overhead = loop_profiler_overhead_ticks()
+        };
+        telemetry_send(&telemetry, TELEMETRY_PROFILE, now_us, &rec, sizeof(rec));
+    }
+#endif
+    scheduler_reset_stats(&scheduler);
+}
+
 int main(void) {
-    if (system_init() != 0) {
+    if (hal_init() != 0) {
         printf("System initialization failed!\n");
         return -1;
     }
 
-    flight_controller_t* fc = flight_controller_init();
+#ifdef FC_PROFILE
+    loop_profiler_init();
+#endif
+
+    fc = flight_controller_init();
     if (fc == NULL) {
         printf("Flight controller initialization failed!\n");
         return -1;
     }
 
-    uint64_t last_update = time_us_64();
-    const uint64_t update_period_us = (uint64_t)(DT * 1000000.0f);
+    telemetry_usb_init(&telemetry);
+    logger_init(&telemetry);
+    blackbox_flash_init(&blackbox, BLACKBOX_FLASH_OFFSET, BLACKBOX_FLASH_SIZE,
+                        BLACKBOX_DECIMATION);
+
+    // Pre-arm: nothing runs yet, so this is where the log region is erased.
+    // In the loop pages are only programmed, into the space prepared here.
+    uint64_t erase_start = hal_time_us();
+    if (BLACKBOX_FLASH_SIZE - blackbox.write_offset < BLACKBOX_MIN_FREE) {
+        LOG_INFO("blackbox full, erasing old logs");
+        blackbox_erase_all(&blackbox);
+    }
+    uint32_t sectors = blackbox_prepare(&blackbox, BLACKBOX_FLASH_SIZE);
+    LOG_INFO("blackbox: %u sectors erased in %u ms, %u bytes ready", (unsigned)sectors,
+             (unsigned)((hal_time_us() - erase_start) / 1000),
+             (unsigned)blackbox_erased_bytes(&blackbox));
+    blackbox_start(&blackbox, CONTROL_LOOP_FREQ);
+
+    // All rates are integer divisions of the IMU rate
+    scheduler_init(&scheduler, IMU_UPDATE_FREQ, scheduler_clock, NULL);
+#if FC_DUAL_CORE
+    scheduler_add_task(&scheduler, "control", CONTROL_LOOP_FREQ, control_task, NULL);
+#endif
+    scheduler_add_task(&scheduler, "telemetry", TELEMETRY_FREQ, telemetry_task, NULL);
+    scheduler_add_task(&scheduler, "stats", STATS_FREQ, stats_task, NULL);
+
+    LOG_INFO("flight controller ready: control %d Hz, imu %d Hz, dual core %d, stack %d bytes",
+             CONTROL_LOOP_FREQ, IMU_UPDATE_FREQ, FC_DUAL_CORE, (int)sizeof(flight_stack_t));
+
+#if FC_DUAL_CORE
+    spsc_ring_init(&attitude_ring, attitude_ring_storage,
+                   sizeof(attitude_sample_t), ATTITUDE_RING_SIZE);
+    multicore_launch_core1(sensor_core_main);
+
+    while (1) {
+        hal_sleep_until(scheduler_next_deadline(&scheduler));
+        scheduler_poll(&scheduler);
+    }
+#else
+    // Collect every IMU update as soon as the sensor signals it and run the
+    // control update on every IMU_OVERSAMPLE-th one, with the mean of the
+    // updates in between; the trigger falls back to a timer if the
+    // interrupt goes quiet
+    loop_trigger_hal_init(&trigger, PIN_IMU_INT, IMU_UPDATE_PERIOD_US);
+    uint32_t imu_ticks = 0;
 
     while (1) {
-        uint64_t now = time_us_64();
-        if (now - last_update >= update_period_us) {
-            flight_controller_update(fc);
-            last_update = now;
+        loop_trigger_wait(&trigger);
+        if (++imu_ticks < IMU_OVERSAMPLE) {
+            flight_controller_imu_step(fc);
+        } else {
+            imu_ticks = 0;
+            flight_controller_sensor_step(fc, trigger.last_tick_us, DT, &control_sample);
+            flight_controller_control_step(fc, &control_sample);
+            blackbox_record();
+            blackbox_write_idle(trigger.last_tick_us);
         }
-        sleep_us(100); // Small delay to prevent tight spinning
+        scheduler_poll(&scheduler);
     }
+#endif
 
     return 0;
 }
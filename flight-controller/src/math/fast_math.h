@@ -0,0 +1,41 @@
+// flight-controller/src/math/fast_math.h
+#pragma once
+
+// Approximate float kernels for the estimator (FC_FAST_MATH). On the
+// RP2040 each libm call runs a soft-float routine that is accurate to an
+// ulp or two. These use a few float multiplies and adds instead, and trade
+// accuracy for that. The bounds below are the worst cases found by
+// fast_math_check, which tries every float in each kernel's domain
+// against the double-precision libm result.
+//
+// Angles are radians. Inputs are assumed finite; none of the kernels
+// checks for NaN or infinity.
+
+// Relative error of fast_inv_sqrtf() for any positive normal float
+#define FAST_INV_SQRTF_MAX_REL_ERROR  5e-6f
+
+// Absolute errors, radians
+#define FAST_ATAN2F_MAX_ERROR  1.2e-5f
+#define FAST_ASINF_MAX_ERROR   5e-7f
+#define FAST_SINF_MAX_ERROR    5e-6f   // Also fast_cosf(), for |x| <= 2 pi
+
+// 1/sqrt(x): bit-level first guess, then two Newton steps. x must be a
+// positive normal float; 0 and denormals give garbage.
+float fast_inv_sqrtf(float x);
+
+// atan2(y, x) in [-pi, pi]: octant reduction and a degree-9 odd
+// polynomial (Abramowitz & Stegun 4.4.47), one divide. atan2(0, 0) is 0,
+// and atan2(-0, x < 0) is pi rather than -pi.
+float fast_atan2f(float y, float x);
+
+// asin(x) for x in [-1, 1]: pi/2 - sqrt(1 - |x|) * P(|x|) with the
+// degree-7 polynomial of Abramowitz & Stegun 4.4.46, and x + x^3 / 6
+// below 1/128. Inputs outside [-1, 1] are clamped.
+float fast_asinf(float x);
+
+// sin and cos from a 257-entry quarter-wave table, linearly interpolated.
+// The interpolation error is at most h^2 / 8 for a step h of pi/512. The
+// reduction is done in float, so the error grows with |x| by about an ulp
+// of x; the bound above holds for |x| <= 2 pi. |x| must stay below 1e7.
+float fast_sinf(float x);
+float fast_cosf(float x);
@@ -0,0 +1,71 @@
+#include "fft_q15.h"
+#include "../utils/heap_guard.h"
+
+// sin(2 pi k / FFT_Q15_MAX_SIZE) in Q15 for k = 0 .. 3/4 of a turn; the
+// cosine is the same table a quarter turn on
+static const q15_t sin_table[FFT_Q15_MAX_SIZE * 3 / 4 + 1] = {
+    0, 804, 1608, 2411, 3212, 4011, 4808, 5602, 6393, 7180, 7962, 8740,
+    9512, 10279, 11039, 11793, 12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595, 23170, 23732, 24279, 24812,
+    25330, 25833, 26320, 26791, 27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972, 32138, 32286, 32413, 32522,
+    32610, 32679, 32729, 32758, 32767, 32758, 32729, 32679, 32610, 32522, 32413, 32286,
+    32138, 31972, 31786, 31581, 31357, 31114, 30853, 30572, 30274, 29957, 29622, 29269,
+    28899, 28511, 28106, 27684, 27246, 26791, 26320, 25833, 25330, 24812, 24279, 23732,
+    23170, 22595, 22006, 21403, 20788, 20160, 19520, 18868, 18205, 17531, 16846, 16151,
+    15447, 14733, 14010, 13279, 12540, 11793, 11039, 10279, 9512, 8740, 7962, 7180,
+    6393, 5602, 4808, 4011, 3212, 2411, 1608, 804, 0, -804, -1608, -2411,
+    -3212, -4011, -4808, -5602, -6393, -7180, -7962, -8740, -9512, -10279, -11039, -11793,
+    -12540, -13279, -14010, -14733, -15447, -16151, -16846, -17531, -18205, -18868, -19520, -20160,
+    -20788, -21403, -22006, -22595, -23170, -23732, -24279, -24812, -25330, -25833, -26320, -26791,
+    -27246, -27684, -28106, -28511, -28899, -29269, -29622, -29957, -30274, -30572, -30853, -31114,
+    -31357, -31581, -31786, -31972, -32138, -32286, -32413, -32522, -32610, -32679, -32729, -32758,
+    -32768
+};
+
+#define COS_OFFSET (FFT_Q15_MAX_SIZE / 4)
+
+q15_t fft_q15_hann(int i, int log2n) {
+    int n = 1 << log2n;
+    if (i > n / 2) i = n - i;       // Symmetric about n / 2
+    int32_t c = sin_table[(i << (FFT_Q15_MAX_LOG2 - log2n)) + COS_OFFSET];
+    return q15_sat((32768 - c) >> 1);
+}
+
+void fft_q15_stage(q15_t* re, q15_t* im, int log2n, int stage) {
+    int n = 1 << log2n;
+    int half = 1 << stage;
+    int span = half << 1;
+    int stride = FFT_Q15_MAX_SIZE >> (stage + 1);
+
+    for (int k = 0; k < half; k++) {
+        // W = exp(-2 pi i k / span)
+        int32_t wr = sin_table[k * stride + COS_OFFSET];
+        int32_t wi = -sin_table[k * stride];
+        for (int i = k; i < n; i += span) {
+            int j = i + half;
+            int32_t tr = (wr * re[j] - wi * im[j] + (1 << 14)) >> 15;
+            int32_t ti = (wr * im[j] + wi * re[j] + (1 << 14)) >> 15;
+            int32_t ar = re[i], ai = im[i];
+            re[j] = (q15_t)((ar - tr) >> 1);
+            im[j] = (q15_t)((ai - ti) >> 1);
+            re[i] = (q15_t)((ar + tr) >> 1);
+            im[i] = (q15_t)((ai + ti) >> 1);
+        }
+    }
+}
+
+void fft_q15(q15_t* re, q15_t* im, int log2n) {
+    int n = 1 << log2n;
+
+    for (int i = 0; i < n; i++) {
+        int j = fft_q15_bit_reverse((uint16_t)i, log2n);
+        if (j > i) {
+            q15_t t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (int stage = 0; stage < log2n; stage++) {
+        fft_q15_stage(re, im, log2n, stage);
+    }
+}
@@ -0,0 +1,42 @@
+// flight-controller/src/math/fft_q15.h
+#pragma once
+
+#include <stdint.h>
+#include "../utils/fixed_point.h"
+
+// Radix-2 decimation-in-time FFT on Q15 data, integer arithmetic only.
+// Transforms are in place on separate real and imaginary arrays of
+// 2^log2n points, log2n <= FFT_Q15_MAX_LOG2. Every stage halves its
+// output, so the result is the DFT divided by n. Keeping the input within
+// half scale leaves room for the twiddle rounding: nothing then overflows.
+//
+// The stages can also be run one at a time (fft_q15_stage()), so a caller
+// can spread one transform over several loop cycles: load the input in
+// bit-reversed order, then run stages 0 to log2n - 1.
+
+#define FFT_Q15_MAX_LOG2 8
+#define FFT_Q15_MAX_SIZE (1 << FFT_Q15_MAX_LOG2)
+
+// Multiplies in one fft_q15_stage() call: n / 2 butterflies of four
+#define FFT_Q15_STAGE_MULTIPLIES(n) (2 * (n))
+
+// Index i with its low log2n bits reversed
+static inline uint16_t fft_q15_bit_reverse(uint16_t i, int log2n) {
+    uint16_t r = 0;
+    for (int b = 0; b < log2n; b++) {
+        r = (uint16_t)((r << 1) | (i & 1));
+        i >>= 1;
+    }
+    return r;
+}
+
+// Periodic Hann window, 0.5 - 0.5 cos(2 pi i / n), for i in [0, n)
+q15_t fft_q15_hann(int i, int log2n);
+
+// One butterfly stage (0 = pairs of neighbours) of a transform whose input
+// is already in bit-reversed order
+void fft_q15_stage(q15_t* re, q15_t* im, int log2n, int stage);
+
+// Whole transform of natural-order input: bit-reversal permutation, then
+// every stage
+void fft_q15(q15_t* re, q15_t* im, int log2n);
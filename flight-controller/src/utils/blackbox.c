@@ -0,0 +1,271 @@
+#include "blackbox.h"
+#include <string.h>
+
+// Fields predicted from the last two frames (constant rate) rather than
+// the last one
+#define BLACKBOX_FIELD_TIME      0
+#define BLACKBOX_FIELD_ITERATION 1
+
+static int32_t scale_float(float value) {
+    float scaled = value * BLACKBOX_FLOAT_SCALE;
+    if (scaled >= 2147483520.0f) return INT32_MAX;
+    if (scaled <= -2147483520.0f) return INT32_MIN;
+    return (int32_t)(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+void blackbox_frame_to_fields(const blackbox_frame_t* frame, int32_t fields[BLACKBOX_FIELD_COUNT]) {
+    int n = 0;
+    fields[n++] = (int32_t)frame->time_us;
+    fields[n++] = (int32_t)frame->iteration;
+    for (int i = 0; i < 3; i++) fields[n++] = frame->accel[i];
+    for (int i = 0; i < 3; i++) fields[n++] = frame->gyro[i];
+    for (int i = 0; i < 4; i++) fields[n++] = scale_float(frame->quaternion[i]);
+    for (int axis = 0; axis < 3; axis++) {
+        for (int term = 0; term < 3; term++) fields[n++] = scale_float(frame->pid[axis][term]);
+    }
+    for (int i = 0; i < 4; i++) fields[n++] = scale_float(frame->motor[i]);
+}
+
+void blackbox_fields_to_frame(const int32_t fields[BLACKBOX_FIELD_COUNT], blackbox_frame_t* frame) {
+    int n = 0;
+    frame->time_us = (uint32_t)fields[n++];
+    frame->iteration = (uint32_t)fields[n++];
+    for (int i = 0; i < 3; i++) frame->accel[i] = (int16_t)fields[n++];
+    for (int i = 0; i < 3; i++) frame->gyro[i] = (int16_t)fields[n++];
+    for (int i = 0; i < 4; i++) frame->quaternion[i] = fields[n++] / BLACKBOX_FLOAT_SCALE;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int term = 0; term < 3; term++) frame->pid[axis][term] = fields[n++] / BLACKBOX_FLOAT_SCALE;
+    }
+    for (int i = 0; i < 4; i++) frame->motor[i] = fields[n++] / BLACKBOX_FLOAT_SCALE;
+}
+
+void blackbox_predict(const int32_t prev[BLACKBOX_FIELD_COUNT],
+                      const int32_t prev2[BLACKBOX_FIELD_COUNT],
+                      int32_t predicted[BLACKBOX_FIELD_COUNT]) {
+    for (int i = 0; i < BLACKBOX_FIELD_COUNT; i++) {
+        predicted[i] = prev[i];
+    }
+    // Unsigned arithmetic so a wrapping timestamp stays well defined
+    for (int i = BLACKBOX_FIELD_TIME; i <= BLACKBOX_FIELD_ITERATION; i++) {
+        predicted[i] = (int32_t)(2u * (uint32_t)prev[i] - (uint32_t)prev2[i]);
+    }
+}
+
+size_t blackbox_put_varint(uint8_t* dst, int32_t value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    size_t n = 0;
+    while (zigzag >= 0x80) {
+        dst[n++] = (uint8_t)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    dst[n++] = (uint8_t)zigzag;
+    return n;
+}
+
+size_t blackbox_get_varint(const uint8_t* src, size_t len, int32_t* value) {
+    uint32_t zigzag = 0;
+    for (size_t i = 0; i < len && i < 5; i++) {
+        zigzag |= (uint32_t)(src[i] & 0x7F) << (7 * i);
+        if ((src[i] & 0x80) == 0) {
+            *value = (int32_t)((zigzag >> 1) ^ (0u - (zigzag & 1)));
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static void open_page(blackbox_t* bb) {
+    bb->page[0] = BLACKBOX_PAGE_MAGIC;
+    bb->page[1] = 0;
+    bb->page[2] = (uint8_t)(bb->page_seq & 0xFF);
+    bb->page[3] = (uint8_t)(bb->page_seq >> 8);
+    bb->page_fill = BLACKBOX_PAGE_HEADER;
+    bb->page_frames = 0;
+}
+
+static void close_page(blackbox_t* bb) {
+    if (bb->page_fill == BLACKBOX_PAGE_HEADER) return;
+
+    // Padding bytes are never a valid frame marker
+    memset(&bb->page[bb->page_fill], 0, BLACKBOX_PAGE_SIZE - bb->page_fill);
+    if (!spsc_ring_push(&bb->queue, bb->page)) {
+        bb->frames_dropped += bb->page_frames;
+        // The decoder never sees this page, so later deltas need a new base
+        bb->force_intra = true;
+    }
+    bb->page_seq++;
+    open_page(bb);
+}
+
+static void put_byte(blackbox_t* bb, uint8_t byte) {
+    if (bb->page_fill == BLACKBOX_PAGE_SIZE) close_page(bb);
+    bb->page[bb->page_fill++] = byte;
+}
+
+static void put_varint(blackbox_t* bb, int32_t value) {
+    uint8_t buf[5];
+    size_t n = blackbox_put_varint(buf, value);
+    for (size_t i = 0; i < n; i++) put_byte(bb, buf[i]);
+}
+
+static void begin_frame(blackbox_t* bb, uint8_t marker) {
+    if (bb->page_fill == BLACKBOX_PAGE_SIZE) close_page(bb);
+    if (bb->page[1] == 0) bb->page[1] = (uint8_t)bb->page_fill;
+    bb->page_frames++;
+    put_byte(bb, marker);
+}
+
+static bool page_programmed(blackbox_t* bb, uint32_t page) {
+    uint8_t magic;
+    bb->storage.read(bb->storage.ctx, page * BLACKBOX_PAGE_SIZE, &magic, 1);
+    return magic == BLACKBOX_PAGE_MAGIC;
+}
+
+void blackbox_init(blackbox_t* bb, const blackbox_storage_t* storage, uint32_t decimation) {
+    memset(bb, 0, sizeof(*bb));
+    bb->storage = *storage;
+    bb->decimation = decimation > 0 ? decimation : 1;
+    spsc_ring_init(&bb->queue, bb->queue_storage, BLACKBOX_PAGE_SIZE, BLACKBOX_PAGE_QUEUE);
+
+    // Pages are programmed in order, so the used part is a prefix
+    uint32_t lo = 0;
+    uint32_t hi = bb->storage.size / BLACKBOX_PAGE_SIZE;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (page_programmed(bb, mid)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    bb->write_offset = lo * BLACKBOX_PAGE_SIZE;
+
+    // The rest of a partly used sector is still erased
+    bb->erased_offset = (bb->write_offset + BLACKBOX_SECTOR_SIZE - 1) & ~(uint32_t)(BLACKBOX_SECTOR_SIZE - 1);
+
+    // Continue the page sequence so the decoder sees no gap
+    if (lo > 0) {
+        uint8_t header[BLACKBOX_PAGE_HEADER];
+        bb->storage.read(bb->storage.ctx, (lo - 1) * BLACKBOX_PAGE_SIZE, header, sizeof(header));
+        bb->page_seq = (uint16_t)(header[2] | (header[3] << 8)) + 1;
+    }
+    open_page(bb);
+}
+
+void blackbox_set_decimation(blackbox_t* bb, uint32_t decimation) {
+    bb->decimation = decimation > 0 ? decimation : 1;
+}
+
+void blackbox_start(blackbox_t* bb, uint32_t loop_rate_hz) {
+    bb->loop_rate_hz = loop_rate_hz;
+    bb->decimation_count = 0;
+    bb->force_intra = true;
+
+    begin_frame(bb, BLACKBOX_FRAME_HEADER);
+    put_varint(bb, BLACKBOX_VERSION);
+    put_varint(bb, (int32_t)loop_rate_hz);
+    put_varint(bb, (int32_t)bb->decimation);
+    put_varint(bb, BLACKBOX_FIELD_COUNT);
+    // The header is not a data frame
+    bb->page_frames--;
+
+    bb->recording = true;
+}
+
+void blackbox_stop(blackbox_t* bb) {
+    if (!bb->recording) return;
+    bb->recording = false;
+    close_page(bb);
+}
+
+void blackbox_log(blackbox_t* bb, const blackbox_frame_t* frame) {
+    if (!bb->recording) return;
+    if (++bb->decimation_count < bb->decimation) return;
+    bb->decimation_count = 0;
+
+    int32_t fields[BLACKBOX_FIELD_COUNT];
+    blackbox_frame_to_fields(frame, fields);
+
+    if (bb->force_intra || bb->frames_since_intra >= BLACKBOX_INTRA_INTERVAL - 1) {
+        begin_frame(bb, BLACKBOX_FRAME_INTRA);
+        for (int i = 0; i < BLACKBOX_FIELD_COUNT; i++) {
+            put_varint(bb, fields[i]);
+            bb->prev2[i] = fields[i];
+        }
+        bb->frames_since_intra = 0;
+        bb->force_intra = false;
+    } else {
+        int32_t predicted[BLACKBOX_FIELD_COUNT];
+        blackbox_predict(bb->prev, bb->prev2, predicted);
+
+        begin_frame(bb, BLACKBOX_FRAME_PREDICTED);
+        for (int i = 0; i < BLACKBOX_FIELD_COUNT; i++) {
+            put_varint(bb, (int32_t)((uint32_t)fields[i] - (uint32_t)predicted[i]));
+            bb->prev2[i] = bb->prev[i];
+        }
+        bb->frames_since_intra++;
+    }
+
+    memcpy(bb->prev, fields, sizeof(fields));
+    bb->frames_logged++;
+}
+
+static bool sector_blank(blackbox_t* bb, uint32_t offset) {
+    uint8_t buf[BLACKBOX_PAGE_SIZE];
+    for (uint32_t at = 0; at < BLACKBOX_SECTOR_SIZE; at += sizeof(buf)) {
+        bb->storage.read(bb->storage.ctx, offset + at, buf, sizeof(buf));
+        for (size_t i = 0; i < sizeof(buf); i++) {
+            if (buf[i] != 0xFF) return false;
+        }
+    }
+    return true;
+}
+
+uint32_t blackbox_prepare(blackbox_t* bb, uint32_t bytes) {
+    uint32_t end = bytes < bb->storage.size - bb->write_offset ? bb->write_offset + bytes
+                                                               : bb->storage.size;
+    uint32_t erased = 0;
+
+    while (bb->erased_offset < end) {
+        // Space past the last log is usually still blank from an earlier erase
+        if (!sector_blank(bb, bb->erased_offset)) {
+            if (bb->storage.erase(bb->storage.ctx, bb->erased_offset, BLACKBOX_SECTOR_SIZE) != 0) break;
+            erased++;
+        }
+        bb->erased_offset += BLACKBOX_SECTOR_SIZE;
+    }
+    return erased;
+}
+
+uint32_t blackbox_flush(blackbox_t* bb, uint32_t max_pages) {
+    uint32_t written = 0;
+
+    while (written < max_pages && spsc_ring_count(&bb->queue) > 0) {
+        uint8_t page[BLACKBOX_PAGE_SIZE];
+        if (bb->write_offset >= bb->storage.size) {
+            // Log region full: discard what is queued
+            spsc_ring_pop(&bb->queue, page);
+            continue;
+        }
+        if (bb->write_offset >= bb->erased_offset) break;
+
+        spsc_ring_pop(&bb->queue, page);
+        bb->storage.program_page(bb->storage.ctx, bb->write_offset, page);
+        bb->write_offset += BLACKBOX_PAGE_SIZE;
+        bb->pages_written++;
+        written++;
+    }
+    return written;
+}
+
+uint32_t blackbox_erased_bytes(const blackbox_t* bb) {
+    return bb->erased_offset > bb->write_offset ? bb->erased_offset - bb->write_offset : 0;
+}
+
+void blackbox_erase_all(blackbox_t* bb) {
+    bb->storage.erase(bb->storage.ctx, 0, bb->storage.size);
+    bb->write_offset = 0;
+    bb->erased_offset = bb->storage.size;
+    bb->page_seq = 0;
+    open_page(bb);
+}
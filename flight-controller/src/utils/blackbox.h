@@ -0,0 +1,134 @@
+// flight-controller/src/utils/blackbox.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "spsc_ring.h"
+
+// Blackbox flight recorder. Each logged loop iteration becomes one frame of
+// zigzag varints: an intra frame ('I') carries absolute values every
+// BLACKBOX_INTRA_INTERVAL frames, the ones in between ('P') carry the
+// difference from a prediction based on the previous frame. Frames are
+// packed into flash pages in RAM by blackbox_log() and only queued there;
+// blackbox_flush() programs the queued pages later, into space that
+// blackbox_prepare() erased before arming. Nothing erases while flying.
+//
+// Page layout: magic, offset of the first frame starting in the page (0 if
+// none), 16-bit page sequence, then payload. Frames may span pages. After
+// a dropped page the encoder forces an intra frame so the decoder can
+// resynchronise.
+
+#define BLACKBOX_VERSION        1
+#define BLACKBOX_PAGE_SIZE      256
+#define BLACKBOX_SECTOR_SIZE    4096
+#define BLACKBOX_PAGE_HEADER    4
+#define BLACKBOX_PAGE_MAGIC     0xB5
+#define BLACKBOX_PAGE_QUEUE     8       // Pages between log and flush, power of two
+#define BLACKBOX_INTRA_INTERVAL 32
+#define BLACKBOX_FLOAT_SCALE    10000.0f
+
+#define BLACKBOX_FRAME_HEADER    'H'
+#define BLACKBOX_FRAME_INTRA     'I'
+#define BLACKBOX_FRAME_PREDICTED 'P'
+
+typedef struct {
+    uint32_t time_us;
+    uint32_t iteration;
+    int16_t accel[3];           // Raw sensor counts
+    int16_t gyro[3];
+    float quaternion[4];
+    float pid[3][3];            // [roll, pitch, yaw][P, I, D]
+    float motor[4];
+} blackbox_frame_t;
+
+// Frames travel as this many integers; floats are scaled by
+// BLACKBOX_FLOAT_SCALE (resolution 1e-4)
+#define BLACKBOX_FIELD_COUNT 25
+
+typedef struct {
+    uint32_t version;
+    uint32_t loop_rate_hz;      // Rate at which blackbox_log() is called
+    uint32_t decimation;        // Every n-th call is recorded
+    uint32_t field_count;
+} blackbox_header_t;
+
+// Backing store. Offsets are relative to the start of the log region.
+typedef struct {
+    int (*erase)(void* ctx, uint32_t offset, uint32_t len);
+    int (*program_page)(void* ctx, uint32_t offset, const uint8_t* data);
+    void (*read)(void* ctx, uint32_t offset, uint8_t* dst, size_t len);
+    uint32_t size;              // Multiple of BLACKBOX_SECTOR_SIZE
+    void* ctx;
+} blackbox_storage_t;
+
+typedef struct {
+    blackbox_storage_t storage;
+    uint32_t loop_rate_hz;
+    uint32_t decimation;
+    uint32_t decimation_count;
+    bool recording;
+
+    // Encoder state, owned by the logging side
+    uint8_t page[BLACKBOX_PAGE_SIZE];
+    uint16_t page_fill;
+    uint16_t page_seq;
+    uint16_t page_frames;       // Frames started in the current page
+    int32_t prev[BLACKBOX_FIELD_COUNT];
+    int32_t prev2[BLACKBOX_FIELD_COUNT];
+    uint32_t frames_since_intra;
+    bool force_intra;
+
+    spsc_ring_t queue;
+    uint8_t queue_storage[BLACKBOX_PAGE_QUEUE][BLACKBOX_PAGE_SIZE];
+
+    // Flush side
+    uint32_t write_offset;      // Next page to program
+    uint32_t erased_offset;     // Everything below this and above write_offset is erased
+
+    // Statistics
+    uint32_t frames_logged;
+    uint32_t frames_dropped;    // Lost with pages the queue or storage could not take
+    uint32_t pages_written;
+} blackbox_t;
+
+// Finds the end of any existing log so new sessions are appended
+void blackbox_init(blackbox_t* bb, const blackbox_storage_t* storage, uint32_t decimation);
+void blackbox_set_decimation(blackbox_t* bb, uint32_t decimation);
+
+// Sessions start with a header frame; stop() pads and queues the last page
+void blackbox_start(blackbox_t* bb, uint32_t loop_rate_hz);
+void blackbox_stop(blackbox_t* bb);
+
+// Loop side: encode into RAM only, never touches flash
+void blackbox_log(blackbox_t* bb, const blackbox_frame_t* frame);
+
+// Ground side: makes sure the next `bytes` after the write position (up to
+// the end of the region) are erased, skipping sectors that already read
+// blank. Blocking, an erase stalls flash access for tens of milliseconds:
+// call it before arming or after disarming. Returns the sectors erased.
+uint32_t blackbox_prepare(blackbox_t* bb, uint32_t bytes);
+
+// Background side: program up to max_pages queued pages. Never erases;
+// once the prepared space is used up, pages stay queued until the next
+// blackbox_prepare() and the log side drops (and counts) what does not fit.
+uint32_t blackbox_flush(blackbox_t* bb, uint32_t max_pages);
+
+// Erased space left ahead of the write position
+uint32_t blackbox_erased_bytes(const blackbox_t* bb);
+
+// Erase the whole region and start over (blocking, ground use only)
+void blackbox_erase_all(blackbox_t* bb);
+
+// Encoding shared with the host decoder
+void blackbox_frame_to_fields(const blackbox_frame_t* frame, int32_t fields[BLACKBOX_FIELD_COUNT]);
+void blackbox_fields_to_frame(const int32_t fields[BLACKBOX_FIELD_COUNT], blackbox_frame_t* frame);
+void blackbox_predict(const int32_t prev[BLACKBOX_FIELD_COUNT],
+                      const int32_t prev2[BLACKBOX_FIELD_COUNT],
+                      int32_t predicted[BLACKBOX_FIELD_COUNT]);
+size_t blackbox_put_varint(uint8_t* dst, int32_t value);
+// Returns the number of bytes consumed, or 0 if src ends mid-varint
+size_t blackbox_get_varint(const uint8_t* src, size_t len, int32_t* value);
+
+// RP2040 port: log region at flash_offset bytes from the start of flash
+void blackbox_flash_init(blackbox_t* bb, uint32_t flash_offset, uint32_t size, uint32_t decimation);
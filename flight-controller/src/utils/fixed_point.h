@@ -0,0 +1,129 @@
+// flight-controller/src/utils/fixed_point.h
+#pragma once
+
+#include <stdint.h>
+
+// Q-format arithmetic for the fixed-point flight path (FC_FIXED_POINT).
+// The Cortex-M0+ has no FPU, so every float operation is a library call.
+// These helpers use only integer adds, shifts and multiplies.
+//
+//   q15_t  Q1.15 in int16_t, [-1, 1 - 2^-15]
+//   q31_t  Q1.31 in int32_t, [-1, 1 - 2^-31]
+//   q30_t  Q2.30 in int32_t, [-2, 2 - 2^-30], for values that must reach
+//          1.0 exactly (quaternion components, normalization factors)
+//
+// Every operation saturates instead of wrapping. Products are rounded to
+// nearest, with ties toward +infinity. The results depend only on integer
+// arithmetic, so host and RP2040 builds agree bit for bit (both compilers
+// shift negative values arithmetically).
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int32_t q30_t;
+
+#define Q15_MAX  INT16_MAX
+#define Q15_MIN  INT16_MIN
+#define Q31_MAX  INT32_MAX
+#define Q31_MIN  INT32_MIN
+#define Q30_ONE  (1 << 30)
+
+typedef struct {
+    q15_t x;
+    q15_t y;
+    q15_t z;
+} vector3_q15_t;
+
+typedef struct {
+    q30_t q0, q1, q2, q3;
+} quaternion_q30_t;
+
+static inline q15_t q15_sat(int32_t x) {
+    if (x > Q15_MAX) return Q15_MAX;
+    if (x < Q15_MIN) return Q15_MIN;
+    return (q15_t)x;
+}
+
+static inline int32_t q31_sat(int64_t x) {
+    if (x > Q31_MAX) return Q31_MAX;
+    if (x < Q31_MIN) return Q31_MIN;
+    return (int32_t)x;
+}
+
+static inline q15_t q15_add(q15_t a, q15_t b) {
+    return q15_sat((int32_t)a + b);
+}
+
+static inline q15_t q15_sub(q15_t a, q15_t b) {
+    return q15_sat((int32_t)a - b);
+}
+
+static inline q15_t q15_mul(q15_t a, q15_t b) {
+    return q15_sat(((int32_t)a * b + (1 << 14)) >> 15);
+}
+
+static inline q31_t q31_add(q31_t a, q31_t b) {
+    return q31_sat((int64_t)a + b);
+}
+
+static inline q31_t q31_sub(q31_t a, q31_t b) {
+    return q31_sat((int64_t)a - b);
+}
+
+static inline q31_t q31_mul(q31_t a, q31_t b) {
+    return q31_sat(((int64_t)a * b + (1 << 30)) >> 31);
+}
+
+static inline q30_t q30_mul(q30_t a, q30_t b) {
+    return q31_sat(((int64_t)a * b + (1 << 29)) >> 30);
+}
+
+// Conversions round to nearest and saturate; NaN converts to 0. They are
+// for setup and for the float views kept for telemetry, not the hot path.
+static inline q15_t q15_from_float(float x) {
+    float s = x * 32768.0f;
+    if (s != s) return 0;
+    if (s >= 32767.0f) return Q15_MAX;
+    if (s <= -32768.0f) return Q15_MIN;
+    return (q15_t)(s >= 0.0f ? s + 0.5f : s - 0.5f);
+}
+
+static inline q31_t q31_from_float(float x) {
+    float s = x * 2147483648.0f;
+    if (s != s) return 0;
+    if (s >= 2147483647.0f) return Q31_MAX;
+    if (s <= -2147483648.0f) return Q31_MIN;
+    return (q31_t)(s >= 0.0f ? s + 0.5f : s - 0.5f);
+}
+
+static inline q30_t q30_from_float(float x) {
+    return q31_from_float(x * 0.5f);
+}
+
+static inline float q15_to_float(q15_t x) {
+    return (float)x * (1.0f / 32768.0f);
+}
+
+static inline float q31_to_float(q31_t x) {
+    return (float)x * (1.0f / 2147483648.0f);
+}
+
+static inline float q30_to_float(q30_t x) {
+    return (float)x * (1.0f / 1073741824.0f);
+}
+
+// floor(sqrt(x)), bit by bit: 16 iterations of shifts, adds and compares
+static inline uint32_t fix_isqrt32(uint32_t x) {
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
@@ -0,0 +1,102 @@
+#include "framing.h"
+
+// Nibble-wide table: 32 bytes of flash instead of 512 for the byte table
+static const uint16_t CRC16_NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t crc16_ccitt(const uint8_t* data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+typedef struct {
+    uint8_t* dst;
+    size_t out;
+    size_t code_pos;
+    uint8_t code;
+} cobs_encoder_t;
+
+static void cobs_begin(cobs_encoder_t* enc, uint8_t* dst) {
+    enc->dst = dst;
+    enc->code_pos = 0;
+    enc->out = 1;
+    enc->code = 1;
+}
+
+static void cobs_put(cobs_encoder_t* enc, uint8_t byte) {
+    if (byte != 0) {
+        enc->dst[enc->out++] = byte;
+        enc->code++;
+        if (enc->code != 0xFF) return;
+    }
+    // Close the current block: either a zero or a full 254-byte run
+    enc->dst[enc->code_pos] = enc->code;
+    enc->code_pos = enc->out++;
+    enc->code = 1;
+}
+
+static size_t cobs_end(cobs_encoder_t* enc) {
+    enc->dst[enc->code_pos] = enc->code;
+    return enc->out;
+}
+
+size_t cobs_encode(const uint8_t* src, size_t len, uint8_t* dst) {
+    cobs_encoder_t enc;
+    cobs_begin(&enc, dst);
+    for (size_t i = 0; i < len; i++) {
+        cobs_put(&enc, src[i]);
+    }
+    return cobs_end(&enc);
+}
+
+size_t cobs_decode(const uint8_t* src, size_t len, uint8_t* dst, size_t dst_cap) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        uint8_t code = src[in++];
+        if (code == 0) return 0;
+
+        for (uint8_t i = 1; i < code; i++) {
+            if (in >= len || src[in] == 0 || out >= dst_cap) return 0;
+            dst[out++] = src[in++];
+        }
+        // A short block implies a zero, except at the very end
+        if (code != 0xFF && in < len) {
+            if (out >= dst_cap) return 0;
+            dst[out++] = 0;
+        }
+    }
+    return out;
+}
+
+size_t frame_encode(const uint8_t* payload, size_t len, uint8_t* dst) {
+    uint16_t crc = crc16_ccitt(payload, len, 0xFFFF);
+
+    cobs_encoder_t enc;
+    cobs_begin(&enc, dst);
+    for (size_t i = 0; i < len; i++) {
+        cobs_put(&enc, payload[i]);
+    }
+    cobs_put(&enc, (uint8_t)(crc & 0xFF));
+    cobs_put(&enc, (uint8_t)(crc >> 8));
+
+    size_t n = cobs_end(&enc);
+    dst[n++] = 0;
+    return n;
+}
+
+int frame_decode(const uint8_t* src, size_t len, uint8_t* dst, size_t dst_cap) {
+    size_t n = cobs_decode(src, len, dst, dst_cap);
+    if (n < 2) return -1;
+
+    n -= 2;
+    uint16_t crc = (uint16_t)(dst[n] | (dst[n + 1] << 8));
+    if (crc16_ccitt(dst, n, 0xFFFF) != crc) return -1;
+    return (int)n;
+}
@@ -0,0 +1,28 @@
+// flight-controller/src/utils/framing.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte-stream framing shared by the firmware and the host tools: payload,
+// CRC-16/CCITT-FALSE (little-endian), COBS-encoded and terminated by 0x00.
+// A receiver can resynchronise on the next 0x00 after any corruption.
+
+// Worst-case COBS output for n input bytes
+#define COBS_MAX_ENCODED(n) ((n) + ((n) / 254) + 1)
+// Worst-case frame for an n-byte payload, including CRC and delimiter
+#define FRAME_MAX_ENCODED(n) (COBS_MAX_ENCODED((n) + 2) + 1)
+
+uint16_t crc16_ccitt(const uint8_t* data, size_t len, uint16_t crc);
+
+// dst must hold COBS_MAX_ENCODED(len) bytes; no delimiter is written
+size_t cobs_encode(const uint8_t* src, size_t len, uint8_t* dst);
+// Returns the decoded length, or 0 if src is malformed or dst too small
+size_t cobs_decode(const uint8_t* src, size_t len, uint8_t* dst, size_t dst_cap);
+
+// Encode payload + CRC + delimiter into dst (FRAME_MAX_ENCODED(len) bytes)
+size_t frame_encode(const uint8_t* payload, size_t len, uint8_t* dst);
+// Decode one frame without its delimiter; dst needs room for the payload
+// plus the two CRC bytes. Returns the payload length, or -1 on a COBS or
+// CRC error.
+int frame_decode(const uint8_t* src, size_t len, uint8_t* dst, size_t dst_cap);
@@ -0,0 +1,14 @@
+// flight-controller/src/utils/heap_guard.h
+#pragma once
+
+// Included last by the modules on the flight loop's path. With
+// FC_STATIC_ALLOC the flight stack lives in one statically allocated
+// flight_stack_t, and any heap call below this include is a compile error,
+// so a module can't quietly start allocating again.
+
+#include <stdlib.h>
+#include "../include/config.h"
+
+#if FC_STATIC_ALLOC
+#pragma GCC poison malloc calloc realloc free
+#endif
@@ -1,10 +1,79 @@
 #include "logger.h"
+#include "telemetry.h"
+#include "spsc_ring.h"
+#include "drivers/hal.h"
+#include "../include/config.h"
 
-void logger_init(void) {
-    // Initialize stdio (already done in system_init)
+_Static_assert(sizeof(((telemetry_log_t*)0)->args) == LOG_MAX_ARGS * sizeof(uint32_t),
+               "log record and LOG_MAX_ARGS disagree");
+
+// Defined by the linker when at least one deferred call site exists
+extern const char __start_fc_log_fmt[] __attribute__((weak));
+
+// A core 1 record, stamped when it was logged
+typedef struct {
+    uint64_t timestamp_us;
+    telemetry_log_t rec;
+} core1_log_t;
+
+static telemetry_t* log_channel;
+static uint32_t log_dropped;            // Written by core 0 only
+
+// Core 1 may not touch the channel, so its records wait here for core 0;
+// the ring counts those it had no room for
+static spsc_ring_t core1_queue;
+static core1_log_t core1_storage[LOG_CORE1_QUEUE_SIZE];
+
+void logger_init(telemetry_t* tel) {
+    // stdio itself is set up by hal_init()
+    log_channel = tel;
+    log_dropped = 0;
+    spsc_ring_init(&core1_queue, core1_storage, sizeof(core1_log_t), LOG_CORE1_QUEUE_SIZE);
 }
 
 void logger_flush(void) {
     // Force output buffer flush
-    stdio_flush();
+    hal_console_flush();
+}
+
+uint16_t logger_format_id(const char* fmt) {
+    return (uint16_t)(fmt - __start_fc_log_fmt);
+}
+
+static void send_record(uint64_t timestamp_us, const telemetry_log_t* rec) {
+    if (log_channel == NULL ||
+        !telemetry_send(log_channel, TELEMETRY_LOG, timestamp_us, rec, sizeof(*rec))) {
+        log_dropped++;
+    }
+}
+
+void logger_pump(void) {
+    core1_log_t queued;
+    while (spsc_ring_pop(&core1_queue, &queued)) send_record(queued.timestamp_us, &queued.rec);
+}
+
+void logger_deferred(log_level_t level, const char* fmt, const uint32_t* args, uint32_t nargs) {
+    core1_log_t log = {
+        .timestamp_us = hal_time_us(),
+        .rec = {
+            .id = logger_format_id(fmt),
+            .level = (uint8_t)level,
+            .nargs = (uint8_t)nargs
+        }
+    };
+    memcpy(log.rec.args, args, nargs * sizeof(uint32_t));
+
+    // Core 1 would race core 0 on the channel's producer side
+    if (hal_core_num() != 0) {
+        spsc_ring_push(&core1_queue, &log);
+        return;
+    }
+
+    // Core 1's earlier records go first
+    logger_pump();
+    send_record(log.timestamp_us, &log.rec);
+}
+
+uint32_t logger_dropped(void) {
+    return log_dropped + core1_queue.dropped;
 }
@@ -1,10 +1,88 @@
 #pragma once
 
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_ERROR
+} log_level_t;
+
+typedef struct telemetry telemetry_t;
+
+// Arguments per deferred call (size of telemetry_log_t.args)
+#define LOG_MAX_ARGS 5
+
+#ifdef FC_LOG_DEFERRED
+// Deferred mode: no formatting on the MCU. Each call site places its format
+// string in the fc_log_fmt section and sends only the string's offset in
+// that section plus the raw argument words as a telemetry record; the host
+// rebuilds the text from the string table in the ELF (tools/telemetry).
+//
+// Up to LOG_MAX_ARGS numeric arguments. Integers travel as 32 bits and
+// floating-point values as float; %s and %p are not supported.
+
+#define LOG_DEBUG(fmt, ...) LOG_DEFERRED(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_DEFERRED(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_DEFERRED(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+#define LOG_DEFERRED(level, fmt, ...) do { \
+        __attribute__((section("fc_log_fmt"), used)) \
+        static const char log_fmt_[] = fmt; \
+        const uint32_t log_args_[] = { 0, LOG_WORDS(__VA_ARGS__) }; \
+        _Static_assert(LOG_NARGS(__VA_ARGS__) <= LOG_MAX_ARGS, "too many log arguments"); \
+        logger_deferred((level), log_fmt_, &log_args_[1], LOG_NARGS(__VA_ARGS__)); \
+    } while (0)
+
+static inline uint32_t log_word_float(double value) {
+    float f = (float)value;
+    uint32_t word;
+    memcpy(&word, &f, sizeof(word));
+    return word;
+}
+
+static inline uint32_t log_word_int(uint32_t value) {
+    return value;
+}
+
+#define LOG_WORD(x) _Generic((x), float: log_word_float, double: log_word_float, \
+                             default: log_word_int)(x)
+
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, n, ...) n
+
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+#define LOG_WORDS(...) LOG_CAT(LOG_WORDS_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define LOG_WORDS_0()
+#define LOG_WORDS_1(a) LOG_WORD(a)
+#define LOG_WORDS_2(a, b) LOG_WORD(a), LOG_WORD(b)
+#define LOG_WORDS_3(a, b, c) LOG_WORD(a), LOG_WORD(b), LOG_WORD(c)
+#define LOG_WORDS_4(a, b, c, d) LOG_WORD(a), LOG_WORD(b), LOG_WORD(c), LOG_WORD(d)
+#define LOG_WORDS_5(a, b, c, d, e) LOG_WORD(a), LOG_WORD(b), LOG_WORD(c), LOG_WORD(d), LOG_WORD(e)
+#else
 #define LOG_DEBUG(fmt, ...) printf("DEBUG: " fmt "\n", ##__VA_ARGS__)
 #define LOG_INFO(fmt, ...) printf("INFO: " fmt "\n", ##__VA_ARGS__)
 #define LOG_ERROR(fmt, ...) printf("ERROR: " fmt "\n", ##__VA_ARGS__)
+#endif
 
-void logger_init(void);
+// Deferred records are sent through tel; until then they are dropped.
+// Deferred logging shares the telemetry producer side, which belongs to
+// core 0. Records logged on core 1 are queued, LOG_CORE1_QUEUE_SIZE at
+// most, and sent by core 0 on its next log call or logger_pump(). Call
+// logger_init() before core 1 starts.
+void logger_init(telemetry_t* tel);
 void logger_flush(void);
+
+void logger_deferred(log_level_t level, const char* fmt, const uint32_t* args, uint32_t nargs);
+
+// Core 0: sends the records core 1 has queued
+void logger_pump(void);
+
+// Records lost: no channel, a full channel, or a full core 1 queue
+uint32_t logger_dropped(void);
+
+// Offset of a format string in fc_log_fmt, as carried in log records
+uint16_t logger_format_id(const char* fmt);
@@ -0,0 +1,109 @@
+#include "loop_profiler.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#define PROFILER_READ_RETRIES 8
+#define PROFILER_CALIBRATION_ROUNDS 64
+
+static profile_stage_stats_t stages[PROFILE_STAGE_COUNT];
+static uint32_t overhead_ticks;
+
+static const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    [PROFILE_STAGE_IMU_READ] = "imu_read",
+    [PROFILE_STAGE_GYRO_FILTER] = "gyro_filter",
+    [PROFILE_STAGE_ESTIMATOR] = "estimator",
+    [PROFILE_STAGE_EULER] = "euler",
+    [PROFILE_STAGE_ANGLE_PIDS] = "angle_pids",
+    [PROFILE_STAGE_RATE_PIDS] = "rate_pids",
+    [PROFILE_STAGE_MIXER] = "mixer"
+};
+
+static inline uint32_t bucket_for(uint32_t ticks) {
+    if (ticks == 0) return 0;
+    uint32_t bucket = 31 - (uint32_t)__builtin_clz(ticks);
+    return bucket < PROFILE_HIST_BUCKETS ? bucket : PROFILE_HIST_BUCKETS - 1;
+}
+
+static void clear_stage(profile_stage_stats_t* s) {
+    s->seq++;
+    atomic_thread_fence(memory_order_release);
+    s->count = 0;
+    s->min = UINT32_MAX;
+    s->max = 0;
+    s->total = 0;
+    memset(s->hist, 0, sizeof(s->hist));
+    atomic_thread_fence(memory_order_release);
+    s->seq++;
+}
+
+void loop_profiler_init_core(void) {
+#ifndef HOST_BUILD
+    // Free-running 24-bit down-counter on the processor clock
+    systick_hw->rvr = PROFILE_SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5;  // ENABLE | CLKSOURCE=processor
+#endif
+}
+
+void loop_profiler_init(void) {
+    loop_profiler_init_core();
+
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        stages[i].seq = 0;
+        clear_stage(&stages[i]);
+    }
+
+    // Time complete probe pairs (both timestamps and the record call) into
+    // a scratch stage, then discard what they recorded
+    uint32_t start = profile_now();
+    for (int i = 0; i < PROFILER_CALIBRATION_ROUNDS; i++) {
+        uint32_t probe_start = profile_now();
+        loop_profiler_record(PROFILE_STAGE_IMU_READ, profile_elapsed(probe_start, profile_now()));
+    }
+    overhead_ticks = profile_elapsed(start, profile_now()) / PROFILER_CALIBRATION_ROUNDS;
+    clear_stage(&stages[PROFILE_STAGE_IMU_READ]);
+}
+
+void loop_profiler_record(profile_stage_t stage, uint32_t ticks) {
+    profile_stage_stats_t* s = &stages[stage];
+
+    s->seq++;
+    atomic_thread_fence(memory_order_release);
+
+    s->count++;
+    s->total += ticks;
+    if (ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+    s->hist[bucket_for(ticks)]++;
+
+    atomic_thread_fence(memory_order_release);
+    s->seq++;
+}
+
+bool loop_profiler_read(profile_stage_t stage, profile_stage_stats_t* out) {
+    const profile_stage_stats_t* s = &stages[stage];
+
+    for (int attempt = 0; attempt < PROFILER_READ_RETRIES; attempt++) {
+        uint32_t before = s->seq;
+        atomic_thread_fence(memory_order_acquire);
+        if (before & 1u) continue;
+
+        memcpy(out, (const void*)s, sizeof(profile_stage_stats_t));
+
+        atomic_thread_fence(memory_order_acquire);
+        if (s->seq == before) return true;
+    }
+    return false;
+}
+
+void loop_profiler_reset(profile_stage_t stage) {
+    clear_stage(&stages[stage]);
+}
+
+uint32_t loop_profiler_overhead_ticks(void) {
+    return overhead_ticks;
+}
+
+const char* loop_profiler_stage_name(profile_stage_t stage) {
+    return STAGE_NAMES[stage];
+}
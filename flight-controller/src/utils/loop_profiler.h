@@ -0,0 +1,95 @@
+// flight-controller/src/utils/loop_profiler.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-stage timing probes for the flight loop.
+//
+// Probes are only compiled in when FC_PROFILE is defined (CMake option
+// FC_ENABLE_PROFILING); otherwise PROFILE_BEGIN/PROFILE_END expand to
+// nothing and the loop is byte-for-byte the release build.
+//
+// Timestamps are SysTick cycles on the RP2040 (clk_sys, 24-bit, so a single
+// stage must finish within 2^24 cycles = 67 ms at 250 MHz) and nanoseconds
+// on the host. Each probe pair costs two SysTick loads plus one
+// loop_profiler_record() call; the measured cost per pair is stored in
+// loop_profiler_overhead_ticks() at init so it can be subtracted when
+// reading the numbers.
+
+typedef enum {
+    PROFILE_STAGE_IMU_READ,
+    PROFILE_STAGE_GYRO_FILTER,  // RPM and dynamic notches, when on
+    PROFILE_STAGE_ESTIMATOR,
+    PROFILE_STAGE_EULER,        // Attitude error, Euler or quaternion
+    PROFILE_STAGE_ANGLE_PIDS,   // The three angle loop PIDs
+    PROFILE_STAGE_RATE_PIDS,    // The three rate loop PIDs
+    PROFILE_STAGE_MIXER,
+    PROFILE_STAGE_COUNT
+} profile_stage_t;
+
+// Bucket n counts durations in [2^n, 2^(n+1)) ticks; the last bucket also
+// takes everything longer
+#define PROFILE_HIST_BUCKETS 24
+
+typedef struct {
+    volatile uint32_t seq;      // Odd while the owning core is updating
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[PROFILE_HIST_BUCKETS];
+} profile_stage_stats_t;
+
+#ifdef HOST_BUILD
+#include <time.h>
+
+static inline uint32_t profile_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+static inline uint32_t profile_elapsed(uint32_t start, uint32_t end) {
+    return end - start;
+}
+#else
+#include "hardware/structs/systick.h"
+
+#define PROFILE_SYSTICK_MASK 0x00FFFFFFu
+
+static inline uint32_t profile_now(void) {
+    return systick_hw->cvr;
+}
+
+// SysTick counts down
+static inline uint32_t profile_elapsed(uint32_t start, uint32_t end) {
+    return (start - end) & PROFILE_SYSTICK_MASK;
+}
+#endif
+
+// Reset all statistics and measure the probe overhead. On the RP2040 each
+// core has its own SysTick, so every core that records stages must call
+// loop_profiler_init_core() once.
+void loop_profiler_init(void);
+void loop_profiler_init_core(void);
+
+// Stages must each be recorded from a single core
+void loop_profiler_record(profile_stage_t stage, uint32_t ticks);
+
+// Consistent copy of one stage, safe to call from any core while the loop
+// keeps running. Returns false if the writer kept it busy for every retry.
+bool loop_profiler_read(profile_stage_t stage, profile_stage_stats_t* out);
+void loop_profiler_reset(profile_stage_t stage);
+
+uint32_t loop_profiler_overhead_ticks(void);
+const char* loop_profiler_stage_name(profile_stage_t stage);
+
+#ifdef FC_PROFILE
+#define PROFILE_BEGIN(stage) const uint32_t profile_start_##stage = profile_now()
+#define PROFILE_END(stage) \
+    loop_profiler_record((stage), profile_elapsed(profile_start_##stage, profile_now()))
+#else
+#define PROFILE_BEGIN(stage) ((void)0)
+#define PROFILE_END(stage) ((void)0)
+#endif
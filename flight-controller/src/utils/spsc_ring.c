@@ -0,0 +1,65 @@
+#include "spsc_ring.h"
+#include <string.h>
+
+bool spsc_ring_init(spsc_ring_t* ring, void* storage, uint32_t elem_size, uint32_t capacity) {
+    if (storage == NULL || elem_size == 0) return false;
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) return false;
+
+    ring->storage = storage;
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->dropped = 0;
+    return true;
+}
+
+bool spsc_ring_push(spsc_ring_t* ring, const void* elem) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail > ring->mask) {
+        ring->dropped++;
+        return false;
+    }
+
+    memcpy(&ring->storage[(head & ring->mask) * ring->elem_size], elem, ring->elem_size);
+
+    // Publish the element only after its bytes are in place
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t* ring, void* elem) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) return false;
+
+    memcpy(elem, &ring->storage[(tail & ring->mask) * ring->elem_size], ring->elem_size);
+
+    // Hand the slot back only after it has been copied out
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_ring_pop_latest(spsc_ring_t* ring, void* elem, uint32_t* skipped) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (skipped != NULL) *skipped = 0;
+    if (head == tail) return false;
+
+    if (skipped != NULL) *skipped = head - tail - 1;
+    uint32_t newest = head - 1;
+    memcpy(elem, &ring->storage[(newest & ring->mask) * ring->elem_size], ring->elem_size);
+
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+    return true;
+}
+
+uint32_t spsc_ring_count(spsc_ring_t* ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
@@ -0,0 +1,33 @@
+// flight-controller/src/utils/spsc_ring.h
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lock-free single-producer/single-consumer ring of fixed-size elements.
+// The producer only writes head and the consumer only writes tail, so the
+// two sides may run on different cores (or host threads) without locks.
+// Storage is supplied by the caller; capacity must be a power of two.
+typedef struct {
+    uint8_t* storage;
+    uint32_t elem_size;
+    uint32_t mask;
+    _Atomic uint32_t head;    // Next slot to write (producer-owned)
+    _Atomic uint32_t tail;    // Next slot to read (consumer-owned)
+    uint32_t dropped;         // Pushes rejected because the ring was full
+} spsc_ring_t;
+
+bool spsc_ring_init(spsc_ring_t* ring, void* storage, uint32_t elem_size, uint32_t capacity);
+
+// Producer side
+bool spsc_ring_push(spsc_ring_t* ring, const void* elem);
+
+// Consumer side
+bool spsc_ring_pop(spsc_ring_t* ring, void* elem);
+// Discard everything but the newest element; returns the number skipped
+// through *skipped (may be NULL)
+bool spsc_ring_pop_latest(spsc_ring_t* ring, void* elem, uint32_t* skipped);
+
+// Either side; the value may be stale by the time it is used
+uint32_t spsc_ring_count(spsc_ring_t* ring);
@@ -0,0 +1,54 @@
+#include "telemetry.h"
+#include <string.h>
+
+void telemetry_init(telemetry_t* tel, const telemetry_port_t* port) {
+    tel->port = *port;
+    spsc_ring_init(&tel->ring, tel->storage, sizeof(telemetry_record_t), TELEMETRY_RING_SIZE);
+    tel->next_seq = 0;
+    tel->frame_len = 0;
+    tel->frame_sent = 0;
+    tel->records_sent = 0;
+    tel->bytes_sent = 0;
+}
+
+bool telemetry_send(telemetry_t* tel, telemetry_type_t type, uint64_t timestamp_us,
+                    const void* payload, size_t payload_len) {
+    if (payload_len > TELEMETRY_PAYLOAD_SIZE) return false;
+
+    telemetry_record_t rec;
+    rec.type = (uint8_t)type;
+    rec.reserved = 0;
+    // Consumed even if the push fails so the receiver sees the gap
+    rec.seq = tel->next_seq++;
+    rec.timestamp_us = (uint32_t)timestamp_us;
+    memcpy(rec.raw, payload, payload_len);
+    memset(rec.raw + payload_len, 0, TELEMETRY_PAYLOAD_SIZE - payload_len);
+
+    return spsc_ring_push(&tel->ring, &rec);
+}
+
+size_t telemetry_drain(telemetry_t* tel, uint32_t max_records) {
+    size_t written = 0;
+
+    while (1) {
+        if (tel->frame_sent == tel->frame_len) {
+            telemetry_record_t rec;
+            if (max_records == 0 || !spsc_ring_pop(&tel->ring, &rec)) break;
+            max_records--;
+
+            tel->frame_len = (uint16_t)frame_encode((const uint8_t*)&rec, sizeof(rec), tel->frame);
+            tel->frame_sent = 0;
+        }
+
+        size_t n = tel->port.write(tel->port.ctx, &tel->frame[tel->frame_sent],
+                                   tel->frame_len - tel->frame_sent);
+        tel->frame_sent += (uint16_t)n;
+        written += n;
+
+        if (tel->frame_sent < tel->frame_len) break;  // Sink is full
+        tel->records_sent++;
+    }
+
+    tel->bytes_sent += (uint32_t)written;
+    return written;
+}
@@ -0,0 +1,146 @@
+// flight-controller/src/utils/telemetry.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "framing.h"
+#include "spsc_ring.h"
+
+// Binary telemetry channel. The loop pushes fixed-size records into a
+// lock-free ring, which never blocks: a full ring drops the record and
+// counts it. telemetry_drain() frames queued records (see framing.h) and
+// hands them to a non-blocking byte sink, resuming partially written
+// frames on the next call. All storage lives in telemetry_t.
+//
+// Records are little-endian and packed so the host decoder can use the
+// same definitions.
+
+#define TELEMETRY_RING_SIZE 32      // Records, must be a power of two
+#define TELEMETRY_PAYLOAD_SIZE 24
+
+typedef enum {
+    TELEMETRY_ATTITUDE = 1,
+    TELEMETRY_MOTORS,
+    TELEMETRY_STATUS,
+    TELEMETRY_TASK,
+    TELEMETRY_PROFILE,
+    TELEMETRY_LOG,
+    TELEMETRY_BLACKBOX
+} telemetry_type_t;
+
+typedef struct __attribute__((packed)) {
+    float roll, pitch, yaw;         // degrees
+    float rate_x, rate_y, rate_z;   // deg/s
+} telemetry_attitude_t;
+
+typedef struct __attribute__((packed)) {
+    float output[4];
+    float throttle;
+} telemetry_motors_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t dropped;               // Records lost to a full ring
+    uint32_t sent;
+    uint32_t trigger_irq;
+    uint32_t trigger_fallback;
+    uint32_t trigger_missed;
+    uint16_t imu_duplicates;        // mpu6050_sample_stats_t, since boot, wrapping
+    uint16_t imu_skipped;
+} telemetry_status_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t task;                   // Index into the scheduler task table
+    uint8_t reserved[3];
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t max_jitter_us;
+    uint32_t mean_jitter_us;
+} telemetry_task_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t stage;                  // profile_stage_t
+    uint8_t reserved[3];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint32_t overhead;
+} telemetry_profile_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t pages_written;
+    uint32_t frames_dropped;
+    uint32_t erased_bytes;          // Prepared space left
+    uint32_t max_stall_us;          // Longest page program since the last record
+    uint32_t deferred;              // Control updates that left too little time for a page
+} telemetry_blackbox_t;
+
+// Deferred log call, see logger.h
+typedef struct __attribute__((packed)) {
+    uint16_t id;                    // Format string offset in fc_log_fmt
+    uint8_t level;                  // log_level_t
+    uint8_t nargs;
+    uint32_t args[5];
+} telemetry_log_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t seq;                   // Gaps on the receiver mean dropped records
+    uint32_t timestamp_us;
+    union {
+        telemetry_attitude_t attitude;
+        telemetry_motors_t motors;
+        telemetry_status_t status;
+        telemetry_task_t task;
+        telemetry_profile_t profile;
+        telemetry_log_t log;
+        telemetry_blackbox_t blackbox;
+        uint8_t raw[TELEMETRY_PAYLOAD_SIZE];
+    };
+} telemetry_record_t;
+
+_Static_assert(sizeof(telemetry_record_t) == 8 + TELEMETRY_PAYLOAD_SIZE,
+               "telemetry record layout changed");
+
+#define TELEMETRY_FRAME_MAX FRAME_MAX_ENCODED(sizeof(telemetry_record_t))
+
+// Byte sink. Must not block: returns how many bytes it accepted, which may
+// be fewer than len (or zero).
+typedef struct {
+    size_t (*write)(void* ctx, const uint8_t* data, size_t len);
+    void* ctx;
+} telemetry_port_t;
+
+typedef struct telemetry {
+    telemetry_port_t port;
+    spsc_ring_t ring;
+    telemetry_record_t storage[TELEMETRY_RING_SIZE];
+    uint16_t next_seq;              // Producer-owned
+
+    // Consumer side: the frame currently being written out
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    uint16_t frame_len;
+    uint16_t frame_sent;
+    uint32_t records_sent;
+    uint32_t bytes_sent;
+} telemetry_t;
+
+void telemetry_init(telemetry_t* tel, const telemetry_port_t* port);
+
+// Producer side. payload_len may be shorter than TELEMETRY_PAYLOAD_SIZE;
+// the rest is zeroed. Returns false if the record was dropped.
+bool telemetry_send(telemetry_t* tel, telemetry_type_t type, uint64_t timestamp_us,
+                    const void* payload, size_t payload_len);
+
+// Consumer side. Writes at most max_records new frames and stops early
+// when the sink is full. Returns the number of bytes written.
+size_t telemetry_drain(telemetry_t* tel, uint32_t max_records);
+
+static inline uint32_t telemetry_dropped(const telemetry_t* tel) {
+    return tel->ring.dropped;
+}
+
+// RP2040 port: writes to the USB CDC interface shared with stdio
+void telemetry_usb_init(telemetry_t* tel);
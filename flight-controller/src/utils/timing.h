@@ -1,14 +1,11 @@
 #pragma once
 
-#include "hardware/timer.h"
-#include "pico/stdlib.h"
-
-#define DT 0.002f  // 500Hz update rate = 2ms period
+#include "drivers/hal.h"
 
 static inline uint64_t get_time_us(void) {
-    return time_us_64();
+    return hal_time_us();
 }
 
 static inline void delay_us(uint32_t us) {
-    sleep_us(us);
+    hal_sleep_us(us);
 }
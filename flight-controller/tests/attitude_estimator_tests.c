@@ -29,3 +29,122 @@ void test_attitude_estimator_level(void) {
     
     free(estimator);
 }
+
+static const attitude_filter_t FUSION_FILTERS[] = {
+    ATTITUDE_FILTER_MAHONY,
+    ATTITUDE_FILTER_MADGWICK
+};
+
+void test_attitude_filters_converge_to_accel_tilt(void) {
+    const float roll = 20.0f * 0.0174532925f;
+    const vector3_t accel = { 0.0f, sinf(roll), cosf(roll) };
+    const vector3_t gyro = { 0.0f, 0.0f, 0.0f };
+
+    for (int f = 0; f < 2; f++) {
+        attitude_estimator_t* estimator = attitude_estimator_init();
+        TEST_ASSERT_NOT_NULL(estimator);
+        attitude_estimator_set_filter(estimator, FUSION_FILTERS[f]);
+
+        // 20 s at 500 Hz from level
+        for (int i = 0; i < 10000; i++) {
+            attitude_estimator_update(estimator, &accel, &gyro, 0.002f);
+        }
+        attitude_t attitude = attitude_estimator_get_attitude(estimator);
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, 20.0f, attitude.roll);
+        TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.0f, attitude.pitch);
+
+        // Renormalized without a square root, still unit length
+        const quaternion_t* q = &estimator->quaternion;
+        float norm = q->q0 * q->q0 + q->q1 * q->q1 + q->q2 * q->q2 + q->q3 * q->q3;
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, norm);
+
+        free(estimator);
+    }
+}
+
+void test_attitude_filters_learn_gyro_bias(void) {
+    const vector3_t accel = { 0.0f, 0.0f, 1.0f };
+    const vector3_t gyro = { 1.0f, -2.0f, 0.5f };
+
+    for (int f = 0; f < 2; f++) {
+        attitude_estimator_t* estimator = attitude_estimator_init();
+        TEST_ASSERT_NOT_NULL(estimator);
+        attitude_estimator_set_filter(estimator, FUSION_FILTERS[f]);
+
+        // A still, level sensor with a constant rate offset: 30 s
+        for (int i = 0; i < 15000; i++) {
+            attitude_estimator_update(estimator, &accel, &gyro, 0.002f);
+        }
+        attitude_t attitude = attitude_estimator_get_attitude(estimator);
+        TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.0f, attitude.roll);
+        TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.0f, attitude.pitch);
+        TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.0f, estimator->gyro_bias.x);
+        TEST_ASSERT_FLOAT_WITHIN(0.05f, -2.0f, estimator->gyro_bias.y);
+        // Gravity says nothing about yaw
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, estimator->gyro_bias.z);
+
+        free(estimator);
+    }
+}
+
+void test_quaternion_from_attitude_round_trip(void) {
+    const attitude_t cases[] = {
+        { 0.0f, 0.0f, 0.0f }, { 30.0f, -20.0f, 45.0f }, { -120.0f, 60.0f, 170.0f },
+        { 5.0f, 80.0f, -90.0f }
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        quaternion_t q;
+        quaternion_from_attitude(&q, &cases[i]);
+        float norm = q.q0 * q.q0 + q.q1 * q.q1 + q.q2 * q.q2 + q.q3 * q.q3;
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, norm);
+
+        attitude_t back = attitude_from_quaternion(&q);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, cases[i].roll, back.roll);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, cases[i].pitch, back.pitch);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, cases[i].yaw, back.yaw);
+    }
+}
+
+void test_quaternion_attitude_error_small_matches_euler(void) {
+    const attitude_t setpoint = { 2.0f, -1.5f, 1.0f };
+    const attitude_t current = { 0.5f, -0.5f, 0.0f };
+    quaternion_t q_sp, q;
+    vector3_t error;
+
+    quaternion_from_attitude(&q_sp, &setpoint);
+    quaternion_from_attitude(&q, &current);
+    quaternion_attitude_error(&error, &q_sp, &q);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, setpoint.roll - current.roll, error.x);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, setpoint.pitch - current.pitch, error.y);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, setpoint.yaw - current.yaw, error.z);
+
+    // q and -q are the same rotation
+    quaternion_t neg = { -q.q0, -q.q1, -q.q2, -q.q3 };
+    vector3_t error_neg;
+    quaternion_attitude_error(&error_neg, &q_sp, &neg);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, error.x, error_neg.x);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, error.y, error_neg.y);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, error.z, error_neg.z);
+}
+
+void test_quaternion_attitude_error_no_wrap_or_gimbal_lock(void) {
+    quaternion_t q_sp, q;
+    vector3_t error;
+
+    // Yaw across the +-180 wrap: 2 degrees, not 358
+    quaternion_from_attitude(&q_sp, &(attitude_t){ 0.0f, 0.0f, 179.0f });
+    quaternion_from_attitude(&q, &(attitude_t){ 0.0f, 0.0f, -179.0f });
+    quaternion_attitude_error(&error, &q_sp, &q);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, error.x);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, error.y);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -2.0f, error.z);
+
+    // Straight up: Euler roll and yaw are undefined, the error is not
+    quaternion_from_attitude(&q_sp, &(attitude_t){ 0.0f, 90.0f, 0.0f });
+    quaternion_from_attitude(&q, &(attitude_t){ 0.0f, 87.0f, 0.0f });
+    quaternion_attitude_error(&error, &q_sp, &q);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, error.x);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 3.0f, error.y);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, error.z);
+}
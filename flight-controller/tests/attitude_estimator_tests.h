@@ -3,3 +3,8 @@
 
 void test_attitude_estimator_initialization(void);
 void test_attitude_estimator_level(void);
+void test_attitude_filters_converge_to_accel_tilt(void);
+void test_attitude_filters_learn_gyro_bias(void);
+void test_quaternion_from_attitude_round_trip(void);
+void test_quaternion_attitude_error_small_matches_euler(void);
+void test_quaternion_attitude_error_no_wrap_or_gimbal_lock(void);
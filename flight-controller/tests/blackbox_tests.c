@@ -0,0 +1,301 @@
+#include "blackbox_tests.h"
+#include "mock_flash.h"
+#include "../tools/blackbox/blackbox_decoder.h"
+#include <math.h>
+#include <string.h>
+
+#define CAPTURE_MAX 2048
+
+typedef struct {
+    blackbox_frame_t frames[CAPTURE_MAX];
+    uint32_t sessions[CAPTURE_MAX];
+    uint32_t count;
+    blackbox_header_t header;
+} capture_t;
+
+static void capture_session(const blackbox_header_t* header, uint32_t session, void* ctx) {
+    (void)session;
+    ((capture_t*)ctx)->header = *header;
+}
+
+static void capture_frame(const blackbox_frame_t* frame, uint32_t session, void* ctx) {
+    capture_t* cap = ctx;
+    if (cap->count < CAPTURE_MAX) {
+        cap->frames[cap->count] = *frame;
+        cap->sessions[cap->count] = session;
+    }
+    cap->count++;
+}
+
+static void decode_into(const mock_flash_t* flash, capture_t* cap, blackbox_decoder_stats_t* stats) {
+    memset(cap, 0, sizeof(*cap));
+    blackbox_decoder_sink_t sink = {
+        .on_session = capture_session,
+        .on_frame = capture_frame,
+        .ctx = cap
+    };
+    blackbox_decode(flash->data, sizeof(flash->data), &sink, stats);
+}
+
+// Plausible flight data: slowly varying signals plus sensor noise
+static void make_frame(uint32_t i, blackbox_frame_t* f) {
+    float t = (float)i * 0.002f;
+    f->time_us = 1000000u + i * 2000u + (i % 3);
+    f->iteration = i;
+    for (int a = 0; a < 3; a++) {
+        f->accel[a] = (int16_t)(4096.0f * sinf(t + (float)a) + (float)((i * 7 + a) % 5));
+        f->gyro[a] = (int16_t)(300.0f * cosf(2.0f * t + (float)a) + (float)((i * 3 + a) % 7));
+    }
+    f->quaternion[0] = cosf(0.1f * t);
+    f->quaternion[1] = sinf(0.1f * t);
+    f->quaternion[2] = 0.01f * sinf(t);
+    f->quaternion[3] = -0.02f;
+    for (int axis = 0; axis < 3; axis++) {
+        f->pid[axis][0] = 0.3f * sinf(t + (float)axis);
+        f->pid[axis][1] = 0.05f * t;
+        f->pid[axis][2] = -0.01f * cosf(3.0f * t);
+    }
+    for (int m = 0; m < 4; m++) f->motor[m] = 0.5f + 0.1f * sinf(t + (float)m);
+}
+
+static void assert_frame_matches(const blackbox_frame_t* expected, const blackbox_frame_t* actual) {
+    const float tol = 0.5f / BLACKBOX_FLOAT_SCALE + 1e-6f;
+    TEST_ASSERT_EQUAL_UINT32(expected->time_us, actual->time_us);
+    TEST_ASSERT_EQUAL_UINT32(expected->iteration, actual->iteration);
+    for (int a = 0; a < 3; a++) {
+        TEST_ASSERT_EQUAL_INT16(expected->accel[a], actual->accel[a]);
+        TEST_ASSERT_EQUAL_INT16(expected->gyro[a], actual->gyro[a]);
+    }
+    for (int q = 0; q < 4; q++) TEST_ASSERT_FLOAT_WITHIN(tol, expected->quaternion[q], actual->quaternion[q]);
+    for (int axis = 0; axis < 3; axis++) {
+        for (int term = 0; term < 3; term++) {
+            TEST_ASSERT_FLOAT_WITHIN(tol, expected->pid[axis][term], actual->pid[axis][term]);
+        }
+    }
+    for (int m = 0; m < 4; m++) TEST_ASSERT_FLOAT_WITHIN(tol, expected->motor[m], actual->motor[m]);
+}
+
+static void flush_all(blackbox_t* bb) {
+    while (spsc_ring_count(&bb->queue) > 0) {
+        blackbox_flush(bb, BLACKBOX_PAGE_QUEUE);
+    }
+}
+
+void test_blackbox_varint_round_trip(void) {
+    const int32_t values[] = { 0, 1, -1, 63, -64, 64, 8191, -8192, 1000000, INT32_MAX, INT32_MIN };
+    uint8_t buf[5];
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        size_t n = blackbox_put_varint(buf, values[i]);
+        int32_t decoded;
+        TEST_ASSERT_EQUAL_UINT32(n, blackbox_get_varint(buf, n, &decoded));
+        TEST_ASSERT_EQUAL_INT32(values[i], decoded);
+        // A truncated varint is reported, not misread
+        if (n > 1) TEST_ASSERT_EQUAL_UINT32(0, blackbox_get_varint(buf, n - 1, &decoded));
+    }
+    // Small magnitudes of either sign take one byte
+    TEST_ASSERT_EQUAL_UINT32(1, blackbox_put_varint(buf, -64));
+    TEST_ASSERT_EQUAL_UINT32(1, blackbox_put_varint(buf, 63));
+}
+
+void test_blackbox_round_trip(void) {
+    static mock_flash_t flash;
+    static blackbox_t bb;
+    static capture_t cap;
+    mock_flash_init(&flash);
+    blackbox_storage_t storage = mock_flash_storage(&flash);
+    blackbox_init(&bb, &storage, 1);
+    blackbox_prepare(&bb, MOCK_FLASH_SIZE);
+
+    blackbox_start(&bb, 500);
+    blackbox_frame_t frame;
+    for (uint32_t i = 0; i < 1000; i++) {
+        make_frame(i, &frame);
+        blackbox_log(&bb, &frame);
+        if (i % 8 == 0) blackbox_flush(&bb, 2);
+    }
+    blackbox_stop(&bb);
+    flush_all(&bb);
+
+    TEST_ASSERT_EQUAL_UINT32(0, bb.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.bad_programs);
+
+    blackbox_decoder_stats_t stats;
+    decode_into(&flash, &cap, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.sessions);
+    TEST_ASSERT_EQUAL_UINT32(500, cap.header.loop_rate_hz);
+    TEST_ASSERT_EQUAL_UINT32(1000, cap.count);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.corrupt);
+    for (uint32_t i = 0; i < 1000; i++) {
+        make_frame(i, &frame);
+        assert_frame_matches(&frame, &cap.frames[i]);
+    }
+
+    // Well under the 108 bytes of the in-memory frame
+    uint32_t bytes_per_frame = bb.write_offset / 1000;
+    TEST_ASSERT_TRUE(bytes_per_frame < 48);
+}
+
+void test_blackbox_decimation(void) {
+    static mock_flash_t flash;
+    static blackbox_t bb;
+    static capture_t cap;
+    mock_flash_init(&flash);
+    blackbox_storage_t storage = mock_flash_storage(&flash);
+    blackbox_init(&bb, &storage, 4);
+    blackbox_prepare(&bb, MOCK_FLASH_SIZE);
+
+    blackbox_start(&bb, 500);
+    blackbox_frame_t frame;
+    for (uint32_t i = 0; i < 100; i++) {
+        make_frame(i, &frame);
+        blackbox_log(&bb, &frame);
+    }
+    blackbox_stop(&bb);
+    flush_all(&bb);
+
+    blackbox_decoder_stats_t stats;
+    decode_into(&flash, &cap, &stats);
+    TEST_ASSERT_EQUAL_UINT32(4, cap.header.decimation);
+    TEST_ASSERT_EQUAL_UINT32(25, cap.count);
+    for (uint32_t i = 0; i < 25; i++) {
+        TEST_ASSERT_EQUAL_UINT32(4 * i + 3, cap.frames[i].iteration);
+    }
+}
+
+void test_blackbox_dropped_pages_resync(void) {
+    static mock_flash_t flash;
+    static blackbox_t bb;
+    static capture_t cap;
+    mock_flash_init(&flash);
+    blackbox_storage_t storage = mock_flash_storage(&flash);
+    blackbox_init(&bb, &storage, 1);
+    blackbox_prepare(&bb, MOCK_FLASH_SIZE);
+
+    // No flushing for a while: the page queue overflows and pages are lost
+    blackbox_start(&bb, 500);
+    blackbox_frame_t frame;
+    for (uint32_t i = 0; i < 600; i++) {
+        make_frame(i, &frame);
+        blackbox_log(&bb, &frame);
+        if (i >= 300) blackbox_flush(&bb, 4);
+    }
+    blackbox_stop(&bb);
+    flush_all(&bb);
+    TEST_ASSERT_TRUE(bb.frames_dropped > 0);
+
+    blackbox_decoder_stats_t stats;
+    decode_into(&flash, &cap, &stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.page_gaps);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.skipped_frames);
+
+    // At most the frame spilling into the lost page is lost on top
+    TEST_ASSERT_TRUE(cap.count <= 600 - bb.frames_dropped);
+    TEST_ASSERT_TRUE(cap.count + 1 >= 600 - bb.frames_dropped);
+
+    // Every frame that did decode is exact, before and after the gap
+    for (uint32_t i = 0; i < cap.count; i++) {
+        make_frame(cap.frames[i].iteration, &frame);
+        assert_frame_matches(&frame, &cap.frames[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(599, cap.frames[cap.count - 1].iteration);
+}
+
+void test_blackbox_appends_sessions(void) {
+    static mock_flash_t flash;
+    static blackbox_t bb;
+    static capture_t cap;
+    mock_flash_init(&flash);
+    blackbox_storage_t storage = mock_flash_storage(&flash);
+    blackbox_frame_t frame;
+
+    for (int boot = 0; boot < 2; boot++) {
+        // A fresh init finds the end of the previous log
+        blackbox_init(&bb, &storage, 1);
+        blackbox_prepare(&bb, MOCK_FLASH_SIZE);
+        blackbox_start(&bb, 500);
+        for (uint32_t i = 0; i < 50; i++) {
+            make_frame(i, &frame);
+            blackbox_log(&bb, &frame);
+        }
+        blackbox_stop(&bb);
+        flush_all(&bb);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, flash.bad_programs);
+
+    blackbox_decoder_stats_t stats;
+    decode_into(&flash, &cap, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.sessions);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.page_gaps);
+    TEST_ASSERT_EQUAL_UINT32(100, cap.count);
+    TEST_ASSERT_EQUAL_UINT32(0, cap.sessions[49]);
+    TEST_ASSERT_EQUAL_UINT32(1, cap.sessions[50]);
+}
+
+void test_blackbox_erases_only_when_prepared(void) {
+    static mock_flash_t flash;
+    static blackbox_t bb;
+    mock_flash_init(&flash);
+    // Stale data (not a log) in the first four sectors
+    memset(flash.data, 0x00, 4 * BLACKBOX_SECTOR_SIZE);
+    blackbox_storage_t storage = mock_flash_storage(&flash);
+    blackbox_init(&bb, &storage, 1);
+
+    blackbox_start(&bb, 500);
+    blackbox_frame_t frame;
+    for (uint32_t i = 0; i < 40; i++) {
+        make_frame(i, &frame);
+        blackbox_log(&bb, &frame);
+    }
+    blackbox_stop(&bb);
+
+    // Nothing is prepared yet, so nothing is written and flush never erases
+    TEST_ASSERT_EQUAL_UINT32(0, blackbox_flush(&bb, BLACKBOX_PAGE_QUEUE));
+    TEST_ASSERT_EQUAL_UINT32(0, flash.erases);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.programs);
+    TEST_ASSERT_EQUAL_UINT32(0, blackbox_erased_bytes(&bb));
+
+    // Before arming: the stale sectors asked for are erased
+    TEST_ASSERT_EQUAL_UINT32(2, blackbox_prepare(&bb, 2 * BLACKBOX_SECTOR_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(2 * BLACKBOX_SECTOR_SIZE, blackbox_erased_bytes(&bb));
+    flush_all(&bb);
+    TEST_ASSERT_TRUE(flash.programs > 0);
+    TEST_ASSERT_EQUAL_UINT32(2, flash.erases);
+    TEST_ASSERT_EQUAL_UINT32(0, flash.bad_programs);
+
+    // The rest of the region: two more stale sectors, the blank ones are skipped
+    TEST_ASSERT_EQUAL_UINT32(2, blackbox_prepare(&bb, MOCK_FLASH_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(4, flash.erases);
+    TEST_ASSERT_EQUAL_UINT32(MOCK_FLASH_SIZE, bb.erased_offset);
+    TEST_ASSERT_EQUAL_UINT32(MOCK_FLASH_SIZE - bb.write_offset, blackbox_erased_bytes(&bb));
+}
+
+void test_blackbox_flush_stops_at_prepared_space(void) {
+    static mock_flash_t flash;
+    static blackbox_t bb;
+    mock_flash_init(&flash);
+    memset(flash.data, 0x00, sizeof(flash.data));
+    blackbox_storage_t storage = mock_flash_storage(&flash);
+    blackbox_init(&bb, &storage, 1);
+    blackbox_prepare(&bb, BLACKBOX_SECTOR_SIZE);
+
+    // More pages than one sector holds
+    const uint32_t sector_pages = BLACKBOX_SECTOR_SIZE / BLACKBOX_PAGE_SIZE;
+    blackbox_start(&bb, 500);
+    blackbox_frame_t frame;
+    for (uint32_t i = 0; bb.pages_written < sector_pages || spsc_ring_count(&bb.queue) < 2; i++) {
+        make_frame(i, &frame);
+        blackbox_log(&bb, &frame);
+        blackbox_flush(&bb, 1);
+    }
+
+    // The rest waits for the next prepare instead of erasing in flight
+    TEST_ASSERT_EQUAL_UINT32(sector_pages, bb.pages_written);
+    TEST_ASSERT_EQUAL_UINT32(1, flash.erases);
+    TEST_ASSERT_EQUAL_UINT32(0, blackbox_flush(&bb, BLACKBOX_PAGE_QUEUE));
+
+    uint32_t queued = spsc_ring_count(&bb.queue);
+    blackbox_prepare(&bb, BLACKBOX_SECTOR_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(queued, blackbox_flush(&bb, BLACKBOX_PAGE_QUEUE));
+    TEST_ASSERT_EQUAL_UINT32(0, flash.bad_programs);
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "unity.h"
+
+void test_blackbox_varint_round_trip(void);
+void test_blackbox_round_trip(void);
+void test_blackbox_decimation(void);
+void test_blackbox_dropped_pages_resync(void);
+void test_blackbox_appends_sessions(void);
+void test_blackbox_erases_only_when_prepared(void);
+void test_blackbox_flush_stops_at_prepared_space(void);
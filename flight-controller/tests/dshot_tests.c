@@ -0,0 +1,430 @@
+#include "dshot_tests.h"
+#include "drivers/dshot.h"
+#include <math.h>
+
+#ifdef HOST_BUILD
+#include "drivers/esc.h"
+#include "drivers/hal_linux.h"
+#include "drivers/pio_sim.h"
+#include "include/config.h"
+#include <stdlib.h>
+#endif
+
+void test_dshot_frame_crc(void) {
+    // 1046 without telemetry: 10000010110 0 0110
+    TEST_ASSERT_EQUAL_HEX16(0x82C6, dshot_frame(1046, false));
+    TEST_ASSERT_EQUAL_HEX16(0x82D7, dshot_frame(1046, true));
+    TEST_ASSERT_EQUAL_HEX16(0x0000, dshot_frame(DSHOT_CMD_MOTOR_STOP, false));
+
+    // The CRC is the XOR of the three nibbles above it
+    for (uint16_t value = 0; value <= DSHOT_THROTTLE_MAX; value++) {
+        uint16_t f = dshot_frame(value, value & 1);
+        TEST_ASSERT_EQUAL_UINT16(value, f >> 5);
+        TEST_ASSERT_EQUAL_HEX16(((f >> 4) ^ (f >> 8) ^ (f >> 12)) & 0xF, f & 0xF);
+    }
+}
+
+void test_dshot_throttle_values(void) {
+    TEST_ASSERT_EQUAL_UINT16(DSHOT_THROTTLE_MIN, dshot_throttle_value(-1.0f));
+    TEST_ASSERT_EQUAL_UINT16(DSHOT_THROTTLE_MIN, dshot_throttle_value(0.0f));
+    TEST_ASSERT_EQUAL_UINT16(1048, dshot_throttle_value(0.5f));
+    TEST_ASSERT_EQUAL_UINT16(DSHOT_THROTTLE_MAX, dshot_throttle_value(1.0f));
+    TEST_ASSERT_EQUAL_UINT16(DSHOT_THROTTLE_MAX, dshot_throttle_value(2.0f));
+
+    TEST_ASSERT_EQUAL_UINT16(DSHOT_THROTTLE_MIN, dshot_throttle_q15_value(-100));
+    TEST_ASSERT_EQUAL_UINT16(DSHOT_THROTTLE_MAX, dshot_throttle_q15_value(Q15_MAX));
+
+    // Fixed point within one step of float over the whole range
+    for (int32_t q = 0; q <= Q15_MAX; q += 7) {
+        int diff = (int)dshot_throttle_q15_value((q15_t)q) -
+                   (int)dshot_throttle_value((float)q / 32768.0f);
+        TEST_ASSERT_TRUE(diff >= -1 && diff <= 1);
+    }
+}
+
+void test_dshot_pack_interleaves_motors(void) {
+    const uint16_t frame[DSHOT_MOTORS] = { 0xFFFF, 0x0000, 0x8001, 0x00FF };
+    uint32_t words[DSHOT_PACKED_WORDS];
+    dshot_pack(frame, words);
+
+    // Bit 15 first: motors 1 and 3 high; then motor 1 alone until bit 7,
+    // where motor 4 joins; bit 0 has motors 1, 3 and 4
+    TEST_ASSERT_EQUAL_HEX32(0x51111111, words[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x9999999D, words[1]);
+
+    // Every bit of every motor lands in its group
+    const uint16_t mixed[DSHOT_MOTORS] = { 0x82C6, 0x1234, 0xBEEF, 0x0F0F };
+    dshot_pack(mixed, words);
+    for (int b = 15; b >= 0; b--) {
+        int slot = 15 - b;
+        uint32_t group = (words[slot / 8] >> (28 - 4 * (slot % 8))) & 0xF;
+        for (int m = 0; m < DSHOT_MOTORS; m++) {
+            TEST_ASSERT_EQUAL_UINT32((mixed[m] >> b) & 1u, (group >> m) & 1u);
+        }
+    }
+}
+
+void test_dshot_clock_div(void) {
+    // 250 MHz system clock
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 52.083f, dshot_pio_clock_div(250000000u, DSHOT600_BIT_RATE));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 104.167f, dshot_pio_clock_div(250000000u, DSHOT300_BIT_RATE));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 208.333f, dshot_pio_clock_div(250000000u, DSHOT150_BIT_RATE));
+}
+
+void test_dshot_bidir_frame_crc(void) {
+    // The CRC inverted, the rest as dshot_frame()
+    TEST_ASSERT_EQUAL_HEX16(0x82C9, dshot_bidir_frame(1046, false));
+    for (uint16_t value = 0; value <= DSHOT_THROTTLE_MAX; value++) {
+        uint16_t f = dshot_bidir_frame(value, false);
+        TEST_ASSERT_EQUAL_HEX16(dshot_frame(value, false) & 0xFFF0, f & 0xFFF0);
+        TEST_ASSERT_EQUAL_HEX16(~((f >> 4) ^ (f >> 8) ^ (f >> 12)) & 0xF, f & 0xF);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 26.042f, dshot_bidir_pio_clock_div(250000000u, DSHOT600_BIT_RATE));
+}
+
+void test_dshot_gcr_round_trip(void) {
+    // Every value survives the ESC's coding, after a low start bit
+    for (uint16_t value = 0; value <= 0xFFF; value++) {
+        uint32_t levels = dshot_gcr_encode(value);
+        uint16_t decoded = 0;
+        TEST_ASSERT_EQUAL_UINT32(0, levels >> (DSHOT_TELEMETRY_BITS - 1));
+        TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_OK, dshot_gcr_decode(levels, &decoded));
+        TEST_ASSERT_EQUAL_HEX16(value, decoded);
+    }
+
+    // A stopped motor, and the eRPM to within the 9-bit period's resolution
+    TEST_ASSERT_EQUAL_HEX16(0xFFF, dshot_erpm_value(0));
+    TEST_ASSERT_EQUAL_UINT32(0, dshot_erpm(0xFFF));
+    for (uint32_t erpm = 1000; erpm <= 200000; erpm += 997) {
+        uint32_t back = dshot_erpm(dshot_erpm_value(erpm));
+        TEST_ASSERT_UINT32_WITHIN(erpm / 200 + 1, erpm, back);
+    }
+}
+
+void test_dshot_gcr_detects_corruption(void) {
+    const uint16_t values[] = { 0x000, 0x7A0, 0x2B3, 0xFFF, 0x555 };
+    for (int v = 0; v < (int)(sizeof(values) / sizeof(values[0])); v++) {
+        uint32_t levels = dshot_gcr_encode(values[v]);
+
+        // A missed or extra edge anywhere flips one GCR bit: an invalid code,
+        // or a nibble the CRC no longer matches
+        for (int bit = 0; bit < DSHOT_TELEMETRY_BITS - 1; bit++) {
+            uint16_t decoded = 0;
+            uint32_t bad = levels ^ ((2u << bit) - 1u);
+            TEST_ASSERT_TRUE(dshot_gcr_decode(bad, &decoded) != DSHOT_TELEMETRY_OK);
+        }
+    }
+    uint16_t decoded;
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_BAD_CODE, dshot_gcr_decode(0, &decoded));
+}
+
+// Synthetic captures, not taken from hardware: runs of samples from the
+// first, alternately high (idle first) and low. Each is dshot_gcr_encode()
+// of a value sampled at 3.2 samples per bit, or 3.36 for an ESC running
+// 5 % slow, and every edge then left where it falls or moved one sample
+// earlier, so bits come out 3 or 4 samples wide as the sample clock slips
+// against the ESC's. 0x7A0 (18029 eRPM) starts at sample 38, 0x565
+// (42017 eRPM) slow at sample 53.
+static const uint8_t synthetic_reply[] = { 38, 3, 6, 3, 4, 6, 7, 6, 3, 10, 3, 9, 22 };
+static const uint8_t synthetic_slow_reply[] = { 53, 4, 6, 7, 3, 7, 3, 7, 7, 6, 7, 10, 40 };
+
+static void fill_capture(uint32_t capture[DSHOT_TELEMETRY_WORDS], int motor,
+                         const uint8_t* runs, int count) {
+    int sample = 0;
+    for (int r = 0; r < count; r++) {
+        for (int i = 0; i < runs[r] && sample < DSHOT_TELEMETRY_SAMPLES; i++, sample++) {
+            if (r & 1) capture[sample >> 3] &= ~(1u << (28 - 4 * (sample & 7) + motor));
+        }
+    }
+}
+
+void test_dshot_telemetry_decodes_capture(void) {
+    uint32_t capture[DSHOT_TELEMETRY_WORDS];
+    uint32_t levels = 0;
+    uint32_t erpm = 0;
+    for (int w = 0; w < DSHOT_TELEMETRY_WORDS; w++) capture[w] = 0xFFFFFFFFu;
+
+    // Motors 1 and 2 the synthetic replies; motor 3 silent; motor 4 cut short
+    const uint8_t short_reply[] = { 40, 3, 6, 3, 4, 6, 7 };
+    fill_capture(capture, 0, synthetic_reply, sizeof(synthetic_reply));
+    fill_capture(capture, 1, synthetic_slow_reply, sizeof(synthetic_slow_reply));
+    fill_capture(capture, 3, short_reply, sizeof(short_reply) - 1);
+
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_OK, dshot_capture_levels(capture, 0, &levels));
+    TEST_ASSERT_EQUAL_HEX32(dshot_gcr_encode(0x7A0), levels);
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_OK, dshot_telemetry_decode(capture, 0, &erpm));
+    TEST_ASSERT_EQUAL_UINT32(18029, erpm);
+
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_OK, dshot_capture_levels(capture, 1, &levels));
+    TEST_ASSERT_EQUAL_HEX32(dshot_gcr_encode(0x565), levels);
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_OK, dshot_telemetry_decode(capture, 1, &erpm));
+    TEST_ASSERT_EQUAL_UINT32(42017, erpm);
+
+    // Failures leave the eRPM alone
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_NO_REPLY, dshot_telemetry_decode(capture, 2, &erpm));
+    TEST_ASSERT_TRUE(dshot_telemetry_decode(capture, 3, &erpm) != DSHOT_TELEMETRY_OK);
+    TEST_ASSERT_EQUAL_UINT32(42017, erpm);
+
+    // A level held longer than GCR allows
+    const uint8_t stuck[] = { 38, 3, 6, 3, 20, 6, 7, 6, 3, 10, 3, 9, 22 };
+    fill_capture(capture, 2, stuck, sizeof(stuck));
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_BAD_CODE, dshot_telemetry_decode(capture, 2, &erpm));
+}
+
+#ifdef HOST_BUILD
+#define MAX_CLOCKS 1024
+
+// Runs the DShot program on the model until it stalls, recording the pins
+// after every clock. Returns the clocks run.
+static int run_program(const uint32_t* words, int count, uint8_t* pins) {
+    pio_sim_t sm;
+    int clocks = 0;
+    pio_sim_init(&sm, dshot_pio_program, DSHOT_PIO_PROGRAM_LENGTH, DSHOT_PIO_WRAP_TARGET,
+                 DSHOT_PIO_WRAP, DSHOT_MOTORS);
+    for (int i = 0; i < count; i++) TEST_ASSERT_TRUE(pio_sim_put(&sm, words[i]));
+    while (clocks < MAX_CLOCKS) {
+        pio_sim_result_t r = pio_sim_step(&sm);
+        TEST_ASSERT_TRUE(r != PIO_SIM_UNSUPPORTED);
+        if (r == PIO_SIM_STALLED) break;
+        pins[clocks++] = (uint8_t)sm.pins;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, sm.pins);
+    return clocks;
+}
+
+// Checks that motor m's bits start every DSHOT_PIO_TICKS_PER_BIT clocks
+// from first_rise, each high for the T0H or T1H of its frame bit
+static void check_bits(const uint8_t* pins, int clocks, int m, int first_rise,
+                       const uint16_t* frames, int frame_count) {
+    int bit = 0;
+    for (int t = 0; t < clocks; t++) {
+        bool level = (pins[t] >> m) & 1u;
+        bool before = t > 0 && ((pins[t - 1] >> m) & 1u);
+        if (!level || before) continue;
+
+        TEST_ASSERT_TRUE(bit < 16 * frame_count);
+        TEST_ASSERT_EQUAL_INT(first_rise + bit * DSHOT_PIO_TICKS_PER_BIT, t);
+        int high = 0;
+        while (t + high < clocks && ((pins[t + high] >> m) & 1u)) high++;
+        bool one = (frames[bit / 16] >> (15 - bit % 16)) & 1u;
+        TEST_ASSERT_EQUAL_INT(one ? DSHOT_PIO_T1H_TICKS : DSHOT_PIO_T0H_TICKS, high);
+        bit++;
+    }
+    TEST_ASSERT_EQUAL_INT(16 * frame_count, bit);
+}
+
+void test_dshot_pio_bit_timing(void) {
+    const uint16_t frame[DSHOT_MOTORS] = { dshot_frame(1046, false), dshot_frame(48, false),
+                                           dshot_frame(2047, true), 0xFFFF };
+    uint32_t words[DSHOT_PACKED_WORDS];
+    uint8_t pins[MAX_CLOCKS];
+    dshot_pack(frame, words);
+
+    // 16 bits from the first pull; the stall is in the next one
+    int clocks = run_program(words, DSHOT_PACKED_WORDS, pins);
+    TEST_ASSERT_EQUAL_INT(16 * DSHOT_PIO_TICKS_PER_BIT, clocks);
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        const uint16_t one[1] = { frame[m] };
+        check_bits(pins, clocks, m, 1, one, 1);
+    }
+
+    // In time: DShot600 wants a 1.67 us bit, high for 0.625 us (0) or
+    // 1.25 us (1), +/- a few percent
+    float clock_us = dshot_pio_clock_div(250000000u, DSHOT600_BIT_RATE) / 250.0f;
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.667f, clock_us * DSHOT_PIO_TICKS_PER_BIT);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.625f, clock_us * DSHOT_PIO_T0H_TICKS);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.25f, clock_us * DSHOT_PIO_T1H_TICKS);
+}
+
+void test_dshot_pio_frames_back_to_back(void) {
+    const uint16_t first[DSHOT_MOTORS] = { 0x82C6, 0x1234, 0xBEEF, 0x0000 };
+    const uint16_t second[DSHOT_MOTORS] = { 0x0001, 0xFFFF, 0x5555, 0xAAAA };
+    uint32_t words[2 * DSHOT_PACKED_WORDS];
+    uint8_t pins[MAX_CLOCKS];
+    dshot_pack(first, words);
+    dshot_pack(second, words + DSHOT_PACKED_WORDS);
+
+    // A full FIFO keeps the bit clock going across the frame boundary
+    int clocks = run_program(words, 2 * DSHOT_PACKED_WORDS, pins);
+    TEST_ASSERT_EQUAL_INT(32 * DSHOT_PIO_TICKS_PER_BIT, clocks);
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        const uint16_t frames[2] = { first[m], second[m] };
+        check_bits(pins, clocks, m, 1, frames, 2);
+    }
+}
+
+void test_dshot_esc_output(void) {
+    esc_config_t config = DEFAULT_ESC_CONFIG;
+    config.protocol = ESC_PROTOCOL_DSHOT600;
+    config.bidirectional = false;
+    hal_linux_set_virtual_time(true);
+
+    // The state machine needs consecutive pins
+    config.motor4_pin = PIN_MOTOR1 + 7;
+    TEST_ASSERT_NULL(esc_init(&config));
+    config.motor4_pin = PIN_MOTOR4;
+
+    esc_controller_t* esc = esc_init(&config);
+    TEST_ASSERT_NOT_NULL(esc);
+
+    // Nothing to calibrate, and nothing sent until armed
+    uint64_t start = hal_time_us();
+    esc_calibrate(esc);
+    TEST_ASSERT_EQUAL_UINT64(start, hal_time_us());
+    esc_set_output(esc, 0.5f, 0.5f, 0.5f, 0.5f);
+    TEST_ASSERT_EQUAL_UINT32(0, hal_linux_dshot_sends());
+
+    // Arming streams stop frames at 1 kHz for a second
+    esc_arm(esc);
+    TEST_ASSERT_EQUAL_UINT32(1000, hal_linux_dshot_sends());
+    TEST_ASSERT_EQUAL_UINT64(start + 1000000u, hal_time_us());
+    TEST_ASSERT_EQUAL_HEX16(0, hal_linux_dshot_frame(PIN_MOTOR1));
+
+    // The frames sent, as the host HAL unpacks them
+    esc_set_output(esc, 0.0f, 0.5f, 1.0f, 2.0f);
+    TEST_ASSERT_EQUAL_HEX16(dshot_frame(DSHOT_THROTTLE_MIN, false), hal_linux_dshot_frame(PIN_MOTOR1));
+    TEST_ASSERT_EQUAL_HEX16(dshot_frame(1048, false), hal_linux_dshot_frame(PIN_MOTOR2));
+    TEST_ASSERT_EQUAL_HEX16(dshot_frame(DSHOT_THROTTLE_MAX, false), hal_linux_dshot_frame(PIN_MOTOR3));
+    TEST_ASSERT_EQUAL_HEX16(dshot_frame(DSHOT_THROTTLE_MAX, false), hal_linux_dshot_frame(PIN_MOTOR4));
+
+    const q15_t motor[4] = { 0, 16384, Q15_MAX, -5 };
+    esc_set_output_q15(esc, motor);
+    TEST_ASSERT_EQUAL_HEX16(dshot_frame(1048, false), hal_linux_dshot_frame(PIN_MOTOR2));
+    TEST_ASSERT_EQUAL_HEX16(dshot_frame(DSHOT_THROTTLE_MIN, false), hal_linux_dshot_frame(PIN_MOTOR4));
+
+    esc_emergency_stop(esc);
+    TEST_ASSERT_EQUAL_HEX16(0, hal_linux_dshot_frame(PIN_MOTOR3));
+    free(esc);
+}
+
+// Runs the bidirectional program for one send, with the ESCs holding
+// inputs on the released pins. Records the pins and the pin directions
+// after every clock; returns the clocks run.
+static int run_bidir(const uint32_t* words, uint32_t inputs, uint8_t* pins, uint8_t* dirs,
+                     uint32_t* capture) {
+    pio_sim_t sm;
+    int clocks = 0;
+    int captured = 0;
+    pio_sim_init(&sm, dshot_bidir_pio_program, DSHOT_BIDIR_PIO_PROGRAM_LENGTH,
+                 DSHOT_BIDIR_PIO_WRAP_TARGET, DSHOT_BIDIR_PIO_WRAP, DSHOT_MOTORS);
+    pio_sim_set_in_shift(&sm, false, true, 32);
+    sm.pins = 0xFu;
+    sm.inputs = inputs;
+    for (int i = 0; i < DSHOT_BIDIR_WORDS; i++) TEST_ASSERT_TRUE(pio_sim_put(&sm, words[i]));
+    while (clocks < 2 * MAX_CLOCKS) {
+        pio_sim_result_t r = pio_sim_step(&sm);
+        TEST_ASSERT_TRUE(r != PIO_SIM_UNSUPPORTED);
+        if (r == PIO_SIM_STALLED) break;
+        pins[clocks] = (uint8_t)pio_sim_pin_levels(&sm);
+        dirs[clocks++] = (uint8_t)sm.pindirs;
+        while (captured < DSHOT_TELEMETRY_WORDS && pio_sim_get(&sm, &capture[captured])) captured++;
+    }
+    TEST_ASSERT_EQUAL_INT(DSHOT_TELEMETRY_WORDS, captured);
+    TEST_ASSERT_EQUAL_UINT32(0xF, sm.pins);
+    TEST_ASSERT_EQUAL_UINT32(0xF, sm.pindirs);
+    return clocks;
+}
+
+void test_dshot_bidir_pio_timing(void) {
+    static uint8_t pins[2 * MAX_CLOCKS], dirs[2 * MAX_CLOCKS];
+    uint32_t capture[DSHOT_TELEMETRY_WORDS];
+    const uint16_t frame[DSHOT_MOTORS] = { dshot_bidir_frame(1046, false), dshot_bidir_frame(48, false),
+                                           0xFFFF, 0x0000 };
+    uint32_t words[DSHOT_BIDIR_WORDS];
+    dshot_pack(frame, words);
+    words[DSHOT_PACKED_WORDS] = DSHOT_TELEMETRY_SAMPLES - 1;
+
+    // The frame, then the capture with the pins released
+    int clocks = run_bidir(words, 0xAu, pins, dirs, capture);
+    const int frame_clocks = 16 * DSHOT_BIDIR_PIO_TICKS_PER_BIT;
+    TEST_ASSERT_TRUE(clocks > frame_clocks + DSHOT_TELEMETRY_SAMPLES * DSHOT_TELEMETRY_SAMPLE_TICKS);
+
+    // Every bit a low pulse from its start, of T0L or T1L clocks, the first
+    // after the bit count is set and the first bits pulled; the line idles
+    // high
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        int bit = 0;
+        for (int t = 0; t < frame_clocks + 2; t++) {
+            bool low = !((pins[t] >> m) & 1u);
+            bool before = t > 0 && !((pins[t - 1] >> m) & 1u);
+            if (!low || before) continue;
+            TEST_ASSERT_EQUAL_INT(2 + bit * DSHOT_BIDIR_PIO_TICKS_PER_BIT, t);
+            int width = 0;
+            while (!((pins[t + width] >> m) & 1u)) width++;
+            bool one = (frame[m] >> (15 - bit)) & 1u;
+            TEST_ASSERT_EQUAL_INT(one ? DSHOT_BIDIR_PIO_T1L_TICKS : DSHOT_BIDIR_PIO_T0L_TICKS, width);
+            bit++;
+        }
+        TEST_ASSERT_EQUAL_INT(16, bit);
+    }
+
+    // Released after the last bit for the whole capture, every sample the
+    // ESCs' levels
+    int released = 0;
+    for (int t = 0; t < clocks; t++) {
+        if (dirs[t] == 0) released++;
+    }
+    TEST_ASSERT_TRUE(released >= DSHOT_TELEMETRY_SAMPLES * DSHOT_TELEMETRY_SAMPLE_TICKS);
+    for (int w = 0; w < DSHOT_TELEMETRY_WORDS; w++) TEST_ASSERT_EQUAL_HEX32(0xAAAAAAAAu, capture[w]);
+
+    // In time: a DShot600 bit of 1.67 us at twice the clock of the
+    // unidirectional program
+    float clock_us = dshot_bidir_pio_clock_div(250000000u, DSHOT600_BIT_RATE) / 250.0f;
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.667f, clock_us * DSHOT_BIDIR_PIO_TICKS_PER_BIT);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.625f, clock_us * DSHOT_BIDIR_PIO_T0L_TICKS);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.25f, clock_us * DSHOT_BIDIR_PIO_T1L_TICKS);
+}
+
+void test_dshot_esc_telemetry(void) {
+    esc_config_t config = DEFAULT_ESC_CONFIG;
+    config.protocol = ESC_PROTOCOL_DSHOT600;
+    config.bidirectional = false;
+    hal_linux_set_virtual_time(true);
+    uint32_t erpm[4] = { 1, 2, 3, 4 };
+
+    // No telemetry unidirectional
+    esc_controller_t* esc = esc_init(&config);
+    TEST_ASSERT_NOT_NULL(esc);
+    TEST_ASSERT_FALSE(esc_get_erpm(esc, erpm));
+    TEST_ASSERT_EQUAL_UINT32(1, erpm[0]);
+    free(esc);
+
+    config.bidirectional = true;
+    esc = esc_init(&config);
+    TEST_ASSERT_NOT_NULL(esc);
+    TEST_ASSERT_TRUE(esc_get_erpm(esc, erpm));
+    TEST_ASSERT_EQUAL_UINT32(0, erpm[0]);
+
+    // Frames with the inverted CRC; each output decodes the replies to the
+    // one before
+    esc_arm(esc);
+    TEST_ASSERT_EQUAL_UINT32(0, esc_telemetry_errors(esc));
+    hal_linux_dshot_set_erpm(PIN_MOTOR1, 18000);
+    hal_linux_dshot_set_erpm(PIN_MOTOR2, 30000);
+    hal_linux_dshot_set_erpm(PIN_MOTOR3, 45000);
+    hal_linux_dshot_set_erpm(PIN_MOTOR4, 60000);
+    esc_set_output(esc, 0.5f, 0.5f, 0.5f, 0.5f);
+    TEST_ASSERT_EQUAL_HEX16(dshot_bidir_frame(1048, false), hal_linux_dshot_frame(PIN_MOTOR2));
+    esc_get_erpm(esc, erpm);
+    TEST_ASSERT_EQUAL_UINT32(0, erpm[0]);
+    esc_set_output(esc, 0.5f, 0.5f, 0.5f, 0.5f);
+    esc_get_erpm(esc, erpm);
+    TEST_ASSERT_UINT32_WITHIN(100, 18000, erpm[0]);
+    TEST_ASSERT_UINT32_WITHIN(150, 30000, erpm[1]);
+    TEST_ASSERT_UINT32_WITHIN(225, 45000, erpm[2]);
+    TEST_ASSERT_UINT32_WITHIN(300, 60000, erpm[3]);
+    TEST_ASSERT_EQUAL_UINT32(0, esc_telemetry_errors(esc));
+
+    // A silent ESC and a corrupt reply: errors, and the last eRPM kept
+    hal_linux_dshot_set_reply(PIN_MOTOR3, false, 0);
+    hal_linux_dshot_set_reply(PIN_MOTOR4, true, dshot_gcr_encode(0x7A0) ^ 0x3u);
+    esc_set_output(esc, 0.5f, 0.5f, 0.5f, 0.5f);
+    esc_set_output(esc, 0.5f, 0.5f, 0.5f, 0.5f);
+    TEST_ASSERT_EQUAL_UINT32(2, esc_telemetry_errors(esc));
+    esc_get_erpm(esc, erpm);
+    TEST_ASSERT_UINT32_WITHIN(100, 18000, erpm[0]);
+    TEST_ASSERT_UINT32_WITHIN(225, 45000, erpm[2]);
+    TEST_ASSERT_UINT32_WITHIN(300, 60000, erpm[3]);
+    free(esc);
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+#include "unity.h"
+
+void test_dshot_frame_crc(void);
+void test_dshot_throttle_values(void);
+void test_dshot_pack_interleaves_motors(void);
+void test_dshot_clock_div(void);
+void test_dshot_bidir_frame_crc(void);
+void test_dshot_gcr_round_trip(void);
+void test_dshot_gcr_detects_corruption(void);
+void test_dshot_telemetry_decodes_capture(void);
+
+#ifdef HOST_BUILD
+void test_dshot_pio_bit_timing(void);
+void test_dshot_pio_frames_back_to_back(void);
+void test_dshot_esc_output(void);
+void test_dshot_bidir_pio_timing(void);
+void test_dshot_esc_telemetry(void);
+#endif
@@ -0,0 +1,164 @@
+#include "dyn_notch_tests.h"
+#include "core/dyn_notch.h"
+#include "notch_test_signals.h"
+#include <math.h>
+
+#define BIN_HZ    (SAMPLE_HZ / DYN_NOTCH_FFT_SIZE)
+#define MIN_HZ    60.0f
+#define MAX_HZ    400.0f
+#define NOTCH_Q   3.0f
+
+// Enough samples to fill the window and analyse every axis a few times
+#define SETTLE_SAMPLES (DYN_NOTCH_FFT_SIZE + 12 * 3 * DYN_NOTCH_STEPS_PER_AXIS)
+
+static dyn_notch_t dn;
+
+// xorshift32, uniform in [-amplitude, amplitude]
+static float noise(uint32_t* state, float amplitude) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return amplitude * ((float)(x >> 8) / 8388608.0f - 1.0f);
+}
+
+// Tone of amplitude a at hz on the roll axis, with a little sensor noise on
+// all three
+static void run_tone(int samples, float hz, float a, uint32_t* state) {
+    for (int i = 0; i < samples; i++) {
+        vector3_t g = {
+            a * sinf(TWO_PI_F * hz * (float)i * SAMPLE_DT) + noise(state, 0.2f),
+            noise(state, 0.2f),
+            noise(state, 0.2f)
+        };
+        dyn_notch_update(&dn, &g, SAMPLE_DT);
+    }
+}
+
+static int active_notches(int axis) {
+    return count_nonzero(dn.peak_hz[axis], DYN_NOTCH_PEAKS, sizeof(dn.peak_hz[axis][0]));
+}
+
+// The tracked frequency nearest hz
+static float tracked_near(int axis, float hz) {
+    float best = 0.0f;
+    for (int p = 0; p < DYN_NOTCH_PEAKS; p++) {
+        float f = dn.peak_hz[axis][p];
+        if (f > 0.0f && fabsf(f - hz) < fabsf(best - hz)) best = f;
+    }
+    return best;
+}
+
+void test_dyn_notch_finds_tone(void) {
+    uint32_t state = 1u;
+    dyn_notch_init(&dn, MIN_HZ, MAX_HZ, NOTCH_Q);
+    run_tone(SETTLE_SAMPLES, 150.0f, 40.0f, &state);
+
+    TEST_ASSERT_EQUAL_INT(1, active_notches(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f * BIN_HZ, 150.0f, tracked_near(0, 150.0f));
+    TEST_ASSERT_EQUAL_INT(0, active_notches(1));
+    TEST_ASSERT_EQUAL_INT(0, active_notches(2));
+}
+
+void test_dyn_notch_finds_two_tones(void) {
+    uint32_t state = 2u;
+    dyn_notch_init(&dn, MIN_HZ, MAX_HZ, NOTCH_Q);
+    for (int i = 0; i < SETTLE_SAMPLES; i++) {
+        float t = (float)i * SAMPLE_DT;
+        vector3_t g = {
+            noise(&state, 0.2f),
+            30.0f * sinf(TWO_PI_F * 115.0f * t) + 10.0f * sinf(TWO_PI_F * 262.0f * t),
+            noise(&state, 0.2f)
+        };
+        dyn_notch_update(&dn, &g, SAMPLE_DT);
+    }
+
+    TEST_ASSERT_EQUAL_INT(2, active_notches(1));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f * BIN_HZ, 115.0f, tracked_near(1, 115.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f * BIN_HZ, 262.0f, tracked_near(1, 262.0f));
+    TEST_ASSERT_EQUAL_INT(0, active_notches(0));
+}
+
+void test_dyn_notch_tracks_moving_tone(void) {
+    uint32_t state = 3u;
+    float phase = 0.0f;
+    float hz = 0.0f;
+
+    // Motor noise sweeping up as the throttle rises, 100 Hz per second
+    dyn_notch_init(&dn, MIN_HZ, MAX_HZ, NOTCH_Q);
+    for (int i = 0; i < 2000; i++) {
+        hz = 120.0f + 100.0f * (float)i * SAMPLE_DT;
+        phase += TWO_PI_F * hz * SAMPLE_DT;
+        if (phase > TWO_PI_F) phase -= TWO_PI_F;
+        vector3_t g = { noise(&state, 0.2f), noise(&state, 0.2f), 40.0f * sinf(phase) };
+        dyn_notch_update(&dn, &g, SAMPLE_DT);
+
+        // Once locked, the notch never falls more than a bin behind
+        if (i >= SETTLE_SAMPLES) {
+            TEST_ASSERT_FLOAT_WITHIN(BIN_HZ, hz, tracked_near(2, hz));
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(1, active_notches(2));
+}
+
+void test_dyn_notch_attenuates_tone_passes_motion(void) {
+    static float in[1000], out[1000];
+    uint32_t state = 4u;
+    dyn_notch_init(&dn, MIN_HZ, MAX_HZ, NOTCH_Q);
+    run_tone(SETTLE_SAMPLES, 150.0f, 40.0f, &state);
+
+    // 150 Hz noise on a 10 Hz manoeuvre, both whole periods in the record
+    for (int i = 0; i < 1000; i++) {
+        float t = (float)(SETTLE_SAMPLES + i) * SAMPLE_DT;
+        in[i] = 40.0f * sinf(TWO_PI_F * 150.0f * t) + 20.0f * sinf(TWO_PI_F * 10.0f * t);
+        vector3_t g = { in[i], 0.0f, 0.0f };
+        dyn_notch_update(&dn, &g, SAMPLE_DT);
+        out[i] = g.x;
+    }
+
+    // At least 20 dB off the tone, and the manoeuvre within 5 %
+    TEST_ASSERT_TRUE(tone_amplitude(out, 1000, 150.0f) < 0.1f * tone_amplitude(in, 1000, 150.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 20.0f, tone_amplitude(out, 1000, 10.0f));
+}
+
+void test_dyn_notch_ignores_white_noise(void) {
+    uint32_t state = 5u;
+    dyn_notch_init(&dn, MIN_HZ, MAX_HZ, NOTCH_Q);
+    for (int i = 0; i < 5000; i++) {
+        vector3_t g = { noise(&state, 30.0f), noise(&state, 30.0f), noise(&state, 30.0f) };
+        dyn_notch_update(&dn, &g, SAMPLE_DT);
+    }
+    TEST_ASSERT_EQUAL_INT(0, active_notches(0));
+    TEST_ASSERT_EQUAL_INT(0, active_notches(1));
+    TEST_ASSERT_EQUAL_INT(0, active_notches(2));
+}
+
+void test_dyn_notch_step_cost_within_budget(void) {
+    uint32_t state = 6u;
+    uint32_t max_cost = 0;
+    const int spectra = 30;
+
+    dyn_notch_init(&dn, MIN_HZ, MAX_HZ, NOTCH_Q);
+    for (int i = 0; i < DYN_NOTCH_FFT_SIZE + spectra * DYN_NOTCH_STEPS_PER_AXIS; i++) {
+        vector3_t g = {
+            40.0f * sinf(TWO_PI_F * 150.0f * (float)i * SAMPLE_DT),
+            noise(&state, 30.0f),
+            noise(&state, 0.2f)
+        };
+        dyn_notch_update(&dn, &g, SAMPLE_DT);
+        if (i < DYN_NOTCH_FFT_SIZE) TEST_ASSERT_EQUAL_UINT32(0, dn.step_cost);
+        if (dn.step_cost > max_cost) max_cost = dn.step_cost;
+    }
+
+    // One transform every DYN_NOTCH_STEPS_PER_AXIS samples, none over budget
+    TEST_ASSERT_EQUAL_UINT32(spectra, dn.spectra);
+    TEST_ASSERT_TRUE(max_cost > 0);
+    TEST_ASSERT_TRUE(max_cost <= DYN_NOTCH_STEP_BUDGET);
+
+    // A new sample rate starts over
+    vector3_t g = { 0.0f, 0.0f, 0.0f };
+    dyn_notch_update(&dn, &g, 2.0f * SAMPLE_DT);
+    TEST_ASSERT_EQUAL_INT(0, active_notches(0));
+    TEST_ASSERT_EQUAL_UINT32(0, dn.step_cost);
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "unity.h"
+
+void test_dyn_notch_finds_tone(void);
+void test_dyn_notch_finds_two_tones(void);
+void test_dyn_notch_tracks_moving_tone(void);
+void test_dyn_notch_attenuates_tone_passes_motion(void);
+void test_dyn_notch_ignores_white_noise(void);
+void test_dyn_notch_step_cost_within_budget(void);
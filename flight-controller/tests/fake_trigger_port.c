@@ -0,0 +1,42 @@
+#include "fake_trigger_port.h"
+
+static uint64_t fake_now_us(void* ctx) {
+    fake_trigger_port_t* fake = ctx;
+    return fake->now_us;
+}
+
+static void fake_wait_until(void* ctx, uint64_t deadline_us) {
+    fake_trigger_port_t* fake = ctx;
+    fake->waits++;
+
+    if (fake->irq_next < fake->irq_total && fake->irq_times[fake->irq_next] <= deadline_us) {
+        uint64_t t = fake->irq_times[fake->irq_next++];
+        if (t > fake->now_us) fake->now_us = t;
+        loop_trigger_signal(fake->trigger, t);
+        return;
+    }
+
+    if (deadline_us > fake->now_us) fake->now_us = deadline_us;
+}
+
+void fake_trigger_port_init(fake_trigger_port_t* fake, loop_trigger_t* trigger, uint32_t period_us) {
+    fake->now_us = 0;
+    fake->irq_times = NULL;
+    fake->irq_total = 0;
+    fake->irq_next = 0;
+    fake->trigger = trigger;
+    fake->waits = 0;
+
+    const loop_trigger_port_t port = {
+        .now_us = fake_now_us,
+        .wait_until = fake_wait_until,
+        .ctx = fake
+    };
+    loop_trigger_init(trigger, &port, period_us);
+}
+
+void fake_trigger_port_set_irqs(fake_trigger_port_t* fake, const uint64_t* times, size_t count) {
+    fake->irq_times = times;
+    fake->irq_total = count;
+    fake->irq_next = 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "../src/core/loop_trigger.h"
+#include <stddef.h>
+
+// Test double for the data-ready interrupt: a fake clock plus a script of
+// interrupt timestamps that fire while the trigger is waiting
+typedef struct {
+    uint64_t now_us;
+    const uint64_t* irq_times;
+    size_t irq_total;
+    size_t irq_next;
+    loop_trigger_t* trigger;
+    uint32_t waits;
+} fake_trigger_port_t;
+
+void fake_trigger_port_init(fake_trigger_port_t* fake, loop_trigger_t* trigger, uint32_t period_us);
+void fake_trigger_port_set_irqs(fake_trigger_port_t* fake, const uint64_t* times, size_t count);
@@ -0,0 +1,113 @@
+#include "fast_math_tests.h"
+#include "core/attitude_estimator.h"
+#include "math/fast_math.h"
+#include <math.h>
+
+// Grids through each domain. fast_math_check on the host tries every float;
+// these run on the target as well, against its own libm.
+#define GRID_POINTS 4001
+#define LIBM_SLACK  1e-6f       // libm's own float error, with room to spare
+
+#define PI_F     3.14159265f
+#define TWO_PI_F 6.28318531f
+
+void test_fast_math_inv_sqrt(void) {
+    TEST_ASSERT_FLOAT_WITHIN(FAST_INV_SQRTF_MAX_REL_ERROR, 1.0f, fast_inv_sqrtf(1.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f * FAST_INV_SQRTF_MAX_REL_ERROR, 0.5f, fast_inv_sqrtf(4.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e15f * FAST_INV_SQRTF_MAX_REL_ERROR, 1e15f, fast_inv_sqrtf(1e-30f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-15f * FAST_INV_SQRTF_MAX_REL_ERROR, 1e-15f, fast_inv_sqrtf(1e30f));
+
+    for (int i = 0; i < GRID_POINTS; i++) {
+        float x = 0.25f + 4.0f * (float)i / (float)GRID_POINTS;
+        float expected = 1.0f / sqrtf(x);
+        float tolerance = expected * (FAST_INV_SQRTF_MAX_REL_ERROR + LIBM_SLACK);
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, expected, fast_inv_sqrtf(x));
+    }
+}
+
+void test_fast_math_atan2_quadrants(void) {
+    static const float points[][2] = {
+        { 0.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, -1.0f }, { -1.0f, 0.0f },
+        { 1.0f, 1.0f }, { -1.0f, 1.0f }, { 1.0f, -1.0f }, { -1.0f, -1.0f },
+        { 3.0f, -4.0f }, { -4.0f, 3.0f }, { 1e-20f, 1e20f }, { -1e20f, 1e-20f }
+    };
+    const float tolerance = FAST_ATAN2F_MAX_ERROR + LIBM_SLACK;
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fast_atan2f(0.0f, 0.0f));
+    for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++) {
+        float y = points[i][0], x = points[i][1];
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, atan2f(y, x), fast_atan2f(y, x));
+    }
+
+    // Around the circle, at two radii; stop short of the cut at +-pi
+    for (int i = 1; i < GRID_POINTS; i++) {
+        float angle = -PI_F + TWO_PI_F * (float)i / (float)GRID_POINTS;
+        float y = sinf(angle), x = cosf(angle);
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, atan2f(y, x), fast_atan2f(y, x));
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, atan2f(y, x), fast_atan2f(250.0f * y, 250.0f * x));
+    }
+}
+
+void test_fast_math_asin(void) {
+    const float tolerance = FAST_ASINF_MAX_ERROR + LIBM_SLACK;
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fast_asinf(0.0f));
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, 1.57079633f, fast_asinf(1.0f));
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, -1.57079633f, fast_asinf(-1.0f));
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, 1.57079633f, fast_asinf(1.0001f));     // Clamped
+
+    for (int i = 0; i <= GRID_POINTS; i++) {
+        float x = -1.0f + 2.0f * (float)i / (float)GRID_POINTS;
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, asinf(x), fast_asinf(x));
+    }
+}
+
+void test_fast_math_sin_cos(void) {
+    const float tolerance = FAST_SINF_MAX_ERROR + LIBM_SLACK;
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fast_sinf(0.0f));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, fast_cosf(0.0f));
+    for (int i = 0; i <= GRID_POINTS; i++) {
+        float x = -TWO_PI_F + 2.0f * TWO_PI_F * (float)i / (float)GRID_POINTS;
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, sinf(x), fast_sinf(x));
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, cosf(x), fast_cosf(x));
+    }
+}
+
+// Whichever math the build uses (FC_FAST_MATH), the Euler angles stay
+// within a thousandth of a degree of a double-precision conversion
+void test_fast_math_attitude_within_bounds(void) {
+    uint32_t state = 3;
+    for (int i = 0; i < 2000; i++) {
+        double c[4], norm = 0.0;
+        for (int k = 0; k < 4; k++) {
+            state = state * 1664525u + 1013904223u;
+            c[k] = (double)(state >> 8) / 8388608.0 - 1.0;
+            norm += c[k] * c[k];
+        }
+        norm = sqrt(norm);
+        if (norm < 0.1) continue;
+        for (int k = 0; k < 4; k++) c[k] /= norm;
+
+        // Stay clear of gimbal lock, where roll and yaw are not defined
+        double sinp = 2.0 * (c[0] * c[2] - c[3] * c[1]);
+        if (fabs(sinp) > 0.99) continue;
+
+        quaternion_t q = { (float)c[0], (float)c[1], (float)c[2], (float)c[3] };
+        attitude_t a = attitude_from_quaternion(&q);
+        double roll = atan2(2.0 * (c[0] * c[1] + c[2] * c[3]),
+                            1.0 - 2.0 * (c[1] * c[1] + c[2] * c[2])) * 180.0 / M_PI;
+        double pitch = asin(sinp) * 180.0 / M_PI;
+        double yaw = atan2(2.0 * (c[0] * c[3] + c[1] * c[2]),
+                           1.0 - 2.0 * (c[2] * c[2] + c[3] * c[3])) * 180.0 / M_PI;
+
+        // Compare roll and yaw around the circle
+        double roll_error = fmod(fabs(a.roll - roll), 360.0);
+        double yaw_error = fmod(fabs(a.yaw - yaw), 360.0);
+        if (roll_error > 180.0) roll_error = 360.0 - roll_error;
+        if (yaw_error > 180.0) yaw_error = 360.0 - yaw_error;
+        TEST_ASSERT_TRUE(roll_error < 1e-3);
+        TEST_ASSERT_TRUE(fabs(a.pitch - pitch) < 1e-3);
+        TEST_ASSERT_TRUE(yaw_error < 1e-3);
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "unity.h"
+
+void test_fast_math_inv_sqrt(void);
+void test_fast_math_atan2_quadrants(void);
+void test_fast_math_asin(void);
+void test_fast_math_sin_cos(void);
+void test_fast_math_attitude_within_bounds(void);
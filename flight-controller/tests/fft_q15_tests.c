@@ -0,0 +1,96 @@
+#include "fft_q15_tests.h"
+#include "math/fft_q15.h"
+#include <math.h>
+
+#define TWO_PI 6.283185307179586
+
+// Rounding adds about half a count per stage
+#define ROUNDING_COUNTS(log2n) ((log2n) + 1)
+
+// xorshift32, +/-amplitude
+static int32_t noise(uint32_t* state, int32_t amplitude) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (int32_t)(x % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+void test_fft_q15_single_tone(void) {
+    q15_t re[64], im[64];
+    const int bin = 5;
+
+    for (int i = 0; i < 64; i++) {
+        re[i] = (q15_t)lround(16000.0 * cos(TWO_PI * bin * i / 64.0));
+        im[i] = 0;
+    }
+    fft_q15(re, im, 6);
+
+    // A cosine of amplitude A is A/2 at +bin and -bin, after the 1/n scaling
+    for (int k = 0; k < 64; k++) {
+        int32_t expected = (k == bin || k == 64 - bin) ? 8000 : 0;
+        TEST_ASSERT_INT_WITHIN(ROUNDING_COUNTS(6), expected, re[k]);
+        TEST_ASSERT_INT_WITHIN(ROUNDING_COUNTS(6), 0, im[k]);
+    }
+}
+
+void test_fft_q15_matches_dft(void) {
+    static q15_t re[FFT_Q15_MAX_SIZE], im[FFT_Q15_MAX_SIZE];
+    static q15_t in_re[FFT_Q15_MAX_SIZE], in_im[FFT_Q15_MAX_SIZE];
+    uint32_t state = 0x2545F491u;
+
+    for (int log2n = 1; log2n <= FFT_Q15_MAX_LOG2; log2n++) {
+        int n = 1 << log2n;
+        for (int i = 0; i < n; i++) {
+            // Half scale in magnitude, so the sum of both parts is too
+            in_re[i] = re[i] = (q15_t)noise(&state, 11000);
+            in_im[i] = im[i] = (q15_t)noise(&state, 11000);
+        }
+        fft_q15(re, im, log2n);
+
+        for (int k = 0; k < n; k++) {
+            double sum_re = 0.0, sum_im = 0.0;
+            for (int i = 0; i < n; i++) {
+                double a = -TWO_PI * (double)((k * i) % n) / n;
+                sum_re += in_re[i] * cos(a) - in_im[i] * sin(a);
+                sum_im += in_re[i] * sin(a) + in_im[i] * cos(a);
+            }
+            TEST_ASSERT_INT_WITHIN(ROUNDING_COUNTS(log2n), (int32_t)lround(sum_re / n), re[k]);
+            TEST_ASSERT_INT_WITHIN(ROUNDING_COUNTS(log2n), (int32_t)lround(sum_im / n), im[k]);
+        }
+    }
+}
+
+void test_fft_q15_stages_match_whole_transform(void) {
+    q15_t re[32], im[32], staged_re[32], staged_im[32];
+    uint32_t state = 12345u;
+
+    for (int i = 0; i < 32; i++) {
+        re[i] = (q15_t)noise(&state, 16000);
+        im[i] = 0;
+    }
+    for (int i = 0; i < 32; i++) {
+        int j = fft_q15_bit_reverse((uint16_t)i, 5);
+        staged_re[j] = re[i];
+        staged_im[j] = im[i];
+    }
+    fft_q15(re, im, 5);
+    for (int stage = 0; stage < 5; stage++) {
+        fft_q15_stage(staged_re, staged_im, 5, stage);
+    }
+    TEST_ASSERT_EQUAL_INT16_ARRAY(re, staged_re, 32);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(im, staged_im, 32);
+}
+
+void test_fft_q15_hann_window(void) {
+    TEST_ASSERT_EQUAL_INT16(0, fft_q15_hann(0, 6));
+    TEST_ASSERT_EQUAL_INT16(Q15_MAX, fft_q15_hann(32, 6));
+    TEST_ASSERT_INT_WITHIN(1, 16384, fft_q15_hann(16, 6));
+    for (int i = 1; i < 64; i++) {
+        TEST_ASSERT_EQUAL_INT16(fft_q15_hann(i, 6), fft_q15_hann(64 - i, 6));
+        double expected = 32768.0 * (0.5 - 0.5 * cos(TWO_PI * i / 64.0));
+        TEST_ASSERT_INT_WITHIN(1, (int32_t)lround(expected > 32767.0 ? 32767.0 : expected),
+                               fft_q15_hann(i, 6));
+    }
+}
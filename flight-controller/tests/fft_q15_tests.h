@@ -0,0 +1,7 @@
+#pragma once
+#include "unity.h"
+
+void test_fft_q15_single_tone(void);
+void test_fft_q15_matches_dft(void);
+void test_fft_q15_stages_match_whole_transform(void);
+void test_fft_q15_hann_window(void);
@@ -0,0 +1,225 @@
+#include "fixed_point_tests.h"
+#include "mock_i2c_bus.h"
+#include "core/attitude_estimator.h"
+#include "core/mixer.h"
+#include "core/pid_controller.h"
+#include "drivers/esc.h"
+#include "drivers/mpu6050.h"
+#include "include/config.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define GYRO_LSB  65.5f         // Counts per deg/s at +/-500 deg/s
+#define ACCEL_LSB 8192.0f       // Counts per g at +/-4 g
+
+// Inputs are made with integer arithmetic only, so that the fixed-point
+// results below do not depend on the target's libm
+
+// xorshift32, +/-amplitude
+static int32_t noise(uint32_t* state, int32_t amplitude) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (int32_t)(x % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+// +/-amplitude, period in steps
+static int32_t triangle(int i, int period, int32_t amplitude) {
+    int phase = i % period;
+    int rise = phase < period / 2 ? phase : period - phase;
+    return (int32_t)((int64_t)amplitude * (4 * rise - period) / period);
+}
+
+// Sensor counts of a tumbling, vibrating airframe
+static void make_sample(int i, uint32_t* state, int16_t accel[3], int16_t gyro[3]) {
+    gyro[0] = (int16_t)(triangle(i, 1430, 2620) + 65 + noise(state, 30));
+    gyro[1] = (int16_t)(triangle(i, 910, 1640) - 130 + noise(state, 30));
+    gyro[2] = (int16_t)(triangle(i, 3300, 655) + noise(state, 30));
+    accel[0] = (int16_t)(triangle(i, 3140, 2460) + noise(state, 400));
+    accel[1] = (int16_t)(triangle(i, 4490, 2460) + noise(state, 400));
+    accel[2] = (int16_t)(7370 + noise(state, 400));
+}
+
+void test_fixed_point_saturating_arithmetic(void) {
+    TEST_ASSERT_EQUAL_INT16(0x2000, q15_mul(0x4000, 0x4000));
+    TEST_ASSERT_EQUAL_INT16(-0x2000, q15_mul(-0x4000, 0x4000));
+    TEST_ASSERT_EQUAL_INT16(Q15_MAX, q15_mul(Q15_MIN, Q15_MIN));
+    TEST_ASSERT_EQUAL_INT16(1, q15_mul(1, 0x4000));         // 0.5 rounds up
+    TEST_ASSERT_EQUAL_INT16(Q15_MAX, q15_add(30000, 10000));
+    TEST_ASSERT_EQUAL_INT16(Q15_MIN, q15_sub(-30000, 10000));
+
+    TEST_ASSERT_EQUAL_INT32(0x20000000, q31_mul(0x40000000, 0x40000000));
+    TEST_ASSERT_EQUAL_INT32(Q31_MAX, q31_mul(Q31_MIN, Q31_MIN));
+    TEST_ASSERT_EQUAL_INT32(Q31_MAX, q31_add(Q31_MAX, 1));
+    TEST_ASSERT_EQUAL_INT32(Q31_MIN, q31_sub(Q31_MIN, 1));
+    TEST_ASSERT_EQUAL_INT32(Q30_ONE, q30_mul(Q30_ONE, Q30_ONE));
+    TEST_ASSERT_EQUAL_INT32(Q31_MAX, q30_mul(Q31_MAX, Q31_MAX));
+}
+
+void test_fixed_point_conversions(void) {
+    TEST_ASSERT_EQUAL_INT16(16384, q15_from_float(0.5f));
+    TEST_ASSERT_EQUAL_INT16(-16384, q15_from_float(-0.5f));
+    TEST_ASSERT_EQUAL_INT16(Q15_MAX, q15_from_float(1.0f));
+    TEST_ASSERT_EQUAL_INT16(Q15_MIN, q15_from_float(-3.0f));
+    TEST_ASSERT_EQUAL_INT16(0, q15_from_float(NAN));
+    TEST_ASSERT_EQUAL_INT16(1, q15_from_float(1.4f / 32768.0f));
+    TEST_ASSERT_EQUAL_INT16(-2, q15_from_float(-1.5f / 32768.0f));   // Ties away from zero
+    TEST_ASSERT_EQUAL_INT32(Q31_MAX, q31_from_float(1.0f));
+    TEST_ASSERT_EQUAL_INT32(-0x40000000, q31_from_float(-0.5f));
+    TEST_ASSERT_EQUAL_INT32(Q30_ONE, q30_from_float(1.0f));
+    TEST_ASSERT_EQUAL_FLOAT(-0.25f, q15_to_float(-8192));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, q30_to_float(Q30_ONE));
+
+    TEST_ASSERT_EQUAL_UINT32(0, fix_isqrt32(0));
+    TEST_ASSERT_EQUAL_UINT32(1, fix_isqrt32(3));
+    TEST_ASSERT_EQUAL_UINT32(2, fix_isqrt32(4));
+    TEST_ASSERT_EQUAL_UINT32(8191, fix_isqrt32(8192u * 8192u - 1u));
+    TEST_ASSERT_EQUAL_UINT32(65535, fix_isqrt32(0xFFFFFFFFu));
+}
+
+void test_fixed_point_sensor_scaling(void) {
+    static const mpu6050_config_t config = {
+        .gyro_range = 1, .accel_range = 1, .dlpf_bandwidth = 2, .sample_rate_div = 0
+    };
+    static const int16_t level_accel[3] = { 100, -200, 8192 };
+    static const int16_t level_gyro[3] = { -5, 6, -32000 };
+    static const int16_t raw_accel[3] = { -1000, 2000, 4096 };
+    static const int16_t raw_gyro[3] = { 32767, 0, 42 };
+
+    mock_i2c_bus_t mock;
+    mock_i2c_bus_init(&mock, 400000);
+    mpu6050_t* dev = mpu6050_init_with_bus(&mock.bus, &config);
+    TEST_ASSERT_NOT_NULL(dev);
+    mock_i2c_bus_set_sample(&mock, level_accel, level_gyro);
+    mpu6050_calibrate(dev, 4);
+    TEST_ASSERT_EQUAL_FLOAT(500.0f, roundf(mpu6050_gyro_full_scale(dev)));
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, mpu6050_accel_full_scale(dev));
+
+    vector3_q15_t accel, gyro;
+    mpu6050_scale_sample_q15(dev, raw_accel, raw_gyro, &accel, &gyro);
+    TEST_ASSERT_EQUAL_INT16(-1100, accel.x);
+    TEST_ASSERT_EQUAL_INT16(2200, accel.y);
+    TEST_ASSERT_EQUAL_INT16(4096, accel.z);       // The 1 g of the level pose is kept
+    TEST_ASSERT_EQUAL_INT16(Q15_MAX, gyro.x);     // 32772 counts saturate
+    TEST_ASSERT_EQUAL_INT16(-6, gyro.y);
+    TEST_ASSERT_EQUAL_INT16(32042, gyro.z);
+
+    // Same values as the float path, in the same units
+    vector3_t a = { -1000.0f, 2000.0f, 4096.0f }, g = { 30000.0f, 0.0f, 42.0f };
+    vector3_t fa, fg;
+    mpu6050_scale_sample(dev, &a, &g, &fa, &fg);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, fa.x, q15_to_float(accel.x) * mpu6050_accel_full_scale(dev));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, fg.y, q15_to_float(gyro.y) * mpu6050_gyro_full_scale(dev));
+
+    free(dev);
+}
+
+void test_fixed_point_estimator_tracks_float(void) {
+    attitude_estimator_t* reference = attitude_estimator_init();
+    TEST_ASSERT_NOT_NULL(reference);
+    attitude_estimator_set_filter(reference, ATTITUDE_FILTER_MAHONY);
+    attitude_estimator_q_t estimator;
+    attitude_estimator_q_init(&estimator, reference, 32768.0f / GYRO_LSB);
+    // A fixed step, so the checksums below don't move with CONTROL_LOOP_FREQ
+    const float step = 0.002f;
+    q31_t dt = q31_from_float(step);
+    uint32_t state = 1;
+    float max_error = 0.0f;
+
+    for (int i = 0; i < 5000; i++) {
+        int16_t a[3], g[3];
+        make_sample(i, &state, a, g);
+        vector3_t accel = { a[0] / ACCEL_LSB, a[1] / ACCEL_LSB, a[2] / ACCEL_LSB };
+        vector3_t gyro = { g[0] / GYRO_LSB, g[1] / GYRO_LSB, g[2] / GYRO_LSB };
+        vector3_q15_t accel_q = { a[0], a[1], a[2] }, gyro_q = { g[0], g[1], g[2] };
+        attitude_estimator_update(reference, &accel, &gyro, step);
+        attitude_estimator_q_update(&estimator, &accel_q, &gyro_q, dt);
+
+        quaternion_t q;
+        attitude_estimator_q_get_quaternion(&estimator, &q);
+        const float error[4] = {
+            fabsf(q.q0 - reference->quaternion.q0), fabsf(q.q1 - reference->quaternion.q1),
+            fabsf(q.q2 - reference->quaternion.q2), fabsf(q.q3 - reference->quaternion.q3)
+        };
+        for (int k = 0; k < 4; k++) {
+            if (error[k] > max_error) max_error = error[k];
+        }
+    }
+    TEST_ASSERT_TRUE(max_error < 1e-4f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, reference->gyro_bias.x,
+                             q31_to_float(estimator.gyro_bias[0]) * 32768.0f / GYRO_LSB);
+
+    // Integer arithmetic only: every build must land on exactly these
+    TEST_ASSERT_EQUAL_INT32(1054481759, estimator.quaternion.q0);
+    TEST_ASSERT_EQUAL_INT32(-98203224, estimator.quaternion.q1);
+    TEST_ASSERT_EQUAL_INT32(-72861513, estimator.quaternion.q2);
+    TEST_ASSERT_EQUAL_INT32(-161360006, estimator.quaternion.q3);
+    TEST_ASSERT_EQUAL_INT32(7466858, estimator.gyro_bias[0]);
+
+    free(reference);
+}
+
+void test_fixed_point_pid_tracks_float(void) {
+    // An angle controller with large gains, so that the terms are far from
+    // the rounding and the output saturates
+    const float dt = 0.002f;
+    pid_controller_t* reference = pid_controller_init(0.5f, 0.2f, 0.1f);
+    TEST_ASSERT_NOT_NULL(reference);
+    pid_controller_q_t pid;
+    pid_controller_q_init(&pid, reference, dt, PID_Q_ERROR_RANGE);
+    uint32_t state = 7;
+    float max_error = 0.0f;
+    uint32_t checksum = 0;
+
+    // Half a degree of slow wobble with noise, then a step that saturates
+    // (a Q31 degree is 11930465)
+    for (int i = 0; i < 2000; i++) {
+        q31_t error = triangle(i, 1047, 5965232) + noise(&state, 119305);
+        if (i >= 1500) error += 5 * 11930465;
+
+        float expected = pid_controller_update(reference, q31_to_float(error) * PID_Q_ERROR_RANGE,
+                                               dt);
+        q15_t output = pid_controller_q_update(&pid, error);
+        float diff = fabsf(q15_to_float(output) - expected);
+        if (diff > max_error) max_error = diff;
+        checksum = checksum * 31u + (uint16_t)output;
+    }
+    TEST_ASSERT_TRUE(max_error < 4.0f / 32768.0f);
+    TEST_ASSERT_EQUAL_UINT32(1612962566u, checksum);
+
+    free(reference);
+}
+
+void test_fixed_point_duty_within_one_count(void) {
+    esc_duty_range_t range;
+    esc_duty_range_init(&range, &ESC_PROTOCOL_CONFIG[ESC_PROTOCOL_PWM]);
+    TEST_ASSERT_EQUAL_UINT16(25000, range.min_duty);
+    TEST_ASSERT_EQUAL_UINT16(50000, range.max_duty);
+    TEST_ASSERT_EQUAL_UINT16(25000, esc_throttle_q15_to_duty(&range, -100));
+    TEST_ASSERT_EQUAL_UINT16(37500, esc_throttle_q15_to_duty(&range, 16384));
+    TEST_ASSERT_EQUAL_UINT16(50000, esc_throttle_q15_to_duty(&range, Q15_MAX));
+
+    for (int32_t t = 0; t <= Q15_MAX; t++) {
+        int32_t expected = esc_throttle_to_duty(&range, q15_to_float((q15_t)t));
+        int32_t duty = esc_throttle_q15_to_duty(&range, (q15_t)t);
+        TEST_ASSERT_INT32_WITHIN(1, expected, duty);
+    }
+}
+
+void test_fixed_point_mixer_saturates(void) {
+    q15_t motor[4];
+    float expected[4];
+    mixer_quad_x_q15(16384, 4096, -2048, 1024, motor);
+    mixer_quad_x(0.5f, 0.125f, -0.0625f, 0.03125f, expected);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(expected[i], q15_to_float(motor[i]));
+    }
+
+    mixer_quad_x_q15(30000, 20000, 20000, 20000, motor);
+    TEST_ASSERT_EQUAL_INT16(Q15_MAX, motor[0]);
+    TEST_ASSERT_EQUAL_INT16(30000 - 20000 + 20000 - 20000, motor[1]);
+    mixer_quad_x_q15(0, -30000, -30000, 0, motor);
+    TEST_ASSERT_EQUAL_INT16(Q15_MIN, motor[0]);
+}
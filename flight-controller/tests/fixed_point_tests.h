@@ -0,0 +1,10 @@
+#pragma once
+#include "unity.h"
+
+void test_fixed_point_saturating_arithmetic(void);
+void test_fixed_point_conversions(void);
+void test_fixed_point_sensor_scaling(void);
+void test_fixed_point_estimator_tracks_float(void);
+void test_fixed_point_pid_tracks_float(void);
+void test_fixed_point_duty_within_one_count(void);
+void test_fixed_point_mixer_saturates(void);
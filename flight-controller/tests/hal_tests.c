@@ -0,0 +1,316 @@
+#include "hal_tests.h"
+
+#ifdef HOST_BUILD
+#include "core/flight_controller.h"
+#include "core/loop_trigger.h"
+#include "drivers/dshot.h"
+#include "drivers/esc.h"
+#include "drivers/hal_linux.h"
+#include "drivers/mpu6050_sim.h"
+#include "include/config.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define TEST_INT_PIN 14
+
+void test_hal_virtual_time(void) {
+    hal_linux_set_virtual_time(true);
+    TEST_ASSERT_EQUAL_UINT64(0, hal_time_us());
+
+    hal_sleep_ms(100);
+    TEST_ASSERT_EQUAL_UINT64(100000, hal_time_us());
+    hal_sleep_us(250);
+    TEST_ASSERT_EQUAL_UINT64(100250, hal_time_us());
+
+    // Deadlines in the past do not move the clock back
+    hal_sleep_until(50);
+    TEST_ASSERT_EQUAL_UINT64(100250, hal_time_us());
+
+    // A pending event ends the wait without advancing the clock, once
+    hal_event_signal();
+    hal_event_wait_until(200000);
+    TEST_ASSERT_EQUAL_UINT64(100250, hal_time_us());
+    hal_event_wait_until(200000);
+    TEST_ASSERT_EQUAL_UINT64(200000, hal_time_us());
+}
+
+void test_hal_loop_trigger_on_gpio_edge(void) {
+    loop_trigger_t trigger;
+    hal_linux_set_virtual_time(true);
+    loop_trigger_hal_init(&trigger, TEST_INT_PIN, 1000);
+
+    // The edge lands before the wait, as if the IRQ fired mid-loop
+    hal_linux_advance_us(400);
+    hal_linux_gpio_edge(TEST_INT_PIN);
+    TEST_ASSERT_EQUAL_INT(LOOP_TRIGGER_DATA_READY, loop_trigger_wait(&trigger));
+    TEST_ASSERT_EQUAL_UINT64(400, trigger.last_tick_us);
+    TEST_ASSERT_EQUAL_UINT64(400, hal_time_us());
+
+    // Silence: the wait sleeps to the 1.5 period timeout and falls back
+    TEST_ASSERT_EQUAL_INT(LOOP_TRIGGER_FALLBACK, loop_trigger_wait(&trigger));
+    TEST_ASSERT_EQUAL_UINT64(1900, hal_time_us());
+}
+
+void test_hal_esc_pwm_levels(void) {
+    const esc_config_t* config = &ESC_PROTOCOL_CONFIG[ESC_PROTOCOL_PWM];
+    esc_controller_t* esc = esc_init(config);
+    TEST_ASSERT_NOT_NULL(esc);
+    TEST_ASSERT_EQUAL_UINT16(config->wrap_value, hal_linux_pwm_wrap(PIN_MOTOR1));
+
+    // Ignored until armed
+    esc_set_output(esc, 0.5f, 0.5f, 0.5f, 0.5f);
+    TEST_ASSERT_EQUAL_UINT16(0, hal_linux_pwm_level(PIN_MOTOR1));
+
+    hal_linux_set_virtual_time(true);
+    esc_arm(esc);
+    // 1.0 ms of a 2.5 ms period
+    TEST_ASSERT_EQUAL_UINT16(25000, hal_linux_pwm_level(PIN_MOTOR1));
+
+    esc_set_output(esc, 0.0f, 0.5f, 1.0f, 2.0f);
+    TEST_ASSERT_EQUAL_UINT16(25000, hal_linux_pwm_level(PIN_MOTOR1));
+    TEST_ASSERT_EQUAL_UINT16(37500, hal_linux_pwm_level(PIN_MOTOR2));
+    TEST_ASSERT_EQUAL_UINT16(50000, hal_linux_pwm_level(PIN_MOTOR3));
+    TEST_ASSERT_EQUAL_UINT16(50000, hal_linux_pwm_level(PIN_MOTOR4));
+    // Free-running
+    TEST_ASSERT_EQUAL_UINT32(0, hal_linux_pwm_restarts(PIN_MOTOR1));
+
+    esc_emergency_stop(esc);
+    TEST_ASSERT_EQUAL_UINT16(0, hal_linux_pwm_level(PIN_MOTOR3));
+    free(esc);
+}
+
+void test_hal_esc_oneshot_synced(void) {
+    esc_controller_t* esc = esc_init(&ESC_PROTOCOL_CONFIG[ESC_PROTOCOL_ONESHOT125]);
+    TEST_ASSERT_NOT_NULL(esc);
+
+    // 125 us held through arming on the free-running slices
+    hal_linux_set_virtual_time(true);
+    esc_arm(esc);
+    TEST_ASSERT_EQUAL_UINT16(3906, hal_linux_pwm_level(PIN_MOTOR1));
+    TEST_ASSERT_EQUAL_UINT32(0, hal_linux_pwm_restarts(PIN_MOTOR1));
+
+    // 125-250 us at 31.25 counts/us, all four restarted after each output
+    esc_set_output(esc, 0.0f, 0.5f, 1.0f, 2.0f);
+    TEST_ASSERT_EQUAL_UINT16(3906, hal_linux_pwm_level(PIN_MOTOR1));
+    TEST_ASSERT_EQUAL_UINT16(5860, hal_linux_pwm_level(PIN_MOTOR2));
+    TEST_ASSERT_EQUAL_UINT16(7813, hal_linux_pwm_level(PIN_MOTOR3));
+    TEST_ASSERT_EQUAL_UINT16(7813, hal_linux_pwm_level(PIN_MOTOR4));
+    const q15_t half[4] = { 16384, 16384, 16384, 16384 };
+    esc_set_output_q15(esc, half);
+    TEST_ASSERT_EQUAL_UINT16(5860, hal_linux_pwm_level(PIN_MOTOR1));
+    TEST_ASSERT_EQUAL_UINT32(2, hal_linux_pwm_restarts(PIN_MOTOR1));
+    TEST_ASSERT_EQUAL_UINT32(2, hal_linux_pwm_restarts(PIN_MOTOR4));
+    TEST_ASSERT_EQUAL_UINT32(0, hal_linux_pwm_restarts(PIN_MOTOR4 + 1));
+    free(esc);
+
+    // Multishot: 5-25 us
+    esc = esc_init(&ESC_PROTOCOL_CONFIG[ESC_PROTOCOL_MULTISHOT]);
+    TEST_ASSERT_NOT_NULL(esc);
+    esc_arm(esc);
+    esc_set_output(esc, 0.0f, 0.0f, 1.0f, 1.0f);
+    TEST_ASSERT_EQUAL_UINT16(156, hal_linux_pwm_level(PIN_MOTOR1));
+    TEST_ASSERT_EQUAL_UINT16(781, hal_linux_pwm_level(PIN_MOTOR3));
+    TEST_ASSERT_EQUAL_UINT32(1, hal_linux_pwm_restarts(PIN_MOTOR1));
+    free(esc);
+}
+
+void test_hal_mpu6050_over_simulated_bus(void) {
+    static mpu6050_sim_t sim;
+    hal_linux_i2c_detach_all();
+    TEST_ASSERT_TRUE(mpu6050_sim_init(&sim, 1));
+
+    i2c_bus_t* bus = i2c_bus_linux_init(1, 400000);
+    TEST_ASSERT_NOT_NULL(bus);
+    const mpu6050_config_t config = { .gyro_range = 1, .accel_range = 1 };
+    mpu6050_t* dev = mpu6050_init_with_bus(bus, &config);
+    TEST_ASSERT_NOT_NULL(dev);
+    TEST_ASSERT_TRUE(mpu6050_test_connection(dev));
+
+    const vector3_t accel = { 0.25f, -0.5f, 0.8f };
+    const vector3_t gyro = { 10.0f, -20.0f, 123.0f };
+    mpu6050_sim_set_sample(&sim, &accel, &gyro);
+
+    vector3_t a, g;
+    mpu6050_read_scaled(dev, &a, &g);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f / 8192.0f, accel.x, a.x);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f / 8192.0f, accel.z, a.z);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f / 65.5f, gyro.y, g.y);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f / 65.5f, gyro.z, g.z);
+
+    // The asynchronous path completes on the simulated bus as well
+    TEST_ASSERT_TRUE(mpu6050_read_async_start(dev));
+    TEST_ASSERT_EQUAL_INT(MPU6050_ASYNC_READY, mpu6050_read_async_poll(dev));
+    TEST_ASSERT_TRUE(mpu6050_read_async_complete_scaled(dev, &a, &g));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f / 65.5f, gyro.x, g.x);
+
+    free(dev);
+    free(bus->ctx);
+    hal_linux_i2c_detach_all();
+}
+
+void test_hal_mpu6050_counts_skipped_samples(void) {
+    static mpu6050_sim_t sim;
+    hal_linux_set_virtual_time(true);
+    hal_linux_i2c_detach_all();
+    TEST_ASSERT_TRUE(mpu6050_sim_init(&sim, 1));
+
+    i2c_bus_t* bus = i2c_bus_linux_init(1, 400000);
+    TEST_ASSERT_NOT_NULL(bus);
+    // 1 kHz
+    const mpu6050_config_t config = { .gyro_range = 1, .accel_range = 1, .dlpf_bandwidth = 2 };
+    mpu6050_t* dev = mpu6050_init_with_bus(bus, &config);
+    TEST_ASSERT_NOT_NULL(dev);
+
+    const vector3_t accel = { 0.0f, 0.0f, 1.0f };
+    const vector3_t gyro = { 1.0f, 2.0f, 3.0f };
+    vector3_t a, g;
+
+    // Read every update, then only every third one
+    for (int i = 0; i < 13; i++) {
+        if (i < 4 || i % 3 == 0) {
+            mpu6050_sim_set_sample(&sim, &accel, &gyro);
+            mpu6050_read_async_poll(dev);
+            mpu6050_read_async_start(dev);
+        }
+        hal_linux_advance_us(1000);
+    }
+    mpu6050_read_async_poll(dev);
+
+    const mpu6050_sample_stats_t* stats = mpu6050_get_sample_stats(dev);
+    TEST_ASSERT_EQUAL_UINT32(7, stats->fresh);
+    TEST_ASSERT_EQUAL_UINT32(6, stats->skipped);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->duplicates);
+    TEST_ASSERT_EQUAL_INT(7, mpu6050_read_average(dev, &a, &g));
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 65.5f, g.x);
+
+    free(dev);
+    free(bus->ctx);
+    hal_linux_i2c_detach_all();
+}
+
+// Motor command on pin as the modeled hardware last saw it, in the units of
+// ESC_PROTOCOL: the PWM compare level, or the DShot throttle value
+static uint16_t motor_level(uint8_t pin) {
+    if (DEFAULT_ESC_CONFIG.protocol >= ESC_PROTOCOL_DSHOT150) return hal_linux_dshot_frame(pin) >> 5;
+    return hal_linux_pwm_level(pin);
+}
+
+static uint16_t throttle_level(float throttle) {
+    if (DEFAULT_ESC_CONFIG.protocol >= ESC_PROTOCOL_DSHOT150) {
+        return (uint16_t)(DSHOT_THROTTLE_MIN + throttle * (DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN) + 0.5f);
+    }
+    esc_duty_range_t range;
+    esc_duty_range_init(&range, &DEFAULT_ESC_CONFIG);
+    return esc_throttle_to_duty(&range, throttle);
+}
+
+void test_hal_flight_controller_runs_on_host(void) {
+    static mpu6050_sim_t sim;
+    hal_linux_set_virtual_time(true);
+    hal_linux_i2c_detach_all();
+    TEST_ASSERT_TRUE(mpu6050_sim_init(&sim, 0));
+
+    flight_controller_t* fc = flight_controller_init();
+    TEST_ASSERT_NOT_NULL(fc);
+    TEST_ASSERT_NOT_NULL(fc->esc);
+    TEST_ASSERT_EQUAL_INT(FLIGHT_MODE_DISARMED, fc->current_mode);
+
+    // Level and still: the attitude stays level and the mix stays balanced
+    fc->setpoint.throttle = 0.5f;
+    for (int i = 0; i < CONTROL_LOOP_FREQ; i++) {
+        flight_controller_update(fc);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, fc->attitude_estimator->quaternion.q0);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.5f, fc->motor_output[i]);
+    }
+    // Nothing reaches the motors while disarmed
+    TEST_ASSERT_EQUAL_UINT16(0, motor_level(PIN_MOTOR1));
+
+    esc_arm(fc->esc);
+    flight_controller_update(fc);
+    TEST_ASSERT_UINT_WITHIN(10, throttle_level(0.5f), motor_level(PIN_MOTOR1));
+    TEST_ASSERT_UINT_WITHIN(10, throttle_level(0.5f), motor_level(PIN_MOTOR4));
+
+    // A roll rate moves the estimate and the roll PID answers it
+    const vector3_t accel = { 0.0f, 0.0f, 1.0f };
+    const vector3_t gyro = { 50.0f, 0.0f, 0.0f };
+    mpu6050_sim_set_sample(&sim, &accel, &gyro);
+    for (int i = 0; i < 50; i++) {
+        flight_controller_update(fc);
+    }
+    TEST_ASSERT_TRUE(fabsf(fc->attitude_estimator->quaternion.q1) > 1e-3f);
+    TEST_ASSERT_TRUE(fabsf(fc->motor_output[0] - fc->motor_output[1]) > 1e-3f);
+
+    flight_controller_cleanup(fc);
+    hal_linux_i2c_detach_all();
+}
+
+void test_hal_flight_controller_cascade(void) {
+    static mpu6050_sim_t sim;
+    hal_linux_set_virtual_time(true);
+    hal_linux_i2c_detach_all();
+    TEST_ASSERT_TRUE(mpu6050_sim_init(&sim, 0));
+    flight_controller_t* fc = flight_controller_init();
+    TEST_ASSERT_NOT_NULL(fc);
+    fc->setpoint.throttle = 0.5f;
+
+    // Rolled 10 degrees right and still
+    attitude_sample_t sample = { 0 };
+    sample.quaternion.q0 = cosf(5.0f * (float)M_PI / 180.0f);
+    sample.quaternion.q1 = sinf(5.0f * (float)M_PI / 180.0f);
+
+    // The first step runs the angle loop, which asks for a roll to the left
+    flight_controller_control_step(fc, &sample);
+    const vector3_t rate_setpoint = fc->rate_setpoint;
+    TEST_ASSERT_TRUE(rate_setpoint.x < -1.0f);
+
+    // Level again: the rate setpoint holds until the angle loop runs next,
+    // while the rate loop answers every gyro sample
+    sample.quaternion.q0 = 1.0f;
+    sample.quaternion.q1 = 0.0f;
+    float last_roll = fc->motor_output[0] - fc->motor_output[1];
+    for (int i = 1; i < ANGLE_LOOP_DECIMATION; i++) {
+        sample.gyro.x = rate_setpoint.x + 10.0f * (float)i;
+        flight_controller_control_step(fc, &sample);
+        TEST_ASSERT_EQUAL_FLOAT(rate_setpoint.x, fc->rate_setpoint.x);
+        float roll = fc->motor_output[0] - fc->motor_output[1];
+        TEST_ASSERT_TRUE(fabsf(roll - last_roll) > 1e-5f);
+        last_roll = roll;
+    }
+    flight_controller_control_step(fc, &sample);
+    TEST_ASSERT_TRUE(fc->rate_setpoint.x > rate_setpoint.x);
+
+    flight_controller_cleanup(fc);
+    hal_linux_i2c_detach_all();
+}
+
+static bool inside(const void* p, const void* block, size_t size) {
+    const char* c = p;
+    return c >= (const char*)block && c < (const char*)block + size;
+}
+
+void test_hal_flight_controller_static_stack(void) {
+    static flight_stack_t stack;
+    static mpu6050_sim_t sim;
+    hal_linux_set_virtual_time(true);
+    hal_linux_i2c_detach_all();
+
+    // Everything the loop reaches lives in the one block
+    TEST_ASSERT_TRUE(mpu6050_sim_init(&sim, 0));
+    flight_controller_t* fc = flight_controller_setup(&stack);
+    TEST_ASSERT_EQUAL_PTR(&stack.fc, fc);
+    TEST_ASSERT_TRUE(inside(fc->imu, &stack, sizeof(stack)));
+    TEST_ASSERT_TRUE(inside(fc->attitude_estimator, &stack, sizeof(stack)));
+    TEST_ASSERT_TRUE(inside(fc->esc, &stack, sizeof(stack)));
+
+    fc->setpoint.throttle = 0.5f;
+    for (int i = 0; i < CONTROL_LOOP_FREQ / 10; i++) {
+        flight_controller_update(fc);
+    }
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.5f, fc->motor_output[i]);
+    }
+    hal_linux_i2c_detach_all();
+}
+#endif
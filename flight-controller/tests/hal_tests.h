@@ -0,0 +1,14 @@
+#pragma once
+#include "unity.h"
+
+#ifdef HOST_BUILD
+void test_hal_virtual_time(void);
+void test_hal_loop_trigger_on_gpio_edge(void);
+void test_hal_esc_pwm_levels(void);
+void test_hal_esc_oneshot_synced(void);
+void test_hal_mpu6050_over_simulated_bus(void);
+void test_hal_mpu6050_counts_skipped_samples(void);
+void test_hal_flight_controller_runs_on_host(void);
+void test_hal_flight_controller_cascade(void);
+void test_hal_flight_controller_static_stack(void);
+#endif
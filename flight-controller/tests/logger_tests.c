@@ -0,0 +1,160 @@
+// The tests exercise deferred mode regardless of the build setting
+#ifndef FC_LOG_DEFERRED
+#define FC_LOG_DEFERRED
+#endif
+
+#include "logger_tests.h"
+#include "../src/utils/logger.h"
+#include "../src/utils/telemetry.h"
+#include "../src/include/config.h"
+
+#ifdef HOST_BUILD
+#include "../src/drivers/hal_linux.h"
+#include "../tools/telemetry/log_decoder.h"
+#else
+#include "../src/utils/loop_profiler.h"
+#endif
+
+static size_t discard_write(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    (void)data;
+    return len;
+}
+
+static telemetry_t log_tel;
+
+static void attach_channel(void) {
+    telemetry_port_t port = { .write = discard_write, .ctx = NULL };
+    telemetry_init(&log_tel, &port);
+    logger_init(&log_tel);
+}
+
+#ifdef HOST_BUILD
+static uint32_t float_word(float f) {
+    uint32_t w;
+    memcpy(&w, &f, sizeof(w));
+    return w;
+}
+
+void test_logger_format_words(void) {
+    char out[128];
+    const uint32_t args[] = { (uint32_t)-42, 3000000000u, 0xBEEFu, float_word(2.5f), 'x' };
+
+    log_format(out, sizeof(out), "%d %u %04x %.3f %c 100%%", args, 5);
+    TEST_ASSERT_EQUAL_STRING("-42 3000000000 beef 2.500 x 100%", out);
+
+    // Length modifiers are ignored; missing and unsupported arguments show up
+    log_format(out, sizeof(out), "%ld %lu %s %d", args, 2);
+    TEST_ASSERT_EQUAL_STRING("-42 3000000000 <?> <?>", out);
+
+    // Truncation keeps the string terminated
+    const uint32_t repeated[] = { 123, 456, 789 };
+    TEST_ASSERT_EQUAL_UINT32(7, log_format(out, 8, "%d%d%d", repeated, 3));
+    TEST_ASSERT_EQUAL_STRING("1234567", out);
+}
+
+void test_logger_deferred_round_trip(void) {
+    attach_channel();
+
+    int8_t small = -7;
+    uint16_t count = 65000;
+    LOG_ERROR("imu timeout after %d retries, %u samples, dt %.4f", small, count, 0.0021f);
+    LOG_INFO("armed");
+
+    telemetry_record_t rec;
+    log_string_table_t strings;
+    TEST_ASSERT_EQUAL_INT(0, log_string_table_load(&strings, "/proc/self/exe"));
+
+    char text[128];
+    TEST_ASSERT_TRUE(spsc_ring_pop(&log_tel.ring, &rec));
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_LOG, rec.type);
+    TEST_ASSERT_EQUAL_UINT8(3, rec.log.nargs);
+    telemetry_log_t log = rec.log;
+    log_render(&strings, &log, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("ERROR: imu timeout after -7 retries, 65000 samples, dt 0.0021", text);
+
+    TEST_ASSERT_TRUE(spsc_ring_pop(&log_tel.ring, &rec));
+    log = rec.log;
+    log_render(&strings, &log, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("INFO: armed", text);
+
+    // Ids that point outside the table are reported, not dereferenced
+    log.id = (uint16_t)strings.size;
+    log_render(&strings, &log, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING_LEN("INFO: <unknown", text, 14);
+
+    log_string_table_free(&strings);
+}
+
+void test_logger_core1_records_wait_for_core0(void) {
+    telemetry_record_t rec;
+    attach_channel();
+
+    // Queued on core 1, sent by core 0
+    hal_linux_set_core_num(1);
+    LOG_ERROR("imu read failed %d", 5);
+    hal_linux_set_core_num(0);
+    TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&log_tel.ring));
+    logger_pump();
+    TEST_ASSERT_TRUE(spsc_ring_pop(&log_tel.ring, &rec));
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_LOG, rec.type);
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_ERROR, rec.log.level);
+    TEST_ASSERT_EQUAL_UINT32(5, rec.log.args[0]);
+
+    // What the queue has no room for is counted
+    hal_linux_set_core_num(1);
+    for (uint32_t i = 0; i < LOG_CORE1_QUEUE_SIZE + 2; i++) LOG_DEBUG("tick %u", i);
+    hal_linux_set_core_num(0);
+    TEST_ASSERT_EQUAL_UINT32(2, logger_dropped());
+
+    // A core 0 log call sends the queued records ahead of its own
+    LOG_INFO("core 0");
+    TEST_ASSERT_EQUAL_UINT32(LOG_CORE1_QUEUE_SIZE + 1, spsc_ring_count(&log_tel.ring));
+    TEST_ASSERT_TRUE(spsc_ring_pop(&log_tel.ring, &rec));
+    TEST_ASSERT_EQUAL_UINT32(0, rec.log.args[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, logger_dropped());
+}
+#endif
+
+void test_logger_drops_without_channel(void) {
+    logger_init(NULL);
+    LOG_DEBUG("nobody listening %d", 1);
+    TEST_ASSERT_EQUAL_UINT32(1, logger_dropped());
+
+    attach_channel();
+    for (uint32_t i = 0; i < TELEMETRY_RING_SIZE + 3; i++) {
+        LOG_DEBUG("tick %u", i);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, logger_dropped());
+}
+
+#ifndef HOST_BUILD
+// Not a pass/fail check: prints the on-target cycle counts of a deferred
+// call and of formatting the same line with snprintf
+void test_logger_target_cost(void) {
+    char line[96];
+    volatile float roll = 1.25f;
+    volatile float pitch = -3.5f;
+    uint32_t deferred = UINT32_MAX;
+    uint32_t text = UINT32_MAX;
+
+    loop_profiler_init_core();
+    for (int i = 0; i < 16; i++) {
+        attach_channel();
+
+        uint32_t start = profile_now();
+        LOG_INFO("attitude %.2f %.2f %.2f", roll, pitch, (float)i);
+        uint32_t cycles = profile_elapsed(start, profile_now());
+        if (cycles < deferred) deferred = cycles;
+
+        start = profile_now();
+        snprintf(line, sizeof(line), "INFO: attitude %.2f %.2f %.2f", roll, pitch, (float)i);
+        cycles = profile_elapsed(start, profile_now());
+        if (cycles < text) text = cycles;
+    }
+
+    printf("LOG_INFO deferred: %lu cycles, snprintf: %lu cycles\n",
+           (unsigned long)deferred, (unsigned long)text);
+    TEST_ASSERT_TRUE(deferred < text);
+}
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+#include "unity.h"
+
+void test_logger_format_words(void);
+void test_logger_deferred_round_trip(void);
+void test_logger_core1_records_wait_for_core0(void);
+void test_logger_drops_without_channel(void);
+void test_logger_target_cost(void);
@@ -0,0 +1,136 @@
+// Probes are off in release builds; the tests always exercise them
+#ifndef FC_PROFILE
+#define FC_PROFILE
+#endif
+
+#include "loop_profiler_tests.h"
+#include "../src/utils/loop_profiler.h"
+
+#ifdef HOST_BUILD
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#endif
+
+void test_loop_profiler_min_max_mean(void) {
+    loop_profiler_init();
+
+    loop_profiler_record(PROFILE_STAGE_ESTIMATOR, 300);
+    loop_profiler_record(PROFILE_STAGE_ESTIMATOR, 100);
+    loop_profiler_record(PROFILE_STAGE_ESTIMATOR, 200);
+
+    profile_stage_stats_t stats;
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_ESTIMATOR, &stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(100, stats.min);
+    TEST_ASSERT_EQUAL_UINT32(300, stats.max);
+    TEST_ASSERT_EQUAL_UINT32(200, (uint32_t)(stats.total / stats.count));
+
+    // Other stages are untouched
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_RATE_PIDS, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.count);
+}
+
+void test_loop_profiler_histogram_buckets(void) {
+    loop_profiler_init();
+
+    loop_profiler_record(PROFILE_STAGE_MIXER, 0);
+    loop_profiler_record(PROFILE_STAGE_MIXER, 1);
+    loop_profiler_record(PROFILE_STAGE_MIXER, 3);
+    loop_profiler_record(PROFILE_STAGE_MIXER, 1000);
+    loop_profiler_record(PROFILE_STAGE_MIXER, 1023);
+    loop_profiler_record(PROFILE_STAGE_MIXER, 1024);
+    loop_profiler_record(PROFILE_STAGE_MIXER, UINT32_MAX);
+
+    profile_stage_stats_t stats;
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_MIXER, &stats));
+    TEST_ASSERT_EQUAL_UINT32(2, stats.hist[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.hist[1]);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.hist[9]);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.hist[10]);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.hist[PROFILE_HIST_BUCKETS - 1]);
+
+    uint32_t sum = 0;
+    for (int i = 0; i < PROFILE_HIST_BUCKETS; i++) sum += stats.hist[i];
+    TEST_ASSERT_EQUAL_UINT32(stats.count, sum);
+}
+
+void test_loop_profiler_reset(void) {
+    loop_profiler_init();
+
+    loop_profiler_record(PROFILE_STAGE_RATE_PIDS, 50);
+    loop_profiler_reset(PROFILE_STAGE_RATE_PIDS);
+
+    profile_stage_stats_t stats;
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_RATE_PIDS, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.count);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.hist[5]);
+
+    loop_profiler_record(PROFILE_STAGE_RATE_PIDS, 40);
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_RATE_PIDS, &stats));
+    TEST_ASSERT_EQUAL_UINT32(40, stats.min);
+    TEST_ASSERT_EQUAL_UINT32(40, stats.max);
+}
+
+void test_loop_profiler_probe_pair_records(void) {
+    loop_profiler_init();
+
+    // Calibration must not leave samples behind
+    profile_stage_stats_t stats;
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_IMU_READ, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.count);
+
+    for (int i = 0; i < 10; i++) {
+        PROFILE_BEGIN(PROFILE_STAGE_IMU_READ);
+        PROFILE_END(PROFILE_STAGE_IMU_READ);
+    }
+
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_IMU_READ, &stats));
+    TEST_ASSERT_EQUAL_UINT32(10, stats.count);
+    TEST_ASSERT_TRUE(stats.min <= stats.max);
+    TEST_ASSERT_EQUAL_STRING("imu_read", loop_profiler_stage_name(PROFILE_STAGE_IMU_READ));
+}
+
+#ifdef HOST_BUILD
+#define SNAPSHOT_RECORDS 200000u
+#define SNAPSHOT_TICKS 7u
+
+static _Atomic bool writer_done;
+
+static void* stage_writer(void* arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < SNAPSHOT_RECORDS; i++) {
+        loop_profiler_record(PROFILE_STAGE_ANGLE_PIDS, SNAPSHOT_TICKS);
+        if ((i & 0xFFu) == 0) sched_yield();
+    }
+    atomic_store(&writer_done, true);
+    return NULL;
+}
+
+void test_loop_profiler_threaded_snapshot(void) {
+    loop_profiler_init();
+    atomic_store(&writer_done, false);
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, stage_writer, NULL);
+
+    // Every accepted snapshot must be internally consistent
+    uint32_t torn = 0;
+    uint32_t last_count = 0;
+    profile_stage_stats_t stats;
+    while (!atomic_load(&writer_done)) {
+        if (loop_profiler_read(PROFILE_STAGE_ANGLE_PIDS, &stats)) {
+            if (stats.total != (uint64_t)stats.count * SNAPSHOT_TICKS) torn++;
+            if (stats.hist[2] != stats.count) torn++;
+            if (stats.count < last_count) torn++;
+            last_count = stats.count;
+        }
+        sched_yield();
+    }
+    pthread_join(writer, NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_TRUE(loop_profiler_read(PROFILE_STAGE_ANGLE_PIDS, &stats));
+    TEST_ASSERT_EQUAL_UINT32(SNAPSHOT_RECORDS, stats.count);
+}
+#endif
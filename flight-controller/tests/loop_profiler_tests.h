@@ -0,0 +1,8 @@
+#pragma once
+#include "unity.h"
+
+void test_loop_profiler_min_max_mean(void);
+void test_loop_profiler_histogram_buckets(void);
+void test_loop_profiler_reset(void);
+void test_loop_profiler_probe_pair_records(void);
+void test_loop_profiler_threaded_snapshot(void);
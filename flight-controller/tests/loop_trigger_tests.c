@@ -0,0 +1,98 @@
+#include "loop_trigger_tests.h"
+#include "fake_trigger_port.h"
+
+#define TEST_PERIOD_US 2000
+
+void test_loop_trigger_follows_data_ready(void) {
+    loop_trigger_t trigger;
+    fake_trigger_port_t fake;
+    fake_trigger_port_init(&fake, &trigger, TEST_PERIOD_US);
+
+    // Sensor clock runs slightly fast; ticks must follow it exactly
+    uint64_t irqs[10];
+    for (int i = 0; i < 10; i++) irqs[i] = 1990 * (uint64_t)(i + 1);
+    fake_trigger_port_set_irqs(&fake, irqs, 10);
+
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(LOOP_TRIGGER_DATA_READY, loop_trigger_wait(&trigger));
+        TEST_ASSERT_EQUAL_UINT64(irqs[i], fake.now_us);
+        fake.now_us += 300;  // Control update
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, trigger.irq_ticks);
+    TEST_ASSERT_EQUAL_UINT32(0, trigger.fallback_ticks);
+}
+
+void test_loop_trigger_falls_back_when_silent(void) {
+    loop_trigger_t trigger;
+    fake_trigger_port_t fake;
+    fake_trigger_port_init(&fake, &trigger, TEST_PERIOD_US);
+
+    TEST_ASSERT_EQUAL(LOOP_TRIGGER_FALLBACK, loop_trigger_wait(&trigger));
+    TEST_ASSERT_EQUAL_UINT64(3000, fake.now_us);
+
+    for (int i = 1; i <= 5; i++) {
+        fake.now_us += 300;
+        TEST_ASSERT_EQUAL(LOOP_TRIGGER_FALLBACK, loop_trigger_wait(&trigger));
+        TEST_ASSERT_EQUAL_UINT64(3000 + i * TEST_PERIOD_US, fake.now_us);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, trigger.fallback_entries);
+    TEST_ASSERT_EQUAL_UINT32(6, trigger.fallback_ticks);
+}
+
+void test_loop_trigger_recovers_from_fallback(void) {
+    loop_trigger_t trigger;
+    fake_trigger_port_t fake;
+    fake_trigger_port_init(&fake, &trigger, TEST_PERIOD_US);
+
+    const uint64_t irqs[] = {2000, 4000, 14100, 16100};
+    fake_trigger_port_set_irqs(&fake, irqs, 4);
+
+    const loop_trigger_source_t expected[] = {
+        LOOP_TRIGGER_DATA_READY,   // 2000
+        LOOP_TRIGGER_DATA_READY,   // 4000
+        LOOP_TRIGGER_FALLBACK,     // 7000
+        LOOP_TRIGGER_FALLBACK,     // 9000
+        LOOP_TRIGGER_FALLBACK,     // 11000
+        LOOP_TRIGGER_FALLBACK,     // 13000
+        LOOP_TRIGGER_DATA_READY,   // 14100
+        LOOP_TRIGGER_DATA_READY    // 16100
+    };
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(expected[i], loop_trigger_wait(&trigger));
+    }
+    TEST_ASSERT_EQUAL_UINT64(16100, fake.now_us);
+    TEST_ASSERT_FALSE(trigger.fallback_active);
+    TEST_ASSERT_EQUAL_UINT32(1, trigger.fallback_entries);
+}
+
+void test_loop_trigger_counts_missed_irqs(void) {
+    loop_trigger_t trigger;
+    fake_trigger_port_t fake;
+    fake_trigger_port_init(&fake, &trigger, TEST_PERIOD_US);
+
+    // Two edges arrive while the previous update is still running
+    loop_trigger_signal(&trigger, 100);
+    loop_trigger_signal(&trigger, 2100);
+    fake.now_us = 2500;
+
+    TEST_ASSERT_EQUAL(LOOP_TRIGGER_DATA_READY, loop_trigger_wait(&trigger));
+    TEST_ASSERT_EQUAL_UINT32(1, trigger.missed_irqs);
+    TEST_ASSERT_EQUAL_UINT64(2100, trigger.last_tick_us);
+}
+
+void test_loop_trigger_fallback_skips_after_overrun(void) {
+    loop_trigger_t trigger;
+    fake_trigger_port_t fake;
+    fake_trigger_port_init(&fake, &trigger, TEST_PERIOD_US);
+
+    TEST_ASSERT_EQUAL(LOOP_TRIGGER_FALLBACK, loop_trigger_wait(&trigger));
+
+    // An update that overruns by several periods yields one immediate tick,
+    // not a burst of catch-up ticks
+    fake.now_us += 5 * TEST_PERIOD_US;
+    uint64_t late = fake.now_us;
+    TEST_ASSERT_EQUAL(LOOP_TRIGGER_FALLBACK, loop_trigger_wait(&trigger));
+    TEST_ASSERT_EQUAL_UINT64(late, fake.now_us);
+    TEST_ASSERT_EQUAL(LOOP_TRIGGER_FALLBACK, loop_trigger_wait(&trigger));
+    TEST_ASSERT_EQUAL_UINT64(late + TEST_PERIOD_US, fake.now_us);
+}
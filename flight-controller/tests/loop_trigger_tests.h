@@ -0,0 +1,8 @@
+#pragma once
+#include "unity.h"
+
+void test_loop_trigger_follows_data_ready(void);
+void test_loop_trigger_falls_back_when_silent(void);
+void test_loop_trigger_recovers_from_fallback(void);
+void test_loop_trigger_counts_missed_irqs(void);
+void test_loop_trigger_fallback_skips_after_overrun(void);
@@ -0,0 +1,51 @@
+#include "mock_flash.h"
+#include <string.h>
+
+static int mock_erase(void* ctx, uint32_t offset, uint32_t len) {
+    mock_flash_t* flash = ctx;
+    if (offset % BLACKBOX_SECTOR_SIZE != 0 || len % BLACKBOX_SECTOR_SIZE != 0) return -1;
+    if (offset + len > MOCK_FLASH_SIZE) return -1;
+    memset(&flash->data[offset], 0xFF, len);
+    flash->erases++;
+    return 0;
+}
+
+static int mock_program_page(void* ctx, uint32_t offset, const uint8_t* data) {
+    mock_flash_t* flash = ctx;
+    if (offset % BLACKBOX_PAGE_SIZE != 0 || offset + BLACKBOX_PAGE_SIZE > MOCK_FLASH_SIZE) return -1;
+    for (uint32_t i = 0; i < BLACKBOX_PAGE_SIZE; i++) {
+        if (flash->data[offset + i] != 0xFF) {
+            flash->bad_programs++;
+            break;
+        }
+    }
+    for (uint32_t i = 0; i < BLACKBOX_PAGE_SIZE; i++) {
+        flash->data[offset + i] &= data[i];
+    }
+    flash->programs++;
+    return 0;
+}
+
+static void mock_read(void* ctx, uint32_t offset, uint8_t* dst, size_t len) {
+    mock_flash_t* flash = ctx;
+    memcpy(dst, &flash->data[offset], len);
+}
+
+void mock_flash_init(mock_flash_t* flash) {
+    // Factory state: erased
+    memset(flash->data, 0xFF, sizeof(flash->data));
+    flash->erases = 0;
+    flash->programs = 0;
+    flash->bad_programs = 0;
+}
+
+blackbox_storage_t mock_flash_storage(mock_flash_t* flash) {
+    blackbox_storage_t storage = {
+        .erase = mock_erase,
+        .program_page = mock_program_page,
+        .read = mock_read,
+        .size = MOCK_FLASH_SIZE,
+        .ctx = flash
+    };
+    return storage;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "../src/utils/blackbox.h"
+
+#define MOCK_FLASH_SIZE (64 * 1024)
+
+// NOR flash model: erase sets bytes to 0xFF, programming can only clear bits
+typedef struct {
+    uint8_t data[MOCK_FLASH_SIZE];
+    uint32_t erases;
+    uint32_t programs;
+    uint32_t bad_programs;      // Pages programmed without a prior erase
+} mock_flash_t;
+
+void mock_flash_init(mock_flash_t* flash);
+blackbox_storage_t mock_flash_storage(mock_flash_t* flash);
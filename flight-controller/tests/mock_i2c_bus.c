@@ -0,0 +1,148 @@
+#include "mock_i2c_bus.h"
+#include "../src/drivers/mpu6050.h"
+#include <string.h>
+
+// Pattern left in an async destination while the transfer is in flight
+#define MOCK_IN_FLIGHT_BYTE 0xEE
+
+uint32_t mock_i2c_bus_transfer_us(const mock_i2c_bus_t* mock, size_t bytes) {
+    // 9 clocks per byte (8 data + ACK), rounded up
+    return (uint32_t)((bytes * 9u * 1000000u + mock->baudrate - 1) / mock->baudrate);
+}
+
+static uint8_t read_reg_byte(mock_i2c_bus_t* mock) {
+    uint8_t reg = mock->reg_ptr;
+
+    // The FIFO data port does not auto-increment
+    if (reg == MPU6050_REG_FIFO_R_W) {
+        if (mock->fifo_len == 0) return 0;
+        uint8_t value = mock->fifo[0];
+        memmove(mock->fifo, mock->fifo + 1, --mock->fifo_len);
+        return value;
+    }
+
+    mock->reg_ptr = (mock->reg_ptr + 1) % MOCK_I2C_REG_COUNT;
+    if (reg == MPU6050_REG_FIFO_COUNTH) return (uint8_t)(mock->fifo_len >> 8);
+    if (reg == MPU6050_REG_FIFO_COUNTH + 1) return (uint8_t)mock->fifo_len;
+    if (reg == MPU6050_REG_INT_STATUS) {
+        // Cleared by reading it
+        uint8_t status = mock->regs[reg];
+        mock->regs[reg] = 0;
+        return status;
+    }
+    return mock->regs[reg];
+}
+
+static void write_reg_byte(mock_i2c_bus_t* mock, uint8_t value) {
+    if (mock->reg_ptr == MPU6050_REG_USER_CTRL && (value & MPU6050_USER_CTRL_FIFO_RESET)) {
+        mock->fifo_len = 0;
+        value &= ~MPU6050_USER_CTRL_FIFO_RESET;  // Self-clearing
+    }
+    mock->regs[mock->reg_ptr] = value;
+    mock->reg_ptr = (mock->reg_ptr + 1) % MOCK_I2C_REG_COUNT;
+}
+
+static int mock_write(i2c_bus_t* bus, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    mock_i2c_bus_t* mock = bus->ctx;
+    (void)addr;
+    (void)nostop;
+    if (mock->async_active || len == 0) return -1;
+
+    mock->reg_ptr = src[0] % MOCK_I2C_REG_COUNT;
+    for (size_t i = 1; i < len; i++) {
+        write_reg_byte(mock, src[i]);
+    }
+
+    // Address byte plus payload
+    mock->blocked_us += mock_i2c_bus_transfer_us(mock, len + 1);
+    mock->now_us += mock_i2c_bus_transfer_us(mock, len + 1);
+    return (int)len;
+}
+
+static int mock_read(i2c_bus_t* bus, uint8_t addr, uint8_t* dst, size_t len, bool nostop) {
+    mock_i2c_bus_t* mock = bus->ctx;
+    (void)addr;
+    (void)nostop;
+    if (mock->async_active) return -1;
+
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = read_reg_byte(mock);
+    }
+
+    mock->blocked_us += mock_i2c_bus_transfer_us(mock, len + 1);
+    mock->now_us += mock_i2c_bus_transfer_us(mock, len + 1);
+    return (int)len;
+}
+
+static bool mock_read_reg_async(i2c_bus_t* bus, uint8_t addr, uint8_t reg, uint8_t* dst, size_t len) {
+    mock_i2c_bus_t* mock = bus->ctx;
+    (void)addr;
+    if (mock->async_active) return false;
+
+    memset(dst, MOCK_IN_FLIGHT_BYTE, len);
+    mock->async_active = true;
+    mock->async_reg = reg;
+    mock->async_dst = dst;
+    mock->async_len = len;
+    // Write address + register, restart, read address + payload
+    mock->async_done_us = mock->now_us + mock_i2c_bus_transfer_us(mock, len + 3);
+    mock->async_count++;
+    return true;
+}
+
+static i2c_bus_status_t mock_poll(i2c_bus_t* bus) {
+    mock_i2c_bus_t* mock = bus->ctx;
+    if (!mock->async_active) return I2C_BUS_IDLE;
+    if (mock->now_us < mock->async_done_us) return I2C_BUS_BUSY;
+
+    mock->async_active = false;
+    if (mock->fail_next_async) {
+        mock->fail_next_async = false;
+        return I2C_BUS_ERROR;
+    }
+
+    mock->reg_ptr = mock->async_reg;
+    for (size_t i = 0; i < mock->async_len; i++) {
+        mock->async_dst[i] = read_reg_byte(mock);
+    }
+    return I2C_BUS_DONE;
+}
+
+static const i2c_bus_ops_t MOCK_I2C_BUS_OPS = {
+    .write = mock_write,
+    .read = mock_read,
+    .read_reg_async = mock_read_reg_async,
+    .poll = mock_poll
+};
+
+void mock_i2c_bus_init(mock_i2c_bus_t* mock, uint32_t baudrate) {
+    memset(mock, 0, sizeof(*mock));
+    mock->baudrate = baudrate;
+    mock->regs[MPU6050_REG_WHO_AM_I] = MPU6050_ADDR;
+    mock->bus.ops = &MOCK_I2C_BUS_OPS;
+    mock->bus.ctx = mock;
+}
+
+void mock_i2c_bus_advance_us(mock_i2c_bus_t* mock, uint64_t us) {
+    mock->now_us += us;
+}
+
+void mock_i2c_bus_set_sample(mock_i2c_bus_t* mock, const int16_t accel[3], const int16_t gyro[3]) {
+    for (int i = 0; i < 3; i++) {
+        mock->regs[MPU6050_REG_ACCEL_XOUT_H + 2 * i] = (uint8_t)((uint16_t)accel[i] >> 8);
+        mock->regs[MPU6050_REG_ACCEL_XOUT_H + 2 * i + 1] = (uint8_t)accel[i];
+        mock->regs[MPU6050_REG_GYRO_XOUT_H + 2 * i] = (uint8_t)((uint16_t)gyro[i] >> 8);
+        mock->regs[MPU6050_REG_GYRO_XOUT_H + 2 * i + 1] = (uint8_t)gyro[i];
+    }
+    mock->regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_DATA_RDY;
+}
+
+void mock_i2c_bus_push_fifo(mock_i2c_bus_t* mock, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (mock->fifo_len == MOCK_I2C_FIFO_SIZE) {
+            memmove(mock->fifo, mock->fifo + 1, --mock->fifo_len);
+            mock->regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_FIFO_OFLOW;
+        }
+        mock->fifo[mock->fifo_len++] = data[i];
+    }
+}
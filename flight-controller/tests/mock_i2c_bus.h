@@ -0,0 +1,41 @@
+#pragma once
+#include "../src/drivers/i2c_bus.h"
+
+#define MOCK_I2C_REG_COUNT 128
+#define MOCK_I2C_FIFO_SIZE 1024
+
+// Register-file model of an I2C device with a simulated clock. Blocking
+// transfers charge their bus time to blocked_us; asynchronous reads only
+// complete once the clock has been advanced past their bus time.
+typedef struct {
+    i2c_bus_t bus;
+    uint8_t regs[MOCK_I2C_REG_COUNT];
+    uint8_t reg_ptr;
+    uint32_t baudrate;
+
+    // MPU6050 FIFO: FIFO_COUNTH/L report fifo_len, FIFO_R_W pops bytes
+    uint8_t fifo[MOCK_I2C_FIFO_SIZE];
+    size_t fifo_len;
+
+    uint64_t now_us;
+    uint64_t blocked_us;
+
+    bool async_active;
+    uint8_t async_reg;
+    uint8_t* async_dst;
+    size_t async_len;
+    uint64_t async_done_us;
+    uint32_t async_count;
+    bool fail_next_async;
+} mock_i2c_bus_t;
+
+void mock_i2c_bus_init(mock_i2c_bus_t* mock, uint32_t baudrate);
+void mock_i2c_bus_advance_us(mock_i2c_bus_t* mock, uint64_t us);
+uint32_t mock_i2c_bus_transfer_us(const mock_i2c_bus_t* mock, size_t bytes);
+
+// Append bytes to the FIFO, dropping the oldest ones when it is full
+void mock_i2c_bus_push_fifo(mock_i2c_bus_t* mock, const uint8_t* data, size_t len);
+
+// Load ACCEL_XOUT_H..GYRO_ZOUT_L with big-endian samples and set DATA_RDY
+// in INT_STATUS, which reading INT_STATUS clears
+void mock_i2c_bus_set_sample(mock_i2c_bus_t* mock, const int16_t accel[3], const int16_t gyro[3]);
@@ -0,0 +1,202 @@
+#include "mpu6050_async_tests.h"
+#include "mock_i2c_bus.h"
+#include "../src/drivers/mpu6050.h"
+#include <stdlib.h>
+
+#define TEST_I2C_FREQ 400000
+#define TEST_CYCLE_US 2000
+
+static const mpu6050_config_t TEST_CONFIG = {
+    .gyro_range = 1,
+    .accel_range = 1,
+    .dlpf_bandwidth = 2,
+    .sample_rate_div = 0
+};
+
+static const int16_t SAMPLE_A_ACCEL[3] = {100, -200, 8192};
+static const int16_t SAMPLE_A_GYRO[3] = {-5, 6, -32768};
+static const int16_t SAMPLE_B_ACCEL[3] = {-1000, 2000, 4096};
+static const int16_t SAMPLE_B_GYRO[3] = {32767, 0, 42};
+
+static mpu6050_t* init_with_mock(mock_i2c_bus_t* mock) {
+    mock_i2c_bus_init(mock, TEST_I2C_FREQ);
+    mpu6050_t* dev = mpu6050_init_with_bus(&mock->bus, &TEST_CONFIG);
+    TEST_ASSERT_NOT_NULL(dev);
+    return dev;
+}
+
+static void assert_sample(mpu6050_t* dev, const int16_t accel[3], const int16_t gyro[3]) {
+    vector3_t a, g;
+    TEST_ASSERT_TRUE(mpu6050_read_async_complete(dev, &a, &g));
+    TEST_ASSERT_EQUAL_FLOAT(accel[0], a.x);
+    TEST_ASSERT_EQUAL_FLOAT(accel[1], a.y);
+    TEST_ASSERT_EQUAL_FLOAT(accel[2], a.z);
+    TEST_ASSERT_EQUAL_FLOAT(gyro[0], g.x);
+    TEST_ASSERT_EQUAL_FLOAT(gyro[1], g.y);
+    TEST_ASSERT_EQUAL_FLOAT(gyro[2], g.z);
+}
+
+void test_mpu6050_async_decodes_burst(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_with_mock(&mock);
+    mock_i2c_bus_set_sample(&mock, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+
+    vector3_t a, g;
+    TEST_ASSERT_EQUAL(MPU6050_ASYNC_EMPTY, mpu6050_read_async_poll(dev));
+    TEST_ASSERT_FALSE(mpu6050_read_async_complete(dev, &a, &g));
+
+    TEST_ASSERT_TRUE(mpu6050_read_async_start(dev));
+    TEST_ASSERT_EQUAL(MPU6050_ASYNC_BUSY, mpu6050_read_async_poll(dev));
+
+    // INT_STATUS and 14 data bytes plus address, register and
+    // repeated-start address
+    mock_i2c_bus_advance_us(&mock, mock_i2c_bus_transfer_us(&mock, 18));
+    TEST_ASSERT_EQUAL(MPU6050_ASYNC_READY, mpu6050_read_async_poll(dev));
+    TEST_ASSERT_EQUAL(MPU6050_ASYNC_IDLE, mpu6050_read_async_poll(dev));
+    assert_sample(dev, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+
+    free(dev);
+}
+
+void test_mpu6050_async_double_buffer(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_with_mock(&mock);
+
+    mock_i2c_bus_set_sample(&mock, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+    mpu6050_read_async_start(dev);
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    mpu6050_read_async_poll(dev);
+
+    // The back slot is full of in-flight garbage; readers must still see A
+    mock_i2c_bus_set_sample(&mock, SAMPLE_B_ACCEL, SAMPLE_B_GYRO);
+    TEST_ASSERT_TRUE(mpu6050_read_async_start(dev));
+    TEST_ASSERT_EQUAL(MPU6050_ASYNC_BUSY, mpu6050_read_async_poll(dev));
+    assert_sample(dev, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    TEST_ASSERT_EQUAL(MPU6050_ASYNC_READY, mpu6050_read_async_poll(dev));
+    assert_sample(dev, SAMPLE_B_ACCEL, SAMPLE_B_GYRO);
+
+    // And the slots keep alternating
+    mock_i2c_bus_set_sample(&mock, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+    mpu6050_read_async_start(dev);
+    assert_sample(dev, SAMPLE_B_ACCEL, SAMPLE_B_GYRO);
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    mpu6050_read_async_poll(dev);
+    assert_sample(dev, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+
+    free(dev);
+}
+
+void test_mpu6050_async_rejects_overlap(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_with_mock(&mock);
+
+    TEST_ASSERT_TRUE(mpu6050_read_async_start(dev));
+    TEST_ASSERT_FALSE(mpu6050_read_async_start(dev));
+    TEST_ASSERT_EQUAL_UINT32(1, mock.async_count);
+
+    free(dev);
+}
+
+void test_mpu6050_async_error_keeps_previous(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_with_mock(&mock);
+
+    mock_i2c_bus_set_sample(&mock, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+    mpu6050_read_async_start(dev);
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    mpu6050_read_async_poll(dev);
+
+    mock.fail_next_async = true;
+    mock_i2c_bus_set_sample(&mock, SAMPLE_B_ACCEL, SAMPLE_B_GYRO);
+    mpu6050_read_async_start(dev);
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    TEST_ASSERT_EQUAL(MPU6050_ASYNC_ERROR, mpu6050_read_async_poll(dev));
+    TEST_ASSERT_EQUAL_UINT32(1, mpu6050_async_error_count(dev));
+    assert_sample(dev, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+
+    // The bus is usable again after an aborted burst
+    TEST_ASSERT_TRUE(mpu6050_read_async_start(dev));
+
+    free(dev);
+}
+
+void test_mpu6050_async_does_not_block(void) {
+    const int cycles = 100;
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_with_mock(&mock);
+    mock_i2c_bus_set_sample(&mock, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+
+    // Blocking reads: every cycle spends the whole burst on the bus
+    uint64_t blocked_before = mock.blocked_us;
+    for (int i = 0; i < cycles; i++) {
+        vector3_t a, g;
+        mpu6050_read_raw(dev, &a, &g);
+        mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    }
+    uint64_t blocking_cost = mock.blocked_us - blocked_before;
+    TEST_ASSERT_GREATER_OR_EQUAL(cycles * mock_i2c_bus_transfer_us(&mock, 17), blocking_cost);
+
+    // Pipelined reads: the control cycle never waits on the bus and only
+    // the first cycle lacks a sample
+    blocked_before = mock.blocked_us;
+    int missing = 0;
+    for (int i = 0; i < cycles; i++) {
+        vector3_t a, g;
+        mpu6050_read_async_poll(dev);
+        if (!mpu6050_read_async_complete(dev, &a, &g)) missing++;
+        TEST_ASSERT_TRUE(mpu6050_read_async_start(dev));
+        mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    }
+    TEST_ASSERT_EQUAL_UINT64(0, mock.blocked_us - blocked_before);
+    TEST_ASSERT_EQUAL(1, missing);
+    TEST_ASSERT_EQUAL_UINT32(cycles, mock.async_count);
+
+    free(dev);
+}
+
+void test_mpu6050_async_averages_fresh_samples(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_with_mock(&mock);
+    vector3_t a, g;
+    TEST_ASSERT_EQUAL_INT(-1, mpu6050_read_average(dev, &a, &g));
+
+    // Two sensor updates, each read by one burst
+    mock_i2c_bus_set_sample(&mock, SAMPLE_A_ACCEL, SAMPLE_A_GYRO);
+    mpu6050_read_async_start(dev);
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    mpu6050_read_async_poll(dev);
+    mock_i2c_bus_set_sample(&mock, SAMPLE_B_ACCEL, SAMPLE_B_GYRO);
+    mpu6050_read_async_start(dev);
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    mpu6050_read_async_poll(dev);
+
+    TEST_ASSERT_EQUAL_INT(2, mpu6050_read_average(dev, &a, &g));
+    TEST_ASSERT_EQUAL_FLOAT(-450.0f, a.x);
+    TEST_ASSERT_EQUAL_FLOAT(900.0f, a.y);
+    TEST_ASSERT_EQUAL_FLOAT(6144.0f, a.z);
+    TEST_ASSERT_EQUAL_FLOAT(16381.0f, g.x);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, g.y);
+    TEST_ASSERT_EQUAL_FLOAT(-16363.0f, g.z);
+
+    // A burst with DATA_RDY clear repeats B: it is counted, not summed,
+    // and the previous mean is held
+    mpu6050_read_async_start(dev);
+    mock_i2c_bus_advance_us(&mock, TEST_CYCLE_US);
+    mpu6050_read_async_poll(dev);
+    vector3_t a2, g2;
+    TEST_ASSERT_EQUAL_INT(0, mpu6050_read_average(dev, &a2, &g2));
+    TEST_ASSERT_EQUAL_FLOAT(a.x, a2.x);
+    TEST_ASSERT_EQUAL_FLOAT(g.z, g2.z);
+
+    const mpu6050_sample_stats_t* stats = mpu6050_get_sample_stats(dev);
+    TEST_ASSERT_EQUAL_UINT32(2, stats->fresh);
+    TEST_ASSERT_EQUAL_UINT32(1, stats->duplicates);
+
+    free(dev);
+}
+
+void test_mpu6050_init_without_bus_fails(void) {
+    TEST_ASSERT_NULL(mpu6050_init_with_bus(NULL, &TEST_CONFIG));
+}
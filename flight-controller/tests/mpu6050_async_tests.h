@@ -0,0 +1,10 @@
+#pragma once
+#include "unity.h"
+
+void test_mpu6050_async_decodes_burst(void);
+void test_mpu6050_async_double_buffer(void);
+void test_mpu6050_async_rejects_overlap(void);
+void test_mpu6050_async_error_keeps_previous(void);
+void test_mpu6050_async_does_not_block(void);
+void test_mpu6050_async_averages_fresh_samples(void);
+void test_mpu6050_init_without_bus_fails(void);
@@ -0,0 +1,202 @@
+#include "mpu6050_fifo_tests.h"
+#include "mock_i2c_bus.h"
+#include "../src/drivers/mpu6050.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const mpu6050_config_t TEST_CONFIG = {
+    .gyro_range = 1,
+    .accel_range = 1,
+    .dlpf_bandwidth = 1,
+    .sample_rate_div = 0
+};
+
+// Build a FIFO frame whose six words are base, base+1, ... base+5
+static void make_frame(uint8_t* out, int16_t base) {
+    for (int i = 0; i < 6; i++) {
+        uint16_t word = (uint16_t)(base + i);
+        out[2 * i] = (uint8_t)(word >> 8);
+        out[2 * i + 1] = (uint8_t)word;
+    }
+}
+
+static void assert_frame(const mpu6050_fifo_frame_t* frame, int16_t base, uint32_t seq) {
+    TEST_ASSERT_EQUAL_FLOAT(base, frame->accel.x);
+    TEST_ASSERT_EQUAL_FLOAT(base + 1, frame->accel.y);
+    TEST_ASSERT_EQUAL_FLOAT(base + 2, frame->accel.z);
+    TEST_ASSERT_EQUAL_FLOAT(base + 3, frame->gyro.x);
+    TEST_ASSERT_EQUAL_FLOAT(base + 4, frame->gyro.y);
+    TEST_ASSERT_EQUAL_FLOAT(base + 5, frame->gyro.z);
+    TEST_ASSERT_EQUAL_UINT32(seq, frame->seq);
+}
+
+static mpu6050_t* init_fifo_with_mock(mock_i2c_bus_t* mock) {
+    mock_i2c_bus_init(mock, 400000);
+    mpu6050_t* dev = mpu6050_init_with_bus(&mock->bus, &TEST_CONFIG);
+    TEST_ASSERT_NOT_NULL(dev);
+    TEST_ASSERT_TRUE(mpu6050_fifo_enable(dev));
+    return dev;
+}
+
+static void push_frames(mock_i2c_bus_t* mock, int count, int16_t base) {
+    uint8_t frame[MPU6050_FIFO_FRAME_LEN];
+    for (int i = 0; i < count; i++) {
+        make_frame(frame, (int16_t)(base + 10 * i));
+        mock_i2c_bus_push_fifo(mock, frame, sizeof(frame));
+    }
+}
+
+void test_mpu6050_fifo_parse_frames(void) {
+    uint8_t dump[3 * MPU6050_FIFO_FRAME_LEN + 5];
+    make_frame(&dump[0], -32768);
+    make_frame(&dump[12], 0);
+    make_frame(&dump[24], 32000);
+    memset(&dump[36], 0xAA, 5);  // Partial frame still being written
+
+    mpu6050_fifo_frame_t frames[4];
+    mpu6050_fifo_stats_t stats = {0};
+    stats.next_seq = 7;
+
+    TEST_ASSERT_EQUAL(3, mpu6050_fifo_parse(dump, sizeof(dump), frames, 4, &stats));
+    assert_frame(&frames[0], -32768, 7);
+    assert_frame(&frames[1], 0, 8);
+    assert_frame(&frames[2], 32000, 9);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.next_seq);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.frames);
+}
+
+void test_mpu6050_fifo_parse_respects_max(void) {
+    uint8_t dump[5 * MPU6050_FIFO_FRAME_LEN];
+    for (int i = 0; i < 5; i++) make_frame(&dump[i * MPU6050_FIFO_FRAME_LEN], (int16_t)i);
+
+    mpu6050_fifo_frame_t frames[2];
+    mpu6050_fifo_stats_t stats = {0};
+
+    TEST_ASSERT_EQUAL(2, mpu6050_fifo_parse(dump, sizeof(dump), frames, 2, &stats));
+    assert_frame(&frames[1], 1, 1);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.next_seq);
+}
+
+void test_mpu6050_fifo_enable_configures_registers(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_fifo_with_mock(&mock);
+
+    TEST_ASSERT_EQUAL_HEX8(0x78, mock.regs[MPU6050_REG_FIFO_EN]);
+    TEST_ASSERT_EQUAL_HEX8(MPU6050_USER_CTRL_FIFO_EN, mock.regs[MPU6050_REG_USER_CTRL]);
+    TEST_ASSERT_TRUE(mock.regs[MPU6050_REG_INT_ENABLE] & MPU6050_INT_FIFO_OFLOW);
+
+    free(dev);
+}
+
+void test_mpu6050_fifo_drain_sequences(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_fifo_with_mock(&mock);
+    mpu6050_fifo_frame_t frames[8];
+
+    TEST_ASSERT_EQUAL(0, mpu6050_fifo_drain(dev, frames, 8));
+
+    push_frames(&mock, 3, 100);
+    uint8_t half[5] = {0};
+    mock_i2c_bus_push_fifo(&mock, half, sizeof(half));
+    TEST_ASSERT_EQUAL(3, mpu6050_fifo_drain(dev, frames, 8));
+    assert_frame(&frames[0], 100, 0);
+    assert_frame(&frames[2], 120, 2);
+    TEST_ASSERT_EQUAL(5, mock.fifo_len);  // Partial frame stays queued
+
+    // Finish the partial frame and queue one more
+    uint8_t rest[7] = {0};
+    mock_i2c_bus_push_fifo(&mock, rest, sizeof(rest));
+    push_frames(&mock, 1, 500);
+    TEST_ASSERT_EQUAL(2, mpu6050_fifo_drain(dev, frames, 8));
+    assert_frame(&frames[1], 500, 4);
+
+    const mpu6050_fifo_stats_t* stats = mpu6050_fifo_get_stats(dev);
+    TEST_ASSERT_EQUAL_UINT32(5, stats->frames);
+    TEST_ASSERT_EQUAL_UINT32(2, stats->drains);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->overflows);
+
+    free(dev);
+}
+
+void test_mpu6050_fifo_drain_overflow(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_fifo_with_mock(&mock);
+    mpu6050_fifo_frame_t frames[8];
+
+    push_frames(&mock, MPU6050_FIFO_MAX_FRAMES + 4, 0);
+    TEST_ASSERT_EQUAL(MOCK_I2C_FIFO_SIZE, mock.fifo_len);
+
+    TEST_ASSERT_EQUAL(0, mpu6050_fifo_drain(dev, frames, 8));
+    TEST_ASSERT_EQUAL(0, mock.fifo_len);
+
+    const mpu6050_fifo_stats_t* stats = mpu6050_fifo_get_stats(dev);
+    TEST_ASSERT_EQUAL_UINT32(1, stats->overflows);
+    TEST_ASSERT_EQUAL_UINT32(MOCK_I2C_FIFO_SIZE / MPU6050_FIFO_FRAME_LEN, stats->lost_frames);
+
+    // Sequence numbers skip over the discarded frames
+    push_frames(&mock, 1, 42);
+    TEST_ASSERT_EQUAL(1, mpu6050_fifo_drain(dev, frames, 8));
+    assert_frame(&frames[0], 42, stats->lost_frames);
+
+    free(dev);
+}
+
+void test_mpu6050_fifo_drain_overflow_status(void) {
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_fifo_with_mock(&mock);
+    mpu6050_fifo_frame_t frames[8];
+
+    // A wrap the count does not show, as when the FIFO overflows between
+    // the count read and the data read: the frames read are dropped
+    push_frames(&mock, 2, 0);
+    mock.regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_FIFO_OFLOW;
+    TEST_ASSERT_EQUAL(0, mpu6050_fifo_drain(dev, frames, 8));
+    TEST_ASSERT_EQUAL(0, mock.fifo_len);
+    TEST_ASSERT_EQUAL_HEX8(0, mock.regs[MPU6050_REG_INT_STATUS]);
+
+    const mpu6050_fifo_stats_t* stats = mpu6050_fifo_get_stats(dev);
+    TEST_ASSERT_EQUAL_UINT32(1, stats->overflows);
+    TEST_ASSERT_EQUAL_UINT32(2, stats->lost_frames);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->frames);
+
+    // An overflow cleared by an asynchronous burst's status read is kept
+    // for the next drain
+    mock.regs[MPU6050_REG_INT_STATUS] |= MPU6050_INT_FIFO_OFLOW;
+    TEST_ASSERT_TRUE(mpu6050_read_async_start(dev));
+    mock_i2c_bus_advance_us(&mock, 1000);
+    mpu6050_read_async_poll(dev);
+    TEST_ASSERT_EQUAL_HEX8(0, mock.regs[MPU6050_REG_INT_STATUS]);
+    push_frames(&mock, 1, 0);
+    TEST_ASSERT_EQUAL(0, mpu6050_fifo_drain(dev, frames, 8));
+    TEST_ASSERT_EQUAL_UINT32(2, stats->overflows);
+
+    // Then drains carry on
+    push_frames(&mock, 1, 42);
+    TEST_ASSERT_EQUAL(1, mpu6050_fifo_drain(dev, frames, 8));
+    assert_frame(&frames[0], 42, 3);
+
+    free(dev);
+}
+
+void test_mpu6050_fifo_drain_amortizes_bus(void) {
+    const int samples = 8;
+    mock_i2c_bus_t mock;
+    mpu6050_t* dev = init_fifo_with_mock(&mock);
+
+    uint64_t before = mock.blocked_us;
+    for (int i = 0; i < samples; i++) {
+        vector3_t a, g;
+        mpu6050_read_raw(dev, &a, &g);
+    }
+    uint64_t per_sample_cost = mock.blocked_us - before;
+
+    mpu6050_fifo_frame_t frames[8];
+    push_frames(&mock, samples, 0);
+    before = mock.blocked_us;
+    TEST_ASSERT_EQUAL(samples, mpu6050_fifo_drain(dev, frames, samples));
+    uint64_t batch_cost = mock.blocked_us - before;
+
+    TEST_ASSERT_LESS_THAN(per_sample_cost, batch_cost);
+
+    free(dev);
+}
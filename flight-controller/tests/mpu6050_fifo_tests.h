@@ -0,0 +1,10 @@
+#pragma once
+#include "unity.h"
+
+void test_mpu6050_fifo_parse_frames(void);
+void test_mpu6050_fifo_parse_respects_max(void);
+void test_mpu6050_fifo_enable_configures_registers(void);
+void test_mpu6050_fifo_drain_sequences(void);
+void test_mpu6050_fifo_drain_overflow(void);
+void test_mpu6050_fifo_drain_overflow_status(void);
+void test_mpu6050_fifo_drain_amortizes_bus(void);
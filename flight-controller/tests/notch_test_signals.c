@@ -0,0 +1,20 @@
+#include "notch_test_signals.h"
+#include <math.h>
+
+float tone_amplitude(const float* x, int n, float hz) {
+    float s = 0.0f, c = 0.0f;
+    for (int i = 0; i < n; i++) {
+        s += x[i] * sinf(TWO_PI_F * hz * (float)i * SAMPLE_DT);
+        c += x[i] * cosf(TWO_PI_F * hz * (float)i * SAMPLE_DT);
+    }
+    return 2.0f * sqrtf(s * s + c * c) / (float)n;
+}
+
+int count_nonzero(const float* first, int count, size_t stride) {
+    const char* p = (const char*)first;
+    int nonzero = 0;
+    for (int i = 0; i < count; i++) {
+        if (*(const float*)(p + (size_t)i * stride) != 0.0f) nonzero++;
+    }
+    return nonzero;
+}
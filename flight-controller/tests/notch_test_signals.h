@@ -0,0 +1,15 @@
+#pragma once
+#include <stddef.h>
+
+// Gyro signals shared by the dynamic and RPM notch tests, sampled at
+// SAMPLE_HZ
+#define SAMPLE_HZ 1000.0f
+#define SAMPLE_DT (1.0f / SAMPLE_HZ)
+#define TWO_PI_F  6.28318531f
+
+// Amplitude of the hz component of x[0 .. n-1], n a whole number of periods
+float tone_amplitude(const float* x, int n, float hz);
+
+// How many of count values, stride bytes apart from the first, are not 0:
+// the notches that are on, from their centers
+int count_nonzero(const float* first, int count, size_t stride);
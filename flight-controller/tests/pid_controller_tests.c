@@ -40,3 +40,108 @@ void test_pid_output_limits(void) {
     
     free(pid);
 }
+
+void test_pid_integrates_once_per_update(void) {
+    pid_controller_t* pid = pid_controller_init(0.0f, 1.0f, 0.0f);
+    pid_controller_set_limits(pid, 10.0f, 10.0f);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.1f, pid_controller_update(pid, 1.0f, 0.1f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.2f, pid_controller_update(pid, 1.0f, 0.1f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.2f, pid->integral);
+
+    // Saturated and pushing further: the integral holds
+    pid_controller_set_limits(pid, 0.25f, 10.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.25f, pid_controller_update(pid, 1.0f, 0.1f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.2f, pid->integral);
+
+    free(pid);
+}
+
+void test_pid_derivative_on_measurement(void) {
+    pid_controller_t* on_error = pid_controller_init(0.0f, 0.0f, 1.0f);
+    pid_controller_t* on_measurement = pid_controller_init(0.0f, 0.0f, 1.0f);
+
+    // A setpoint step kicks the derivative of the error only
+    pid_controller_update(on_error, 0.0f, 0.1f);
+    pid_controller_update_dom(on_measurement, 0.0f, 0.0f, 0.1f);
+    pid_controller_update(on_error, 1.0f, 0.1f);
+    pid_controller_update_dom(on_measurement, 1.0f, 0.0f, 0.1f);
+    TEST_ASSERT_TRUE(on_error->d_term > 0.5f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, on_measurement->d_term);
+
+    // A falling measurement gives the same kick
+    pid_controller_update_dom(on_measurement, 1.0f, -1.0f, 0.1f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, on_error->d_term, on_measurement->d_term);
+
+    free(on_error);
+    free(on_measurement);
+}
+
+void test_pid_axes_match_scalar(void) {
+    const float gains[PID_AXES][3] = { { 0.5f, 0.2f, 0.1f }, { 0.3f, 0.4f, 0.05f },
+                                       { 0.8f, 0.1f, 0.0f } };
+    pid_axes_t axes, axes_dom;
+    pid_controller_t* scalar[PID_AXES];
+    pid_controller_t* scalar_dom[PID_AXES];
+    uint32_t state = 3;
+
+    TEST_ASSERT_FALSE(pid_axes_init(&axes, 0.0f));
+    TEST_ASSERT_TRUE(pid_axes_init(&axes, 0.01f));
+    TEST_ASSERT_TRUE(pid_axes_init(&axes_dom, 0.01f));
+    for (int a = 0; a < PID_AXES; a++) {
+        pid_axes_set_gains(&axes, a, gains[a][0], gains[a][1], gains[a][2]);
+        pid_axes_set_gains(&axes_dom, a, gains[a][0], gains[a][1], gains[a][2]);
+        pid_axes_set_limits(&axes, a, 1.0f, 2.0f);
+        pid_axes_set_limits(&axes_dom, a, 1.0f, 2.0f);
+        scalar[a] = pid_controller_init(gains[a][0], gains[a][1], gains[a][2]);
+        scalar_dom[a] = pid_controller_init(gains[a][0], gains[a][1], gains[a][2]);
+        pid_controller_set_limits(scalar[a], 1.0f, 2.0f);
+        pid_controller_set_limits(scalar_dom[a], 1.0f, 2.0f);
+    }
+
+    // Small errors, then large ones that saturate; halfway the rate changes
+    float dt = 0.01f;
+    for (int i = 0; i < 400; i++) {
+        if (i == 200) {
+            dt = 0.004f;
+            TEST_ASSERT_TRUE(pid_axes_set_dt(&axes, dt));
+            TEST_ASSERT_TRUE(pid_axes_set_dt(&axes_dom, dt));
+        }
+        float scale = i < 100 ? 0.2f : 5.0f;
+        float e[PID_AXES], m[PID_AXES];
+        for (int a = 0; a < PID_AXES; a++) {
+            state = state * 1664525u + 1013904223u;
+            e[a] = scale * ((float)(state >> 8) / 8388608.0f - 1.0f);
+            m[a] = -0.5f * e[a];
+        }
+        const vector3_t error = { e[0], e[1], e[2] };
+        const vector3_t measurement = { m[0], m[1], m[2] };
+        const vector3_t setpoint = { e[0] + m[0], e[1] + m[1], e[2] + m[2] };
+        vector3_t out, out_dom;
+        pid_axes_update(&axes, &error, &out);
+        pid_axes_update_dom(&axes_dom, &setpoint, &measurement, &out_dom);
+        const float o[PID_AXES] = { out.x, out.y, out.z };
+        const float o_dom[PID_AXES] = { out_dom.x, out_dom.y, out_dom.z };
+
+        for (int a = 0; a < PID_AXES; a++) {
+            float expected = pid_controller_update(scalar[a], e[a], dt);
+            float expected_dom = pid_controller_update_dom(scalar_dom[a], e[a] + m[a], m[a], dt);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected, o[a]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected_dom, o_dom[a]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f, scalar[a]->i_term, axes.i_term[a]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, scalar[a]->d_term, axes.d_term[a]);
+        }
+    }
+
+    // Back to a scalar controller, state included
+    pid_controller_t roll;
+    pid_axes_get(&axes, PID_AXIS_ROLL, &roll);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, scalar[0]->integral, roll.integral);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, scalar[0]->derivative_lpf, roll.derivative_lpf);
+    TEST_ASSERT_EQUAL_FLOAT(scalar[0]->prev_error, roll.prev_error);
+
+    for (int a = 0; a < PID_AXES; a++) {
+        free(scalar[a]);
+        free(scalar_dom[a]);
+    }
+}
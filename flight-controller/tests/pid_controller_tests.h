@@ -4,3 +4,6 @@
 void test_pid_initialization(void);
 void test_pid_reset(void);
 void test_pid_output_limits(void);
+void test_pid_integrates_once_per_update(void);
+void test_pid_derivative_on_measurement(void);
+void test_pid_axes_match_scalar(void);
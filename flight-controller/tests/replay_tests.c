@@ -0,0 +1,136 @@
+#include "replay_tests.h"
+#include "core/mixer.h"
+#include "include/config.h"
+#include <string.h>
+
+void test_mixer_quad_x(void) {
+    float m[4];
+
+    mixer_quad_x(0.5f, 0.0f, 0.0f, 0.0f, m);
+    for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL_FLOAT(0.5f, m[i]);
+
+    // Each axis command raises one diagonal pair and lowers the other, so
+    // the total thrust is unchanged
+    mixer_quad_x(0.5f, 0.1f, 0.0f, 0.0f, m);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.6f, m[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.4f, m[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.4f, m[2]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.6f, m[3]);
+
+    mixer_quad_x(0.5f, 0.1f, -0.2f, 0.05f, m);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0f, m[0] + m[1] + m[2] + m[3]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.45f, m[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.15f, m[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.65f, m[2]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.75f, m[3]);
+}
+
+#ifdef HOST_BUILD
+// The replay runs the flight stack on the Linux HAL
+#include "../tools/replay/replay.h"
+
+#define TRACE_LEN 200
+
+static replay_sample_t trace[TRACE_LEN];
+static replay_sample_t rerun[TRACE_LEN];
+
+static void run_trace(replay_sample_t* samples) {
+    replay_t replay;
+    TEST_ASSERT_TRUE(replay_init(&replay, DT));
+    replay_run(&replay, samples, TRACE_LEN);
+    replay_free(&replay);
+}
+
+void test_replay_parse_line(void) {
+    replay_sample_t s;
+
+    TEST_ASSERT_EQUAL_INT(REPLAY_INPUT_COLUMNS,
+                          replay_parse_line("2000,0,0.1,1,5,-5,0.5,10,-5,0,0.5\n", &s));
+    TEST_ASSERT_EQUAL_UINT64(2000, s.time_us);
+    TEST_ASSERT_EQUAL_FLOAT(0.1f, s.accel.y);
+    TEST_ASSERT_EQUAL_FLOAT(-5.0f, s.gyro.y);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, s.setpoint[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, s.setpoint[3]);
+
+    TEST_ASSERT_EQUAL_INT(REPLAY_CSV_COLUMNS,
+                          replay_parse_line("4000,0,0,1,0,0,0,0,0,0,0.5,1,0,0,0,0.5,0.25,0.5,0.75\r\n", &s));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, s.quaternion.q0);
+    TEST_ASSERT_EQUAL_FLOAT(0.75f, s.motor[3]);
+
+    // Partial reference columns, junk and truncated lines are rejected
+    TEST_ASSERT_EQUAL_INT(0, replay_parse_line("4000,0,0,1,0,0,0,0,0,0,0.5,1,0,0\n", &s));
+    TEST_ASSERT_EQUAL_INT(0, replay_parse_line("4000,0,0,1,0,0,0,0,0,0,0.5x\n", &s));
+    TEST_ASSERT_EQUAL_INT(0, replay_parse_line("time_us,ax\n", &s));
+}
+
+void test_replay_is_deterministic(void) {
+    replay_synthesize(trace, TRACE_LEN, DT, 7);
+    run_trace(trace);
+
+    // Re-running the inputs from fresh state reproduces the outputs exactly
+    memcpy(rerun, trace, sizeof(trace));
+    for (int i = 0; i < TRACE_LEN; i++) {
+        memset(&rerun[i].quaternion, 0, sizeof(rerun[i].quaternion));
+        memset(rerun[i].motor, 0, sizeof(rerun[i].motor));
+    }
+    run_trace(rerun);
+
+    replay_diff_t diff;
+    replay_compare(rerun, trace, TRACE_LEN, 0.0f, 0.0f, &diff);
+    TEST_ASSERT_EQUAL_UINT(TRACE_LEN, diff.compared);
+    TEST_ASSERT_EQUAL_UINT(0, diff.mismatches);
+
+    // The synthetic flight starts level and stays a unit quaternion
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, trace[0].quaternion.q0);
+    const quaternion_t* q = &trace[TRACE_LEN - 1].quaternion;
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, q->q0 * q->q0 + q->q1 * q->q1 +
+                                          q->q2 * q->q2 + q->q3 * q->q3);
+}
+
+void test_replay_reports_first_mismatch(void) {
+    replay_synthesize(trace, TRACE_LEN, DT, 3);
+    run_trace(trace);
+    memcpy(rerun, trace, sizeof(trace));
+
+    rerun[57].motor[2] += 1e-3f;
+    rerun[120].quaternion.q1 -= 5e-3f;
+
+    replay_diff_t diff;
+    replay_compare(rerun, trace, TRACE_LEN, 1e-4f, 1e-4f, &diff);
+    TEST_ASSERT_EQUAL_UINT(2, diff.mismatches);
+    TEST_ASSERT_EQUAL_UINT(57, diff.first_mismatch);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1e-3f, diff.max_motor_error);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 5e-3f, diff.max_quaternion_error);
+
+    // Within a looser tolerance both are accepted
+    replay_compare(rerun, trace, TRACE_LEN, 1e-2f, 1e-2f, &diff);
+    TEST_ASSERT_EQUAL_UINT(0, diff.mismatches);
+}
+
+void test_replay_tilt_error_against_truth(void) {
+    static quaternion_t truth[TRACE_LEN];
+    replay_synthesize_truth(trace, truth, TRACE_LEN, DT, 5);
+    replay_synthesize(rerun, TRACE_LEN, DT, 5);
+    TEST_ASSERT_EQUAL_MEMORY(rerun, trace, sizeof(trace));
+
+    // The truth against itself, then every filter tracking it
+    float rms, max;
+    for (int i = 0; i < TRACE_LEN; i++) rerun[i].quaternion = truth[i];
+    replay_tilt_error(rerun, truth, TRACE_LEN, &rms, &max);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, 0.0f, max);
+
+    for (int f = ATTITUDE_FILTER_COMPLEMENTARY; f <= ATTITUDE_FILTER_MADGWICK; f++) {
+        replay_t replay;
+        memcpy(rerun, trace, sizeof(trace));
+        TEST_ASSERT_TRUE(replay_init(&replay, DT));
+        attitude_estimator_set_filter(replay.fc->attitude_estimator, (attitude_filter_t)f);
+        flight_controller_sync_fixed(replay.fc);
+        replay_run(&replay, rerun, TRACE_LEN);
+        replay_free(&replay);
+
+        replay_tilt_error(rerun, truth, TRACE_LEN, &rms, &max);
+        TEST_ASSERT_TRUE(rms < 1.0f);
+        TEST_ASSERT_TRUE(max < 2.0f);
+    }
+}
+#endif
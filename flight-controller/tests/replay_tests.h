@@ -0,0 +1,8 @@
+#pragma once
+#include "unity.h"
+
+void test_mixer_quad_x(void);
+void test_replay_parse_line(void);
+void test_replay_is_deterministic(void);
+void test_replay_reports_first_mismatch(void);
+void test_replay_tilt_error_against_truth(void);
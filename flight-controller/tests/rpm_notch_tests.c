@@ -0,0 +1,140 @@
+#include "rpm_notch_tests.h"
+#include "core/rpm_notch.h"
+#include "core/dyn_notch.h"
+#include "notch_test_signals.h"
+#include <math.h>
+
+#define POLES     14
+#define MIN_HZ    80.0f
+#define NOTCH_Q   5.0f
+
+// Enough updates to bring every notch on, one cosf() and sinf() each
+#define SETTLE_SAMPLES (2 * RPM_NOTCH_COUNT)
+
+static rpm_notch_t rn;
+
+// eRPM of a rotor turning at hz
+static uint32_t erpm_of(float hz) {
+    return (uint32_t)(hz * 60.0f * (POLES / 2) + 0.5f);
+}
+
+static void set_motor_hz(float m0, float m1, float m2, float m3) {
+    uint32_t erpm[RPM_NOTCH_MOTORS] = { erpm_of(m0), erpm_of(m1), erpm_of(m2), erpm_of(m3) };
+    rpm_notch_set_erpm(&rn, erpm);
+}
+
+static int active_notches(void) {
+    return count_nonzero(&rn.notch[0].center, RPM_NOTCH_COUNT, sizeof(rn.notch[0]));
+}
+
+static void run_silence(int samples) {
+    for (int i = 0; i < samples; i++) {
+        vector3_t g = { 0.0f, 0.0f, 0.0f };
+        rpm_notch_update(&rn, &g, SAMPLE_DT);
+    }
+}
+
+void test_rpm_notch_attenuates_harmonics_passes_motion(void) {
+    static float in[1000], out[1000];
+    rpm_notch_init(&rn, POLES, MIN_HZ, NOTCH_Q);
+    set_motor_hz(150.0f, 170.0f, 190.0f, 210.0f);
+    run_silence(SETTLE_SAMPLES);
+    TEST_ASSERT_EQUAL_INT(RPM_NOTCH_COUNT, active_notches());
+
+    // Motor 1 at its rotation rate and twice it, on a 10 Hz manoeuvre
+    for (int i = 0; i < 1000; i++) {
+        float t = (float)i * SAMPLE_DT;
+        in[i] = 40.0f * sinf(TWO_PI_F * 150.0f * t) + 20.0f * sinf(TWO_PI_F * 300.0f * t) +
+                20.0f * sinf(TWO_PI_F * 10.0f * t);
+        vector3_t g = { 0.0f, in[i], 0.0f };
+        rpm_notch_update(&rn, &g, SAMPLE_DT);
+        out[i] = g.y;
+    }
+
+    // At least 20 dB off both harmonics, and the manoeuvre within 5 %
+    TEST_ASSERT_TRUE(tone_amplitude(out, 1000, 150.0f) < 0.1f * tone_amplitude(in, 1000, 150.0f));
+    TEST_ASSERT_TRUE(tone_amplitude(out, 1000, 300.0f) < 0.1f * tone_amplitude(in, 1000, 300.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 20.0f, tone_amplitude(out, 1000, 10.0f));
+}
+
+void test_rpm_notch_tracks_rpm_incrementally(void) {
+    rpm_notch_init(&rn, POLES, MIN_HZ, NOTCH_Q);
+    set_motor_hz(100.0f, 120.0f, 140.0f, 160.0f);
+    run_silence(SETTLE_SAMPLES);
+    uint32_t exact_before = rn.exact_retunes;
+
+    // Throttle up: every motor 100 Hz faster per second, for two seconds
+    for (int i = 0; i < 2000; i++) {
+        float up = 100.0f * (float)i * SAMPLE_DT;
+        set_motor_hz(100.0f + up, 120.0f + up, 140.0f + up, 160.0f + up);
+        run_silence(1);
+
+        // Every notch on its harmonic, with the coefficients cosf() and
+        // sinf() would give
+        for (int n = 0; n < RPM_NOTCH_COUNT; n++) {
+            const rpm_notch_filter_t* f = &rn.notch[n];
+            float hz = rn.motor_hz[n / RPM_NOTCH_HARMONICS] * (float)(n % RPM_NOTCH_HARMONICS + 1);
+            if (hz > 0.45f * SAMPLE_HZ) {
+                TEST_ASSERT_EQUAL_FLOAT(0.0f, f->center);
+                continue;
+            }
+            biquad_t ref;
+            biquad_notch_set(&ref, hz, NOTCH_Q, SAMPLE_HZ);
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f, TWO_PI_F * hz * SAMPLE_DT, f->center);
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, ref.b0, f->b0);
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, ref.b1, f->b1);
+            TEST_ASSERT_FLOAT_WITHIN(1e-4f, ref.a2, f->a2);
+        }
+    }
+
+    // Nearly all retunes were rotations
+    TEST_ASSERT_TRUE(rn.rotations > 10000);
+    TEST_ASSERT_TRUE(rn.exact_retunes - exact_before < rn.rotations / 100);
+
+    // A jump is followed at most RPM_NOTCH_MAX_STEP radians per sample
+    rpm_notch_init(&rn, POLES, MIN_HZ, NOTCH_Q);
+    set_motor_hz(100.0f, 0.0f, 0.0f, 0.0f);
+    run_silence(SETTLE_SAMPLES);
+    set_motor_hz(400.0f, 0.0f, 0.0f, 0.0f);
+    float before = rn.notch[0].center;
+    run_silence(1);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, RPM_NOTCH_MAX_STEP, rn.notch[0].center - before);
+    run_silence(8);
+    TEST_ASSERT_TRUE(rn.notch[0].center < TWO_PI_F * 400.0f * SAMPLE_DT);
+    run_silence(1);
+    TEST_ASSERT_EQUAL_FLOAT(TWO_PI_F * 400.0f * SAMPLE_DT, rn.notch[0].center);
+}
+
+void test_rpm_notch_off_when_stopped_or_out_of_band(void) {
+    rpm_notch_init(&rn, POLES, MIN_HZ, NOTCH_Q);
+
+    // Stopped motors report no eRPM: the rates pass untouched
+    set_motor_hz(0.0f, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < 100; i++) {
+        float x = 30.0f * sinf(TWO_PI_F * 150.0f * (float)i * SAMPLE_DT);
+        vector3_t g = { x, -x, 0.5f * x };
+        rpm_notch_update(&rn, &g, SAMPLE_DT);
+        TEST_ASSERT_EQUAL_FLOAT(x, g.x);
+        TEST_ASSERT_EQUAL_FLOAT(-x, g.y);
+        TEST_ASSERT_EQUAL_FLOAT(0.5f * x, g.z);
+    }
+    TEST_ASSERT_EQUAL_INT(0, active_notches());
+    TEST_ASSERT_EQUAL_UINT32(0, rn.exact_retunes);
+
+    // Below MIN_HZ the fundamental is off and twice it on; above 0.45 of
+    // the sample rate, the reverse
+    set_motor_hz(50.0f, 300.0f, 0.0f, 0.0f);
+    run_silence(SETTLE_SAMPLES);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, rn.notch[0].center);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, TWO_PI_F * 100.0f * SAMPLE_DT, rn.notch[1].center);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, TWO_PI_F * 300.0f * SAMPLE_DT, rn.notch[RPM_NOTCH_HARMONICS].center);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, rn.notch[RPM_NOTCH_HARMONICS + 1].center);
+    TEST_ASSERT_EQUAL_INT(2, active_notches());
+
+    // A new sample rate starts over, where 300 Hz is out of band
+    vector3_t g = { 0.0f, 0.0f, 0.0f };
+    rpm_notch_update(&rn, &g, 2.0f * SAMPLE_DT);
+    rpm_notch_update(&rn, &g, 2.0f * SAMPLE_DT);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, TWO_PI_F * 100.0f * 2.0f * SAMPLE_DT, rn.notch[1].center);
+    TEST_ASSERT_EQUAL_INT(1, active_notches());
+}
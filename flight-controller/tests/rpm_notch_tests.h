@@ -0,0 +1,6 @@
+#pragma once
+#include "unity.h"
+
+void test_rpm_notch_attenuates_harmonics_passes_motion(void);
+void test_rpm_notch_tracks_rpm_incrementally(void);
+void test_rpm_notch_off_when_stopped_or_out_of_band(void);
@@ -0,0 +1,155 @@
+#include "scheduler_tests.h"
+#include "../src/core/scheduler.h"
+
+typedef struct {
+    uint64_t now_us;
+} fake_clock_t;
+
+typedef struct {
+    fake_clock_t* clock;
+    uint32_t runs;
+    uint32_t work_us;        // Simulated execution time
+    uint64_t last_run_us;
+} counting_task_t;
+
+static uint64_t fake_clock_now(void* ctx) {
+    return ((fake_clock_t*)ctx)->now_us;
+}
+
+static void counting_task(void* ctx, uint64_t now_us) {
+    counting_task_t* task = ctx;
+    task->runs++;
+    task->last_run_us = now_us;
+    task->clock->now_us += task->work_us;
+}
+
+void test_scheduler_rejects_bad_rates(void) {
+    fake_clock_t clock = {0};
+    scheduler_t sched;
+    counting_task_t task = {&clock, 0, 0, 0};
+    scheduler_init(&sched, 1000, fake_clock_now, &clock);
+
+    TEST_ASSERT_EQUAL(-1, scheduler_add_task(&sched, "bad", 300, counting_task, &task));
+    TEST_ASSERT_EQUAL(-1, scheduler_add_task(&sched, "fast", 2000, counting_task, &task));
+    TEST_ASSERT_EQUAL(-1, scheduler_add_task(&sched, "zero", 0, counting_task, &task));
+
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        TEST_ASSERT_EQUAL(i, scheduler_add_task(&sched, "ok", 100, counting_task, &task));
+    }
+    TEST_ASSERT_EQUAL(-1, scheduler_add_task(&sched, "full", 100, counting_task, &task));
+}
+
+void test_scheduler_runs_integer_divided_rates(void) {
+    fake_clock_t clock = {0};
+    scheduler_t sched;
+    counting_task_t imu = {&clock, 0, 0, 0};
+    counting_task_t control = {&clock, 0, 0, 0};
+    counting_task_t telemetry = {&clock, 0, 0, 0};
+
+    scheduler_init(&sched, 1000, fake_clock_now, &clock);
+    scheduler_add_task(&sched, "imu", 1000, counting_task, &imu);
+    scheduler_add_task(&sched, "control", 500, counting_task, &control);
+    scheduler_add_task(&sched, "telemetry", 100, counting_task, &telemetry);
+
+    for (int tick = 0; tick < 1000; tick++) {
+        clock.now_us = tick * 1000u;
+        scheduler_poll(&sched);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1000, imu.runs);
+    TEST_ASSERT_EQUAL_UINT32(500, control.runs);
+    TEST_ASSERT_EQUAL_UINT32(100, telemetry.runs);
+    TEST_ASSERT_EQUAL_UINT32(2, sched.tasks[1].divider);
+    TEST_ASSERT_EQUAL_UINT32(10, sched.tasks[2].divider);
+    TEST_ASSERT_EQUAL_UINT32(0, sched.tasks[2].max_jitter_us);
+}
+
+void test_scheduler_late_polls_do_not_drift(void) {
+    fake_clock_t clock = {0};
+    scheduler_t sched;
+    counting_task_t control = {&clock, 0, 0, 0};
+
+    scheduler_init(&sched, 1000, fake_clock_now, &clock);
+    scheduler_add_task(&sched, "control", 500, counting_task, &control);
+
+    // Every wakeup lands 0..900 us late; with last_update = now the phase
+    // would creep by that much each cycle
+    uint32_t lcg = 12345;
+    for (int cycle = 0; cycle < 1000; cycle++) {
+        lcg = lcg * 1103515245u + 12345u;
+        clock.now_us = cycle * 2000u + (lcg >> 16) % 900;
+        scheduler_poll(&sched);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1000, control.runs);
+    TEST_ASSERT_EQUAL_UINT64(1000u * 2000u, sched.tasks[0].next_deadline_us);
+    TEST_ASSERT_EQUAL_UINT32(0, sched.tasks[0].overruns);
+    TEST_ASSERT_LESS_THAN(900, sched.tasks[0].max_jitter_us);
+}
+
+void test_scheduler_reports_jitter(void) {
+    fake_clock_t clock = {0};
+    scheduler_t sched;
+    counting_task_t first = {&clock, 0, 150, 0};
+    counting_task_t second = {&clock, 0, 0, 0};
+
+    scheduler_init(&sched, 1000, fake_clock_now, &clock);
+    scheduler_add_task(&sched, "first", 1000, counting_task, &first);
+    scheduler_add_task(&sched, "second", 1000, counting_task, &second);
+
+    // Time spent in the first task delays the second one
+    for (int tick = 0; tick < 10; tick++) {
+        clock.now_us = tick * 1000u + (tick == 4 ? 250u : 0u);
+        scheduler_poll(&sched);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(250, sched.tasks[0].max_jitter_us);
+    TEST_ASSERT_EQUAL_UINT32(25, scheduler_mean_jitter_us(&sched.tasks[0]));
+    TEST_ASSERT_EQUAL_UINT32(400, sched.tasks[1].max_jitter_us);
+    TEST_ASSERT_EQUAL_UINT32(175, scheduler_mean_jitter_us(&sched.tasks[1]));
+
+    scheduler_reset_stats(&sched);
+    TEST_ASSERT_EQUAL_UINT32(0, sched.tasks[1].runs);
+    TEST_ASSERT_EQUAL_UINT32(0, sched.tasks[1].max_jitter_us);
+}
+
+void test_scheduler_counts_overruns(void) {
+    fake_clock_t clock = {0};
+    scheduler_t sched;
+    counting_task_t slow = {&clock, 0, 0, 0};
+
+    scheduler_init(&sched, 1000, fake_clock_now, &clock);
+    scheduler_add_task(&sched, "slow", 500, counting_task, &slow);
+
+    scheduler_poll(&sched);              // t=0, on time
+    clock.now_us = 7100;                 // Deadlines 2000, 4000, 6000 passed
+    TEST_ASSERT_EQUAL(1, scheduler_poll(&sched));
+    TEST_ASSERT_EQUAL(0, scheduler_poll(&sched));  // No catch-up burst
+
+    TEST_ASSERT_EQUAL_UINT32(2, slow.runs);
+    TEST_ASSERT_EQUAL_UINT32(2, sched.tasks[0].overruns);
+    TEST_ASSERT_EQUAL_UINT32(5100, sched.tasks[0].max_jitter_us);
+    TEST_ASSERT_EQUAL_UINT64(8000, sched.tasks[0].next_deadline_us);
+}
+
+void test_scheduler_next_deadline(void) {
+    fake_clock_t clock = {0};
+    scheduler_t sched;
+    counting_task_t a = {&clock, 0, 0, 0};
+    counting_task_t b = {&clock, 0, 0, 0};
+
+    scheduler_init(&sched, 1000, fake_clock_now, &clock);
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, scheduler_next_deadline(&sched));
+
+    scheduler_add_task(&sched, "a", 100, counting_task, &a);
+    scheduler_add_task(&sched, "b", 250, counting_task, &b);
+    scheduler_poll(&sched);
+    TEST_ASSERT_EQUAL_UINT64(4000, scheduler_next_deadline(&sched));
+
+    // Tasks added later join the grid at the next multiple of their period
+    clock.now_us = 4500;
+    scheduler_poll(&sched);
+    counting_task_t c = {&clock, 0, 0, 0};
+    scheduler_add_task(&sched, "c", 200, counting_task, &c);
+    TEST_ASSERT_EQUAL_UINT64(5000, sched.tasks[2].next_deadline_us);
+}
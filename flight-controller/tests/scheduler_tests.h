@@ -0,0 +1,9 @@
+#pragma once
+#include "unity.h"
+
+void test_scheduler_rejects_bad_rates(void);
+void test_scheduler_runs_integer_divided_rates(void);
+void test_scheduler_late_polls_do_not_drift(void);
+void test_scheduler_reports_jitter(void);
+void test_scheduler_counts_overruns(void);
+void test_scheduler_next_deadline(void);
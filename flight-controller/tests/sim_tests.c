@@ -0,0 +1,163 @@
+#include "sim_tests.h"
+
+#ifdef HOST_BUILD
+#include "core/mixer.h"
+#include "drivers/dshot.h"
+#include "drivers/esc.h"
+#include "include/config.h"
+#include "../tools/sim/quad_sim.h"
+#include "../tools/sim/sil.h"
+#include <math.h>
+#include <string.h>
+
+static void noiseless_params(quad_sim_params_t* params) {
+    quad_sim_default_params(params);
+    params->gyro_noise = 0.0f;
+    params->accel_noise = 0.0f;
+}
+
+void test_sim_hover_and_free_fall(void) {
+    quad_sim_params_t params;
+    quad_sim_t sim;
+    noiseless_params(&params);
+    quad_sim_init(&sim, &params, 1);
+
+    float hover = quad_sim_hover_throttle(&params);
+    const float level[4] = { hover, hover, hover, hover };
+    quad_sim_set_pose(&sim, 10.0f, 0.0f, 0.0f, 0.0f, hover);
+    for (int i = 0; i < CONTROL_LOOP_FREQ; i++) quad_sim_step(&sim, level, DT);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 10.0f, sim.state.position.z);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, quad_sim_tilt(&sim));
+
+    // Motors stopped: with drag k = 0.2/s the first second drops
+    // g (t/k - (1 - e^-kt)/k^2) = 4.59 m, and the accelerometer only feels
+    // the drag until the ground catches it
+    const float off[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    quad_sim_set_pose(&sim, 10.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < CONTROL_LOOP_FREQ; i++) quad_sim_step(&sim, off, DT);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 10.0f - 4.59f, sim.state.position.z);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -params.linear_drag * sim.state.velocity.z / params.mass,
+                             sim.state.specific_force.z);
+    TEST_ASSERT_FALSE(sim.state.on_ground);
+
+    for (int i = 0; i < CONTROL_LOOP_FREQ; i++) quad_sim_step(&sim, off, DT);
+    TEST_ASSERT_TRUE(sim.state.on_ground);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sim.state.position.z);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 9.80665f, sim.state.specific_force.z);
+}
+
+void test_sim_mixer_outputs_give_positive_torques(void) {
+    const float axes[3][3] = { { 0.05f, 0.0f, 0.0f }, { 0.0f, 0.05f, 0.0f }, { 0.0f, 0.0f, 0.05f } };
+    quad_sim_params_t params;
+    quad_sim_t sim;
+    noiseless_params(&params);
+    float hover = quad_sim_hover_throttle(&params);
+
+    for (int axis = 0; axis < 3; axis++) {
+        float m[4];
+        quad_sim_init(&sim, &params, 1);
+        quad_sim_set_pose(&sim, 10.0f, 0.0f, 0.0f, 0.0f, hover);
+        mixer_quad_x(hover, axes[axis][0], axes[axis][1], axes[axis][2], m);
+        for (int i = 0; i < CONTROL_LOOP_FREQ / 10; i++) quad_sim_step(&sim, m, DT);
+
+        const float rate[3] = { sim.state.rate.x, sim.state.rate.y, sim.state.rate.z };
+        for (int other = 0; other < 3; other++) {
+            if (other == axis) {
+                TEST_ASSERT_TRUE(rate[other] > 0.1f);
+            } else {
+                TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, rate[other]);
+            }
+        }
+    }
+}
+
+void test_sim_imu_reads_gravity_and_rates(void) {
+    quad_sim_params_t params;
+    quad_sim_t sim;
+    vector3_t accel, gyro;
+    noiseless_params(&params);
+    params.gyro_bias = (vector3_t){ 1.0f, -2.0f, 0.5f };
+    quad_sim_init(&sim, &params, 1);
+
+    // Rolled 30 deg right wing up: gravity leans onto +y
+    quad_sim_set_pose(&sim, 10.0f, 30.0f, 0.0f, 0.0f, 0.5f);
+    sim.state.rate = (vector3_t){ 0.5f, 0.0f, -1.0f };
+    quad_sim_imu(&sim, &accel, &gyro);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.0f, accel.x);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.5f, accel.y);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.8660254f, accel.z);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 28.6479f + 1.0f, gyro.x);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -2.0f, gyro.y);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -57.2958f + 0.5f, gyro.z);
+
+    // Noise has roughly the configured spread
+    sim.params.gyro_noise = 2.0f;
+    float sum_sq = 0.0f;
+    for (int i = 0; i < 4000; i++) {
+        quad_sim_imu(&sim, &accel, &gyro);
+        sum_sq += (gyro.y + 2.0f) * (gyro.y + 2.0f);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 2.0f, sqrtf(sum_sq / 4000.0f));
+}
+
+// Throttle resolution of ESC_PROTOCOL: one DShot value, or one PWM count
+// of the pulse width range
+static float throttle_step(void) {
+    if (DEFAULT_ESC_CONFIG.protocol >= ESC_PROTOCOL_DSHOT150) {
+        return 1.0f / (float)(DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN);
+    }
+    esc_duty_range_t range;
+    esc_duty_range_init(&range, &DEFAULT_ESC_CONFIG);
+    return 1.0f / range.span;
+}
+
+void test_sil_decodes_esc_output(void) {
+    static sil_t sil;
+    quad_sim_params_t params;
+    noiseless_params(&params);
+    TEST_ASSERT_TRUE(sil_init(&sil, &params));
+
+    // Level, still and noiseless: the loop commands hover throttle on every
+    // motor and keeps the quad where it is
+    const sil_scenario_t scenario = { 1.0f, 20.0f, 0.0f, 0.0f };
+    sil_result_t result;
+    sil_fly(&sil, &scenario, 1, &result);
+
+    float hover = quad_sim_hover_throttle(&params);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(throttle_step(), hover, sil.throttle[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT64(CONTROL_LOOP_FREQ, result.steps);
+    TEST_ASSERT_EQUAL_UINT64(CONTROL_LOOP_PERIOD_US * CONTROL_LOOP_FREQ, hal_time_us());
+    TEST_ASSERT_TRUE(sil.imu.reads >= CONTROL_LOOP_FREQ);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, result.max_tilt);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 20.0f, result.min_altitude);
+    TEST_ASSERT_FALSE(result.ground_contact);
+
+    sil_free(&sil);
+}
+
+void test_sil_is_deterministic(void) {
+    static sil_t sil;
+    quad_sim_params_t params;
+    quad_sim_default_params(&params);
+    params.gyro_bias = (vector3_t){ 0.5f, -0.5f, 0.2f };
+    TEST_ASSERT_TRUE(sil_init(&sil, &params));
+
+    const sil_scenario_t scenario = { 0.5f, 20.0f, 10.0f, 30.0f };
+    sil_result_t first, again, other;
+    quad_sim_state_t first_state;
+
+    sil_fly(&sil, &scenario, 7, &first);
+    first_state = sil.quad.state;
+    sil_fly(&sil, &scenario, 8, &other);
+    sil_fly(&sil, &scenario, 7, &again);
+
+    // Nothing carries over from one flight to the next
+    TEST_ASSERT_EQUAL_MEMORY(&first, &again, sizeof(first));
+    TEST_ASSERT_EQUAL_MEMORY(&first_state, &sil.quad.state, sizeof(first_state));
+    TEST_ASSERT_TRUE(memcmp(&first, &other, sizeof(first)) != 0);
+
+    sil_free(&sil);
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include "unity.h"
+
+#ifdef HOST_BUILD
+void test_sim_hover_and_free_fall(void);
+void test_sim_mixer_outputs_give_positive_torques(void);
+void test_sim_imu_reads_gravity_and_rates(void);
+void test_sil_decodes_esc_output(void);
+void test_sil_is_deterministic(void);
+#endif
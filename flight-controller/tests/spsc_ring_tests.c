@@ -0,0 +1,208 @@
+#include "spsc_ring_tests.h"
+#include "../src/utils/spsc_ring.h"
+#include <string.h>
+
+#ifdef HOST_BUILD
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Same shape as an attitude sample: timestamp, sequence and a payload whose
+// every word is derived from the sequence so torn copies are detectable
+typedef struct {
+    uint64_t timestamp_us;
+    uint32_t seq;
+    uint32_t payload[7];
+} test_record_t;
+
+static void fill_record(test_record_t* rec, uint32_t seq) {
+    rec->timestamp_us = (uint64_t)seq * 1000u;
+    rec->seq = seq;
+    for (int i = 0; i < 7; i++) rec->payload[i] = seq * 2654435761u + (uint32_t)i;
+}
+
+static bool record_is_intact(const test_record_t* rec) {
+    if (rec->timestamp_us != (uint64_t)rec->seq * 1000u) return false;
+    for (int i = 0; i < 7; i++) {
+        if (rec->payload[i] != rec->seq * 2654435761u + (uint32_t)i) return false;
+    }
+    return true;
+}
+
+void test_spsc_ring_rejects_bad_capacity(void) {
+    spsc_ring_t ring;
+    test_record_t storage[6];
+    TEST_ASSERT_FALSE(spsc_ring_init(&ring, storage, sizeof(test_record_t), 6));
+    TEST_ASSERT_FALSE(spsc_ring_init(&ring, storage, sizeof(test_record_t), 1));
+    TEST_ASSERT_FALSE(spsc_ring_init(&ring, NULL, sizeof(test_record_t), 4));
+    TEST_ASSERT_TRUE(spsc_ring_init(&ring, storage, sizeof(test_record_t), 4));
+}
+
+void test_spsc_ring_fifo_order(void) {
+    spsc_ring_t ring;
+    test_record_t storage[4];
+    test_record_t rec;
+    spsc_ring_init(&ring, storage, sizeof(test_record_t), 4);
+
+    TEST_ASSERT_FALSE(spsc_ring_pop(&ring, &rec));
+    for (uint32_t i = 0; i < 3; i++) {
+        fill_record(&rec, i);
+        TEST_ASSERT_TRUE(spsc_ring_push(&ring, &rec));
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, spsc_ring_count(&ring));
+
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(spsc_ring_pop(&ring, &rec));
+        TEST_ASSERT_EQUAL_UINT32(i, rec.seq);
+        TEST_ASSERT_TRUE(record_is_intact(&rec));
+    }
+    TEST_ASSERT_FALSE(spsc_ring_pop(&ring, &rec));
+}
+
+void test_spsc_ring_full_drops(void) {
+    spsc_ring_t ring;
+    test_record_t storage[4];
+    test_record_t rec;
+    spsc_ring_init(&ring, storage, sizeof(test_record_t), 4);
+
+    for (uint32_t i = 0; i < 6; i++) {
+        fill_record(&rec, i);
+        TEST_ASSERT_EQUAL(i < 4, spsc_ring_push(&ring, &rec));
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, ring.dropped);
+
+    // The oldest data survives; rejected pushes never overwrite it
+    TEST_ASSERT_TRUE(spsc_ring_pop(&ring, &rec));
+    TEST_ASSERT_EQUAL_UINT32(0, rec.seq);
+}
+
+void test_spsc_ring_wraparound(void) {
+    spsc_ring_t ring;
+    test_record_t storage[4];
+    test_record_t rec;
+    spsc_ring_init(&ring, storage, sizeof(test_record_t), 4);
+
+    // Walk the indices well past several laps of the storage
+    uint32_t next_pop = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        fill_record(&rec, i);
+        TEST_ASSERT_TRUE(spsc_ring_push(&ring, &rec));
+        if (i % 3 != 0) {
+            while (spsc_ring_pop(&ring, &rec)) {
+                TEST_ASSERT_EQUAL_UINT32(next_pop++, rec.seq);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, ring.dropped);
+}
+
+void test_spsc_ring_pop_latest(void) {
+    spsc_ring_t ring;
+    test_record_t storage[8];
+    test_record_t rec;
+    uint32_t skipped;
+    spsc_ring_init(&ring, storage, sizeof(test_record_t), 8);
+
+    TEST_ASSERT_FALSE(spsc_ring_pop_latest(&ring, &rec, &skipped));
+    TEST_ASSERT_EQUAL_UINT32(0, skipped);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        fill_record(&rec, i);
+        spsc_ring_push(&ring, &rec);
+    }
+    TEST_ASSERT_TRUE(spsc_ring_pop_latest(&ring, &rec, &skipped));
+    TEST_ASSERT_EQUAL_UINT32(4, rec.seq);
+    TEST_ASSERT_EQUAL_UINT32(4, skipped);
+    TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&ring));
+}
+
+#ifdef HOST_BUILD
+#define STRESS_RECORDS 200000u
+
+typedef struct {
+    spsc_ring_t ring;
+    test_record_t storage[8];
+    _Atomic bool done;
+} stress_ctx_t;
+
+static void* producer_retrying(void* arg) {
+    stress_ctx_t* ctx = arg;
+    test_record_t rec;
+    for (uint32_t i = 0; i < STRESS_RECORDS; i++) {
+        fill_record(&rec, i);
+        while (!spsc_ring_push(&ctx->ring, &rec)) {
+            sched_yield();  // Ring full, let the consumer catch up
+        }
+    }
+    return NULL;
+}
+
+static void* producer_dropping(void* arg) {
+    stress_ctx_t* ctx = arg;
+    test_record_t rec;
+    for (uint32_t i = 0; i < STRESS_RECORDS; i++) {
+        fill_record(&rec, i);
+        if (!spsc_ring_push(&ctx->ring, &rec)) sched_yield();
+    }
+    atomic_store(&ctx->done, true);
+    return NULL;
+}
+
+void test_spsc_ring_threaded_stress(void) {
+    static stress_ctx_t ctx;
+    spsc_ring_init(&ctx.ring, ctx.storage, sizeof(test_record_t), 8);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, producer_retrying, &ctx);
+
+    uint32_t expected = 0;
+    uint32_t corrupt = 0;
+    test_record_t rec;
+    while (expected < STRESS_RECORDS) {
+        if (!spsc_ring_pop(&ctx.ring, &rec)) {
+            sched_yield();
+            continue;
+        }
+        if (rec.seq != expected || !record_is_intact(&rec)) corrupt++;
+        expected++;
+    }
+    pthread_join(producer, NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+    TEST_ASSERT_EQUAL_UINT32(0, spsc_ring_count(&ctx.ring));
+}
+
+void test_spsc_ring_threaded_latest_stress(void) {
+    static stress_ctx_t ctx;
+    spsc_ring_init(&ctx.ring, ctx.storage, sizeof(test_record_t), 8);
+    atomic_store(&ctx.done, false);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, producer_dropping, &ctx);
+
+    // Consumer behaves like the control core: newest sample only
+    uint32_t received = 0;
+    uint32_t skipped_total = 0;
+    uint32_t corrupt = 0;
+    int64_t last_seq = -1;
+    test_record_t rec;
+    uint32_t skipped;
+    while (last_seq < (int64_t)STRESS_RECORDS - 1) {
+        // Check for completion before popping so the final push is not missed
+        bool producer_done = atomic_load(&ctx.done);
+        if (!spsc_ring_pop_latest(&ctx.ring, &rec, &skipped)) {
+            if (producer_done) break;  // The last records were dropped
+            sched_yield();
+            continue;
+        }
+        if ((int64_t)rec.seq <= last_seq || !record_is_intact(&rec)) corrupt++;
+        last_seq = rec.seq;
+        received++;
+        skipped_total += skipped;
+    }
+    pthread_join(producer, NULL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, corrupt);
+    TEST_ASSERT_EQUAL_UINT32(STRESS_RECORDS, received + skipped_total + ctx.ring.dropped);
+}
+#endif
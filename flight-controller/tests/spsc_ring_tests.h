@@ -0,0 +1,12 @@
+#pragma once
+#include "unity.h"
+
+void test_spsc_ring_rejects_bad_capacity(void);
+void test_spsc_ring_fifo_order(void);
+void test_spsc_ring_full_drops(void);
+void test_spsc_ring_wraparound(void);
+void test_spsc_ring_pop_latest(void);
+#ifdef HOST_BUILD
+void test_spsc_ring_threaded_stress(void);
+void test_spsc_ring_threaded_latest_stress(void);
+#endif
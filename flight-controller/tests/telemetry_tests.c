@@ -0,0 +1,202 @@
+#include "telemetry_tests.h"
+#include "../src/utils/framing.h"
+#include "../src/utils/telemetry.h"
+#include "../tools/telemetry/telemetry_decoder.h"
+#include <string.h>
+
+// Sink with `room` bytes of free space, like the USB CDC FIFO
+typedef struct {
+    uint8_t data[4096];
+    size_t len;
+    size_t room;
+} fake_sink_t;
+
+static size_t fake_sink_write(void* ctx, const uint8_t* data, size_t len) {
+    fake_sink_t* sink = ctx;
+    if (len > sink->room) len = sink->room;
+    memcpy(&sink->data[sink->len], data, len);
+    sink->len += len;
+    sink->room -= len;
+    return len;
+}
+
+typedef struct {
+    telemetry_record_t recs[64];
+    uint32_t count;
+} record_log_t;
+
+static void log_record(const telemetry_record_t* rec, void* ctx) {
+    record_log_t* log = ctx;
+    if (log->count < 64) log->recs[log->count] = *rec;
+    log->count++;
+}
+
+static telemetry_attitude_t attitude_for(uint32_t i) {
+    telemetry_attitude_t att = {
+        (float)i, -(float)i, 0.0f, 0.5f * (float)i, 0.0f, 256.0f
+    };
+    return att;
+}
+
+void test_framing_crc16_check_value(void) {
+    const uint8_t check[] = "123456789";
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16_ccitt(check, 9, 0xFFFF));
+}
+
+void test_framing_cobs_round_trip(void) {
+    const uint8_t cases[][6] = {
+        { 0, 0, 0, 0, 0, 0 },
+        { 1, 2, 3, 4, 5, 6 },
+        { 0, 1, 0, 2, 0, 3 },
+        { 7, 0, 0, 8, 9, 0 }
+    };
+    uint8_t enc[COBS_MAX_ENCODED(6)];
+    uint8_t dec[6];
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        size_t n = cobs_encode(cases[c], 6, enc);
+        TEST_ASSERT_TRUE(n <= COBS_MAX_ENCODED(6));
+        TEST_ASSERT_NULL(memchr(enc, 0, n));
+        TEST_ASSERT_EQUAL_UINT32(6, cobs_decode(enc, n, dec, sizeof(dec)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(cases[c], dec, 6);
+    }
+}
+
+void test_framing_cobs_long_runs(void) {
+    // Runs of non-zero bytes longer than a COBS block
+    static uint8_t src[600];
+    static uint8_t enc[COBS_MAX_ENCODED(600)];
+    static uint8_t dec[600];
+    const size_t lengths[] = { 253, 254, 255, 508, 600 };
+
+    for (size_t i = 0; i < sizeof(src); i++) src[i] = (uint8_t)(i % 255 + 1);
+
+    for (size_t c = 0; c < sizeof(lengths) / sizeof(lengths[0]); c++) {
+        size_t len = lengths[c];
+        size_t n = cobs_encode(src, len, enc);
+        TEST_ASSERT_TRUE(n <= COBS_MAX_ENCODED(len));
+        TEST_ASSERT_NULL(memchr(enc, 0, n));
+        TEST_ASSERT_EQUAL_UINT32(len, cobs_decode(enc, n, dec, sizeof(dec)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(src, dec, len);
+    }
+}
+
+void test_framing_rejects_corruption(void) {
+    const uint8_t payload[] = { 0x10, 0x00, 0x20, 0x30 };
+    uint8_t frame[FRAME_MAX_ENCODED(4)];
+    uint8_t out[8];
+
+    size_t n = frame_encode(payload, sizeof(payload), frame);
+    TEST_ASSERT_EQUAL_UINT8(0, frame[n - 1]);
+    TEST_ASSERT_EQUAL_INT(4, frame_decode(frame, n - 1, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, out, 4);
+
+    frame[2] ^= 0x40;
+    TEST_ASSERT_EQUAL_INT(-1, frame_decode(frame, n - 1, out, sizeof(out)));
+}
+
+void test_telemetry_drain_survives_partial_writes(void) {
+    static telemetry_t tel;
+    static fake_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+
+    telemetry_port_t port = { .write = fake_sink_write, .ctx = &sink };
+    telemetry_init(&tel, &port);
+
+    for (uint32_t i = 0; i < 10; i++) {
+        telemetry_attitude_t att = attitude_for(i);
+        TEST_ASSERT_TRUE(telemetry_send(&tel, TELEMETRY_ATTITUDE, 1000u * i, &att, sizeof(att)));
+    }
+
+    // Only 7 bytes free per call, so frames straddle several drains; each
+    // call returns as soon as the sink is full
+    uint32_t calls = 0;
+    while (spsc_ring_count(&tel.ring) > 0 || tel.frame_sent < tel.frame_len) {
+        sink.room = 7;
+        TEST_ASSERT_TRUE(telemetry_drain(&tel, 4) <= 7);
+        TEST_ASSERT_TRUE(++calls < 1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, tel.records_sent);
+    TEST_ASSERT_EQUAL_UINT32(sink.len, tel.bytes_sent);
+
+    static record_log_t log;
+    memset(&log, 0, sizeof(log));
+    telemetry_decoder_t dec;
+    telemetry_decoder_init(&dec, log_record, &log);
+    telemetry_decoder_feed(&dec, sink.data, sink.len);
+
+    TEST_ASSERT_EQUAL_UINT32(10, log.count);
+    TEST_ASSERT_EQUAL_UINT32(0, dec.crc_errors);
+    TEST_ASSERT_EQUAL_UINT32(0, dec.lost_records);
+    for (uint32_t i = 0; i < 10; i++) {
+        telemetry_attitude_t att = attitude_for(i);
+        TEST_ASSERT_EQUAL_UINT8(TELEMETRY_ATTITUDE, log.recs[i].type);
+        TEST_ASSERT_EQUAL_UINT16(i, log.recs[i].seq);
+        TEST_ASSERT_EQUAL_UINT32(1000u * i, log.recs[i].timestamp_us);
+        TEST_ASSERT_EQUAL_MEMORY(&att, &log.recs[i].attitude, sizeof(att));
+    }
+}
+
+void test_telemetry_counts_dropped_records(void) {
+    static telemetry_t tel;
+    static fake_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.room = sizeof(sink.data);
+
+    telemetry_port_t port = { .write = fake_sink_write, .ctx = &sink };
+    telemetry_init(&tel, &port);
+
+    // Nothing drains in between: the overflow is dropped, not waited on
+    telemetry_motors_t motors = { { 0.1f, 0.2f, 0.3f, 0.4f }, 0.5f };
+    for (uint32_t i = 0; i < TELEMETRY_RING_SIZE + 5; i++) {
+        telemetry_send(&tel, TELEMETRY_MOTORS, i, &motors, sizeof(motors));
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, telemetry_dropped(&tel));
+
+    telemetry_drain(&tel, TELEMETRY_RING_SIZE);
+    // The sequence keeps counting, so the receiver sees the loss
+    telemetry_send(&tel, TELEMETRY_MOTORS, 99, &motors, sizeof(motors));
+    telemetry_drain(&tel, 1);
+
+    static record_log_t log;
+    memset(&log, 0, sizeof(log));
+    telemetry_decoder_t dec;
+    telemetry_decoder_init(&dec, log_record, &log);
+    telemetry_decoder_feed(&dec, sink.data, sink.len);
+
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRY_RING_SIZE + 1, dec.records);
+    TEST_ASSERT_EQUAL_UINT32(5, dec.lost_records);
+}
+
+void test_telemetry_decoder_resyncs_after_garbage(void) {
+    static record_log_t log;
+    memset(&log, 0, sizeof(log));
+    telemetry_decoder_t dec;
+    telemetry_decoder_init(&dec, log_record, &log);
+
+    telemetry_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.type = TELEMETRY_STATUS;
+    rec.status.dropped = 3;
+
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    size_t n = frame_encode((const uint8_t*)&rec, sizeof(rec), frame);
+
+    // Stray text ahead of the first delimiter, then a corrupted frame
+    const char text[] = "INFO: boot\n";
+    telemetry_decoder_feed(&dec, (const uint8_t*)text, sizeof(text) - 1);
+    telemetry_decoder_feed(&dec, (const uint8_t*)"", 1);
+    frame[5] = frame[5] == 0x55 ? 0xAA : 0x55;
+    telemetry_decoder_feed(&dec, frame, n);
+
+    // A good frame fed one byte at a time
+    rec.seq = 1;
+    n = frame_encode((const uint8_t*)&rec, sizeof(rec), frame);
+    for (size_t i = 0; i < n; i++) {
+        telemetry_decoder_feed(&dec, &frame[i], 1);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1, dec.records);
+    TEST_ASSERT_EQUAL_UINT32(2, dec.crc_errors + dec.framing_errors);
+    TEST_ASSERT_EQUAL_UINT32(3, log.recs[0].status.dropped);
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "unity.h"
+
+void test_framing_crc16_check_value(void);
+void test_framing_cobs_round_trip(void);
+void test_framing_cobs_long_runs(void);
+void test_framing_rejects_corruption(void);
+void test_telemetry_drain_survives_partial_writes(void);
+void test_telemetry_counts_dropped_records(void);
+void test_telemetry_decoder_resyncs_after_garbage(void);
@@ -1,11 +1,31 @@
 #include "unity.h"
 #include "pid_controller_tests.h"
 #include "attitude_estimator_tests.h"
+#include "mpu6050_async_tests.h"
+#include "mpu6050_fifo_tests.h"
+#include "loop_trigger_tests.h"
+#include "spsc_ring_tests.h"
+#include "scheduler_tests.h"
+#include "loop_profiler_tests.h"
+#include "telemetry_tests.h"
+#include "logger_tests.h"
+#include "blackbox_tests.h"
+#include "replay_tests.h"
+#include "hal_tests.h"
+#include "sim_tests.h"
+#include "fixed_point_tests.h"
+#include "fast_math_tests.h"
+#include "fft_q15_tests.h"
+#include "dyn_notch_tests.h"
+#include "rpm_notch_tests.h"
+#include "dshot_tests.h"
+
+#ifdef HOST_BUILD
+#include "drivers/hal_linux.h"
+#else
 #include "mpu6050_tests.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
-
-#ifndef HOST_BUILD
 #include "pico/stdlib.h"
 
 static void wait_for_usb() {
@@ -41,6 +61,9 @@ void tearDown(void) {
 void test_pid_initialization(void);
 void test_pid_reset(void);
 void test_pid_output_limits(void);
+void test_pid_integrates_once_per_update(void);
+void test_pid_derivative_on_measurement(void);
+void test_pid_axes_match_scalar(void);
 void test_attitude_estimator_initialization(void);
 void test_attitude_estimator_level(void);
 void test_mpu6050_initialization(void);
@@ -48,11 +71,120 @@ void test_mpu6050_connection(void);
 void test_mpu6050_calibration(void);
 void test_mpu6050_scaling(void);
 void test_mpu6050_read_operations(void);
+void test_mpu6050_async_decodes_burst(void);
+void test_mpu6050_async_double_buffer(void);
+void test_mpu6050_async_rejects_overlap(void);
+void test_mpu6050_async_error_keeps_previous(void);
+void test_mpu6050_async_does_not_block(void);
+void test_mpu6050_async_averages_fresh_samples(void);
+void test_mpu6050_init_without_bus_fails(void);
+void test_mpu6050_fifo_parse_frames(void);
+void test_mpu6050_fifo_parse_respects_max(void);
+void test_mpu6050_fifo_enable_configures_registers(void);
+void test_mpu6050_fifo_drain_sequences(void);
+void test_mpu6050_fifo_drain_overflow(void);
+void test_mpu6050_fifo_drain_overflow_status(void);
+void test_mpu6050_fifo_drain_amortizes_bus(void);
+void test_loop_trigger_follows_data_ready(void);
+void test_loop_trigger_falls_back_when_silent(void);
+void test_loop_trigger_recovers_from_fallback(void);
+void test_loop_trigger_counts_missed_irqs(void);
+void test_loop_trigger_fallback_skips_after_overrun(void);
+void test_spsc_ring_rejects_bad_capacity(void);
+void test_spsc_ring_fifo_order(void);
+void test_spsc_ring_full_drops(void);
+void test_spsc_ring_wraparound(void);
+void test_spsc_ring_pop_latest(void);
+void test_scheduler_rejects_bad_rates(void);
+void test_scheduler_runs_integer_divided_rates(void);
+void test_scheduler_late_polls_do_not_drift(void);
+void test_scheduler_reports_jitter(void);
+void test_scheduler_counts_overruns(void);
+void test_scheduler_next_deadline(void);
+void test_loop_profiler_min_max_mean(void);
+void test_loop_profiler_histogram_buckets(void);
+void test_loop_profiler_reset(void);
+void test_loop_profiler_probe_pair_records(void);
+void test_loop_profiler_threaded_snapshot(void);
+void test_framing_crc16_check_value(void);
+void test_framing_cobs_round_trip(void);
+void test_framing_cobs_long_runs(void);
+void test_framing_rejects_corruption(void);
+void test_telemetry_drain_survives_partial_writes(void);
+void test_telemetry_counts_dropped_records(void);
+void test_telemetry_decoder_resyncs_after_garbage(void);
+void test_logger_format_words(void);
+void test_logger_deferred_round_trip(void);
+void test_logger_core1_records_wait_for_core0(void);
+void test_logger_drops_without_channel(void);
+void test_logger_target_cost(void);
+void test_blackbox_varint_round_trip(void);
+void test_blackbox_round_trip(void);
+void test_blackbox_decimation(void);
+void test_blackbox_dropped_pages_resync(void);
+void test_blackbox_appends_sessions(void);
+void test_blackbox_erases_only_when_prepared(void);
+void test_blackbox_flush_stops_at_prepared_space(void);
+void test_mixer_quad_x(void);
+void test_replay_parse_line(void);
+void test_replay_is_deterministic(void);
+void test_replay_reports_first_mismatch(void);
+void test_replay_tilt_error_against_truth(void);
+void test_fixed_point_saturating_arithmetic(void);
+void test_fixed_point_conversions(void);
+void test_fixed_point_sensor_scaling(void);
+void test_fixed_point_estimator_tracks_float(void);
+void test_fixed_point_pid_tracks_float(void);
+void test_fixed_point_duty_within_one_count(void);
+void test_fixed_point_mixer_saturates(void);
+void test_fast_math_inv_sqrt(void);
+void test_fast_math_atan2_quadrants(void);
+void test_fast_math_asin(void);
+void test_fast_math_sin_cos(void);
+void test_fast_math_attitude_within_bounds(void);
+void test_fft_q15_single_tone(void);
+void test_fft_q15_matches_dft(void);
+void test_fft_q15_stages_match_whole_transform(void);
+void test_fft_q15_hann_window(void);
+void test_dyn_notch_finds_tone(void);
+void test_dyn_notch_finds_two_tones(void);
+void test_dyn_notch_tracks_moving_tone(void);
+void test_dyn_notch_attenuates_tone_passes_motion(void);
+void test_dyn_notch_ignores_white_noise(void);
+void test_dyn_notch_step_cost_within_budget(void);
+void test_rpm_notch_attenuates_harmonics_passes_motion(void);
+void test_rpm_notch_tracks_rpm_incrementally(void);
+void test_rpm_notch_off_when_stopped_or_out_of_band(void);
+void test_dshot_frame_crc(void);
+void test_dshot_throttle_values(void);
+void test_dshot_pack_interleaves_motors(void);
+void test_dshot_clock_div(void);
+void test_dshot_bidir_frame_crc(void);
+void test_dshot_gcr_round_trip(void);
+void test_dshot_gcr_detects_corruption(void);
+void test_dshot_telemetry_decodes_capture(void);
+void test_dshot_pio_bit_timing(void);
+void test_dshot_pio_frames_back_to_back(void);
+void test_dshot_esc_output(void);
+void test_dshot_bidir_pio_timing(void);
+void test_dshot_esc_telemetry(void);
+void test_hal_virtual_time(void);
+void test_hal_loop_trigger_on_gpio_edge(void);
+void test_hal_esc_pwm_levels(void);
+void test_hal_esc_oneshot_synced(void);
+void test_hal_mpu6050_over_simulated_bus(void);
+void test_hal_mpu6050_counts_skipped_samples(void);
+void test_hal_flight_controller_runs_on_host(void);
+void test_hal_flight_controller_cascade(void);
+void test_hal_flight_controller_static_stack(void);
 
 int main(void) {
     #ifndef HOST_BUILD    
     stdio_init_all();  // Only for Pico
     wait_for_usb();
+    #else
+    // Driver reset and calibration delays cost no wall time
+    hal_linux_set_virtual_time(true);
     #endif
 
     UNITY_BEGIN();
@@ -61,17 +193,186 @@ int main(void) {
     RUN_TEST(test_pid_initialization);
     RUN_TEST(test_pid_reset);
     RUN_TEST(test_pid_output_limits);
+    RUN_TEST(test_pid_integrates_once_per_update);
+    RUN_TEST(test_pid_derivative_on_measurement);
+    RUN_TEST(test_pid_axes_match_scalar);
 
     // Attitude Estimator Tests
     RUN_TEST(test_attitude_estimator_initialization);
     RUN_TEST(test_attitude_estimator_level);
+    RUN_TEST(test_attitude_filters_converge_to_accel_tilt);
+    RUN_TEST(test_attitude_filters_learn_gyro_bias);
+    RUN_TEST(test_quaternion_from_attitude_round_trip);
+    RUN_TEST(test_quaternion_attitude_error_small_matches_euler);
+    RUN_TEST(test_quaternion_attitude_error_no_wrap_or_gimbal_lock);
+
+    // MPU6050 asynchronous read tests (mock I2C bus)
+    RUN_TEST(test_mpu6050_async_decodes_burst);
+    RUN_TEST(test_mpu6050_async_double_buffer);
+    RUN_TEST(test_mpu6050_async_rejects_overlap);
+    RUN_TEST(test_mpu6050_async_error_keeps_previous);
+    RUN_TEST(test_mpu6050_async_does_not_block);
+    RUN_TEST(test_mpu6050_async_averages_fresh_samples);
+    RUN_TEST(test_mpu6050_init_without_bus_fails);
+
+    // MPU6050 FIFO tests (synthetic register dumps)
+    RUN_TEST(test_mpu6050_fifo_parse_frames);
+    RUN_TEST(test_mpu6050_fifo_parse_respects_max);
+    RUN_TEST(test_mpu6050_fifo_enable_configures_registers);
+    RUN_TEST(test_mpu6050_fifo_drain_sequences);
+    RUN_TEST(test_mpu6050_fifo_drain_overflow);
+    RUN_TEST(test_mpu6050_fifo_drain_overflow_status);
+    RUN_TEST(test_mpu6050_fifo_drain_amortizes_bus);
+
+    // Control loop trigger tests (fake interrupt source)
+    RUN_TEST(test_loop_trigger_follows_data_ready);
+    RUN_TEST(test_loop_trigger_falls_back_when_silent);
+    RUN_TEST(test_loop_trigger_recovers_from_fallback);
+    RUN_TEST(test_loop_trigger_counts_missed_irqs);
+    RUN_TEST(test_loop_trigger_fallback_skips_after_overrun);
+
+    // Inter-core SPSC ring tests
+    RUN_TEST(test_spsc_ring_rejects_bad_capacity);
+    RUN_TEST(test_spsc_ring_fifo_order);
+    RUN_TEST(test_spsc_ring_full_drops);
+    RUN_TEST(test_spsc_ring_wraparound);
+    RUN_TEST(test_spsc_ring_pop_latest);
+    #ifdef HOST_BUILD
+    RUN_TEST(test_spsc_ring_threaded_stress);
+    RUN_TEST(test_spsc_ring_threaded_latest_stress);
+    #endif
+
+    // Multi-rate scheduler tests (fake clock)
+    RUN_TEST(test_scheduler_rejects_bad_rates);
+    RUN_TEST(test_scheduler_runs_integer_divided_rates);
+    RUN_TEST(test_scheduler_late_polls_do_not_drift);
+    RUN_TEST(test_scheduler_reports_jitter);
+    RUN_TEST(test_scheduler_counts_overruns);
+    RUN_TEST(test_scheduler_next_deadline);
+
+    // Loop profiler tests
+    RUN_TEST(test_loop_profiler_min_max_mean);
+    RUN_TEST(test_loop_profiler_histogram_buckets);
+    RUN_TEST(test_loop_profiler_reset);
+    RUN_TEST(test_loop_profiler_probe_pair_records);
+    #ifdef HOST_BUILD
+    RUN_TEST(test_loop_profiler_threaded_snapshot);
+    #endif
+
+    // Telemetry framing and channel tests
+    RUN_TEST(test_framing_crc16_check_value);
+    RUN_TEST(test_framing_cobs_round_trip);
+    RUN_TEST(test_framing_cobs_long_runs);
+    RUN_TEST(test_framing_rejects_corruption);
+    RUN_TEST(test_telemetry_drain_survives_partial_writes);
+    RUN_TEST(test_telemetry_counts_dropped_records);
+    RUN_TEST(test_telemetry_decoder_resyncs_after_garbage);
+
+    // Deferred logging tests
+    #ifdef HOST_BUILD
+    RUN_TEST(test_logger_format_words);
+    RUN_TEST(test_logger_deferred_round_trip);
+    RUN_TEST(test_logger_core1_records_wait_for_core0);
+    #endif
+    RUN_TEST(test_logger_drops_without_channel);
+    #ifndef HOST_BUILD
+    RUN_TEST(test_logger_target_cost);
+    #endif
+
+    // Blackbox recorder tests (RAM flash model)
+    RUN_TEST(test_blackbox_varint_round_trip);
+    RUN_TEST(test_blackbox_round_trip);
+    RUN_TEST(test_blackbox_decimation);
+    RUN_TEST(test_blackbox_dropped_pages_resync);
+    RUN_TEST(test_blackbox_appends_sessions);
+    RUN_TEST(test_blackbox_erases_only_when_prepared);
+    RUN_TEST(test_blackbox_flush_stops_at_prepared_space);
+
+    // Mixer and host replay tests (synthetic traces)
+    RUN_TEST(test_mixer_quad_x);
+    #ifdef HOST_BUILD
+    RUN_TEST(test_replay_parse_line);
+    RUN_TEST(test_replay_is_deterministic);
+    RUN_TEST(test_replay_reports_first_mismatch);
+    RUN_TEST(test_replay_tilt_error_against_truth);
+    #endif
+
+    // Fixed-point path tests (bit-exact golden values)
+    RUN_TEST(test_fixed_point_saturating_arithmetic);
+    RUN_TEST(test_fixed_point_conversions);
+    RUN_TEST(test_fixed_point_sensor_scaling);
+    RUN_TEST(test_fixed_point_estimator_tracks_float);
+    RUN_TEST(test_fixed_point_pid_tracks_float);
+    RUN_TEST(test_fixed_point_duty_within_one_count);
+    RUN_TEST(test_fixed_point_mixer_saturates);
+
+    // Fast math kernels (grids against libm; fast_math_check is exhaustive)
+    RUN_TEST(test_fast_math_inv_sqrt);
+    RUN_TEST(test_fast_math_atan2_quadrants);
+    RUN_TEST(test_fast_math_asin);
+    RUN_TEST(test_fast_math_sin_cos);
+    RUN_TEST(test_fast_math_attitude_within_bounds);
+
+    // Q15 FFT, the dynamic gyro notch and the RPM notches (synthetic tones)
+    RUN_TEST(test_fft_q15_single_tone);
+    RUN_TEST(test_fft_q15_matches_dft);
+    RUN_TEST(test_fft_q15_stages_match_whole_transform);
+    RUN_TEST(test_fft_q15_hann_window);
+    RUN_TEST(test_dyn_notch_finds_tone);
+    RUN_TEST(test_dyn_notch_finds_two_tones);
+    RUN_TEST(test_dyn_notch_tracks_moving_tone);
+    RUN_TEST(test_dyn_notch_attenuates_tone_passes_motion);
+    RUN_TEST(test_dyn_notch_ignores_white_noise);
+    RUN_TEST(test_dyn_notch_step_cost_within_budget);
+    RUN_TEST(test_rpm_notch_attenuates_harmonics_passes_motion);
+    RUN_TEST(test_rpm_notch_tracks_rpm_incrementally);
+    RUN_TEST(test_rpm_notch_off_when_stopped_or_out_of_band);
 
+    // DShot frames, and their waveform on the PIO model
+    RUN_TEST(test_dshot_frame_crc);
+    RUN_TEST(test_dshot_throttle_values);
+    RUN_TEST(test_dshot_pack_interleaves_motors);
+    RUN_TEST(test_dshot_clock_div);
+    RUN_TEST(test_dshot_bidir_frame_crc);
+    RUN_TEST(test_dshot_gcr_round_trip);
+    RUN_TEST(test_dshot_gcr_detects_corruption);
+    RUN_TEST(test_dshot_telemetry_decodes_capture);
+    #ifdef HOST_BUILD
+    RUN_TEST(test_dshot_pio_bit_timing);
+    RUN_TEST(test_dshot_pio_frames_back_to_back);
+    RUN_TEST(test_dshot_esc_output);
+    RUN_TEST(test_dshot_bidir_pio_timing);
+    RUN_TEST(test_dshot_esc_telemetry);
+    #endif
+
+    #ifdef HOST_BUILD
+    // Linux HAL backend and the whole loop on the host (simulated IMU)
+    RUN_TEST(test_hal_virtual_time);
+    RUN_TEST(test_hal_loop_trigger_on_gpio_edge);
+    RUN_TEST(test_hal_esc_pwm_levels);
+    RUN_TEST(test_hal_esc_oneshot_synced);
+    RUN_TEST(test_hal_mpu6050_over_simulated_bus);
+    RUN_TEST(test_hal_mpu6050_counts_skipped_samples);
+    RUN_TEST(test_hal_flight_controller_runs_on_host);
+    RUN_TEST(test_hal_flight_controller_cascade);
+    RUN_TEST(test_hal_flight_controller_static_stack);
+
+    // Quad simulator and software-in-the-loop flights
+    RUN_TEST(test_sim_hover_and_free_fall);
+    RUN_TEST(test_sim_mixer_outputs_give_positive_torques);
+    RUN_TEST(test_sim_imu_reads_gravity_and_rates);
+    RUN_TEST(test_sil_decodes_esc_output);
+    RUN_TEST(test_sil_is_deterministic);
+    #endif
+
+    #ifndef HOST_BUILD
     // MPU6050 Tests - only run if hardware is available
     RUN_TEST(test_mpu6050_initialization);
     RUN_TEST(test_mpu6050_connection);
     RUN_TEST(test_mpu6050_calibration);
     RUN_TEST(test_mpu6050_scaling);
     RUN_TEST(test_mpu6050_read_operations);
+    #endif
 
     return UNITY_END();
 }
@@ -0,0 +1,75 @@
+#include "bench.h"
+#include "utils/loop_profiler.h"
+#include <stdlib.h>
+
+#define BENCH_WARMUP_SAMPLES 8
+
+static uint32_t ticks[BENCH_MAX_SAMPLES];
+static uint32_t deviations[BENCH_MAX_SAMPLES];
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorted batch timings in ticks[]; the first runs warm caches and branch
+// predictors (and the XIP cache on the RP2040) and are thrown away
+static uint32_t sample(bench_fn_t run, uint32_t batch, uint32_t samples) {
+    if (samples > BENCH_MAX_SAMPLES) samples = BENCH_MAX_SAMPLES;
+    if (samples == 0) samples = 1;
+
+    for (uint32_t i = 0; i < BENCH_WARMUP_SAMPLES; i++) run(batch);
+    for (uint32_t i = 0; i < samples; i++) {
+        uint32_t start = profile_now();
+        run(batch);
+        ticks[i] = profile_elapsed(start, profile_now());
+    }
+    qsort(ticks, samples, sizeof(ticks[0]), compare_u32);
+    return samples;
+}
+
+uint32_t bench_overhead(bench_fn_t empty, uint32_t batch, uint32_t samples) {
+    samples = sample(empty, batch, samples);
+    return ticks[samples / 2];
+}
+
+void bench_run(const bench_case_t* bench, uint32_t batch, uint32_t samples,
+               uint32_t overhead, bench_result_t* result) {
+    samples = sample(bench->run, batch, samples);
+
+    uint32_t median = ticks[samples / 2];
+    for (uint32_t i = 0; i < samples; i++) {
+        deviations[i] = ticks[i] > median ? ticks[i] - median : median - ticks[i];
+    }
+    qsort(deviations, samples, sizeof(deviations[0]), compare_u32);
+
+    float per_call = 1.0f / (float)batch;
+    float base = (float)overhead;
+    result->name = bench->name;
+    result->median = ((float)median - base) * per_call;
+    result->min = ((float)ticks[0] - base) * per_call;
+    result->p90 = ((float)ticks[(samples * 9) / 10] - base) * per_call;
+    result->mad = (float)deviations[samples / 2] * per_call;
+}
+
+void bench_write_json(FILE* f, const bench_env_t* env, const bench_result_t* results,
+                      size_t count) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"target\": \"%s\",\n", env->target);
+    fprintf(f, "  \"revision\": \"%s\",\n", env->revision);
+    fprintf(f, "  \"tick\": \"%s\",\n", env->tick);
+    fprintf(f, "  \"tick_hz\": %lu,\n", (unsigned long)env->tick_hz);
+    fprintf(f, "  \"batch\": %lu,\n", (unsigned long)env->batch);
+    fprintf(f, "  \"samples\": %lu,\n", (unsigned long)env->samples);
+    fprintf(f, "  \"overhead\": %.2f,\n", (double)env->overhead);
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const bench_result_t* r = &results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"median\": %.2f, \"min\": %.2f, \"p90\": %.2f, "
+                   "\"mad\": %.2f}%s\n",
+                r->name, (double)r->median, (double)r->min, (double)r->p90, (double)r->mad,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
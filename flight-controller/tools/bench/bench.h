@@ -0,0 +1,52 @@
+// flight-controller/tools/bench/bench.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Microbenchmark harness shared by the host and RP2040 builds of fc_bench.
+//
+// A case runs its function `batch` times between two profile_now() reads.
+// That is one sample. The harness takes `samples` samples after a warm-up
+// and reports robust statistics per call: median, min, 90th percentile and
+// median absolute deviation. The empty loop's median is subtracted first.
+// Ticks are nanoseconds on the host and SysTick cycles on the RP2040 (see
+// loop_profiler.h). On the RP2040 a batch must stay under 2^24 cycles.
+
+#define BENCH_MAX_SAMPLES 1001
+
+typedef void (*bench_fn_t)(uint32_t iterations);
+
+typedef struct {
+    const char* name;
+    bench_fn_t run;
+} bench_case_t;
+
+typedef struct {
+    const char* name;
+    float median;               // Ticks per call
+    float min;
+    float p90;
+    float mad;
+} bench_result_t;
+
+typedef struct {
+    const char* target;         // "host" or "rp2040"
+    const char* revision;       // Source revision the binary was built from
+    const char* tick;           // "ns" or "cycle"
+    uint32_t tick_hz;
+    uint32_t batch;
+    uint32_t samples;
+    float overhead;             // Empty loop, ticks per call
+} bench_env_t;
+
+// Median ticks of one whole batch of the empty case, to pass to bench_run()
+uint32_t bench_overhead(bench_fn_t empty, uint32_t batch, uint32_t samples);
+
+void bench_run(const bench_case_t* bench, uint32_t batch, uint32_t samples,
+               uint32_t overhead, bench_result_t* result);
+
+// One JSON object, one result per line so reports diff cleanly
+void bench_write_json(FILE* f, const bench_env_t* env, const bench_result_t* results,
+                      size_t count);
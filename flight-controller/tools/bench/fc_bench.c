@@ -0,0 +1,528 @@
+// Microbenchmarks of the flight loop's math: the estimator (each of its
+// filters) and its steps,
+// Euler conversion, the PID update, the mixer and the ESC duty conversion,
+// DShot frames and telemetry, the gyro notches and the dynamic one's FFT,
+// each also in its FC_FIXED_POINT form (the *_q cases), and the libm
+// calls the estimator makes next to their math/fast_math.h versions. The same
+// cases build for the host (nanoseconds) and for the RP2040 (SysTick
+// cycles at clk_sys), and both print the same JSON report.
+//
+//   fc_bench                        report on stdout
+//   fc_bench -s 501 -o bench.json   more samples, written to a file
+//
+// On the RP2040 the report is printed over USB serial once a host
+// connects, then again every 10 s.
+#include "bench.h"
+#include "core/attitude_estimator.h"
+#include "core/dyn_notch.h"
+#include "core/mixer.h"
+#include "core/pid_controller.h"
+#include "core/rpm_notch.h"
+#include "drivers/dshot.h"
+#include "drivers/esc.h"
+#include "drivers/hal.h"
+#include "include/config.h"
+#include "math/fast_math.h"
+#include "math/fft_q15.h"
+#include "utils/loop_profiler.h"
+#include <math.h>
+#include <stdlib.h>
+
+#ifndef BENCH_REVISION
+#define BENCH_REVISION "unknown"
+#endif
+
+#define BENCH_INPUTS         64     // Power of two: inputs are picked with i & mask
+#define BENCH_INPUT_MASK     (BENCH_INPUTS - 1)
+#define BENCH_DEFAULT_BATCH  64
+#define BENCH_DEFAULT_SAMPLES 101
+
+// Inputs vary from call to call so nothing can be hoisted out of the loop
+static vector3_t accel_in[BENCH_INPUTS];
+static vector3_t gyro_in[BENCH_INPUTS];
+static quaternion_t quat_in[BENCH_INPUTS];
+static attitude_estimator_t estimators[BENCH_INPUTS];
+static float error_in[BENCH_INPUTS];
+static float throttle_in[BENCH_INPUTS];
+static float unit_in[BENCH_INPUTS];
+static float angle_in[BENCH_INPUTS];
+static vector3_q15_t accel_q_in[BENCH_INPUTS];
+static vector3_q15_t gyro_q_in[BENCH_INPUTS];
+static q31_t error_q_in[BENCH_INPUTS];
+static q15_t throttle_q_in[BENCH_INPUTS];
+static vector3_t vibration_in[BENCH_INPUTS];
+static q15_t fft_in[BENCH_INPUTS];
+static uint32_t erpm_in[BENCH_INPUTS][RPM_NOTCH_MOTORS];
+static uint32_t telemetry_capture[DSHOT_TELEMETRY_WORDS];
+
+static attitude_estimator_t* estimator;
+static attitude_estimator_t* mahony;
+static attitude_estimator_t* madgwick;
+static pid_controller_t* pid;
+static pid_controller_t* pid_pitch;
+static pid_controller_t* pid_yaw;
+static pid_axes_t pid_axes;
+static attitude_estimator_q_t estimator_q;
+static pid_controller_q_t pid_q;
+static esc_duty_range_t duty_range;
+static dyn_notch_t notch;
+static rpm_notch_t rpm_notch;
+
+static volatile float sink_f;
+static volatile uint32_t sink_u;
+
+// xorshift32, so every build sees the same inputs
+static float uniform(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)(x >> 8) / 8388608.0f - 1.0f;
+}
+
+static void make_inputs(void) {
+    uint32_t state = 12345u;
+    for (int i = 0; i < BENCH_INPUTS; i++) {
+        quaternion_t q = { 1.0f, 0.3f * uniform(&state), 0.3f * uniform(&state),
+                           0.3f * uniform(&state) };
+        float inv_norm = 1.0f / sqrtf(q.q0 * q.q0 + q.q1 * q.q1 + q.q2 * q.q2 + q.q3 * q.q3);
+        q.q0 *= inv_norm;
+        q.q1 *= inv_norm;
+        q.q2 *= inv_norm;
+        q.q3 *= inv_norm;
+        quat_in[i] = q;
+        estimators[i] = *estimator;
+        estimators[i].quaternion = q;
+
+        // Gravity in the body frame at attitude q, in sensor counts (+/-8 g)
+        accel_in[i].x = 4096.0f * (2.0f * (q.q1 * q.q3 - q.q0 * q.q2) + 0.05f * uniform(&state));
+        accel_in[i].y = 4096.0f * (2.0f * (q.q0 * q.q1 + q.q2 * q.q3) + 0.05f * uniform(&state));
+        accel_in[i].z = 4096.0f * (1.0f - 2.0f * (q.q1 * q.q1 + q.q2 * q.q2));
+        gyro_in[i] = (vector3_t){ 200.0f * uniform(&state), 200.0f * uniform(&state),
+                                  50.0f * uniform(&state) };
+        error_in[i] = 10.0f * uniform(&state);
+        throttle_in[i] = 0.5f + 0.6f * uniform(&state);
+        unit_in[i] = uniform(&state);
+        angle_in[i] = 3.14159265f * uniform(&state);
+
+        // The same values in the fixed-point path's units (+/-500 deg/s gyro)
+        accel_q_in[i] = (vector3_q15_t){ q15_from_float(accel_in[i].x / 32768.0f),
+                                         q15_from_float(accel_in[i].y / 32768.0f),
+                                         q15_from_float(accel_in[i].z / 32768.0f) };
+        gyro_q_in[i] = (vector3_q15_t){ q15_from_float(gyro_in[i].x / 500.0f),
+                                        q15_from_float(gyro_in[i].y / 500.0f),
+                                        q15_from_float(gyro_in[i].z / 500.0f) };
+        error_q_in[i] = q31_from_float(error_in[i] / PID_Q_RATE_ERROR_RANGE);
+        throttle_q_in[i] = q15_from_float(throttle_in[i]);
+
+        // Motor noise at 10 / BENCH_INPUTS of the IMU rate, so the inputs
+        // repeat seamlessly and the notch stays locked
+        float tone = 40.0f * sinf(6.28318531f * 10.0f * (float)i / (float)BENCH_INPUTS);
+        vibration_in[i] = (vector3_t){ tone + gyro_in[i].x * 0.01f, gyro_in[i].y * 0.01f,
+                                       0.5f * tone };
+        fft_in[i] = q15_from_float(0.4f * unit_in[i]);
+
+        // The throttle wobbling, so every RPM notch moves each sample
+        for (int m = 0; m < RPM_NOTCH_MOTORS; m++) {
+            erpm_in[i][m] = (uint32_t)(60000.0f + 6000.0f * (float)m +
+                                       3000.0f * sinf(6.28318531f * (float)i / (float)BENCH_INPUTS));
+        }
+    }
+
+    // A reply from every ESC, 3.2 samples to a bit, each a little later
+    for (int w = 0; w < DSHOT_TELEMETRY_WORDS; w++) telemetry_capture[w] = 0xFFFFFFFFu;
+    for (int m = 0; m < DSHOT_MOTORS; m++) {
+        uint32_t levels = dshot_gcr_encode(dshot_erpm_value(20000u + 5000u * (uint32_t)m));
+        int start = 40 + 2 * m;
+        for (int s = start; s < start + DSHOT_TELEMETRY_BITS * 16 / 5; s++) {
+            int bit = (s - start) * 5 / 16;
+            if (!((levels >> (DSHOT_TELEMETRY_BITS - 1 - bit)) & 1u)) {
+                telemetry_capture[s >> 3] &= ~(1u << (28 - 4 * (s & 7) + m));
+            }
+        }
+    }
+}
+
+static void bench_empty(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = error_in[i & BENCH_INPUT_MASK];
+    }
+}
+
+static void run_estimator(attitude_estimator_t* e, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        attitude_estimator_update(e, &accel_in[i & BENCH_INPUT_MASK],
+                                  &gyro_in[i & BENCH_INPUT_MASK], DT);
+    }
+    sink_f = e->quaternion.q0;
+}
+
+static void bench_estimator_update(uint32_t n) {
+    run_estimator(estimator, n);
+}
+
+static void bench_mahony_update(uint32_t n) {
+    run_estimator(mahony, n);
+}
+
+static void bench_madgwick_update(uint32_t n) {
+    run_estimator(madgwick, n);
+}
+
+static void bench_estimator_q_update(uint32_t n) {
+    const q31_t dt = q31_from_float(DT);
+    for (uint32_t i = 0; i < n; i++) {
+        attitude_estimator_q_update(&estimator_q, &accel_q_in[i & BENCH_INPUT_MASK],
+                                    &gyro_q_in[i & BENCH_INPUT_MASK], dt);
+    }
+    sink_u = (uint32_t)estimator_q.quaternion.q0;
+}
+
+static void bench_slerp(uint32_t n) {
+    quaternion_t out;
+    for (uint32_t i = 0; i < n; i++) {
+        quaternion_slerp(&out, &quat_in[i & BENCH_INPUT_MASK],
+                         &quat_in[(i + 1) & BENCH_INPUT_MASK], 0.04f);
+        sink_f = out.q0;
+    }
+}
+
+static void bench_estimate_from_accel(uint32_t n) {
+    quaternion_t out = { 1.0f, 0.0f, 0.0f, 0.0f };
+    for (uint32_t i = 0; i < n; i++) {
+        estimate_from_accel(&out, &accel_in[i & BENCH_INPUT_MASK]);
+        sink_f = out.q1;
+    }
+}
+
+static void bench_get_attitude(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        attitude_t a = attitude_estimator_get_attitude(&estimators[i & BENCH_INPUT_MASK]);
+        sink_f = a.yaw;
+    }
+}
+
+static void bench_attitude_error(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        vector3_t error;
+        quaternion_attitude_error(&error, &quat_in[i & BENCH_INPUT_MASK],
+                                  &quat_in[(i + 1) & BENCH_INPUT_MASK]);
+        sink_f = error.z;
+    }
+}
+
+static void bench_pid_update(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = pid_controller_update(pid, error_in[i & BENCH_INPUT_MASK], DT);
+    }
+}
+
+// The rate loop as three per-axis controllers, and as the engine
+static void bench_pid_update_3(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = pid_controller_update(pid, error_in[i & BENCH_INPUT_MASK], DT);
+        sink_f = pid_controller_update(pid_pitch, error_in[(i + 1) & BENCH_INPUT_MASK], DT);
+        sink_f = pid_controller_update(pid_yaw, error_in[(i + 2) & BENCH_INPUT_MASK], DT);
+    }
+}
+
+static void bench_pid_axes_update(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        const vector3_t error = { error_in[i & BENCH_INPUT_MASK],
+                                  error_in[(i + 1) & BENCH_INPUT_MASK],
+                                  error_in[(i + 2) & BENCH_INPUT_MASK] };
+        vector3_t output;
+        pid_axes_update(&pid_axes, &error, &output);
+        sink_f = output.z;
+    }
+}
+
+static void bench_pid_q_update(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_u = (uint32_t)pid_controller_q_update(&pid_q, error_q_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_mixer(uint32_t n) {
+    float motor[4];
+    for (uint32_t i = 0; i < n; i++) {
+        float u = error_in[i & BENCH_INPUT_MASK] * 0.01f;
+        mixer_quad_x(throttle_in[i & BENCH_INPUT_MASK], u, -u, 0.5f * u, motor);
+        sink_f = motor[0];
+    }
+}
+
+static void bench_mixer_q(uint32_t n) {
+    q15_t motor[4];
+    for (uint32_t i = 0; i < n; i++) {
+        q15_t u = (q15_t)(error_q_in[i & BENCH_INPUT_MASK] >> 22);
+        mixer_quad_x_q15(throttle_q_in[i & BENCH_INPUT_MASK], u, (q15_t)-u, (q15_t)(u / 2),
+                         motor);
+        sink_u = (uint32_t)motor[0];
+    }
+}
+
+static void bench_inv_sqrtf(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = 1.0f / sqrtf(throttle_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_fast_inv_sqrtf(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = fast_inv_sqrtf(throttle_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_atan2f(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = atan2f(unit_in[i & BENCH_INPUT_MASK], unit_in[(i + 1) & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_fast_atan2f(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = fast_atan2f(unit_in[i & BENCH_INPUT_MASK], unit_in[(i + 1) & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_asinf(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = asinf(unit_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_fast_asinf(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = fast_asinf(unit_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_sinf(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = sinf(angle_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_fast_sinf(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_f = fast_sinf(angle_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_throttle_to_duty(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_u = esc_throttle_to_duty(&duty_range, throttle_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+static void bench_throttle_q15_to_duty(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sink_u = esc_throttle_q15_to_duty(&duty_range, throttle_q_in[i & BENCH_INPUT_MASK]);
+    }
+}
+
+// Everything the CPU does for a DShot send: four throttle values, their
+// frames and the packed words handed to DMA
+static void bench_dshot_frames(uint32_t n) {
+    uint16_t frame[DSHOT_MOTORS];
+    uint32_t words[DSHOT_PACKED_WORDS];
+    for (uint32_t i = 0; i < n; i++) {
+        for (int m = 0; m < DSHOT_MOTORS; m++) {
+            float throttle = throttle_in[(i + (uint32_t)m) & BENCH_INPUT_MASK];
+            frame[m] = dshot_frame(dshot_throttle_value(throttle), false);
+        }
+        dshot_pack(frame, words);
+        sink_u = words[0] ^ words[1];
+    }
+}
+
+// The CPU's side of bidirectional DShot: all four replies of a capture
+static void bench_dshot_telemetry_decode(uint32_t n) {
+    uint32_t erpm = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        for (int m = 0; m < DSHOT_MOTORS; m++) {
+            sink_u = (uint32_t)dshot_telemetry_decode(telemetry_capture, m, &erpm);
+        }
+        sink_u = erpm;
+    }
+}
+
+// One whole 64-point transform per iteration
+static void bench_fft_q15_64(uint32_t n) {
+    static q15_t re[64], im[64];
+    for (uint32_t i = 0; i < n; i++) {
+        for (int k = 0; k < 64; k++) {
+            re[k] = fft_in[(i + k) & BENCH_INPUT_MASK];
+            im[k] = 0;
+        }
+        fft_q15(re, im, 6);
+        sink_u = (uint32_t)re[i & 63];
+    }
+}
+
+// The mean over the analysis steps, with both notches running on two axes
+static void bench_dyn_notch_update(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        vector3_t g = vibration_in[i & BENCH_INPUT_MASK];
+        dyn_notch_update(&notch, &g, IMU_DT);
+        sink_f = g.x;
+    }
+}
+
+// New eRPM and a sample, as each sensor step sees them: every notch turned
+// a little, and now and then one retuned with cosf() and sinf()
+static void bench_rpm_notch_update(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        vector3_t g = vibration_in[i & BENCH_INPUT_MASK];
+        rpm_notch_set_erpm(&rpm_notch, erpm_in[i & BENCH_INPUT_MASK]);
+        rpm_notch_update(&rpm_notch, &g, IMU_DT);
+        sink_f = g.x;
+    }
+}
+
+static const bench_case_t CASES[] = {
+    { "attitude_estimator_update", bench_estimator_update },
+    { "attitude_estimator_update_mahony", bench_mahony_update },
+    { "attitude_estimator_update_madgwick", bench_madgwick_update },
+    { "quaternion_slerp", bench_slerp },
+    { "estimate_from_accel", bench_estimate_from_accel },
+    { "attitude_estimator_get_attitude", bench_get_attitude },
+    { "quaternion_attitude_error", bench_attitude_error },
+    { "pid_controller_update", bench_pid_update },
+    { "pid_controller_update_x3", bench_pid_update_3 },
+    { "pid_axes_update", bench_pid_axes_update },
+    { "mixer_quad_x", bench_mixer },
+    { "esc_throttle_to_duty", bench_throttle_to_duty },
+    { "dshot_frames", bench_dshot_frames },
+    { "dshot_telemetry_decode", bench_dshot_telemetry_decode },
+    { "fft_q15_64", bench_fft_q15_64 },
+    { "dyn_notch_update", bench_dyn_notch_update },
+    { "rpm_notch_update", bench_rpm_notch_update },
+    { "attitude_estimator_update_q", bench_estimator_q_update },
+    { "pid_controller_update_q", bench_pid_q_update },
+    { "mixer_quad_x_q", bench_mixer_q },
+    { "esc_throttle_to_duty_q", bench_throttle_q15_to_duty },
+    { "inv_sqrtf", bench_inv_sqrtf },
+    { "fast_inv_sqrtf", bench_fast_inv_sqrtf },
+    { "atan2f", bench_atan2f },
+    { "fast_atan2f", bench_fast_atan2f },
+    { "asinf", bench_asinf },
+    { "fast_asinf", bench_fast_asinf },
+    { "sinf", bench_sinf },
+    { "fast_sinf", bench_fast_sinf },
+};
+
+#define BENCH_CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+static bool bench_setup(void) {
+    estimator = attitude_estimator_init();
+    mahony = attitude_estimator_init();
+    madgwick = attitude_estimator_init();
+    pid = pid_controller_init(PID_ROLL_KP, PID_ROLL_KI, PID_ROLL_KD);
+    pid_pitch = pid_controller_init(PID_PITCH_KP, PID_PITCH_KI, PID_PITCH_KD);
+    pid_yaw = pid_controller_init(PID_YAW_KP, PID_YAW_KI, PID_YAW_KD);
+    if (estimator == NULL || mahony == NULL || madgwick == NULL || pid == NULL ||
+        pid_pitch == NULL || pid_yaw == NULL || !pid_axes_init(&pid_axes, DT)) {
+        return false;
+    }
+    pid_axes_set_gains(&pid_axes, PID_AXIS_ROLL, PID_ROLL_KP, PID_ROLL_KI, PID_ROLL_KD);
+    pid_axes_set_gains(&pid_axes, PID_AXIS_PITCH, PID_PITCH_KP, PID_PITCH_KI, PID_PITCH_KD);
+    pid_axes_set_gains(&pid_axes, PID_AXIS_YAW, PID_YAW_KP, PID_YAW_KI, PID_YAW_KD);
+    attitude_estimator_set_filter(estimator, ATTITUDE_FILTER_COMPLEMENTARY);
+    attitude_estimator_set_filter(mahony, ATTITUDE_FILTER_MAHONY);
+    attitude_estimator_set_filter(madgwick, ATTITUDE_FILTER_MADGWICK);
+    attitude_estimator_q_init(&estimator_q, mahony, 500.0f);
+    pid_controller_q_init(&pid_q, pid, DT, PID_Q_RATE_ERROR_RANGE);
+    esc_duty_range_init(&duty_range, &DEFAULT_ESC_CONFIG);
+    make_inputs();
+    dyn_notch_init(&notch, DYN_NOTCH_MIN_HZ, DYN_NOTCH_MAX_HZ, DYN_NOTCH_Q);
+    bench_dyn_notch_update(2000);
+    rpm_notch_init(&rpm_notch, MOTOR_POLES, RPM_NOTCH_MIN_HZ, RPM_NOTCH_Q);
+    bench_rpm_notch_update(2 * RPM_NOTCH_COUNT);
+    loop_profiler_init_core();
+    return true;
+}
+
+static void bench_report(FILE* f, bench_env_t* env) {
+    static bench_result_t results[BENCH_CASE_COUNT];
+    uint32_t overhead = bench_overhead(bench_empty, env->batch, env->samples);
+
+    env->overhead = (float)overhead / (float)env->batch;
+    for (size_t i = 0; i < BENCH_CASE_COUNT; i++) {
+        bench_run(&CASES[i], env->batch, env->samples, overhead, &results[i]);
+    }
+    bench_write_json(f, env, results, BENCH_CASE_COUNT);
+}
+
+#ifdef HOST_BUILD
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    bench_env_t env = {
+        .target = "host",
+        .revision = BENCH_REVISION,
+        .tick = "ns",
+        .tick_hz = 1000000000u,
+        .batch = BENCH_DEFAULT_BATCH,
+        .samples = BENCH_DEFAULT_SAMPLES
+    };
+    const char* out_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:o:h")) != -1) {
+        switch (opt) {
+        case 'n': env.batch = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 's': env.samples = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'o': out_path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-n batch] [-s samples (max %d)] [-o report.json]\n",
+                    argv[0], BENCH_MAX_SAMPLES);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (env.batch == 0) env.batch = 1;
+    if (env.samples == 0 || env.samples > BENCH_MAX_SAMPLES) env.samples = BENCH_MAX_SAMPLES;
+
+    if (hal_init() != 0 || !bench_setup()) {
+        fprintf(stderr, "benchmark setup failed\n");
+        return 1;
+    }
+
+    FILE* f = out_path != NULL ? fopen(out_path, "w") : stdout;
+    if (f == NULL) {
+        perror(out_path);
+        return 1;
+    }
+    bench_report(f, &env);
+    if (f != stdout) fclose(f);
+    return 0;
+}
+#else
+#include "hardware/clocks.h"
+#include "pico/stdlib.h"
+
+int main(void) {
+    hal_init();
+    if (!bench_setup()) return 1;
+
+    while (!stdio_usb_connected()) {
+        sleep_ms(100);
+    }
+
+    bench_env_t env = {
+        .target = "rp2040",
+        .revision = BENCH_REVISION,
+        .tick = "cycle",
+        .tick_hz = clock_get_hz(clk_sys),
+        .batch = BENCH_DEFAULT_BATCH,
+        .samples = BENCH_DEFAULT_SAMPLES
+    };
+    while (true) {
+        bench_report(stdout, &env);
+        hal_console_flush();
+        sleep_ms(10000);
+    }
+}
+#endif
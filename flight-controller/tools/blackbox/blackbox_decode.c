@@ -0,0 +1,65 @@
+// Convert a blackbox flash dump to CSV on stdout.
+//
+//   picotool save -r 0x10100000 0x10200000 blackbox.bin
+//   blackbox_decode blackbox.bin > flight.csv
+#include "blackbox_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void print_session(const blackbox_header_t* header, uint32_t session, void* ctx) {
+    (void)ctx;
+    fprintf(stderr, "session %u: version %u, %u Hz, decimation %u\n",
+            (unsigned)session, (unsigned)header->version,
+            (unsigned)header->loop_rate_hz, (unsigned)header->decimation);
+}
+
+static void print_frame(const blackbox_frame_t* frame, uint32_t session, void* ctx) {
+    (void)ctx;
+    char row[512];
+    blackbox_csv_row(frame, session, row, sizeof(row));
+    puts(row);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <blackbox dump>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t* image = malloc(len > 0 ? (size_t)len : 1);
+    if (image == NULL || fread(image, 1, (size_t)len, f) != (size_t)len) {
+        fprintf(stderr, "%s: read failed\n", argv[1]);
+        fclose(f);
+        free(image);
+        return 1;
+    }
+    fclose(f);
+
+    char header[512];
+    blackbox_csv_header(header, sizeof(header));
+    puts(header);
+
+    blackbox_decoder_sink_t sink = {
+        .on_session = print_session,
+        .on_frame = print_frame,
+        .ctx = NULL
+    };
+    blackbox_decoder_stats_t stats;
+    blackbox_decode(image, (size_t)len, &sink, &stats);
+
+    fprintf(stderr, "pages=%u sessions=%u frames=%u gaps=%u skipped=%u corrupt=%u\n",
+            (unsigned)stats.pages, (unsigned)stats.sessions, (unsigned)stats.frames,
+            (unsigned)stats.page_gaps, (unsigned)stats.skipped_frames, (unsigned)stats.corrupt);
+
+    free(image);
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "blackbox_decoder.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PAYLOAD_SIZE (BLACKBOX_PAGE_SIZE - BLACKBOX_PAGE_HEADER)
+
+typedef struct {
+    const blackbox_decoder_sink_t* sink;
+    blackbox_decoder_stats_t* stats;
+    int32_t prev[BLACKBOX_FIELD_COUNT];
+    int32_t prev2[BLACKBOX_FIELD_COUNT];
+    bool have_intra;
+    uint32_t session;
+} decoder_t;
+
+// Reads count varints; 0 if the stream ends first
+static size_t read_varints(const uint8_t* src, size_t len, int32_t* values, int count) {
+    size_t used = 0;
+    for (int i = 0; i < count; i++) {
+        size_t n = blackbox_get_varint(src + used, len - used, &values[i]);
+        if (n == 0) return 0;
+        used += n;
+    }
+    return used;
+}
+
+// Decode one frame at src. Returns bytes consumed, or 0 if the bytes do not
+// form a frame.
+static size_t decode_frame(decoder_t* dec, const uint8_t* src, size_t len) {
+    int32_t values[BLACKBOX_FIELD_COUNT];
+    size_t n;
+
+    switch (src[0]) {
+        case BLACKBOX_FRAME_HEADER: {
+            n = read_varints(src + 1, len - 1, values, 4);
+            if (n == 0) return 0;
+            blackbox_header_t header = {
+                .version = (uint32_t)values[0],
+                .loop_rate_hz = (uint32_t)values[1],
+                .decimation = (uint32_t)values[2],
+                .field_count = (uint32_t)values[3]
+            };
+            if (header.field_count != BLACKBOX_FIELD_COUNT) return 0;
+            dec->session = dec->stats->sessions++;
+            dec->have_intra = false;
+            if (dec->sink->on_session) dec->sink->on_session(&header, dec->session, dec->sink->ctx);
+            return n + 1;
+        }
+
+        case BLACKBOX_FRAME_INTRA:
+            n = read_varints(src + 1, len - 1, values, BLACKBOX_FIELD_COUNT);
+            if (n == 0) return 0;
+            for (int i = 0; i < BLACKBOX_FIELD_COUNT; i++) dec->prev2[i] = values[i];
+            dec->have_intra = true;
+            break;
+
+        case BLACKBOX_FRAME_PREDICTED: {
+            n = read_varints(src + 1, len - 1, values, BLACKBOX_FIELD_COUNT);
+            if (n == 0) return 0;
+            if (!dec->have_intra) {
+                dec->stats->skipped_frames++;
+                return n + 1;
+            }
+            int32_t predicted[BLACKBOX_FIELD_COUNT];
+            blackbox_predict(dec->prev, dec->prev2, predicted);
+            for (int i = 0; i < BLACKBOX_FIELD_COUNT; i++) {
+                dec->prev2[i] = dec->prev[i];
+                values[i] = (int32_t)((uint32_t)predicted[i] + (uint32_t)values[i]);
+            }
+            break;
+        }
+
+        default:
+            return 0;
+    }
+
+    memcpy(dec->prev, values, sizeof(values));
+    dec->stats->frames++;
+
+    if (dec->sink->on_frame) {
+        blackbox_frame_t frame;
+        blackbox_fields_to_frame(values, &frame);
+        dec->sink->on_frame(&frame, dec->session, dec->sink->ctx);
+    }
+    return n + 1;
+}
+
+// Position of the first frame that starts in a page at or after `page`
+// within [page, end_page), or SIZE_MAX
+static size_t next_frame_start(const uint8_t* image, size_t page, size_t end_page) {
+    for (; page < end_page; page++) {
+        uint8_t first = image[page * BLACKBOX_PAGE_SIZE + 1];
+        if (first >= BLACKBOX_PAGE_HEADER) {
+            return page * PAYLOAD_SIZE + (first - BLACKBOX_PAGE_HEADER);
+        }
+    }
+    return SIZE_MAX;
+}
+
+// Frames are parsed from the page payloads laid end to end; a segment is a
+// run of pages with consecutive sequence numbers
+static void decode_segment(decoder_t* dec, const uint8_t* image, const uint8_t* stream,
+                           size_t first_page, size_t end_page) {
+    size_t end = end_page * PAYLOAD_SIZE;
+    size_t pos = next_frame_start(image, first_page, end_page);
+    dec->have_intra = false;
+
+    while (pos < end) {
+        if (stream[pos] == 0) {
+            // Padding after a stopped session; the next page starts clean
+            pos = (pos / PAYLOAD_SIZE + 1) * PAYLOAD_SIZE;
+            continue;
+        }
+
+        size_t n = decode_frame(dec, stream + pos, end - pos);
+        if (n == 0) {
+            dec->stats->corrupt++;
+            dec->have_intra = false;
+            pos = next_frame_start(image, pos / PAYLOAD_SIZE + 1, end_page);
+            continue;
+        }
+        pos += n;
+    }
+}
+
+void blackbox_decode(const uint8_t* image, size_t len, const blackbox_decoder_sink_t* sink,
+                     blackbox_decoder_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+    decoder_t dec = { .sink = sink, .stats = stats };
+
+    size_t pages = 0;
+    while (pages < len / BLACKBOX_PAGE_SIZE &&
+           image[pages * BLACKBOX_PAGE_SIZE] == BLACKBOX_PAGE_MAGIC) {
+        pages++;
+    }
+    stats->pages = (uint32_t)pages;
+    if (pages == 0) return;
+
+    uint8_t* stream = malloc(pages * PAYLOAD_SIZE);
+    if (stream == NULL) return;
+    for (size_t p = 0; p < pages; p++) {
+        memcpy(stream + p * PAYLOAD_SIZE, image + p * BLACKBOX_PAGE_SIZE + BLACKBOX_PAGE_HEADER,
+               PAYLOAD_SIZE);
+    }
+
+    size_t segment_start = 0;
+    for (size_t p = 1; p <= pages; p++) {
+        bool gap = false;
+        if (p < pages) {
+            const uint8_t* prev = image + (p - 1) * BLACKBOX_PAGE_SIZE;
+            const uint8_t* page = image + p * BLACKBOX_PAGE_SIZE;
+            uint16_t prev_seq = (uint16_t)(prev[2] | (prev[3] << 8));
+            uint16_t seq = (uint16_t)(page[2] | (page[3] << 8));
+            gap = seq != (uint16_t)(prev_seq + 1);
+        }
+        if (p == pages || gap) {
+            decode_segment(&dec, image, stream, segment_start, p);
+            if (gap) stats->page_gaps++;
+            segment_start = p;
+        }
+    }
+
+    free(stream);
+}
+
+void blackbox_csv_header(char* out, size_t cap) {
+    snprintf(out, cap,
+             "session,time_us,iteration,accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z,"
+             "q0,q1,q2,q3,roll_p,roll_i,roll_d,pitch_p,pitch_i,pitch_d,yaw_p,yaw_i,yaw_d,"
+             "motor1,motor2,motor3,motor4");
+}
+
+void blackbox_csv_row(const blackbox_frame_t* f, uint32_t session, char* out, size_t cap) {
+    snprintf(out, cap,
+             "%u,%u,%u,%d,%d,%d,%d,%d,%d,"
+             "%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,"
+             "%.4f,%.4f,%.4f,%.4f",
+             (unsigned)session, (unsigned)f->time_us, (unsigned)f->iteration,
+             f->accel[0], f->accel[1], f->accel[2], f->gyro[0], f->gyro[1], f->gyro[2],
+             f->quaternion[0], f->quaternion[1], f->quaternion[2], f->quaternion[3],
+             f->pid[0][0], f->pid[0][1], f->pid[0][2],
+             f->pid[1][0], f->pid[1][1], f->pid[1][2],
+             f->pid[2][0], f->pid[2][1], f->pid[2][2],
+             f->motor[0], f->motor[1], f->motor[2], f->motor[3]);
+}
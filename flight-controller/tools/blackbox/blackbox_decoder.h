@@ -0,0 +1,32 @@
+// flight-controller/tools/blackbox/blackbox_decoder.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/blackbox.h"
+
+// Host-side decoder for a blackbox log region dumped from flash, e.g.
+//   picotool save -r 0x10100000 0x10200000 blackbox.bin
+
+typedef struct {
+    void (*on_session)(const blackbox_header_t* header, uint32_t session, void* ctx);
+    void (*on_frame)(const blackbox_frame_t* frame, uint32_t session, void* ctx);
+    void* ctx;
+} blackbox_decoder_sink_t;
+
+typedef struct {
+    uint32_t pages;
+    uint32_t sessions;
+    uint32_t frames;
+    uint32_t page_gaps;         // Sequence breaks: pages dropped on the device
+    uint32_t skipped_frames;    // Predicted frames with no intra frame to build on
+    uint32_t corrupt;           // Unknown markers or truncated frames
+} blackbox_decoder_stats_t;
+
+// Decode every session in image (len bytes, a multiple of the page size)
+void blackbox_decode(const uint8_t* image, size_t len, const blackbox_decoder_sink_t* sink,
+                     blackbox_decoder_stats_t* stats);
+
+// CSV helpers used by blackbox_decode's command line tool
+void blackbox_csv_header(char* out, size_t cap);
+void blackbox_csv_row(const blackbox_frame_t* frame, uint32_t session, char* out, size_t cap);
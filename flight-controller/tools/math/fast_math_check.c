@@ -0,0 +1,149 @@
+// Check the fast_math kernels against double-precision libm on every float
+// of their domains, and compare the worst error with the bound the header
+// documents.
+//
+//   fast_math_check            every float (about 4 * 10^9 inputs)
+//   fast_math_check -s 1000    every 1000th float, for a quick look
+//
+// Exits 1 if any kernel exceeds its documented bound.
+#include "math/fast_math.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    double max_error;
+    float worst_input;
+    uint64_t count;
+} sweep_t;
+
+typedef double (*error_fn_t)(float x);
+
+static float from_bits(uint32_t bits) {
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+static uint32_t to_bits(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+// Every stride-th float from lo to hi, both non-negative
+static void sweep(error_fn_t error, float lo, float hi, uint32_t stride, sweep_t* result) {
+    uint32_t end = to_bits(hi);
+    for (uint32_t bits = to_bits(lo); bits <= end; bits += stride) {
+        float x = from_bits(bits);
+        double e = error(x);
+        if (e > result->max_error) {
+            result->max_error = e;
+            result->worst_input = x;
+        }
+        result->count++;
+        if (end - bits < stride) break;
+    }
+}
+
+static double inv_sqrt_error(float x) {
+    double expected = 1.0 / sqrt((double)x);
+    return fabs((double)fast_inv_sqrtf(x) - expected) / expected;
+}
+
+// Both octant branches on |z| <= 1, in the first quadrant
+static double atan2_error(float z) {
+    double a = fabs((double)fast_atan2f(z, 1.0f) - atan2((double)z, 1.0));
+    double b = fabs((double)fast_atan2f(1.0f, z) - atan2(1.0, (double)z));
+    return a > b ? a : b;
+}
+
+// Angular distance, so that pi and -pi at the branch cut agree
+static double angle_error(float angle, double expected) {
+    double e = fabs((double)angle - expected);
+    return e > M_PI ? 2.0 * M_PI - e : e;
+}
+
+// All four quadrants
+static double atan2_signs_error(float z) {
+    double e = 0.0;
+    for (int sy = -1; sy <= 1; sy += 2) {
+        for (int sx = -1; sx <= 1; sx += 2) {
+            float y = (float)sy * z, x = (float)sx;
+            double d = angle_error(fast_atan2f(y, x), atan2((double)y, (double)x));
+            double s = angle_error(fast_atan2f(x, y), atan2((double)x, (double)y));
+            if (d > e) e = d;
+            if (s > e) e = s;
+        }
+    }
+    return e;
+}
+
+static double asin_error(float x) {
+    double a = fabs((double)fast_asinf(x) - asin((double)x));
+    double b = fabs((double)fast_asinf(-x) - asin(-(double)x));
+    return a > b ? a : b;
+}
+
+static double sin_error(float x) {
+    double a = fabs((double)fast_sinf(x) - sin((double)x));
+    double b = fabs((double)fast_sinf(-x) - sin(-(double)x));
+    return a > b ? a : b;
+}
+
+static double cos_error(float x) {
+    double a = fabs((double)fast_cosf(x) - cos((double)x));
+    double b = fabs((double)fast_cosf(-x) - cos(-(double)x));
+    return a > b ? a : b;
+}
+
+static bool report(const char* name, const sweep_t* s, double bound) {
+    bool ok = s->max_error <= bound;
+    printf("%-16s %11llu inputs  max error %.3e at %.9g  bound %.1e  %s\n", name,
+           (unsigned long long)s->count, s->max_error, (double)s->worst_input, bound,
+           ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t stride = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:h")) != -1) {
+        switch (opt) {
+        case 's': stride = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default:
+            fprintf(stderr, "usage: %s [-s stride]\n", argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (stride == 0) stride = 1;
+
+    const float two_pi = 6.28318531f;
+    sweep_t inv_sqrt = { 0 }, atan2_unit = { 0 }, atan2_signs = { 0 }, asin_s = { 0 };
+    sweep_t sin_s = { 0 }, cos_s = { 0 };
+
+    // The first guess and both Newton steps commute with scaling x by 4, so
+    // the relative error repeats every two binades: [1, 4) covers all of
+    // them. The sparse sweep over every normal float checks that claim.
+    sweep(inv_sqrt_error, 1.0f, 3.99999976f, stride, &inv_sqrt);
+    sweep(inv_sqrt_error, 1.17549435e-38f, 3.40282347e+38f, stride * 4099u, &inv_sqrt);
+    sweep(atan2_error, 0.0f, 1.0f, stride, &atan2_unit);
+    sweep(atan2_signs_error, 0.0f, 1.0f, stride * 61u, &atan2_signs);
+    sweep(asin_error, 0.0f, 1.0f, stride, &asin_s);
+    sweep(sin_error, 0.0f, two_pi, stride, &sin_s);
+    sweep(cos_error, 0.0f, two_pi, stride, &cos_s);
+
+    bool ok = true;
+    ok &= report("fast_inv_sqrtf", &inv_sqrt, FAST_INV_SQRTF_MAX_REL_ERROR);
+    ok &= report("fast_atan2f", &atan2_unit, FAST_ATAN2F_MAX_ERROR);
+    ok &= report("fast_atan2f +-", &atan2_signs, FAST_ATAN2F_MAX_ERROR);
+    ok &= report("fast_asinf", &asin_s, FAST_ASINF_MAX_ERROR);
+    ok &= report("fast_sinf", &sin_s, FAST_SINF_MAX_ERROR);
+    ok &= report("fast_cosf", &cos_s, FAST_SINF_MAX_ERROR);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+// Replay a recorded trace through the flight controller's sensor and control
+// steps compiled for the host, check the outputs against the trace's reference columns and
+// report the throughput.
+//
+//   fc_replay trace.csv                  check against the reference
+//   fc_replay -w new.csv trace.csv       write this build's outputs
+//   fc_replay -n 200 trace.csv           repeat the run for a steadier rate
+//   fc_replay -g 5000 > trace.csv        synthesize a trace
+//   fc_replay -f mahony trace.csv        replay with another attitude filter
+//   fc_replay -c euler trace.csv         replay with Euler-angle errors
+//   fc_replay -A 20000                   compare the filters' accuracy
+#include "replay.h"
+#include "include/config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_TOLERANCE 1e-4f
+#define STUDY_GYRO_BIAS   2.0f      // deg/s added to every axis in the biased run
+
+static const char* const FILTER_NAMES[] = { "complementary", "mahony", "madgwick" };
+#define FILTER_COUNT (sizeof(FILTER_NAMES) / sizeof(FILTER_NAMES[0]))
+
+// In attitude_control_t order
+static const char* const CONTROL_NAMES[] = { "euler", "quaternion" };
+#define CONTROL_COUNT (sizeof(CONTROL_NAMES) / sizeof(CONTROL_NAMES[0]))
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [-q tol] [-m tol] [-n repeats] [-f filter] [-c control] [-w out.csv] "
+            "<trace.csv>\n"
+            "       %s -g samples [-s seed]\n"
+            "       %s -A samples [-s seed]\n"
+            "  -q  quaternion tolerance (default %g)\n"
+            "  -m  motor output tolerance (default %g)\n"
+            "  -n  replay the trace this many times for timing (default 1)\n"
+            "  -f  attitude filter: complementary, mahony or madgwick (default: config.h)\n"
+            "  -c  attitude error: euler or quaternion (default: config.h)\n"
+            "  -w  write the trace with this build's outputs as a new reference\n"
+            "  -g  write a synthetic trace with reference outputs to stdout\n"
+            "  -A  replay a synthetic flight through every filter, with and without\n"
+            "      gyro bias, and report tilt error against the true attitude\n",
+            prog, prog, prog, (double)DEFAULT_TOLERANCE, (double)DEFAULT_TOLERANCE);
+}
+
+static int parse_filter(const char* name) {
+    for (size_t i = 0; i < FILTER_COUNT; i++) {
+        if (strcmp(name, FILTER_NAMES[i]) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static int parse_control(const char* name) {
+    for (size_t i = 0; i < CONTROL_COUNT; i++) {
+        if (strcmp(name, CONTROL_NAMES[i]) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static bool init_with_filter(replay_t* replay, int filter) {
+    if (!replay_init(replay, DT)) return false;
+    if (filter >= 0) {
+        attitude_estimator_set_filter(replay->fc->attitude_estimator, (attitude_filter_t)filter);
+        flight_controller_sync_fixed(replay->fc);
+    }
+    return true;
+}
+
+static int synthesize(long count, uint32_t seed) {
+    replay_sample_t* samples = malloc((size_t)count * sizeof(*samples));
+    replay_t replay;
+    if (samples == NULL || !replay_init(&replay, DT)) {
+        fprintf(stderr, "out of memory\n");
+        free(samples);
+        return 1;
+    }
+
+    replay_synthesize(samples, (size_t)count, DT, seed);
+    replay_run(&replay, samples, (size_t)count);
+    replay_write_csv(stdout, samples, (size_t)count);
+
+    replay_free(&replay);
+    free(samples);
+    return 0;
+}
+
+// One filter over the flight in output[], gyro bias already applied
+static bool study_filter(int filter, replay_sample_t* output, const quaternion_t* truth,
+                         size_t count, size_t skip, float bias) {
+    replay_t replay;
+    if (!init_with_filter(&replay, filter)) {
+        replay_free(&replay);
+        return false;
+    }
+    double start = now_s();
+    replay_run(&replay, output, count);
+    double elapsed = now_s() - start;
+    replay_free(&replay);
+
+    float rms, max;
+    replay_tilt_error(output + skip, truth + skip, count - skip, &rms, &max);
+    printf("%-14s %5.1f d/s %8.3f deg %8.3f deg %10.1f\n", FILTER_NAMES[filter], (double)bias,
+           (double)rms, (double)max, elapsed * 1e9 / (double)count);
+    return true;
+}
+
+// Every filter on the same synthetic flight. The first second is left out
+// so a filter's start-up transient does not dominate its score.
+static int accuracy_study(long count, uint32_t seed) {
+    replay_sample_t* input = malloc((size_t)count * sizeof(*input));
+    replay_sample_t* output = malloc((size_t)count * sizeof(*output));
+    quaternion_t* truth = malloc((size_t)count * sizeof(*truth));
+    size_t skip = (long)CONTROL_LOOP_FREQ < count ? (size_t)CONTROL_LOOP_FREQ : 0;
+    bool ok = input != NULL && output != NULL && truth != NULL;
+
+    if (ok) {
+        replay_synthesize_truth(input, truth, (size_t)count, DT, seed);
+#if FC_FIXED_POINT
+        printf("FC_FIXED_POINT: every row runs the Q15 Mahony filter of the loop\n");
+#endif
+        printf("%-14s %9s %12s %12s %10s\n", "filter", "bias", "rms_tilt", "max_tilt",
+               "ns/sample");
+    }
+    for (int biased = 0; ok && biased < 2; biased++) {
+        float bias = biased ? STUDY_GYRO_BIAS : 0.0f;
+        for (size_t f = 0; ok && f < FILTER_COUNT; f++) {
+            memcpy(output, input, (size_t)count * sizeof(*output));
+            for (long i = 0; i < count; i++) {
+                output[i].gyro.x += bias;
+                output[i].gyro.y += bias;
+                output[i].gyro.z += bias;
+            }
+            ok = study_filter((int)f, output, truth, (size_t)count, skip, bias);
+        }
+    }
+    if (!ok) fprintf(stderr, "out of memory\n");
+
+    free(input);
+    free(output);
+    free(truth);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    float quaternion_tol = DEFAULT_TOLERANCE;
+    float motor_tol = DEFAULT_TOLERANCE;
+    long repeats = 1;
+    long generate = 0;
+    long study = 0;
+    int filter = -1;
+    int control = -1;
+    uint32_t seed = 1;
+    const char* write_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "q:m:n:f:c:w:g:A:s:h")) != -1) {
+        switch (opt) {
+        case 'q': quaternion_tol = strtof(optarg, NULL); break;
+        case 'm': motor_tol = strtof(optarg, NULL); break;
+        case 'n': repeats = strtol(optarg, NULL, 10); break;
+        case 'f':
+            filter = parse_filter(optarg);
+            if (filter < 0) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'c':
+            control = parse_control(optarg);
+            if (control < 0) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'w': write_path = optarg; break;
+        case 'g': generate = strtol(optarg, NULL, 10); break;
+        case 'A': study = strtol(optarg, NULL, 10); break;
+        case 's': seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (generate > 0) return synthesize(generate, seed);
+    if (study > 0) return accuracy_study(study, seed);
+    if (optind != argc - 1 || repeats < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE* f = fopen(argv[optind], "r");
+    if (f == NULL) {
+        perror(argv[optind]);
+        return 2;
+    }
+    replay_sample_t* reference;
+    bool has_reference;
+    long count = replay_load_csv(f, &reference, &has_reference);
+    fclose(f);
+    if (count < 0) {
+        fprintf(stderr, "%s: malformed trace\n", argv[optind]);
+        return 2;
+    }
+
+    replay_sample_t* output = malloc((size_t)(count > 0 ? count : 1) * sizeof(*output));
+    if (output == NULL) {
+        fprintf(stderr, "out of memory\n");
+        free(reference);
+        return 2;
+    }
+
+    // Every repeat starts from fresh controller state; only the steps are timed
+    double elapsed = 0.0;
+    for (long r = 0; r < repeats; r++) {
+        replay_t replay;
+        memcpy(output, reference, (size_t)count * sizeof(*output));
+        if (!init_with_filter(&replay, filter)) {
+            fprintf(stderr, "out of memory\n");
+            replay_free(&replay);
+            free(output);
+            free(reference);
+            return 2;
+        }
+        if (control >= 0) replay.fc->attitude_control = (attitude_control_t)control;
+        double start = now_s();
+        replay_run(&replay, output, (size_t)count);
+        elapsed += now_s() - start;
+        replay_free(&replay);
+    }
+
+    int status = 0;
+    if (has_reference) {
+        replay_diff_t diff;
+        replay_compare(output, reference, (size_t)count, quaternion_tol, motor_tol, &diff);
+        fprintf(stderr, "samples=%zu mismatches=%zu max_quaternion_error=%.3g max_motor_error=%.3g\n",
+                diff.compared, diff.mismatches,
+                (double)diff.max_quaternion_error, (double)diff.max_motor_error);
+        if (diff.mismatches > 0) {
+            const replay_sample_t* a = &output[diff.first_mismatch];
+            const replay_sample_t* b = &reference[diff.first_mismatch];
+            fprintf(stderr, "first mismatch at sample %zu (t=%llu us): "
+                    "q=[%g %g %g %g] ref [%g %g %g %g], m=[%g %g %g %g] ref [%g %g %g %g]\n",
+                    diff.first_mismatch, (unsigned long long)b->time_us,
+                    a->quaternion.q0, a->quaternion.q1, a->quaternion.q2, a->quaternion.q3,
+                    b->quaternion.q0, b->quaternion.q1, b->quaternion.q2, b->quaternion.q3,
+                    a->motor[0], a->motor[1], a->motor[2], a->motor[3],
+                    b->motor[0], b->motor[1], b->motor[2], b->motor[3]);
+            status = 1;
+        }
+    } else {
+        fprintf(stderr, "samples=%ld (no reference columns, nothing checked)\n", count);
+    }
+
+    double total = (double)count * (double)repeats;
+    if (elapsed > 0.0) {
+        fprintf(stderr, "rate=%.0f samples/s (%.1f ns/sample over %ld run%s)\n",
+                total / elapsed, elapsed * 1e9 / total, repeats, repeats == 1 ? "" : "s");
+    }
+
+    if (write_path != NULL) {
+        FILE* out = fopen(write_path, "w");
+        if (out == NULL) {
+            perror(write_path);
+            status = 2;
+        } else {
+            replay_write_csv(out, output, (size_t)count);
+            fclose(out);
+        }
+    }
+
+    free(output);
+    free(reference);
+    return status;
+}
@@ -0,0 +1,260 @@
+#include "replay.h"
+#include "drivers/esc.h"
+#include "drivers/hal_linux.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEG_TO_RAD 0.0174532925f
+#define TWO_PI     6.28318531f
+
+bool replay_init(replay_t* replay, float dt) {
+    memset(replay, 0, sizeof(*replay));
+    replay->dt = dt;
+
+    hal_linux_set_virtual_time(true);
+    if (hal_init() != 0) return false;
+    hal_linux_i2c_detach_all();
+    if (!mpu6050_sim_init(&replay->imu, 0)) return false;
+
+    replay->fc = flight_controller_init();
+    if (replay->fc == NULL) return false;
+    esc_arm(replay->fc->esc);
+    replay->fc->current_mode = FLIGHT_MODE_STABILIZE;
+    return true;
+}
+
+void replay_free(replay_t* replay) {
+    if (replay->fc != NULL) flight_controller_cleanup(replay->fc);
+    hal_linux_i2c_detach_all();
+    memset(replay, 0, sizeof(*replay));
+}
+
+void replay_step(replay_t* replay, replay_sample_t* sample) {
+    flight_controller_t* fc = replay->fc;
+    attitude_sample_t attitude;
+
+    mpu6050_sim_set_sample(&replay->imu, &sample->accel, &sample->gyro);
+    fc->setpoint = (setpoint_t){ sample->setpoint[0], sample->setpoint[1],
+                                 sample->setpoint[2], sample->setpoint[3] };
+    flight_controller_sensor_step(fc, hal_time_us(), replay->dt, &attitude);
+    flight_controller_control_step(fc, &attitude);
+
+    sample->quaternion = attitude.quaternion;
+    for (int i = 0; i < 4; i++) sample->motor[i] = fc->motor_output[i];
+    replay->steps++;
+    hal_linux_advance_us((uint64_t)(replay->dt * 1e6f + 0.5f));
+}
+
+void replay_run(replay_t* replay, replay_sample_t* samples, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        replay_step(replay, &samples[i]);
+    }
+}
+
+void replay_compare(const replay_sample_t* output, const replay_sample_t* reference,
+                    size_t count, float quaternion_tol, float motor_tol,
+                    replay_diff_t* diff) {
+    memset(diff, 0, sizeof(*diff));
+
+    for (size_t i = 0; i < count; i++) {
+        const quaternion_t* a = &output[i].quaternion;
+        const quaternion_t* b = &reference[i].quaternion;
+        const float dq[4] = {
+            fabsf(a->q0 - b->q0), fabsf(a->q1 - b->q1),
+            fabsf(a->q2 - b->q2), fabsf(a->q3 - b->q3)
+        };
+        bool mismatch = false;
+
+        for (int k = 0; k < 4; k++) {
+            float dm = fabsf(output[i].motor[k] - reference[i].motor[k]);
+            if (dq[k] > diff->max_quaternion_error) diff->max_quaternion_error = dq[k];
+            if (dm > diff->max_motor_error) diff->max_motor_error = dm;
+            // Written so that NaN counts as a mismatch
+            if (!(dq[k] <= quaternion_tol) || !(dm <= motor_tol)) mismatch = true;
+        }
+
+        if (mismatch) {
+            if (diff->mismatches == 0) diff->first_mismatch = i;
+            diff->mismatches++;
+        }
+        diff->compared++;
+    }
+}
+
+int replay_parse_line(const char* line, replay_sample_t* sample) {
+    float v[REPLAY_CSV_COLUMNS - 1];
+    char* end;
+    const char* p = line;
+
+    memset(sample, 0, sizeof(*sample));
+    sample->time_us = strtoull(p, &end, 10);
+    if (end == p) return 0;
+
+    int columns = 1;
+    p = end;
+    while (columns < REPLAY_CSV_COLUMNS && *p == ',') {
+        p++;
+        v[columns - 1] = strtof(p, &end);
+        if (end == p) return 0;
+        p = end;
+        columns++;
+    }
+    while (*p == ' ' || *p == '\r' || *p == '\n') p++;
+    if (*p != '\0') return 0;
+    if (columns != REPLAY_INPUT_COLUMNS && columns != REPLAY_CSV_COLUMNS) return 0;
+
+    sample->accel = (vector3_t){ v[0], v[1], v[2] };
+    sample->gyro = (vector3_t){ v[3], v[4], v[5] };
+    for (int i = 0; i < 4; i++) sample->setpoint[i] = v[6 + i];
+    if (columns == REPLAY_CSV_COLUMNS) {
+        sample->quaternion = (quaternion_t){ v[10], v[11], v[12], v[13] };
+        for (int i = 0; i < 4; i++) sample->motor[i] = v[14 + i];
+    }
+    return columns;
+}
+
+long replay_load_csv(FILE* f, replay_sample_t** samples, bool* has_reference) {
+    char line[512];
+    size_t count = 0, cap = 0;
+    replay_sample_t* out = NULL;
+
+    *samples = NULL;
+    *has_reference = true;
+
+    // Header
+    if (fgets(line, sizeof(line), f) == NULL) return 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '\n' || line[0] == '\0') continue;
+        if (count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            replay_sample_t* grown = realloc(out, cap * sizeof(*out));
+            if (grown == NULL) {
+                free(out);
+                return -1;
+            }
+            out = grown;
+        }
+        int columns = replay_parse_line(line, &out[count]);
+        if (columns == 0) {
+            free(out);
+            return -1;
+        }
+        if (columns != REPLAY_CSV_COLUMNS) *has_reference = false;
+        count++;
+    }
+
+    if (count == 0) *has_reference = false;
+    *samples = out;
+    return (long)count;
+}
+
+void replay_write_csv(FILE* f, const replay_sample_t* samples, size_t count) {
+    fputs("time_us,ax,ay,az,gx,gy,gz,sp_roll,sp_pitch,sp_yaw,throttle,"
+          "q0,q1,q2,q3,m1,m2,m3,m4\n", f);
+    for (size_t i = 0; i < count; i++) {
+        const replay_sample_t* s = &samples[i];
+        fprintf(f, "%llu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%g,%g,%g,%g,"
+                "%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n",
+                (unsigned long long)s->time_us,
+                s->accel.x, s->accel.y, s->accel.z,
+                s->gyro.x, s->gyro.y, s->gyro.z,
+                s->setpoint[0], s->setpoint[1], s->setpoint[2], s->setpoint[3],
+                s->quaternion.q0, s->quaternion.q1, s->quaternion.q2, s->quaternion.q3,
+                s->motor[0], s->motor[1], s->motor[2], s->motor[3]);
+    }
+}
+
+// xorshift32, so traces are identical on every host
+static float noise(uint32_t* state, float amplitude) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return amplitude * ((float)(x >> 8) / 8388608.0f - 1.0f);
+}
+
+void replay_synthesize(replay_sample_t* samples, size_t count, float dt, uint32_t seed) {
+    replay_synthesize_truth(samples, NULL, count, dt, seed);
+}
+
+void replay_synthesize_truth(replay_sample_t* samples, quaternion_t* truth, size_t count,
+                             float dt, uint32_t seed) {
+    quaternion_t q = { 1.0f, 0.0f, 0.0f, 0.0f };
+    uint32_t state = seed ? seed : 1u;
+
+    for (size_t i = 0; i < count; i++) {
+        replay_sample_t* s = &samples[i];
+        float t = (float)i * dt;
+        memset(s, 0, sizeof(*s));
+        s->time_us = (uint64_t)i * (uint64_t)(dt * 1e6f + 0.5f);
+
+        // True body rates in deg/s
+        float gx = 40.0f * sinf(TWO_PI * 0.7f * t);
+        float gy = 25.0f * sinf(TWO_PI * 1.1f * t + 1.0f);
+        float gz = 10.0f * sinf(TWO_PI * 0.3f * t);
+
+        // Integrate the true attitude
+        float wx = gx * DEG_TO_RAD, wy = gy * DEG_TO_RAD, wz = gz * DEG_TO_RAD;
+        quaternion_t d = {
+            0.5f * (-q.q1 * wx - q.q2 * wy - q.q3 * wz),
+            0.5f * (q.q0 * wx + q.q2 * wz - q.q3 * wy),
+            0.5f * (q.q0 * wy - q.q1 * wz + q.q3 * wx),
+            0.5f * (q.q0 * wz + q.q1 * wy - q.q2 * wx)
+        };
+        q.q0 += d.q0 * dt;
+        q.q1 += d.q1 * dt;
+        q.q2 += d.q2 * dt;
+        q.q3 += d.q3 * dt;
+        float norm = sqrtf(q.q0 * q.q0 + q.q1 * q.q1 + q.q2 * q.q2 + q.q3 * q.q3);
+        q.q0 /= norm;
+        q.q1 /= norm;
+        q.q2 /= norm;
+        q.q3 /= norm;
+        if (truth != NULL) truth[i] = q;
+
+        // Gravity seen in the body frame, plus vibration
+        s->accel.x = 2.0f * (q.q1 * q.q3 - q.q0 * q.q2) + noise(&state, 0.05f);
+        s->accel.y = 2.0f * (q.q0 * q.q1 + q.q2 * q.q3) + noise(&state, 0.05f);
+        s->accel.z = q.q0 * q.q0 - q.q1 * q.q1 - q.q2 * q.q2 + q.q3 * q.q3 +
+                     noise(&state, 0.05f);
+        s->gyro.x = gx + noise(&state, 0.5f);
+        s->gyro.y = gy + noise(&state, 0.5f);
+        s->gyro.z = gz + noise(&state, 0.5f);
+
+        // Level hover with a roll step and a pitch step
+        s->setpoint[0] = (t >= 0.1f && t < 0.3f) ? 10.0f : 0.0f;
+        s->setpoint[1] = (t >= 0.2f) ? -5.0f : 0.0f;
+        s->setpoint[2] = 0.0f;
+        s->setpoint[3] = 0.5f;
+    }
+}
+
+// Angle between the gravity directions the two attitudes imply, in degrees
+static float tilt_error(const quaternion_t* a, const quaternion_t* b) {
+    float ax = 2.0f * (a->q1 * a->q3 - a->q0 * a->q2);
+    float ay = 2.0f * (a->q0 * a->q1 + a->q2 * a->q3);
+    float az = a->q0 * a->q0 - a->q1 * a->q1 - a->q2 * a->q2 + a->q3 * a->q3;
+    float bx = 2.0f * (b->q1 * b->q3 - b->q0 * b->q2);
+    float by = 2.0f * (b->q0 * b->q1 + b->q2 * b->q3);
+    float bz = b->q0 * b->q0 - b->q1 * b->q1 - b->q2 * b->q2 + b->q3 * b->q3;
+    float cx = ay * bz - az * by;
+    float cy = az * bx - ax * bz;
+    float cz = ax * by - ay * bx;
+    float dot = ax * bx + ay * by + az * bz;
+    return atan2f(sqrtf(cx * cx + cy * cy + cz * cz), dot) / DEG_TO_RAD;
+}
+
+void replay_tilt_error(const replay_sample_t* output, const quaternion_t* truth, size_t count,
+                       float* rms, float* max) {
+    double sum = 0.0;
+    *max = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        float e = tilt_error(&output[i].quaternion, &truth[i]);
+        sum += (double)e * (double)e;
+        if (e > *max) *max = e;
+    }
+    *rms = count > 0 ? (float)sqrt(sum / (double)count) : 0.0f;
+}
@@ -0,0 +1,96 @@
+// flight-controller/tools/replay/replay.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "include/types.h"
+#include "core/flight_controller.h"
+#include "drivers/mpu6050_sim.h"
+#include "include/config.h"
+
+// Host replay of recorded IMU samples through the flight code itself: each
+// sample is written into a simulated MPU6050 on the Linux HAL, then
+// flight_controller_sensor_step() and flight_controller_control_step() run
+// once, as the single-core loop does. The replay covers whatever that build
+// flies: the gyro notches, the fixed-point path (FC_FIXED_POINT), the
+// setpoint quaternion cache, and the sensor's quantization and one-sample
+// read latency.
+//
+// A trace is a CSV file with one sample per line:
+//
+//   time_us,ax,ay,az,gx,gy,gz,sp_roll,sp_pitch,sp_yaw,throttle,q0,q1,q2,q3,m1,m2,m3,m4
+//
+// accel and gyro are the scaled sensor values (g and deg/s), the gyro before
+// the notch; the setpoint is in degrees. The last eight columns are the
+// reference outputs; a trace without them can be replayed but not checked.
+
+#define REPLAY_CSV_COLUMNS     19
+#define REPLAY_INPUT_COLUMNS   11
+
+typedef struct {
+    uint64_t time_us;
+    vector3_t accel;
+    vector3_t gyro;
+    float setpoint[4];          // roll, pitch, yaw, throttle
+    quaternion_t quaternion;    // Estimator output
+    float motor[4];             // Mixer output
+} replay_sample_t;
+
+typedef struct {
+    flight_controller_t* fc;    // Armed, in stabilize mode
+    mpu6050_sim_t imu;
+    uint32_t steps;
+    float dt;                   // Step of the sensor stage; the control stage runs at DT
+} replay_t;
+
+typedef struct {
+    size_t compared;
+    size_t mismatches;          // Samples with any output outside tolerance
+    size_t first_mismatch;      // Index of the first one, valid if mismatches > 0
+    float max_quaternion_error;
+    float max_motor_error;
+} replay_diff_t;
+
+// Switches the HAL to virtual time, attaches the simulated IMU to I2C
+// instance 0 and brings up a fresh flight controller. Change the filter
+// (fc->attitude_estimator, then flight_controller_sync_fixed()) or
+// fc->attitude_control before the first step. Only one replay_t can exist
+// at a time, and not next to a sil_t. Returns false on failure;
+// replay_free() is safe either way.
+bool replay_init(replay_t* replay, float dt);
+void replay_free(replay_t* replay);
+
+// Run one sample and fill in its quaternion and motor outputs
+void replay_step(replay_t* replay, replay_sample_t* sample);
+void replay_run(replay_t* replay, replay_sample_t* samples, size_t count);
+
+// Element-wise absolute difference of the outputs
+void replay_compare(const replay_sample_t* output, const replay_sample_t* reference,
+                    size_t count, float quaternion_tol, float motor_tol,
+                    replay_diff_t* diff);
+
+// CSV trace I/O. replay_parse_line() returns the number of columns read
+// (REPLAY_INPUT_COLUMNS or REPLAY_CSV_COLUMNS) or 0 for a malformed line.
+int replay_parse_line(const char* line, replay_sample_t* sample);
+// Reads every sample after the header line into a malloc'd array. Returns
+// the sample count, or -1 on a malformed line. *has_reference is set if
+// every line carries the output columns.
+long replay_load_csv(FILE* f, replay_sample_t** samples, bool* has_reference);
+void replay_write_csv(FILE* f, const replay_sample_t* samples, size_t count);
+
+// Deterministic synthetic flight for trying out the tool: sinusoidal body
+// rates with noise, gravity rotated into the body frame and a few setpoint
+// steps. Outputs are left zero.
+void replay_synthesize(replay_sample_t* samples, size_t count, float dt, uint32_t seed);
+// The same flight, also writing the true attitude of every sample to truth
+// (may be NULL)
+void replay_synthesize_truth(replay_sample_t* samples, quaternion_t* truth, size_t count,
+                             float dt, uint32_t seed);
+
+// RMS and worst angle, in degrees, between the gravity direction of the
+// replayed estimate and of the truth. Heading is left out: no filter can
+// observe it from an accelerometer.
+void replay_tilt_error(const replay_sample_t* output, const quaternion_t* truth, size_t count,
+                       float* rms, float* max);
@@ -0,0 +1,138 @@
+// Fly the flight controller against the quad simulator, many seeded
+// flights at a time, and fail if any of them crashes or tilts too far.
+//
+//   fc_sim                               100 flights of 5 s
+//   fc_sim -f 5000 -l 30                 fail any flight tilting past 30 deg
+//   fc_sim -f 1 -s 42 -c flight.csv      trace one flight for plotting
+#include "sil.h"
+#include "include/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [-f flights] [-s seed] [-t seconds] [-z altitude] [-a tilt] [-r rate]\n"
+            "          [-g gyro_noise] [-b gyro_bias] [-n accel_noise] [-l max_tilt] [-c trace.csv]\n"
+            "  -f  number of flights, seeds counting up from -s (default 100, seed 1)\n"
+            "  -t  flight length in seconds (default 5)\n"
+            "  -z  start altitude in m (default 20)\n"
+            "  -a  initial roll and pitch drawn from +/- this, deg (default 10)\n"
+            "  -r  initial body rates drawn from +/- this, deg/s (default 30)\n"
+            "  -g  gyro noise, deg/s rms; -b gyro bias on every axis, deg/s\n"
+            "  -n  accelerometer noise, g rms\n"
+            "  -l  fail flights whose tilt exceeds this, deg (default: ground contact only)\n"
+            "  -c  write the first flight step by step as CSV\n",
+            prog);
+}
+
+// time, true and estimated attitude (deg), motor commands, altitude
+static void trace_flight(sil_t* sil, const sil_scenario_t* scenario, uint32_t seed, FILE* f) {
+    uint64_t steps = (uint64_t)(scenario->duration * (float)CONTROL_LOOP_FREQ);
+
+    sil_reset(sil, scenario, seed);
+    fprintf(f, "time_s,roll,pitch,yaw,est_roll,est_pitch,est_yaw,m1,m2,m3,m4,altitude\n");
+    for (uint64_t i = 0; i < steps; i++) {
+        sil_step(sil);
+        attitude_t truth = attitude_from_quaternion(&sil->quad.state.attitude);
+        attitude_t est = attitude_from_quaternion(&sil->fc->attitude_estimator->quaternion);
+        fprintf(f, "%.4f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+                sil->quad.time_s, truth.roll, truth.pitch, truth.yaw,
+                est.roll, est.pitch, est.yaw,
+                sil->throttle[0], sil->throttle[1], sil->throttle[2], sil->throttle[3],
+                sil->quad.state.position.z);
+    }
+}
+
+int main(int argc, char** argv) {
+    sil_scenario_t scenario = { 5.0f, 20.0f, 10.0f, 30.0f };
+    quad_sim_params_t params;
+    long flights = 100;
+    uint32_t seed = 1;
+    float tilt_limit = 0.0f;
+    const char* trace_path = NULL;
+    int opt;
+
+    quad_sim_default_params(&params);
+    while ((opt = getopt(argc, argv, "f:s:t:z:a:r:g:b:n:l:c:h")) != -1) {
+        switch (opt) {
+        case 'f': flights = strtol(optarg, NULL, 10); break;
+        case 's': seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 't': scenario.duration = strtof(optarg, NULL); break;
+        case 'z': scenario.altitude = strtof(optarg, NULL); break;
+        case 'a': scenario.max_initial_tilt = strtof(optarg, NULL); break;
+        case 'r': scenario.max_initial_rate = strtof(optarg, NULL); break;
+        case 'g': params.gyro_noise = strtof(optarg, NULL); break;
+        case 'b':
+            params.gyro_bias.x = params.gyro_bias.y = params.gyro_bias.z = strtof(optarg, NULL);
+            break;
+        case 'n': params.accel_noise = strtof(optarg, NULL); break;
+        case 'l': tilt_limit = strtof(optarg, NULL); break;
+        case 'c': trace_path = optarg; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (flights < 1 || scenario.duration <= 0.0f) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static sil_t sil;
+    if (!sil_init(&sil, &params)) {
+        fprintf(stderr, "flight controller initialization failed\n");
+        return 1;
+    }
+
+    if (trace_path != NULL) {
+        FILE* f = fopen(trace_path, "w");
+        if (f == NULL) {
+            perror(trace_path);
+            sil_free(&sil);
+            return 1;
+        }
+        trace_flight(&sil, &scenario, seed, f);
+        fclose(f);
+    }
+
+    long failures = 0;
+    float worst_tilt = 0.0f;
+    double final_tilt_sum = 0.0;
+    uint64_t steps = 0;
+    double start = now_s();
+
+    for (long i = 0; i < flights; i++) {
+        sil_result_t result;
+        sil_fly(&sil, &scenario, seed + (uint32_t)i, &result);
+        steps += result.steps;
+        final_tilt_sum += result.final_tilt;
+        if (result.max_tilt > worst_tilt) worst_tilt = result.max_tilt;
+
+        bool tilted = tilt_limit > 0.0f && result.max_tilt > tilt_limit;
+        if (result.ground_contact || tilted) {
+            if (failures < 10) {
+                printf("seed %u: %s, max tilt %.1f deg, min altitude %.2f m\n",
+                       seed + (uint32_t)i, result.ground_contact ? "hit the ground" : "tilt limit",
+                       result.max_tilt, result.min_altitude);
+            }
+            failures++;
+        }
+    }
+
+    double wall = now_s() - start;
+    double simulated = (double)steps / CONTROL_LOOP_FREQ;
+    printf("%ld flights, %ld failed, worst tilt %.1f deg, mean final tilt %.1f deg\n",
+           flights, failures, worst_tilt, final_tilt_sum / (double)flights);
+    printf("%.0f s simulated in %.3f s, %.0fx realtime\n", simulated, wall, simulated / wall);
+
+    sil_free(&sil);
+    return failures == 0 ? 0 : 1;
+}
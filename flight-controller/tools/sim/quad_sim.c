@@ -0,0 +1,210 @@
+#include "quad_sim.h"
+#include <math.h>
+#include <string.h>
+
+#define GRAVITY    9.80665f
+#define DEG_TO_RAD 0.0174532925f
+#define RAD_TO_DEG 57.2957795131f
+#define TWO_PI     6.28318531f
+
+// Per motor, in mixer order: arm direction (x, y) and spin direction
+static const float MOTOR_X[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+static const float MOTOR_Y[4] = { 1.0f, -1.0f, -1.0f, 1.0f };
+static const float MOTOR_SPIN[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+
+void quad_sim_default_params(quad_sim_params_t* params) {
+    memset(params, 0, sizeof(*params));
+    params->mass = 0.5f;
+    params->inertia = (vector3_t){ 2.5e-3f, 2.5e-3f, 4.5e-3f };
+    params->arm_length = 0.125f;
+    params->motor_max_thrust = 0.5f * GRAVITY;
+    params->motor_time_constant = 0.03f;
+    params->yaw_torque_coeff = 0.016f;
+    params->linear_drag = 0.1f;
+    params->angular_drag = 1e-3f;
+    params->gyro_noise = 0.1f;
+    params->accel_noise = 0.005f;
+    params->substeps = 4;
+}
+
+void quad_sim_init(quad_sim_t* sim, const quad_sim_params_t* params, uint32_t seed) {
+    memset(sim, 0, sizeof(*sim));
+    sim->params = *params;
+    if (sim->params.substeps == 0) sim->params.substeps = 1;
+    sim->state.attitude.q0 = 1.0f;
+    sim->state.specific_force.z = GRAVITY;
+    sim->state.on_ground = true;
+    sim->rng = seed ? seed : 1u;
+}
+
+float quad_sim_hover_throttle(const quad_sim_params_t* params) {
+    return sqrtf(params->mass * GRAVITY / (4.0f * params->motor_max_thrust));
+}
+
+// v rotated from body to world by q
+static vector3_t rotate(const quaternion_t* q, const vector3_t* v) {
+    float q0 = q->q0, q1 = q->q1, q2 = q->q2, q3 = q->q3;
+    return (vector3_t){
+        (1.0f - 2.0f * (q2 * q2 + q3 * q3)) * v->x + 2.0f * (q1 * q2 - q0 * q3) * v->y +
+            2.0f * (q1 * q3 + q0 * q2) * v->z,
+        2.0f * (q1 * q2 + q0 * q3) * v->x + (1.0f - 2.0f * (q1 * q1 + q3 * q3)) * v->y +
+            2.0f * (q2 * q3 - q0 * q1) * v->z,
+        2.0f * (q1 * q3 - q0 * q2) * v->x + 2.0f * (q2 * q3 + q0 * q1) * v->y +
+            (1.0f - 2.0f * (q1 * q1 + q2 * q2)) * v->z
+    };
+}
+
+// v rotated from world to body
+static vector3_t rotate_inverse(const quaternion_t* q, const vector3_t* v) {
+    const quaternion_t conj = { q->q0, -q->q1, -q->q2, -q->q3 };
+    return rotate(&conj, v);
+}
+
+void quad_sim_set_pose(quad_sim_t* sim, float altitude, float roll, float pitch, float yaw,
+                       float motor_speed) {
+    float cr = cosf(roll * DEG_TO_RAD * 0.5f), sr = sinf(roll * DEG_TO_RAD * 0.5f);
+    float cp = cosf(pitch * DEG_TO_RAD * 0.5f), sp = sinf(pitch * DEG_TO_RAD * 0.5f);
+    float cy = cosf(yaw * DEG_TO_RAD * 0.5f), sy = sinf(yaw * DEG_TO_RAD * 0.5f);
+    quad_sim_state_t* s = &sim->state;
+
+    s->attitude.q0 = cr * cp * cy + sr * sp * sy;
+    s->attitude.q1 = sr * cp * cy - cr * sp * sy;
+    s->attitude.q2 = cr * sp * cy + sr * cp * sy;
+    s->attitude.q3 = cr * cp * sy - sr * sp * cy;
+    s->position = (vector3_t){ 0.0f, 0.0f, altitude };
+    s->velocity = (vector3_t){ 0.0f, 0.0f, 0.0f };
+    s->rate = (vector3_t){ 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 4; i++) s->motor_speed[i] = motor_speed;
+    s->on_ground = altitude <= 0.0f;
+
+    // Thrust and gravity balance until the first step says otherwise
+    const vector3_t up = { 0.0f, 0.0f, GRAVITY };
+    s->specific_force = rotate_inverse(&s->attitude, &up);
+}
+
+static void integrate(quad_sim_t* sim, const float throttle[4], float h) {
+    const quad_sim_params_t* p = &sim->params;
+    quad_sim_state_t* s = &sim->state;
+    float arm = p->arm_length * 0.70710678f;
+    float lag = h >= p->motor_time_constant ? 1.0f : h / p->motor_time_constant;
+
+    // Rotor speeds, thrust and torques in the body frame
+    float thrust = 0.0f;
+    vector3_t torque = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 4; i++) {
+        float cmd = throttle[i];
+        if (!(cmd > 0.0f)) cmd = 0.0f;     // Also catches NaN
+        if (cmd > 1.0f) cmd = 1.0f;
+        s->motor_speed[i] += (cmd - s->motor_speed[i]) * lag;
+
+        float f = p->motor_max_thrust * s->motor_speed[i] * s->motor_speed[i];
+        thrust += f;
+        torque.x += arm * MOTOR_Y[i] * f;
+        torque.y -= arm * MOTOR_X[i] * f;
+        torque.z += p->yaw_torque_coeff * MOTOR_SPIN[i] * f;
+    }
+
+    // Translation
+    const vector3_t thrust_body = { 0.0f, 0.0f, thrust };
+    vector3_t thrust_world = rotate(&s->attitude, &thrust_body);
+    vector3_t accel = {
+        (thrust_world.x - p->linear_drag * s->velocity.x) / p->mass,
+        (thrust_world.y - p->linear_drag * s->velocity.y) / p->mass,
+        (thrust_world.z - p->linear_drag * s->velocity.z) / p->mass - GRAVITY
+    };
+    s->velocity.x += accel.x * h;
+    s->velocity.y += accel.y * h;
+    s->velocity.z += accel.z * h;
+    s->position.x += s->velocity.x * h;
+    s->position.y += s->velocity.y * h;
+    s->position.z += s->velocity.z * h;
+
+    // Rotation: J dw/dt = torque - w x Jw - drag w
+    vector3_t w = s->rate;
+    const vector3_t* j = &p->inertia;
+    vector3_t gyroscopic = {
+        w.y * j->z * w.z - w.z * j->y * w.y,
+        w.z * j->x * w.x - w.x * j->z * w.z,
+        w.x * j->y * w.y - w.y * j->x * w.x
+    };
+    s->rate.x += (torque.x - gyroscopic.x - p->angular_drag * w.x) / j->x * h;
+    s->rate.y += (torque.y - gyroscopic.y - p->angular_drag * w.y) / j->y * h;
+    s->rate.z += (torque.z - gyroscopic.z - p->angular_drag * w.z) / j->z * h;
+
+    quaternion_t* q = &s->attitude;
+    w = s->rate;
+    quaternion_t dq = {
+        0.5f * (-q->q1 * w.x - q->q2 * w.y - q->q3 * w.z),
+        0.5f * (q->q0 * w.x + q->q2 * w.z - q->q3 * w.y),
+        0.5f * (q->q0 * w.y - q->q1 * w.z + q->q3 * w.x),
+        0.5f * (q->q0 * w.z + q->q1 * w.y - q->q2 * w.x)
+    };
+    q->q0 += dq.q0 * h;
+    q->q1 += dq.q1 * h;
+    q->q2 += dq.q2 * h;
+    q->q3 += dq.q3 * h;
+    float inv_norm = 1.0f / sqrtf(q->q0 * q->q0 + q->q1 * q->q1 + q->q2 * q->q2 + q->q3 * q->q3);
+    q->q0 *= inv_norm;
+    q->q1 *= inv_norm;
+    q->q2 *= inv_norm;
+    q->q3 *= inv_norm;
+
+    // The ground stops the quad dead; it only leaves again under thrust
+    s->on_ground = s->position.z <= 0.0f;
+    if (s->on_ground) {
+        s->position.z = 0.0f;
+        s->velocity = (vector3_t){ 0.0f, 0.0f, 0.0f };
+        s->rate = (vector3_t){ 0.0f, 0.0f, 0.0f };
+        accel = (vector3_t){ 0.0f, 0.0f, 0.0f };
+    }
+
+    const vector3_t felt = { accel.x, accel.y, accel.z + GRAVITY };
+    s->specific_force = rotate_inverse(q, &felt);
+}
+
+void quad_sim_step(quad_sim_t* sim, const float throttle[4], float dt) {
+    float h = dt / (float)sim->params.substeps;
+    for (uint32_t i = 0; i < sim->params.substeps; i++) {
+        integrate(sim, throttle, h);
+    }
+    sim->time_s += dt;
+}
+
+float quad_sim_uniform(quad_sim_t* sim) {
+    // xorshift32, as in the replay tool
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return (float)(x >> 8) / 8388608.0f - 1.0f;
+}
+
+// Box-Muller, one value per call
+static float gaussian(quad_sim_t* sim, float sigma) {
+    if (sigma == 0.0f) return 0.0f;
+    float u1 = 0.5f * (quad_sim_uniform(sim) + 1.0f);
+    float u2 = 0.5f * (quad_sim_uniform(sim) + 1.0f);
+    if (u1 < 1e-7f) u1 = 1e-7f;
+    return sigma * sqrtf(-2.0f * logf(u1)) * cosf(TWO_PI * u2);
+}
+
+void quad_sim_imu(quad_sim_t* sim, vector3_t* accel, vector3_t* gyro) {
+    const quad_sim_params_t* p = &sim->params;
+    const quad_sim_state_t* s = &sim->state;
+
+    accel->x = s->specific_force.x / GRAVITY + p->accel_bias.x + gaussian(sim, p->accel_noise);
+    accel->y = s->specific_force.y / GRAVITY + p->accel_bias.y + gaussian(sim, p->accel_noise);
+    accel->z = s->specific_force.z / GRAVITY + p->accel_bias.z + gaussian(sim, p->accel_noise);
+    gyro->x = s->rate.x * RAD_TO_DEG + p->gyro_bias.x + gaussian(sim, p->gyro_noise);
+    gyro->y = s->rate.y * RAD_TO_DEG + p->gyro_bias.y + gaussian(sim, p->gyro_noise);
+    gyro->z = s->rate.z * RAD_TO_DEG + p->gyro_bias.z + gaussian(sim, p->gyro_noise);
+}
+
+float quad_sim_tilt(const quad_sim_t* sim) {
+    const quaternion_t* q = &sim->state.attitude;
+    float cos_tilt = 1.0f - 2.0f * (q->q1 * q->q1 + q->q2 * q->q2);
+    if (cos_tilt > 1.0f) cos_tilt = 1.0f;
+    if (cos_tilt < -1.0f) cos_tilt = -1.0f;
+    return acosf(cos_tilt) * RAD_TO_DEG;
+}
@@ -0,0 +1,80 @@
+// flight-controller/tools/sim/quad_sim.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "include/types.h"
+
+// Rigid-body quad X model for software-in-the-loop runs on the host.
+//
+// World frame is x forward, y left, z up; the body frame matches it when
+// level, which is the frame the attitude estimator assumes (a level sensor
+// reads +1 g on z). Motor positions follow the signs in mixer_quad_x(), so
+// positive roll, pitch and yaw outputs produce positive body torques:
+//
+//   motor 1 rear-left   motor 2 rear-right   motor 3 front-right   motor 4 front-left
+//
+// Each motor is a first-order lag from the commanded throttle to a
+// normalized rotor speed; thrust grows with its square. Drag is linear in
+// velocity and in body rate. Everything random comes from the seed, so a
+// run is reproducible bit for bit on the same host.
+
+typedef struct {
+    float mass;                 // kg
+    vector3_t inertia;          // Diagonal, kg m^2
+    float arm_length;           // Center to motor, m
+    float motor_max_thrust;     // Per motor at full speed, N
+    float motor_time_constant;  // s
+    float yaw_torque_coeff;     // Reaction torque per unit thrust, m
+    float linear_drag;          // N per m/s
+    float angular_drag;         // N m per rad/s
+    float gyro_noise;           // Standard deviation, deg/s
+    float accel_noise;          // Standard deviation, g
+    vector3_t gyro_bias;        // deg/s
+    vector3_t accel_bias;       // g
+    uint32_t substeps;          // Integration steps per quad_sim_step()
+} quad_sim_params_t;
+
+typedef struct {
+    vector3_t position;         // World, m
+    vector3_t velocity;         // World, m/s
+    quaternion_t attitude;      // Body to world
+    vector3_t rate;             // Body, rad/s
+    float motor_speed[4];       // Normalized rotor speed, 0..1
+    vector3_t specific_force;   // Body, m/s^2: what an ideal accelerometer reads
+    bool on_ground;             // Resting on z = 0
+} quad_sim_state_t;
+
+typedef struct {
+    quad_sim_params_t params;
+    quad_sim_state_t state;
+    uint32_t rng;
+    double time_s;
+} quad_sim_t;
+
+// A 250-class quad with a thrust-to-weight ratio of 4
+void quad_sim_default_params(quad_sim_params_t* params);
+
+// Level, at rest on the ground at the origin with the motors stopped
+void quad_sim_init(quad_sim_t* sim, const quad_sim_params_t* params, uint32_t seed);
+
+// Throttle that holds altitude when level
+float quad_sim_hover_throttle(const quad_sim_params_t* params);
+
+// Place the quad in the air with the given Euler angles (deg, ZYX) and
+// every rotor spinning at speed
+void quad_sim_set_pose(quad_sim_t* sim, float altitude, float roll, float pitch, float yaw,
+                       float motor_speed);
+
+// Advance by dt with the throttle commands (0..1) held
+void quad_sim_step(quad_sim_t* sim, const float throttle[4], float dt);
+
+// Sensor reading of the current state: accel in g and gyro in deg/s with
+// the configured bias and white noise
+void quad_sim_imu(quad_sim_t* sim, vector3_t* accel, vector3_t* gyro);
+
+// Angle between the body and world z axes, deg
+float quad_sim_tilt(const quad_sim_t* sim);
+
+// Uniform in [-1, 1) from the simulation's generator
+float quad_sim_uniform(quad_sim_t* sim);
@@ -0,0 +1,137 @@
+#include "sil.h"
+#include "drivers/dshot.h"
+#include "drivers/esc.h"
+#include "drivers/hal_linux.h"
+#include "include/config.h"
+#include <math.h>
+#include <string.h>
+
+#define RAD_TO_DEG 57.2957795131f
+
+bool sil_init(sil_t* sil, const quad_sim_params_t* params) {
+    memset(sil, 0, sizeof(*sil));
+    quad_sim_init(&sil->quad, params, 1);
+
+    hal_linux_set_virtual_time(true);
+    if (hal_init() != 0) return false;
+    hal_linux_i2c_detach_all();
+    if (!mpu6050_sim_init(&sil->imu, 0)) return false;
+
+    sil->fc = flight_controller_init();
+    if (sil->fc == NULL) return false;
+    esc_arm(sil->fc->esc);
+    sil->fc->current_mode = FLIGHT_MODE_STABILIZE;
+    return true;
+}
+
+void sil_free(sil_t* sil) {
+    flight_controller_cleanup(sil->fc);
+    hal_linux_i2c_detach_all();
+    sil->fc = NULL;
+}
+
+// Inverse of the ESC's throttle to pulse width or DShot value mapping
+static float pwm_to_throttle(uint8_t pin) {
+    const esc_config_t* esc = &DEFAULT_ESC_CONFIG;
+    if (esc->protocol >= ESC_PROTOCOL_DSHOT150) {
+        int value = hal_linux_dshot_frame(pin) >> 5;
+        if (value < DSHOT_THROTTLE_MIN) return 0.0f;
+        return (float)(value - DSHOT_THROTTLE_MIN) / (float)(DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN);
+    }
+    esc_duty_range_t range;
+    esc_duty_range_init(&range, esc);
+    return ((float)hal_linux_pwm_level(pin) - (float)range.min_duty) / range.span;
+}
+
+static void sample_imu(sil_t* sil) {
+    vector3_t accel, gyro;
+    quad_sim_imu(&sil->quad, &accel, &gyro);
+    mpu6050_sim_set_sample(&sil->imu, &accel, &gyro);
+}
+
+void sil_reset(sil_t* sil, const sil_scenario_t* scenario, uint32_t seed) {
+    flight_controller_t* fc = sil->fc;
+    quad_sim_t* quad = &sil->quad;
+    const quad_sim_params_t params = quad->params;
+    float hover = quad_sim_hover_throttle(&params);
+
+    quad_sim_init(quad, &params, seed);
+    float roll = scenario->max_initial_tilt * quad_sim_uniform(quad);
+    float pitch = scenario->max_initial_tilt * quad_sim_uniform(quad);
+    float yaw = 180.0f * quad_sim_uniform(quad);
+    quad_sim_set_pose(quad, scenario->altitude, roll, pitch, yaw, hover);
+    quad->state.rate.x = scenario->max_initial_rate * quad_sim_uniform(quad) / RAD_TO_DEG;
+    quad->state.rate.y = scenario->max_initial_rate * quad_sim_uniform(quad) / RAD_TO_DEG;
+    quad->state.rate.z = scenario->max_initial_rate * quad_sim_uniform(quad) / RAD_TO_DEG;
+    for (int i = 0; i < 4; i++) sil->throttle[i] = hover;
+    sil->steps = 0;
+
+    // Controller state as after flight_controller_init()
+    fc->attitude_estimator->quaternion = (quaternion_t){ 1.0f, 0.0f, 0.0f, 0.0f };
+    fc->attitude_estimator->gyro_bias = (vector3_t){ 0.0f, 0.0f, 0.0f };
+    pid_axes_reset(&fc->rate_pid);
+    pid_axes_reset(&fc->angle_pid);
+    fc->rate_setpoint = (vector3_t){ 0.0f, 0.0f, 0.0f };
+    fc->angle_countdown = 0;
+    fc->sample_seq = 0;
+    for (int i = 0; i < 4; i++) fc->motor_output[i] = 0.0f;
+    fc->setpoint = (setpoint_t){ 0.0f, 0.0f, 0.0f, hover };
+#if FC_DYN_NOTCH
+    dyn_notch_init(&fc->gyro_notch, DYN_NOTCH_MIN_HZ, DYN_NOTCH_MAX_HZ, DYN_NOTCH_Q);
+#endif
+    flight_controller_sync_fixed(fc);
+
+    // The burst queued at the end of the last flight still holds its final
+    // sample: publish it, drop it from the oversampling sum and queue one
+    // of this flight instead
+    vector3_t stale_accel, stale_gyro;
+    sample_imu(sil);
+    mpu6050_read_async_poll(fc->imu);
+    mpu6050_read_average(fc->imu, &stale_accel, &stale_gyro);
+    mpu6050_read_async_start(fc->imu);
+
+    hal_linux_set_virtual_time(true);
+}
+
+void sil_step(sil_t* sil) {
+    for (int i = 1; i <= IMU_OVERSAMPLE; i++) {
+        sample_imu(sil);
+        if (i < IMU_OVERSAMPLE) {
+            flight_controller_imu_step(sil->fc);
+        } else {
+            flight_controller_update(sil->fc);
+            sil->throttle[0] = pwm_to_throttle(PIN_MOTOR1);
+            sil->throttle[1] = pwm_to_throttle(PIN_MOTOR2);
+            sil->throttle[2] = pwm_to_throttle(PIN_MOTOR3);
+            sil->throttle[3] = pwm_to_throttle(PIN_MOTOR4);
+        }
+        quad_sim_step(&sil->quad, sil->throttle, IMU_DT);
+        hal_linux_advance_us(IMU_UPDATE_PERIOD_US);
+    }
+    sil->steps++;
+}
+
+void sil_fly(sil_t* sil, const sil_scenario_t* scenario, uint32_t seed, sil_result_t* result) {
+    const quad_sim_state_t* s = &sil->quad.state;
+    uint64_t steps = (uint64_t)(scenario->duration * (float)CONTROL_LOOP_FREQ);
+
+    sil_reset(sil, scenario, seed);
+    memset(result, 0, sizeof(*result));
+    result->min_altitude = s->position.z;
+
+    for (uint64_t i = 0; i < steps; i++) {
+        sil_step(sil);
+
+        float tilt = quad_sim_tilt(&sil->quad);
+        float drift = sqrtf(s->position.x * s->position.x + s->position.y * s->position.y);
+        if (tilt > result->max_tilt) result->max_tilt = tilt;
+        if (drift > result->max_drift) result->max_drift = drift;
+        if (s->position.z < result->min_altitude) result->min_altitude = s->position.z;
+        if (s->on_ground) result->ground_contact = true;
+    }
+
+    result->steps = sil->steps;
+    result->final_tilt = quad_sim_tilt(&sil->quad);
+    result->final_rate = sqrtf(s->rate.x * s->rate.x + s->rate.y * s->rate.y +
+                               s->rate.z * s->rate.z) * RAD_TO_DEG;
+}
@@ -0,0 +1,59 @@
+// flight-controller/tools/sim/sil.h
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "quad_sim.h"
+#include "core/flight_controller.h"
+#include "drivers/mpu6050_sim.h"
+
+// Software-in-the-loop harness: the unmodified flight_controller_update()
+// on the Linux HAL, flying quad_sim. Every control period the quad's IMU
+// reading is written into the simulated MPU6050's registers, the flight
+// loop runs once, and the PWM levels from esc_set_output() are decoded back
+// into throttle commands for the motors. Time is virtual, so a flight runs
+// as fast as the host can compute it.
+
+typedef struct {
+    float duration;             // s
+    float altitude;             // Start height, m
+    float max_initial_tilt;     // Initial roll and pitch drawn from +/- this, deg
+    float max_initial_rate;     // Initial body rates drawn from +/- this, deg/s
+} sil_scenario_t;
+
+typedef struct {
+    uint64_t steps;
+    float max_tilt;             // deg
+    float final_tilt;           // deg
+    float final_rate;           // Body rate magnitude at the end, deg/s
+    float min_altitude;         // m
+    float max_drift;            // Horizontal distance from the start, m
+    bool ground_contact;
+} sil_result_t;
+
+typedef struct {
+    quad_sim_t quad;
+    mpu6050_sim_t imu;
+    flight_controller_t* fc;
+    float throttle[4];          // Last decoded motor commands
+    uint64_t steps;
+} sil_t;
+
+// Switches the HAL to virtual time, attaches the simulated IMU to I2C
+// instance 0 and brings up an armed flight controller in stabilize mode.
+// Only one sil_t can exist at a time. Returns false on failure.
+bool sil_init(sil_t* sil, const quad_sim_params_t* params);
+void sil_free(sil_t* sil);
+
+// Start a new flight: fresh quad, estimator and PID state, initial
+// conditions drawn from the seed, and a hover-throttle level setpoint
+void sil_reset(sil_t* sil, const sil_scenario_t* scenario, uint32_t seed);
+
+// One control period of IMU_OVERSAMPLE sensor samples, like the
+// single-core loop: flight_controller_imu_step() on all but the last one,
+// then flight_controller_update() and the motors. The physics advance
+// by IMU_DT per sample.
+void sil_step(sil_t* sil);
+
+// sil_reset() followed by the whole flight
+void sil_fly(sil_t* sil, const sil_scenario_t* scenario, uint32_t seed, sil_result_t* result);
@@ -0,0 +1,85 @@
+// Deferred logging cost on the host: a LOG_INFO call with three float
+// arguments (what the loop pays), the same line through snprintf (what
+// text logging pays), and how fast log_render() rebuilds the text from the
+// string table of this executable. Per-call cost on the RP2040 is measured
+// by test_logger_target_cost in the Pico test binary.
+#define FC_LOG_DEFERRED
+#include "log_decoder.h"
+#include "telemetry_decoder.h"
+#include "utils/logger.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_CALLS 2000000u
+#define BENCH_BATCH TELEMETRY_RING_SIZE
+
+static size_t discard_write(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    (void)data;
+    return len;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    static telemetry_t tel;
+    telemetry_port_t port = { .write = discard_write, .ctx = NULL };
+    telemetry_init(&tel, &port);
+    logger_init(&tel);
+
+    volatile float roll = 1.25f;
+    volatile float pitch = -3.5f;
+    double log_s = 0.0;
+
+    for (uint32_t done = 0; done < BENCH_CALLS; done += BENCH_BATCH) {
+        double t0 = now_s();
+        for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+            LOG_INFO("attitude %.2f %.2f %.2f", roll, pitch, (float)i);
+        }
+        log_s += now_s() - t0;
+        // Keep the ring from filling; the drain runs outside the timed part
+        while (spsc_ring_count(&tel.ring) > 0) telemetry_drain(&tel, BENCH_BATCH);
+    }
+
+    char line[128];
+    volatile int text_len = 0;
+    double t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+        text_len += snprintf(line, sizeof(line), "INFO: attitude %.2f %.2f %.2f",
+                             roll, pitch, (float)i);
+    }
+    double printf_s = now_s() - t0;
+
+    log_string_table_t strings;
+    if (log_string_table_load(&strings, "/proc/self/exe") != 0) {
+        fprintf(stderr, "could not read the string table of this executable\n");
+        return 1;
+    }
+
+    // One real record to render repeatedly
+    LOG_INFO("attitude %.2f %.2f %.2f", roll, pitch, 42.0f);
+    telemetry_record_t captured;
+    spsc_ring_pop(&tel.ring, &captured);
+    telemetry_log_t rec = captured.log;
+
+    size_t rendered = 0;
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+        rendered += log_render(&strings, &rec, line, sizeof(line));
+    }
+    double render_s = now_s() - t0;
+
+    printf("deferred LOG_INFO  %.1f ns/call\n", log_s * 1e9 / BENCH_CALLS);
+    printf("snprintf (text)    %.1f ns/call\n", printf_s * 1e9 / BENCH_CALLS);
+    printf("log_render         %.1f ns/record, %.2f M records/s\n",
+           render_s * 1e9 / BENCH_CALLS, BENCH_CALLS / render_s / 1e6);
+    printf("sample: %s\n", line);
+    printf("dropped=%u\n", (unsigned)logger_dropped());
+
+    log_string_table_free(&strings);
+    return rendered > 0 ? 0 : 1;
+}
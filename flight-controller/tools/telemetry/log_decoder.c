@@ -0,0 +1,195 @@
+#include "log_decoder.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_SECTION_NAME "fc_log_fmt"
+
+static uint64_t read_le(const uint8_t* p, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+int log_string_table_load_image(log_string_table_t* table, const uint8_t* elf, size_t len) {
+    table->data = NULL;
+    table->size = 0;
+
+    if (len < 52 || memcmp(elf, "\x7f" "ELF", 4) != 0) return -1;
+    if (elf[5] != 1) return -1;  // Little-endian only
+
+    bool is64 = elf[4] == 2;
+    size_t word = is64 ? 8 : 4;
+    if (is64 && len < 64) return -1;
+
+    // Section header table location and geometry
+    uint64_t shoff = read_le(elf + (is64 ? 0x28 : 0x20), word);
+    size_t shentsize = (size_t)read_le(elf + (is64 ? 0x3A : 0x2E), 2);
+    size_t shnum = (size_t)read_le(elf + (is64 ? 0x3C : 0x30), 2);
+    size_t shstrndx = (size_t)read_le(elf + (is64 ? 0x3E : 0x32), 2);
+    if (shoff == 0 || shstrndx >= shnum || shoff + shnum * shentsize > len) return -1;
+
+    // Field offsets within a section header
+    size_t off_offset = is64 ? 0x18 : 0x10;
+    size_t off_size = is64 ? 0x20 : 0x14;
+
+    const uint8_t* strhdr = elf + shoff + shstrndx * shentsize;
+    uint64_t names_off = read_le(strhdr + off_offset, word);
+    uint64_t names_size = read_le(strhdr + off_size, word);
+    if (names_off + names_size > len) return -1;
+
+    for (size_t i = 0; i < shnum; i++) {
+        const uint8_t* sh = elf + shoff + i * shentsize;
+        uint32_t name = (uint32_t)read_le(sh, 4);
+        if (name >= names_size) continue;
+
+        const char* sec_name = (const char*)elf + names_off + name;
+        size_t max_name = (size_t)(names_size - name);
+        if (strnlen(sec_name, max_name) != strlen(LOG_SECTION_NAME) ||
+            strncmp(sec_name, LOG_SECTION_NAME, max_name) != 0) {
+            continue;
+        }
+
+        uint64_t offset = read_le(sh + off_offset, word);
+        uint64_t size = read_le(sh + off_size, word);
+        if (offset + size > len) return -1;
+
+        // Trailing NUL so a corrupt id can never run off the end
+        table->data = malloc((size_t)size + 1);
+        if (table->data == NULL) return -1;
+        memcpy(table->data, elf + offset, (size_t)size);
+        table->data[size] = 0;
+        table->size = (size_t)size;
+        return 0;
+    }
+    return -1;
+}
+
+int log_string_table_load(log_string_table_t* table, const char* elf_path) {
+    table->data = NULL;
+    table->size = 0;
+
+    FILE* f = fopen(elf_path, "rb");
+    if (f == NULL) return -1;
+
+    uint8_t* image = NULL;
+    size_t len = 0;
+    size_t cap = 0;
+    size_t n;
+    do {
+        if (len == cap) {
+            cap = cap ? cap * 2 : (1u << 20);
+            uint8_t* grown = realloc(image, cap);
+            if (grown == NULL) {
+                free(image);
+                fclose(f);
+                return -1;
+            }
+            image = grown;
+        }
+        n = fread(image + len, 1, cap - len, f);
+        len += n;
+    } while (n > 0);
+    fclose(f);
+
+    int result = log_string_table_load_image(table, image, len);
+    free(image);
+    return result;
+}
+
+void log_string_table_free(log_string_table_t* table) {
+    free(table->data);
+    table->data = NULL;
+    table->size = 0;
+}
+
+const char* log_string_table_lookup(const log_string_table_t* table, uint16_t id) {
+    if (table->data == NULL || id >= table->size) return NULL;
+    return (const char*)table->data + id;
+}
+
+static void append(char* out, size_t cap, size_t* len, const char* text, size_t n) {
+    for (size_t i = 0; i < n && *len + 1 < cap; i++) {
+        out[(*len)++] = text[i];
+    }
+}
+
+size_t log_format(char* out, size_t cap, const char* fmt, const uint32_t* args, uint32_t nargs) {
+    size_t len = 0;
+    uint32_t next_arg = 0;
+    if (cap == 0) return 0;
+
+    while (*fmt != '\0') {
+        if (*fmt != '%') {
+            const char* run = fmt;
+            while (*fmt != '\0' && *fmt != '%') fmt++;
+            append(out, cap, &len, run, (size_t)(fmt - run));
+            continue;
+        }
+        if (fmt[1] == '%') {
+            append(out, cap, &len, "%", 1);
+            fmt += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision; drop length modifiers since every
+        // argument arrives as one 32-bit word
+        char spec[32];
+        size_t spec_len = 0;
+        spec[spec_len++] = *fmt++;
+        while (*fmt != '\0' && strchr("-+ #0123456789.", *fmt) != NULL &&
+               spec_len < sizeof(spec) - 3) {
+            spec[spec_len++] = *fmt++;
+        }
+        while (*fmt != '\0' && strchr("hlLqjzt", *fmt) != NULL) fmt++;
+        if (*fmt == '\0') break;
+
+        char conv = *fmt++;
+        spec[spec_len++] = conv;
+        spec[spec_len] = '\0';
+
+        char text[64];
+        int n;
+        if (strchr("diouxXcfFeEgGaA", conv) == NULL || next_arg >= nargs) {
+            n = snprintf(text, sizeof(text), "<?>");
+        } else {
+            uint32_t w = args[next_arg++];
+            if (strchr("di", conv) != NULL) {
+                n = snprintf(text, sizeof(text), spec, (int)(int32_t)w);
+            } else if (strchr("ouxX", conv) != NULL) {
+                n = snprintf(text, sizeof(text), spec, (unsigned)w);
+            } else if (conv == 'c') {
+                n = snprintf(text, sizeof(text), spec, (int)w);
+            } else {
+                float f;
+                memcpy(&f, &w, sizeof(f));
+                n = snprintf(text, sizeof(text), spec, (double)f);
+            }
+        }
+        if (n > (int)sizeof(text) - 1) n = (int)sizeof(text) - 1;
+        if (n > 0) append(out, cap, &len, text, (size_t)n);
+    }
+
+    out[len] = '\0';
+    return len;
+}
+
+size_t log_render(const log_string_table_t* table, const telemetry_log_t* rec,
+                  char* out, size_t cap) {
+    static const char* const LEVELS[] = { "DEBUG: ", "INFO: ", "ERROR: " };
+    const char* level = rec->level < 3 ? LEVELS[rec->level] : "LOG: ";
+
+    const char* fmt = log_string_table_lookup(table, rec->id);
+    if (fmt == NULL) {
+        int n = snprintf(out, cap, "%s<unknown format id %u>", level, (unsigned)rec->id);
+        return n < (int)cap ? (size_t)n : cap - 1;
+    }
+
+    size_t len = 0;
+    append(out, cap, &len, level, strlen(level));
+    uint32_t args[5];
+    memcpy(args, rec->args, sizeof(args));
+    uint32_t nargs = rec->nargs < 5 ? rec->nargs : 5;
+    return len + log_format(out + len, cap - len, fmt, args, nargs);
+}
@@ -0,0 +1,33 @@
+// flight-controller/tools/telemetry/log_decoder.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/telemetry.h"
+
+// Rebuilds deferred log text (see utils/logger.h) on the host. The string
+// table is the fc_log_fmt section of the firmware ELF; a record's id is the
+// offset of its format string in that section.
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+} log_string_table_t;
+
+// Extract fc_log_fmt from a little-endian ELF32 or ELF64 image. Returns 0
+// on success, -1 if the file is unreadable, not ELF or has no such section.
+int log_string_table_load(log_string_table_t* table, const char* elf_path);
+int log_string_table_load_image(log_string_table_t* table, const uint8_t* elf, size_t len);
+void log_string_table_free(log_string_table_t* table);
+
+// NULL if id is outside the table
+const char* log_string_table_lookup(const log_string_table_t* table, uint16_t id);
+
+// printf-style formatting from raw 32-bit argument words. Integer
+// conversions read the word as int32/uint32, floating-point conversions as
+// float. Returns the length written (truncated to cap - 1).
+size_t log_format(char* out, size_t cap, const char* fmt, const uint32_t* args, uint32_t nargs);
+
+// "LEVEL: text" for one record; unknown ids render as a placeholder
+size_t log_render(const log_string_table_t* table, const telemetry_log_t* rec,
+                  char* out, size_t cap);
@@ -0,0 +1,96 @@
+// Throughput of the telemetry path on the host: what the loop pays per
+// record (telemetry_send), the framing cost paid by the drain task, and how
+// fast the host decoder keeps up. The snprintf line is the cost of the
+// printf-style logging this channel replaces, for comparison.
+#include "telemetry_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_RECORDS 2000000u
+#define BENCH_BATCH   TELEMETRY_RING_SIZE
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+} memory_sink_t;
+
+static size_t sink_write(void* ctx, const uint8_t* data, size_t len) {
+    memory_sink_t* sink = ctx;
+    size_t room = sink->cap - sink->len;
+    if (len > room) len = room;
+    for (size_t i = 0; i < len; i++) sink->data[sink->len + i] = data[i];
+    sink->len += len;
+    return len;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void count_record(const telemetry_record_t* rec, void* ctx) {
+    (void)rec;
+    (*(uint32_t*)ctx)++;
+}
+
+int main(void) {
+    static telemetry_t tel;
+    memory_sink_t sink = { .len = 0, .cap = (size_t)BENCH_RECORDS * TELEMETRY_FRAME_MAX };
+    sink.data = malloc(sink.cap);
+    if (sink.data == NULL) return 1;
+
+    telemetry_port_t port = { .write = sink_write, .ctx = &sink };
+    telemetry_init(&tel, &port);
+
+    telemetry_attitude_t att = { 1.5f, -2.25f, 90.0f, 10.0f, -20.0f, 0.5f };
+    double send_s = 0.0;
+    double drain_s = 0.0;
+
+    for (uint32_t done = 0; done < BENCH_RECORDS; done += BENCH_BATCH) {
+        double t0 = now_s();
+        for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+            att.yaw = (float)(done + i);
+            telemetry_send(&tel, TELEMETRY_ATTITUDE, done + i, &att, sizeof(att));
+        }
+        double t1 = now_s();
+        telemetry_drain(&tel, BENCH_BATCH);
+        double t2 = now_s();
+        send_s += t1 - t0;
+        drain_s += t2 - t1;
+    }
+
+    uint32_t decoded = 0;
+    telemetry_decoder_t dec;
+    telemetry_decoder_init(&dec, count_record, &decoded);
+    double t0 = now_s();
+    telemetry_decoder_feed(&dec, sink.data, sink.len);
+    double decode_s = now_s() - t0;
+
+    char line[96];
+    volatile int sink_len = 0;
+    t0 = now_s();
+    for (uint32_t i = 0; i < BENCH_RECORDS; i++) {
+        sink_len += snprintf(line, sizeof(line), "DEBUG: attitude %.2f %.2f %.2f",
+                             att.roll, att.pitch, (float)i);
+    }
+    double printf_s = now_s() - t0;
+
+    double mb = (double)sink.len / 1e6;
+    printf("records            %u (%zu bytes, %.1f bytes/record)\n",
+           (unsigned)BENCH_RECORDS, sink.len, (double)sink.len / BENCH_RECORDS);
+    printf("telemetry_send     %.1f ns/record\n", send_s * 1e9 / BENCH_RECORDS);
+    printf("telemetry_drain    %.1f ns/record, %.1f MB/s\n",
+           drain_s * 1e9 / BENCH_RECORDS, mb / drain_s);
+    printf("decoder            %.1f ns/record, %.1f MB/s\n",
+           decode_s * 1e9 / BENCH_RECORDS, mb / decode_s);
+    printf("snprintf (text)    %.1f ns/record\n", printf_s * 1e9 / BENCH_RECORDS);
+    printf("dropped=%u decoded=%u lost=%u crc_errors=%u\n",
+           (unsigned)telemetry_dropped(&tel), (unsigned)decoded,
+           (unsigned)dec.lost_records, (unsigned)dec.crc_errors);
+
+    free(sink.data);
+    return decoded == BENCH_RECORDS ? 0 : 1;
+}
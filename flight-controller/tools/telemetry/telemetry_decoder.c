@@ -0,0 +1,69 @@
+#include "telemetry_decoder.h"
+#include <string.h>
+
+void telemetry_decoder_init(telemetry_decoder_t* dec, telemetry_record_fn on_record, void* ctx) {
+    memset(dec, 0, sizeof(*dec));
+    dec->on_record = on_record;
+    dec->ctx = ctx;
+}
+
+static void finish_frame(telemetry_decoder_t* dec) {
+    // Room for the record plus its CRC
+    uint8_t payload[sizeof(telemetry_record_t) + 2];
+
+    if (dec->len == 0) return;  // Back-to-back delimiters
+    if (dec->overflow) {
+        dec->framing_errors++;
+        return;
+    }
+
+    int n = frame_decode(dec->buf, dec->len, payload, sizeof(payload));
+    if (n < 0) {
+        dec->crc_errors++;
+        return;
+    }
+    if ((size_t)n != sizeof(telemetry_record_t)) {
+        dec->framing_errors++;
+        return;
+    }
+
+    telemetry_record_t rec;
+    memcpy(&rec, payload, sizeof(rec));
+
+    if (dec->have_seq && rec.seq != dec->next_seq) {
+        dec->lost_records += (uint16_t)(rec.seq - dec->next_seq);
+    }
+    dec->have_seq = true;
+    dec->next_seq = (uint16_t)(rec.seq + 1);
+    dec->records++;
+
+    if (dec->on_record != NULL) dec->on_record(&rec, dec->ctx);
+}
+
+void telemetry_decoder_feed(telemetry_decoder_t* dec, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t byte = data[i];
+        if (byte == 0) {
+            finish_frame(dec);
+            dec->len = 0;
+            dec->overflow = false;
+        } else if (dec->len < sizeof(dec->buf)) {
+            dec->buf[dec->len++] = byte;
+        } else {
+            dec->overflow = true;
+        }
+    }
+}
+
+const char* telemetry_type_name(uint8_t type) {
+    switch (type) {
+        case TELEMETRY_ATTITUDE: return "attitude";
+        case TELEMETRY_MOTORS: return "motors";
+        case TELEMETRY_STATUS: return "status";
+        case TELEMETRY_TASK: return "task";
+        case TELEMETRY_PROFILE: return "profile";
+        case TELEMETRY_LOG: return "log";
+        case TELEMETRY_BLACKBOX: return "blackbox";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,36 @@
+// flight-controller/tools/telemetry/telemetry_decoder.h
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/telemetry.h"
+
+// Host-side streaming decoder for the firmware telemetry channel. Feed it
+// raw bytes in chunks of any size; each valid record is passed to the
+// callback. Corrupt frames are counted and skipped up to the next delimiter.
+
+typedef void (*telemetry_record_fn)(const telemetry_record_t* rec, void* ctx);
+
+typedef struct {
+    telemetry_record_fn on_record;
+    void* ctx;
+
+    uint8_t buf[TELEMETRY_FRAME_MAX];
+    size_t len;
+    bool overflow;                  // Current frame is longer than any record
+
+    bool have_seq;
+    uint16_t next_seq;
+
+    // Statistics
+    uint32_t records;
+    uint32_t crc_errors;            // COBS or CRC failures
+    uint32_t framing_errors;        // Oversized frames or wrong record size
+    uint32_t lost_records;          // Sequence gaps: dropped on the device or in transit
+} telemetry_decoder_t;
+
+void telemetry_decoder_init(telemetry_decoder_t* dec, telemetry_record_fn on_record, void* ctx);
+void telemetry_decoder_feed(telemetry_decoder_t* dec, const uint8_t* data, size_t len);
+
+const char* telemetry_type_name(uint8_t type);
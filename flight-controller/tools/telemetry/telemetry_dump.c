@@ -0,0 +1,114 @@
+// Decode a telemetry capture (or a raw serial device) to CSV on stdout.
+//
+//   stty -F /dev/ttyACM0 raw && telemetry_dump /dev/ttyACM0
+//   telemetry_dump capture.bin > flight.csv
+//
+// With -e flight_controller.elf, deferred log records are printed as text
+// using the format strings from that firmware image.
+#include "log_decoder.h"
+#include "telemetry_decoder.h"
+#include <stdio.h>
+#include <string.h>
+
+static void print_record(const telemetry_record_t* rec, void* ctx) {
+    const log_string_table_t* strings = ctx;
+
+    if (rec->type == TELEMETRY_LOG && strings != NULL) {
+        char text[256];
+        telemetry_log_t log;
+        memcpy(&log, &rec->log, sizeof(log));
+        log_render(strings, &log, text, sizeof(text));
+        printf("log,%u,%u,\"%s\"\n", (unsigned)rec->seq, (unsigned)rec->timestamp_us, text);
+        return;
+    }
+
+    printf("%s,%u,%u", telemetry_type_name(rec->type), (unsigned)rec->seq,
+           (unsigned)rec->timestamp_us);
+
+    switch (rec->type) {
+        case TELEMETRY_ATTITUDE:
+            printf(",%.3f,%.3f,%.3f,%.2f,%.2f,%.2f",
+                   rec->attitude.roll, rec->attitude.pitch, rec->attitude.yaw,
+                   rec->attitude.rate_x, rec->attitude.rate_y, rec->attitude.rate_z);
+            break;
+        case TELEMETRY_MOTORS:
+            printf(",%.4f,%.4f,%.4f,%.4f,%.4f",
+                   rec->motors.output[0], rec->motors.output[1], rec->motors.output[2],
+                   rec->motors.output[3], rec->motors.throttle);
+            break;
+        case TELEMETRY_STATUS:
+            printf(",%u,%u,%u,%u,%u,%u,%u",
+                   (unsigned)rec->status.dropped, (unsigned)rec->status.sent,
+                   (unsigned)rec->status.trigger_irq, (unsigned)rec->status.trigger_fallback,
+                   (unsigned)rec->status.trigger_missed, (unsigned)rec->status.imu_duplicates,
+                   (unsigned)rec->status.imu_skipped);
+            break;
+        case TELEMETRY_TASK:
+            printf(",%u,%u,%u,%u,%u",
+                   (unsigned)rec->task.task, (unsigned)rec->task.runs,
+                   (unsigned)rec->task.overruns, (unsigned)rec->task.max_jitter_us,
+                   (unsigned)rec->task.mean_jitter_us);
+            break;
+        case TELEMETRY_PROFILE:
+            printf(",%u,%u,%u,%u,%u,%u",
+                   (unsigned)rec->profile.stage, (unsigned)rec->profile.count,
+                   (unsigned)rec->profile.min, (unsigned)rec->profile.max,
+                   (unsigned)rec->profile.mean, (unsigned)rec->profile.overhead);
+            break;
+        case TELEMETRY_LOG:
+            printf(",%u,%u,%u", (unsigned)rec->log.id, (unsigned)rec->log.level,
+                   (unsigned)rec->log.nargs);
+            break;
+        case TELEMETRY_BLACKBOX:
+            printf(",%u,%u,%u,%u,%u",
+                   (unsigned)rec->blackbox.pages_written, (unsigned)rec->blackbox.frames_dropped,
+                   (unsigned)rec->blackbox.erased_bytes, (unsigned)rec->blackbox.max_stall_us,
+                   (unsigned)rec->blackbox.deferred);
+            break;
+        default:
+            break;
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    log_string_table_t strings;
+    log_string_table_t* strings_ptr = NULL;
+    int arg = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-e") == 0) {
+        if (log_string_table_load(&strings, argv[2]) != 0) {
+            fprintf(stderr, "%s: no fc_log_fmt section\n", argv[2]);
+            return 1;
+        }
+        strings_ptr = &strings;
+        arg = 3;
+    }
+
+    FILE* in = stdin;
+    if (argc > arg) {
+        in = fopen(argv[arg], "rb");
+        if (in == NULL) {
+            perror(argv[arg]);
+            return 1;
+        }
+    }
+
+    telemetry_decoder_t dec;
+    telemetry_decoder_init(&dec, print_record, strings_ptr);
+
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        telemetry_decoder_feed(&dec, chunk, n);
+        fflush(stdout);
+    }
+
+    fprintf(stderr, "records=%u lost=%u crc_errors=%u framing_errors=%u\n",
+            (unsigned)dec.records, (unsigned)dec.lost_records,
+            (unsigned)dec.crc_errors, (unsigned)dec.framing_errors);
+
+    if (in != stdin) fclose(in);
+    if (strings_ptr != NULL) log_string_table_free(strings_ptr);
+    return 0;
+}